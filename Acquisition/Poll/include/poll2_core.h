@@ -18,8 +18,13 @@
 #ifndef POLL2_CORE_H
 #define POLL2_CORE_H
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include "BoundedQueue.hpp"
 #include "PixieInterface.h"
 #include "hribf_buffers.h"
 #define maxEventSize 4095 // (0x1FFE0000 >> 17)
@@ -100,6 +105,15 @@ class Client;
 class Server;
 class Terminal;
 
+/// A spill read from the FIFOs that is waiting to be written to disk and broadcast.
+struct SpillBuffer{
+    std::vector<word_t> data; /// Storage for the spill, sized for a full FIFO in every module.
+    size_t nWords; /// Number of words of data that are in use.
+    bool recorded; /// True if the spill is written to disk.
+    bool shmMode; /// True if the spill is broadcast in the shared-memory style.
+    std::atomic<int> consumers; /// Number of threads that still need the spill before it may be reused.
+};
+
 class Poll{
 private:
     Terminal *poll_term_;
@@ -173,6 +187,27 @@ private:
 
     data_pack AcqBuf; /// Data packet for class shared-memory broadcast
 
+    // Spill buffers handed from the FIFO readout to the disk writer and network broadcaster threads.
+    static const size_t numSpillBuffers_ = 8; ///< The number of spills that may be waiting on the disk or network.
+    std::vector<SpillBuffer*> spillBuffers_; ///< Every spill buffer, allocated once in Initialize.
+    std::vector<SpillBuffer*> freeSpills_; ///< Spill buffers that the readout may fill, only used by the readout.
+    BoundedQueue<SpillBuffer*> *writerQueue_; ///< Spills waiting to be written to disk.
+    BoundedQueue<SpillBuffer*> *broadcasterQueue_; ///< Spills waiting to be broadcast.
+    BoundedQueue<SpillBuffer*> *writerReturns_; ///< Spills that the writer finished last.
+    BoundedQueue<SpillBuffer*> *broadcasterReturns_; ///< Spills that the broadcaster finished last.
+    std::thread writerThread_; ///< Writes spills to disk.
+    std::thread broadcasterThread_; ///< Broadcasts spills onto the network.
+    std::mutex outputFileMutex_; ///< Protects the output file from the writer, broadcaster and status updates.
+    std::mutex statsMutex_; ///< Protects the stats handler from the readout and the writer.
+    std::mutex clientMutex_; ///< Serializes the messages that the threads send on the client, always locked last.
+    std::chrono::steady_clock::time_point nextShmChunkTime_; ///< When the broadcaster may send the next shm chunk.
+    std::string fileStatus_; ///< The file part of the status bar from the last time that the file was free.
+
+    // Back-pressure statistics for the spill buffers.
+    std::atomic<unsigned long> numSpillStalls_; ///< Number of times the readout had to wait for a free spill.
+    std::atomic<double> spillStallTime_; ///< Total time the readout waited for a free spill, in seconds.
+    std::atomic<size_t> maxSpillsInFlight_; ///< Most spills that were waiting on the disk or network at once.
+
     /// Print help dialogue for POLL options.
     void help();
 
@@ -228,11 +263,38 @@ private:
     int write_data(word_t *data, unsigned int nWords);
 
     /// Broadcast a data spill onto the network.
-    void broadcast_data(word_t *data, unsigned int nWords);
+    void broadcast_data(word_t *data, unsigned int nWords, const bool &shm);
+
+    /// Send a message on the client, the readout, writer and broadcaster threads all share the socket.
+    void SendToClient(char *message, const size_t &length);
 
     /// Broadcast a data spill onto the network in the classic pacman format.
     void broadcast_pac_data();
 
+    /// Returns a spill buffer for the readout to fill, waiting on the writer and broadcaster if every one is in use.
+    SpillBuffer *AcquireSpill();
+
+    /// Hands a filled spill buffer to the writer (if we're recording) and the broadcaster.
+    void SubmitSpill(SpillBuffer *spill, const bool &record);
+
+    /// Moves the spill buffers that the writer and broadcaster have finished with onto the free list.
+    void CollectSpills();
+
+    /// Waits until the writer and broadcaster have finished with every spill.
+    void DrainSpills();
+
+    /// Hands a spill back to the readout once the last thread that needs it is done.
+    void ReleaseSpill(SpillBuffer *spill, BoundedQueue<SpillBuffer*> *returns);
+
+    /// Loop run by the writer thread, writes spills to disk until it receives a NULL spill.
+    void WriteSpills();
+
+    /// Loop run by the broadcaster thread, broadcasts spills until it receives a NULL spill.
+    void BroadcastSpills();
+
+    /// Prints the back-pressure statistics for the spill buffers.
+    void PrintSpillStats();
+
     /// @brief Splits the arguments to pread and pwrite on a colon delimeter.
     /// @param[in] arg The argument to be split.
     /// @param[out] start The first value in the string indicating the first mod / ch.
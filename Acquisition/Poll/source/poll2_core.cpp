@@ -16,6 +16,7 @@
 */
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -179,7 +180,14 @@ Poll::Poll() :
         output_title("PIXIE data file"), // Set with 'title' command
         next_run_num(1), // Set with 'runnum' command
         output_format(0), // Set with 'oform' command
-        current_file_num(0)
+        current_file_num(0),
+        writerQueue_(NULL),
+        broadcasterQueue_(NULL),
+        writerReturns_(NULL),
+        broadcasterReturns_(NULL),
+        numSpillStalls_(0),
+        spillStallTime_(0),
+        maxSpillsInFlight_(0)
 {
     pif = new PixieInterface("pixie.cfg");
 
@@ -256,6 +264,26 @@ bool Poll::Initialize(){
     //Allocate an array of vectors to store partial events from the FIFO.
     partialEvents = new std::vector<word_t>[n_cards];
 
+    //Allocate the spill buffers up front, each one can hold a full FIFO from every module.
+    for (size_t i = 0; i < numSpillBuffers_; i++) {
+        SpillBuffer *spill = new SpillBuffer();
+        spill->data.resize((EXTERNAL_FIFO_LENGTH + 2) * n_cards);
+        spill->nWords = 0;
+        spill->consumers = 0;
+        spillBuffers_.push_back(spill);
+    }
+    freeSpills_ = spillBuffers_;
+
+    //The queues have room for every spill and the NULL spill that stops the threads, so pushing never waits.
+    writerQueue_ = new BoundedQueue<SpillBuffer*>(numSpillBuffers_ + 1);
+    broadcasterQueue_ = new BoundedQueue<SpillBuffer*>(numSpillBuffers_ + 1);
+    writerReturns_ = new BoundedQueue<SpillBuffer*>(numSpillBuffers_);
+    broadcasterReturns_ = new BoundedQueue<SpillBuffer*>(numSpillBuffers_);
+
+    //Start the threads that take the disk and network I/O off of the FIFO readout.
+    writerThread_ = std::thread(&Poll::WriteSpills, this);
+    broadcasterThread_ = std::thread(&Poll::BroadcastSpills, this);
+
     //Create a stats handler and set the interval.
     statsHandler = new StatsHandler(n_cards);
     statsHandler->SetDumpInterval(statsInterval_);
@@ -276,10 +304,32 @@ bool Poll::Close(){
     //We return if the class has not been initialized.
     if(!init){ return false; }
 
+    //Let the writer and broadcaster finish the spills that they have, then stop them.
+    DrainSpills();
+    SpillBuffer *stopSpill = NULL;
+    writerQueue_->Push(stopSpill);
+    broadcasterQueue_->Push(stopSpill);
+    writerThread_.join();
+    broadcasterThread_.join();
+
+    delete writerQueue_;
+    delete broadcasterQueue_;
+    delete writerReturns_;
+    delete broadcasterReturns_;
+    writerQueue_ = broadcasterQueue_ = writerReturns_ = broadcasterReturns_ = NULL;
+
+    for (size_t i = 0; i < spillBuffers_.size(); i++)
+        delete spillBuffers_[i];
+    spillBuffers_.clear();
+    freeSpills_.clear();
+
     //Send message to Cory's SHM that we are closing.
-    client->SendMessage((char *)"$KILL_SOCKET", 13);
+    SendToClient((char *)"$KILL_SOCKET", 13);
     //Close the UDP data / SHM port.
-    client->Close();
+    {
+        std::lock_guard<std::mutex> lock(clientMutex_);
+        client->Close();
+    }
 
     // Close any open files.
     if(output_file.IsOpen()) CloseOutputFile();
@@ -317,6 +367,7 @@ bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
 
     //Clear the stats
     if (!continueRun){
+        std::lock_guard<std::mutex> lock(statsMutex_);
         statsHandler->Clear();
         statsHandler->Dump();
     }
@@ -324,7 +375,7 @@ bool Poll::CloseOutputFile(const bool continueRun /*=false*/){
     output_file.CloseFile();
 
     //Broadcast to Cory's SHM that the file is now closed.
-    client->SendMessage((char *)"$CLOSE_FILE", 12);
+    SendToClient((char *)"$CLOSE_FILE", 12);
 
     //Set the flag that no file is open.
     file_open = false;
@@ -380,11 +431,14 @@ bool Poll::OpenOutputFile(bool continueRun){
     std::cout <<Display::OkayStr() <<std::endl;
     std::cout << "|- Filename: '" << output_file.GetCurrentFilename() << "'.\n";
 
-    //Clear the stats
-    statsHandler->Clear();
-    statsHandler->Dump();
+    //Clear the stats, the writer opens continuation files while the readout is adding to them.
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        statsHandler->Clear();
+        statsHandler->Dump();
+    }
 
-    client->SendMessage((char *)"$OPEN_FILE", 12);
+    SendToClient((char *)"$OPEN_FILE", 12);
 
     file_open = true;
 
@@ -441,12 +495,17 @@ int Poll::write_data(word_t *data, unsigned int nWords){
     return output_file.Write((char*)data, nWords);
 }
 
-void Poll::broadcast_data(word_t *data, unsigned int nWords) {
+/// The caller needs to hold the output file mutex when the spill is not broadcast in the shared-memory style since
+/// the notification describes the output file. The shared-memory chunks are paced to a fixed rate instead of being
+/// sent in one burst, the datagrams are dropped once the reader's receive buffer is full and it can't ask us to slow
+/// down. Only the broadcaster sends chunks, so it's the only one that waits.
+void Poll::broadcast_data(word_t *data, unsigned int nWords, const bool &shm) {
     // Maximum size of the shared memory buffer
     static const unsigned int maxShmSizeL = 4050; // in pixie words
-    static const unsigned int maxShmSize  = maxShmSizeL * sizeof(word_t); // in bytes
+    // The most that we send to the shared memory in a second, in bytes. A full chunk goes out every 162 us.
+    static const double maxShmRate = 100.e6;
 
-    if(shm_mode){ // Broadcast the spill onto the network using the new shm style
+    if(shm){ // Broadcast the spill onto the network using the new shm style
         int shm_data[maxShmSizeL+2]; // packets of data
         unsigned int num_net_chunks = nWords / maxShmSizeL;
         unsigned int num_net_remain = nWords % maxShmSizeL;
@@ -459,29 +518,134 @@ void Poll::broadcast_data(word_t *data, unsigned int nWords) {
                       << " chunks (fragment = " << num_net_remain << " words)\n";
 
         while(words_bcast < nWords){
-            if(nWords - words_bcast > maxShmSizeL){ // Broadcast the spill chunks
-                memcpy(&shm_data[0], &net_chunk, 4);
-                memcpy(&shm_data[1], &num_net_chunks, 4);
-                memcpy(&shm_data[2], &data[words_bcast], maxShmSize);
-                client->SendMessage((char *)shm_data, maxShmSize+8);
-                words_bcast += maxShmSizeL;
-            }
-            else{ // Broadcast the spill remainder
-                memcpy(&shm_data[0], &net_chunk, 4);
-                memcpy(&shm_data[1], &num_net_chunks, 4);
-                memcpy(&shm_data[2], &data[words_bcast], (nWords-words_bcast)*4);
-                client->SendMessage((char *)shm_data, (nWords - words_bcast + 2)*4);
-                words_bcast += nWords-words_bcast;
-            }
-            usleep(1);
+            unsigned int chunkWords = std::min(nWords - words_bcast, maxShmSizeL);
+            memcpy(&shm_data[0], &net_chunk, 4);
+            memcpy(&shm_data[1], &num_net_chunks, 4);
+            memcpy(&shm_data[2], &data[words_bcast], chunkWords * 4);
+
+            // We only wait if we're ahead of the rate, a broadcaster that fell behind doesn't get to send a burst.
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (nextShmChunkTime_ > now)
+                std::this_thread::sleep_until(nextShmChunkTime_);
+            else
+                nextShmChunkTime_ = now;
+            nextShmChunkTime_ += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>((chunkWords + 2) * 4 / maxShmRate));
+
+            SendToClient((char *)shm_data, (chunkWords + 2) * 4);
+            words_bcast += chunkWords;
             net_chunk++;
         }
     }
     else{ // Broadcast a spill notification to the network
+        std::lock_guard<std::mutex> lock(clientMutex_);
         output_file.SendPacket(client);
     }
 }
 
+void Poll::SendToClient(char *message, const size_t &length) {
+    std::lock_guard<std::mutex> lock(clientMutex_);
+    client->SendMessage(message, length);
+}
+
+SpillBuffer *Poll::AcquireSpill() {
+    CollectSpills();
+
+    if (freeSpills_.empty()) {
+        //Every spill is still waiting on the disk or the network. The FIFOs keep filling while we wait here, so
+        // this is the back-pressure that we want to keep an eye on.
+        numSpillStalls_++;
+        double waitStart = usGetTime(0);
+        while (freeSpills_.empty()) {
+            usleep(50);
+            CollectSpills();
+        }
+        spillStallTime_ = spillStallTime_ + usGetTime(waitStart) * 1e-6;
+    }
+
+    SpillBuffer *spill = freeSpills_.back();
+    freeSpills_.pop_back();
+    return spill;
+}
+
+void Poll::SubmitSpill(SpillBuffer *spill, const bool &record) {
+    spill->recorded = record;
+    spill->shmMode = shm_mode;
+
+    //When we're recording without shm the writer sends the notification once the spill is in the file.
+    bool broadcast = spill->shmMode || !record;
+    spill->consumers = (record ? 1 : 0) + (broadcast ? 1 : 0);
+
+    if (record)
+        writerQueue_->Push(spill);
+    if (broadcast)
+        broadcasterQueue_->Push(spill);
+
+    size_t inFlight = spillBuffers_.size() - freeSpills_.size();
+    if (inFlight > maxSpillsInFlight_)
+        maxSpillsInFlight_ = inFlight;
+}
+
+void Poll::CollectSpills() {
+    SpillBuffer *spill;
+    while (writerReturns_->TryPop(spill))
+        freeSpills_.push_back(spill);
+    while (broadcasterReturns_->TryPop(spill))
+        freeSpills_.push_back(spill);
+}
+
+void Poll::DrainSpills() {
+    CollectSpills();
+    while (freeSpills_.size() < spillBuffers_.size()) {
+        usleep(50);
+        CollectSpills();
+    }
+}
+
+void Poll::ReleaseSpill(SpillBuffer *spill, BoundedQueue<SpillBuffer*> *returns) {
+    if (spill->consumers.fetch_sub(1) == 1)
+        returns->Push(spill);
+}
+
+void Poll::WriteSpills() {
+    SpillBuffer *spill = NULL;
+    while (true) {
+        writerQueue_->Pop(spill);
+        if (!spill)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(outputFileMutex_);
+            write_data(&spill->data[0], spill->nWords);
+            if (!spill->shmMode)
+                broadcast_data(&spill->data[0], spill->nWords, false);
+        }
+        ReleaseSpill(spill, writerReturns_);
+    }
+}
+
+void Poll::BroadcastSpills() {
+    SpillBuffer *spill = NULL;
+    while (true) {
+        broadcasterQueue_->Pop(spill);
+        if (!spill)
+            return;
+
+        if (spill->shmMode)
+            broadcast_data(&spill->data[0], spill->nWords, true);
+        else {
+            std::lock_guard<std::mutex> lock(outputFileMutex_);
+            broadcast_data(&spill->data[0], spill->nWords, false);
+        }
+        ReleaseSpill(spill, broadcasterReturns_);
+    }
+}
+
+void Poll::PrintSpillStats() {
+    std::cout << sys_message_head << "Spill buffers: " << maxSpillsInFlight_ << "/" << numSpillBuffers_
+              << " in use at most, readout waited " << numSpillStalls_ << " times for " << spillStallTime_ << " s.\n";
+}
+
 /* Print help dialogue for POLL options. */
 void Poll::help(){
     std::cout << "  Help:\n";
@@ -614,6 +778,8 @@ void Poll::show_status(){
     std::cout << "   Force Spill     - " << StringManipulation::BoolToString(force_spill) << std::endl;
     std::cout << "   Do MCA run      - " << StringManipulation::BoolToString(do_MCA_run) << std::endl;
     std::cout << "   Run ctrl Exited - " << StringManipulation::BoolToString(run_ctrl_exit) << std::endl;
+    std::cout << "   Spill stalls    - " << numSpillStalls_ << " (" << spillStallTime_ << " s, " << maxSpillsInFlight_
+              << "/" << numSpillBuffers_ << " buffers in use at most)" << std::endl;
 
     std::cout << "\n  Poll Options:\n";
     std::cout << "   Boot fast   - " << StringManipulation::BoolToString(boot_fast) << std::endl;
@@ -1509,6 +1675,9 @@ void Poll::RunControl(){
                     acq_running = true;
                     startTime = usGetTime(0);
                     lastSpillTime = 0;
+                    numSpillStalls_ = 0;
+                    spillStallTime_ = 0;
+                    maxSpillsInFlight_ = 0;
                 }
                 else{
                     std::cout << sys_message_head << "Failed to start list mode run. Try rebooting PIXIE\n";
@@ -1579,6 +1748,10 @@ void Poll::RunControl(){
                 statsHandler->Dump();
                 statsHandler->ClearTotals();
 
+                //The writer and broadcaster need to finish the last spills before the file is closed.
+                DrainSpills();
+                PrintSpillStats();
+
                 //Close the output file
                 if(output_file.IsOpen()) CloseOutputFile();
 
@@ -1623,11 +1796,18 @@ void Poll::UpdateStatus() {
     }
 
     if (file_open) {
-        if (acq_running && !record_data) status << TermColors::DkYellow;
-        //Add file size to status
-        status << " " << StringManipulation::FormatHumanReadableSizes(output_file.GetFilesize());
-        status << " " << output_file.GetCurrentFilename();
-        if (acq_running && !record_data) status << TermColors::Reset;
+        //We don't wait on the writer here since that would hold up the readout, instead we show what we had last.
+        std::unique_lock<std::mutex> lock(outputFileMutex_, std::try_to_lock);
+        if (lock.owns_lock()) {
+            std::stringstream fileStatus;
+            if (acq_running && !record_data) fileStatus << TermColors::DkYellow;
+            //Add file size to status
+            fileStatus << " " << StringManipulation::FormatHumanReadableSizes(output_file.GetFilesize());
+            fileStatus << " " << output_file.GetCurrentFilename();
+            if (acq_running && !record_data) fileStatus << TermColors::Reset;
+            fileStatus_ = fileStatus.str();
+        }
+        status << fileStatus_;
     }
 
     //Update the status bar
@@ -1651,8 +1831,6 @@ void Poll::ReadScalers() {
     }
 }
 bool Poll::ReadFIFO() {
-    static word_t *fifoData = new word_t[(EXTERNAL_FIFO_LENGTH + 2) * n_cards];
-
     if (!acq_running) return false;
 
     //Number of words in the FIFO of each module.
@@ -1677,6 +1855,13 @@ bool Poll::ReadFIFO() {
         //Number of data words read from the FIFO
         size_t dataWords = 0;
 
+        //The spill is read straight into a buffer that is handed to the writer and broadcaster when we're done.
+        SpillBuffer *spill = AcquireSpill();
+        word_t *fifoData = &spill->data[0];
+
+        //The writer clears the stats when it opens a continuation file, so we hold them while we fill them.
+        std::unique_lock<std::mutex> statsLock(statsMutex_);
+
         //Loop over each module's FIFO
         for (unsigned short mod=0;mod < n_cards; mod++) {
 
@@ -1703,6 +1888,7 @@ bool Poll::ReadFIFO() {
                           << EXTERNAL_FIFO_LENGTH << Display::ErrorStr(" ABORTING!") << std::endl;
                 had_error = true;
                 do_stop_acq = true;
+                freeSpills_.push_back(spill);
                 return false;
             }
 
@@ -1720,6 +1906,7 @@ bool Poll::ReadFIFO() {
                 std::cout << Display::ErrorStr() << " Unable to read " << nWords[mod] << " from module " << mod << "\n";
                 had_error = true;
                 do_stop_acq = true;
+                freeSpills_.push_back(spill);
                 return false;
             }
 
@@ -1847,6 +2034,7 @@ bool Poll::ReadFIFO() {
 
                 do_stop_acq = true;
                 had_error = true;
+                freeSpills_.push_back(spill);
                 return false;
             }
 
@@ -1868,13 +2056,13 @@ bool Poll::ReadFIFO() {
             statsHandler->Dump();
             statsHandler->ClearRates();
         }
+        statsLock.unlock();
 
         if (!is_quiet || debug_mode)
             std::cout << "Writing/Broadcasting " << dataWords << " words.\n";
-        //We have read the FIFO now we write the data
-        if (record_data)
-            write_data(fifoData, dataWords);
-        broadcast_data(fifoData, dataWords);
+        //We have read the FIFO now we hand the data to the writer and broadcaster threads.
+        spill->nWords = dataWords;
+        SubmitSpill(spill, record_data);
 
     } //If we had exceeded the threshold or forced a flush
 
@@ -71,11 +71,11 @@ public:
     unsigned int GetTrigger(void) { return (trigs_[0]); }
 
     /** \return The trigger filter */
-    std::vector<double> GetTriggerFilter(void) { return (trigFilter_); }
+    const std::vector<double> &GetTriggerFilter(void) const { return (trigFilter_); }
 
     /** \return The list of energies that were found if we chose to analyze
      * pileup events. */
-    std::vector<double> GetEnergies(void) { return (en_); }
+    const std::vector<double> &GetEnergies(void) const { return (en_); }
 
     /** There will be three coefficients per identified trigger if we chose to
      * analyze pileups. This means the first three elements belong to the first 
@@ -89,10 +89,10 @@ public:
      * trigger, the next three to the second trigger, etc. The size will always 
      * be 3*NumTriggers.
      *  \return The list of energy filter coefficients.  */
-    std::vector<double> GetEnergySums(void) { return (esums_); }
+    const std::vector<double> &GetEnergySums(void) const { return (esums_); }
 
     /** \return List of the triggers found in the trace.*/
-    std::vector<unsigned int> GetTriggers(void) { return (trigs_); }
+    const std::vector<unsigned int> &GetTriggers(void) const { return (trigs_); }
 
     /** This will always have 6 elements. If analyzing pileups it will be the
      * limits for the last identified pileup. 
@@ -108,6 +108,16 @@ public:
         ConvertToClockticks();
     }
 
+    /** Sets both sets of filter parameters, they are converted to clockticks the next time that we filter a trace.
+     * This lets us reuse a single filter, and its memory, for traces from every channel.
+     * \param [in] tFilt : the trigger (fast) filter parameters in ns
+     * \param [in] eFilt : the energy (slow) filter parameters in ns */
+    void SetFilterParameters(const TrapFilterParameters &tFilt, const TrapFilterParameters &eFilt) {
+        t_ = tFilt;
+        e_ = eFilt;
+        isConverted_ = false;
+    }
+
     /** Sets the trace that we are going to use to filter */
     void SetSig(const Trace *sig) { sig_ = sig; }
 
@@ -143,6 +153,7 @@ private:
     std::vector<double> coeffs_; //!< the calculated energy coefficients
     std::vector<double> trigFilter_; //!< the calculated trigger filter
     std::vector<double> esums_; //!< the caluclated energy sums
+    std::vector<double> runningSum_; //!< runningSum_[i] is the sum of the first i samples in the trace
 
     std::vector<unsigned int> limits_; //!< the limits for the energy filter
     std::vector<unsigned int> trigs_; //!< the identified triggers
@@ -151,9 +162,17 @@ private:
     void CalcEnergyFilterCoeffs(void); //!< calculates energy filter coeffs
     void CalcEnergyFilterLimits(const unsigned int &tpos); //!< calc energy filter limits
     void CalcEnergyFilter(void); //!< calculate the energy filter
+    void CalcRunningSum(void); //!< calculates the running sum of the trace
     void CalcTriggerFilter(void); //!< calculate trigger filter
     void ConvertToClockticks(void); //!< convert from ns to clockticks
     void Reset(void); //!< Reset values for repeated calls. 
+
+    /** \return The sum of the samples in the range [low, high), 0 if the range is empty.
+     * \param [in] low : The first sample in the sum
+     * \param [in] high : One past the last sample in the sum */
+    double Sum(const unsigned int &low, const unsigned int &high) const {
+        return high > low ? runningSum_[high] - runningSum_[low] : 0.0;
+    }
 };
 
 #endif //__TRACEFILTER_HPP__
@@ -9,12 +9,17 @@
 #include <iomanip>
 #include <iostream>
 
-ChannelConfiguration::ChannelConfiguration() : location_(9999), subtype_(""), type_("") {}
+ChannelConfiguration::ChannelConfiguration() : baselineThreshold_(0), discriminationStartInSamples_(0), location_(9999),
+                                               subtype_(""), traceDelayInSamples_(0), type_(""),
+                                               waveformBoundsInSeconds_(0, 0) {}
 
 ChannelConfiguration::~ChannelConfiguration() = default;
 
 ChannelConfiguration::ChannelConfiguration(const std::string &atype, const std::string &subType,
-                                           const unsigned int &loc) : location_(loc), subtype_(subType), type_(atype) {}
+                                           const unsigned int &loc) : baselineThreshold_(0),
+                                                                      discriminationStartInSamples_(0), location_(loc),
+                                                                      subtype_(subType), traceDelayInSamples_(0),
+                                                                      type_(atype), waveformBoundsInSeconds_(0, 0) {}
 
 void ChannelConfiguration::AddTag(const std::string &s) { tags_.insert(s); }
 
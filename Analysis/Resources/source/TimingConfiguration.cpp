@@ -7,7 +7,8 @@
 
 #include "TimingConfiguration.hpp"
 
-TimingConfiguration::TimingConfiguration() : isFastSiPm_(false) {}
+TimingConfiguration::TimingConfiguration() : beta_(0), delay_(0), fraction_(0), gamma_(0), gap_(0), isFastSiPm_(false),
+                                             length_(0), qdc_(0) {}
 
 TimingConfiguration::~TimingConfiguration() = default;
 
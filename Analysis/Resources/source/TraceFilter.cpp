@@ -45,6 +45,7 @@ TraceFilter::TraceFilter(const unsigned int &adc, const TrapFilterParameters &tF
     nsPerSample_ = adc;
     isVerbose_ = verbose;
     analyzePileup_ = analyzePileup;
+    isConverted_ = false;
 }
 
 void TraceFilter::CalcBaseline(void) {
@@ -54,9 +55,7 @@ void TraceFilter::CalcBaseline(void) {
     if (offset < 0)
         throw (EARLY_TRIG);
 
-    for (unsigned int i = 0; i < (unsigned int) offset; i++)
-        baseline_ += sig_->at(i);
-    baseline_ /= offset;
+    baseline_ = Sum(0, offset) / offset;
 
     if (isVerbose_)
         cout << "********** CalcBaseline **********" << endl
@@ -71,6 +70,7 @@ unsigned int TraceFilter::CalcFilters(const Trace *sig) {
 
         if (!isConverted_)
             ConvertToClockticks();
+        CalcRunningSum();
         CalcTriggerFilter();
         CalcBaseline();
         CalcEnergyFilterCoeffs();
@@ -113,14 +113,9 @@ unsigned int TraceFilter::CalcFilters(const Trace *sig) {
 }
 
 void TraceFilter::CalcEnergyFilter(void) {
-    double partA = 0, partB = 0, partC = 0;
-
-    for (unsigned int i = limits_[0]; i < limits_[1]; i++)
-        partA += sig_->at(i);
-    for (unsigned int i = limits_[2]; i < limits_[3]; i++)
-        partB += sig_->at(i);
-    for (unsigned int i = limits_[4]; i < limits_[5]; i++)
-        partC += sig_->at(i);
+    double partA = Sum(limits_[0], limits_[1]);
+    double partB = Sum(limits_[2], limits_[3]);
+    double partC = Sum(limits_[4], limits_[5]);
     esums_.push_back(partA);
     esums_.push_back(partB);
     esums_.push_back(partC);
@@ -186,33 +181,41 @@ void TraceFilter::CalcEnergyFilterLimits(const unsigned int &tpos) {
     limits_.push_back(p5);      // end of sum E1
 }
 
+/// The trace holds integers, so the running sum is exact and every window sum is exactly what we'd get by adding up
+/// the samples one at a time.
+void TraceFilter::CalcRunningSum(void) {
+    runningSum_.resize(sig_->size() + 1);
+    runningSum_[0] = 0.0;
+    for (unsigned int i = 0; i < sig_->size(); i++)
+        runningSum_[i + 1] = runningSum_[i] + (*sig_)[i];
+}
+
+/// The filter is calculated in one pass and searched for triggers in a second. The iterations of the first pass are
+/// independent of each other, so the compiler is free to vectorize it.
 void TraceFilter::CalcTriggerFilter(void) {
     bool hasRecrossed = false;
 
     int l = t_.GetRisetime(), g = t_.GetFlattop();
-    for (int i = 0; i < (int) sig_->size(); i++) {
-        double sum1 = 0, sum2 = 0;
-        if ((i - 2 * l - g + 1) >= 0) {
-            for (int a = i - 2 * l - g + 1; a < i - l - g + 1; a++)
-                sum1 += sig_->at(a);
-            for (int a = i - l + 1; a < i + 1; a++)
-                sum2 += sig_->at(a);
-
-            if ((sum2 - sum1) / l >= t_.GetT()) {
-                if (trigs_.size() == 0)
-                    trigs_.push_back(i);
-                if (hasRecrossed) {
-                    trigs_.push_back(i);
-                    hasRecrossed = false;
-                }
-            } else {
-                if (trigs_.size() != 0)
-                    hasRecrossed = true;
+    int size = sig_->size();
+    int start = max(2 * l + g - 1, 0);
+
+    trigFilter_.assign(size, 0.0);
+    const double *sum = runningSum_.data();
+    for (int i = start; i < size; i++)
+        trigFilter_[i] = ((sum[i + 1] - sum[i - l + 1]) - (sum[i - l - g + 1] - sum[i - 2 * l - g + 1])) / l;
+
+    for (int i = start; i < size; i++) {
+        if (trigFilter_[i] >= t_.GetT()) {
+            if (trigs_.size() == 0)
+                trigs_.push_back(i);
+            if (hasRecrossed) {
+                trigs_.push_back(i);
+                hasRecrossed = false;
             }
-
-            trigFilter_.push_back((sum2 - sum1) / l);
-        } else
-            trigFilter_.push_back(0.0);
+        } else {
+            if (trigs_.size() != 0)
+                hasRecrossed = true;
+        }
     }
 
     if (trigs_.size() == 0)
@@ -287,4 +290,6 @@ void TraceFilter::Reset(void) {
     trigFilter_.clear();
     trigs_.clear();
     limits_.clear();
+    coeffs_.clear();
+    esums_.clear();
 }
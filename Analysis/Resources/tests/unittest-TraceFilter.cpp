@@ -0,0 +1,129 @@
+///@file unittest-TraceFilter.cpp
+///@brief Checks that the running sum filters match summing every window directly, and times them.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include "TraceFilter.hpp"
+
+#include "HelperFunctions.hpp"
+
+#include <UnitTest++.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+namespace unittest_trace_filter {
+    static const unsigned int nsPerSample = 4;
+    static const unsigned int baseline = 400;
+    ///The trigger filter parameters in ns, which are 10 and 5 samples respectively.
+    static const TrapFilterParameters triggerParameters(40, 20, 50);
+    ///The energy filter parameters in ns, which are 100 and 25 samples respectively.
+    static const TrapFilterParameters energyParameters(400, 100, 200);
+    static const int triggerRisetime = 10;
+    static const int triggerFlattop = 5;
+    ///Shorter energy filter parameters in ns, 50 and 10 samples, so that the filter fits in our shortest traces.
+    static const TrapFilterParameters benchmarkEnergyParameters(200, 40, 200);
+
+    ///@return A trace with a pulse at every one of the provided positions
+    ///@param[in] size : The number of samples in the trace
+    ///@param[in] positions : The samples where the pulses start
+    Trace MakeTrace(const unsigned int &size, const vector<unsigned int> &positions) {
+        Trace trace;
+        for (unsigned int i = 0; i < size; i++) {
+            double value = baseline;
+            for (auto position : positions)
+                if (i >= position)
+                    value += 2000 * exp(-double(i - position) / 50.);
+            trace.push_back((unsigned int) value);
+        }
+        return trace;
+    }
+
+    ///The trigger filter as it was calculated before we switched to running sums.
+    vector<double> DirectTriggerFilter(const Trace &trace, const int &l, const int &g) {
+        vector<double> filter;
+        for (int i = 0; i < (int) trace.size(); i++) {
+            double sum1 = 0, sum2 = 0;
+            if ((i - 2 * l - g + 1) >= 0) {
+                for (int a = i - 2 * l - g + 1; a < i - l - g + 1; a++)
+                    sum1 += trace.at(a);
+                for (int a = i - l + 1; a < i + 1; a++)
+                    sum2 += trace.at(a);
+                filter.push_back((sum2 - sum1) / l);
+            } else
+                filter.push_back(0.0);
+        }
+        return filter;
+    }
+
+    ///@return The sum of the samples in [low, high) added one at a time.
+    double DirectSum(const Trace &trace, const unsigned int &low, const unsigned int &high) {
+        double sum = 0;
+        for (unsigned int i = low; i < high; i++)
+            sum += trace.at(i);
+        return sum;
+    }
+}
+
+using namespace unittest_trace_filter;
+
+TEST(TestFiltersMatchDirectSums) {
+    Trace trace = MakeTrace(1000, {300, 600});
+    TraceFilter filter(nsPerSample, triggerParameters, energyParameters, true);
+    CHECK_EQUAL(0u, filter.CalcFilters(&trace));
+
+    vector<double> expected = DirectTriggerFilter(trace, triggerRisetime, triggerFlattop);
+    CHECK_EQUAL(expected.size(), filter.GetTriggerFilter().size());
+    CHECK_ARRAY_EQUAL(expected, filter.GetTriggerFilter(), expected.size());
+
+    CHECK_EQUAL(2u, filter.GetNumTriggers());
+
+    unsigned int baselineEnd = filter.GetTrigger() - triggerRisetime - 5;
+    CHECK_EQUAL(DirectSum(trace, 0, baselineEnd) / baselineEnd, filter.GetBaseline());
+
+    //The limits are for the last trigger, whose sums are the last three.
+    vector<unsigned int> limits = filter.GetEnergySumLimits();
+    vector<double> sums = filter.GetEnergySums();
+    CHECK_EQUAL(6u, sums.size());
+    CHECK_EQUAL(DirectSum(trace, limits[0], limits[1]), sums[3]);
+    CHECK_EQUAL(DirectSum(trace, limits[2], limits[3]), sums[4]);
+    CHECK_EQUAL(DirectSum(trace, limits[4], limits[5]), sums[5]);
+}
+
+///Times the filters over the trace lengths that we typically record. We only print the timing since it depends on
+/// the machine.
+TEST(BenchmarkFilters) {
+    static const unsigned int numTraces = 2000;
+    static const vector<unsigned int> lengths = {250, 500, 1000, 2000, 4000};
+
+    for (auto length : lengths) {
+        Trace trace = MakeTrace(length, {length / 2});
+        vector<double> data(trace.begin(), trace.end());
+
+        auto start = chrono::steady_clock::now();
+        unsigned int retval = 0;
+        for (unsigned int i = 0; i < numTraces; i++) {
+            TraceFilter filter(nsPerSample, triggerParameters, benchmarkEnergyParameters);
+            retval += filter.CalcFilters(&trace);
+        }
+        chrono::duration<double> traceFilterTime = chrono::steady_clock::now() - start;
+        CHECK_EQUAL(0u, retval);
+
+        start = chrono::steady_clock::now();
+        double checksum = 0;
+        for (unsigned int i = 0; i < numTraces; i++)
+            checksum += Filtering::TrapezoidalFilter(data, 50, 10).back();
+        chrono::duration<double> trapezoidalTime = chrono::steady_clock::now() - start;
+        CHECK(!std::isnan(checksum));
+
+        cout << "BenchmarkFilters - " << length << " samples : TraceFilter::CalcFilters "
+             << traceFilterTime.count() / numTraces * 1e6 << " us/trace, Filtering::TrapezoidalFilter "
+             << trapezoidalTime.count() / numTraces * 1e6 << " us/trace" << endl;
+    }
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
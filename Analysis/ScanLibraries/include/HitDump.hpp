@@ -0,0 +1,137 @@
+///@file HitDump.hpp
+///@brief Writes the hits in the built raw events to a compact columnar file and reads them back.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef PIXIESUITE_HITDUMP_HPP
+#define PIXIESUITE_HITDUMP_HPP
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "XiaData.hpp"
+
+///The hits from a run of raw events, kept as one vector per quantity. Every vector except the samples has one entry
+/// for each hit. The hits from an event are next to each other and share an event number, and an event is never
+/// split between two chunks. The traces of all of the hits are packed one after the other into the samples.
+struct HitDumpChunk {
+    ///Bits that are set in the flags of a hit.
+    enum HitFlags {
+        PILEUP = 0x1, ///< The module flagged the hit as pileup
+        SATURATED = 0x2, ///< The trace went out of the ADC's range
+        CFD_FORCED_TRIGGER = 0x4, ///< The CFD was forced to trigger
+        CFD_TRIGGER_SOURCE = 0x70 ///< The bits holding the CFD trigger source, shifted up by cfdTriggerSourceShift
+    };
+
+    ///The shift of the CFD trigger source in the flags, it's three bits wide at 500 MS/s.
+    static const unsigned int cfdTriggerSourceShift = 4;
+
+    ///@return The number of hits in the chunk
+    size_t GetNumberOfHits() const { return eventNumber.size(); }
+
+    ///Empties the chunk, the vectors keep their capacity so that the chunk can be reused.
+    void Clear();
+
+    ///Appends a hit to the chunk.
+    ///@param[in] hit : The hit to add
+    ///@param[in] event : The number of the raw event that the hit was built into
+    ///@param[in] keepTrace : True if the trace of the hit is added to the samples
+    void Add(const XiaData &hit, const unsigned long long &event, const bool &keepTrace);
+
+    std::vector<unsigned long long> eventNumber; ///< The raw event that the hit belongs to, counted from zero
+    std::vector<unsigned char> crate; ///< The crate number
+    std::vector<unsigned char> module; ///< The module number
+    std::vector<unsigned char> channel; ///< The channel number
+    std::vector<unsigned long long> timestamp; ///< The 48-bit timestamp in clock ticks
+    std::vector<double> time; ///< The time including the CFD correction in ADC samples
+    std::vector<double> energy; ///< The energy from the on-board filter
+    std::vector<unsigned int> cfdFraction; ///< The raw CFD fractional time
+    std::vector<unsigned char> flags; ///< The HitFlags of the hit
+    std::vector<unsigned int> traceLength; ///< The number of samples in the trace, zero if it wasn't kept
+    std::vector<unsigned long long> traceOffset; ///< The index of the first sample of the trace in the samples
+    std::vector<unsigned short> samples; ///< The samples of all of the traces that were kept
+};
+
+///Writes the hits of the raw events into a file as they're built. The hits are collected into chunks of a fixed
+/// size and every chunk is written column by column, so a reader only touches the quantities that it wants and
+/// can read the file far faster than the list mode data can be decoded again. The file starts with a magic number,
+/// the version and a word of flags, each chunk starts with a magic number, the number of hits and the number of
+/// samples. The numbers are written in the byte order of the machine, like the spill index.
+class HitDumpWriter {
+public:
+    ///The number of hits that are collected before a chunk is written.
+    static const unsigned int defaultChunkSize = 65536;
+
+    ///Default constructor
+    HitDumpWriter();
+
+    ///Default destructor, writes whatever is left and closes the file.
+    ~HitDumpWriter() { Close(); }
+
+    ///Creates the file, anything that was in it is lost.
+    ///@param[in] filename : The name of the file to write
+    ///@param[in] keepTraces : True if the traces are written with the hits
+    ///@param[in] chunkSize : The number of hits after which a chunk is written
+    ///@return True if the file was opened and the header was written
+    bool Open(const std::string &filename, const bool &keepTraces, const unsigned int &chunkSize = defaultChunkSize);
+
+    ///@return True if we're writing a file
+    bool IsOpen() const { return file_.is_open(); }
+
+    ///@return True if the traces are written with the hits
+    bool KeepsTraces() const { return keepTraces_; }
+
+    ///Adds the hits from a raw event. They go to the file once the chunk fills up.
+    ///@param[in] event : The hits in the event
+    void Add(const std::deque<XiaData *> &event);
+
+    ///Writes the last chunk and closes the file.
+    void Close();
+
+    ///@return The number of events that have been added
+    unsigned long long GetNumberOfEvents() const { return numEvents_; }
+
+    ///@return The number of hits that have been added
+    unsigned long long GetNumberOfHits() const { return numHits_; }
+
+private:
+    std::ofstream file_; ///< The file that we're writing
+    HitDumpChunk chunk_; ///< The hits that haven't been written yet
+    bool keepTraces_; ///< True if the traces are written
+    unsigned int chunkSize_; ///< The number of hits after which a chunk is written
+    unsigned long long numEvents_; ///< The number of events that have been added
+    unsigned long long numHits_; ///< The number of hits that have been added
+
+    ///Writes the chunk to the file and empties it.
+    void WriteChunk();
+};
+
+///Reads the chunks back from a file written by HitDumpWriter.
+class HitDumpReader {
+public:
+    ///Default constructor
+    HitDumpReader() : hasTraces_(false) {}
+
+    ///Default destructor
+    ~HitDumpReader() {}
+
+    ///Opens the file and checks its header.
+    ///@param[in] filename : The name of the file to read
+    ///@return True if the file is a hit dump that we know how to read
+    bool Open(const std::string &filename);
+
+    ///@return True if the traces were written with the hits
+    bool HasTraces() const { return hasTraces_; }
+
+    ///Reads the next chunk in the file. The trace offsets are worked out from the trace lengths.
+    ///@param[out] chunk : The chunk that's filled, anything that was in it is cleared first
+    ///@return False if there are no more chunks or the chunk couldn't be read
+    bool ReadChunk(HitDumpChunk &chunk);
+
+private:
+    std::ifstream file_; ///< The file that we're reading
+    bool hasTraces_; ///< True if the traces were written with the hits
+};
+
+#endif //PIXIESUITE_HITDUMP_HPP
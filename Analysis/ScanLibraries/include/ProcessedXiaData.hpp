@@ -29,6 +29,18 @@ public:
     /// Default Destructor.
     ~ProcessedXiaData() {}
 
+    ///Takes the values of the event along with its energy sums, QDCs and trace without copying them. Everything that
+    /// we had from a previous hit is cleared, and the event is left with our old storage so that it can reuse it.
+    ///@param[in,out] evt : The event that we take the values from.
+    void Adopt(XiaData &evt) {
+        XiaData::Adopt(evt);
+        trace_.Reset();
+        MoveTraceInto(trace_);
+        trace_.SetIsSaturated(IsSaturated());
+        isIgnored_ = isValidData_ = false;
+        calibratedEnergy_ = highResTimeInNs_ = walkCorrectedTime_ = 0;
+    }
+
     ///@return The calibrated energy for the channel
     double GetCalibratedEnergy() const { return calibratedEnergy_; }
 
@@ -22,6 +22,8 @@
 #include <getopt.h>
 
 #include "hribf_buffers.h"
+#include "MappedFile.h"
+#include "SpillIndex.h"
 #include "XiaData.hpp"
 
 #define SCAN_VERSION "1.2.29"
@@ -127,6 +129,16 @@ public:
     /// Return a pointer to a fileInformation object used to store file header info.
     fileInformation *GetFileInfo() { return &finfo; }
 
+    /** Builds the table of every command line option known to the scan, including the ones added by the derived
+      * class, so that it can be parsed by others before Setup is called.
+      * \param[out] shortOptions The short options in the form that getopt_long expects them.
+      * \return The long options, ending with the empty option that getopt_long needs.
+      */
+    const std::vector<option> &GetOptionTable(std::string &shortOptions);
+
+    /// @return True if the user asked to start part way through the run with --spill or --start-time.
+    bool IsStartingPartWay() const { return first_spill > 0 || start_time > 0; }
+
     /// Set the header string used to prefix output messages.
     void SetProgramName(const std::string &head_) {
         progName = head_;
@@ -188,6 +200,13 @@ protected:
       */
     void AddOption(optionExt opt_);
 
+    /** Look up one of the options that was added with AddOption, so that the derived class doesn't depend on the
+      * order that they were added in.
+      * \param[in]  name_ The long name of the option.
+      * \return The option. Throws invalid_argument if no option has that name.
+      */
+    const optionExt &GetUserOption(const std::string &name_) const;
+
     /** ExtraCommands is used to send command strings to classes derived
       * from ScanInterface. If ScanInterface receives an unrecognized
       * command from the user, it will pass it on to the derived class.
@@ -291,6 +310,17 @@ private:
     unsigned long num_spills_recvd; /// The total number of good spills received from either the input file or shared memory.
     unsigned long file_start_offset; /// The first word in the file at which to start scanning.
 
+    long long first_spill; /// The first spill to scan, counted from zero, or -1 to not select by spill.
+    long long last_spill; /// The last spill to scan, or -1 to only scan the first one.
+    double start_time; /// Scan from this many seconds after the first event in the run, negative if not set.
+    double stop_time; /// Stop scanning this many seconds after the first event in the run, negative if not set.
+    double clock_tick; /// The length of a clock tick in the event times, in seconds.
+    unsigned long warmup_spills; /// The number of spills before the selected ones that are scanned to rebuild state.
+    unsigned long warmup_remaining; /// The number of warm-up spills that are left to scan.
+    bool is_warming_up; /// Set to true while the warm-up spills are being scanned.
+    long long spills_remaining; /// The number of selected spills that are left to scan, or -1 to scan everything.
+    unsigned long spills_to_skip; /// Full spills that are read after seeking but come before the selected ones.
+
     bool write_counts; /// Set to true if raw channel counts are to be written to file.
 
     bool total_stopped; /// Set to true if when the scan finishes.
@@ -301,6 +331,7 @@ private:
     bool shm_mode; /// Set to true if shared memory mode is to be used.
     bool batch_mode; /// Set to true if the program is to be run with no interactive command line.
     bool file_open; /// Set to true when an input binary file is successfully opened for reading.
+    bool mmap_mode; /// Set to true if pld files are to be mapped into memory and unpacked in place.
 
     bool kill_all; /// Set to true when user has sent kill command.
     bool run_ctrl_exit; /// Set to true when run control thread has exited.
@@ -309,6 +340,8 @@ private:
 
     std::ifstream input_file; /// Main input binary data file.
     std::streampos file_length; /// Main input file length (in bytes).
+    MappedFile mapped_file; /// The input file mapped into memory when mmap_mode is set.
+    SpillIndex spill_index; /// The spill index for the input file, loaded when spills or times are selected.
 
     fileInformation finfo; /// Data structure for storing binary file header information.
 
@@ -336,6 +369,19 @@ private:
     /// Open a new binary input file for reading.
     bool open_input_file(const std::string &fname_);
 
+    /// Load the spill index for the input file and seek to the first spill that was selected on the command line.
+    bool select_spills(const std::string &fname_);
+
+    /** Count a full spill that was just read against the selection. The derived class is notified with
+      * "WARMUP_DONE" before the first spill after the warm-up spills is unpacked, by then every warm-up event,
+      * including the ones carried over to the next spill, has been processed.
+      * \return True if the spill comes before the selected spills and should not be unpacked.
+      */
+    bool skip_spill();
+
+    /// Scan the spills of a pld file that has been mapped into memory, handing the unpacker the spills in place.
+    void ScanMappedFile(unsigned int *data);
+
     ///Sets output Filename and path that were passed using the -o flag.
     ///@param[in] a : The parameter that we are going to set
     void SetOutputInformation(const std::string &a);
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <cmath>
@@ -20,14 +21,45 @@
 /// We also store information about the Waveform. The waveform is the part
 /// of the trace that actually contains information about the signal that
 /// was captured. This excludes the baseline.
+///
+/// The getters hand out references to the trace's own storage, and the setters
+/// reuse that storage, so analyzing a trace doesn't copy the results around.
 class Trace : public std::vector<unsigned int> {
 public:
     ///Default constructor
-    Trace() : std::vector<unsigned int>() {}
+    Trace() : std::vector<unsigned int>(), waveformRange_(0, 0), isWaveformCurrent_(false) {}
 
     ///An automatic conversion for the trace
     ///@param [in] x : the trace to store in the class
-    Trace(const std::vector<unsigned int> &x) : std::vector<unsigned int>(x) {}
+    Trace(const std::vector<unsigned int> &x) : std::vector<unsigned int>(x), waveformRange_(0, 0),
+                                                isWaveformCurrent_(false) {}
+
+    ///Clears the samples and all of the results of the analysis so that the trace can be used for another hit. The
+    /// vectors keep their capacity.
+    void Reset() {
+        clear();
+        isSaturated_ = hasValidAnalysis_ = isWaveformCurrent_ = false;
+        phase_ = qdc_ = tailRatio_ = tau_ = filteredBaseline_ = 0;
+        numTriggers_ = 0;
+        baseline_ = std::make_pair(0., 0.);
+        max_ = extrapolatedMax_ = std::make_pair(0u, 0.);
+        waveformRange_ = std::make_pair(0u, 0u);
+        filteredEnergies_.clear();
+        traceSansBaseline_.clear();
+        waveform_.clear();
+        trigFilter_.clear();
+        esums_.clear();
+        triggerPositions_.clear();
+    }
+
+    ///Fills the baseline subtracted trace from the samples in the trace.
+    ///@param[in] baseline : The value of the baseline that we'll subtract from every sample.
+    void CalculateTraceSansBaseline(const double &baseline) {
+        traceSansBaseline_.resize(size());
+        for (unsigned int i = 0; i < size(); i++)
+            traceSansBaseline_[i] = (*this)[i] - baseline;
+        isWaveformCurrent_ = false;
+    }
 
     ///@return Returns a std::pair<double,double> containing the average and
     /// standard deviation of the baseline as the .first and .second
@@ -35,7 +67,7 @@ public:
     std::pair<double, double> GetBaselineInfo() const { return baseline_; }
 
     ///@return Returns the energy sums that were set.
-    std::vector<double> GetEnergySums() const { return esums_; }
+    const std::vector<double> &GetEnergySums() const { return esums_; }
 
     ///@return Returns a std::pair<unsigned int, double> containing the
     /// position of the maximum value in the trace and the amplitude of the
@@ -47,7 +79,7 @@ public:
     double GetFilteredBaseline() const { return filteredBaseline_; }
 
     ///@return The energies found by filtering the trace.
-    std::vector<double> GetFilteredEnergies() const { return filteredEnergies_; }
+    const std::vector<double> &GetFilteredEnergies() const { return filteredEnergies_; }
 
     ///@return Returns a std::pair<unsigned int, double> containing the
     /// position of the maximum value in the trace and the amplitude of the
@@ -58,6 +90,13 @@ public:
     ///@return The number of triggers that were found in the trace
     unsigned int GetNumberOfTriggers() const { return triggerPositions_.size(); }
 
+    ///@return The number of elements that the analysis results can hold before the trace has to grow its buffers.
+    /// Analyzers compare this before and after they store their results to count the regrowths that they caused.
+    size_t GetResultsCapacity() const {
+        return traceSansBaseline_.capacity() + waveform_.capacity() + trigFilter_.capacity() + esums_.capacity() +
+               filteredEnergies_.capacity() + triggerPositions_.capacity();
+    }
+
     ///@return The phase of the trace.
     double GetPhase() const { return phase_; }
 
@@ -74,18 +113,23 @@ public:
     double GetTau() const { return tau_; }
 
     ///@return Returns the waveform sans baseline
-    std::vector<double> GetTraceSansBaseline() const { return traceSansBaseline_; }
+    const std::vector<double> &GetTraceSansBaseline() const { return traceSansBaseline_; }
 
     ///@return Returns the Trigger Filter that was set.
-    std::vector<double> GetTriggerFilter() const { return trigFilter_; }
+    const std::vector<double> &GetTriggerFilter() const { return trigFilter_; }
 
     ///@return Returns a vector containing all of the found triggers
-    std::vector<unsigned int> GetTriggerPositions() const { return triggerPositions_; }
-
-    ///@return Returns the baseline subtracted waveform found inside the trace.
-    std::vector<double> GetWaveform() {
-        return std::vector<double>(traceSansBaseline_.begin() + waveformRange_.first,
-                                   traceSansBaseline_.begin() + waveformRange_.second);
+    const std::vector<unsigned int> &GetTriggerPositions() const { return triggerPositions_; }
+
+    ///@return Returns the baseline subtracted waveform found inside the trace. The waveform is copied out of the
+    /// baseline subtracted trace the first time that it's requested after either of them changes.
+    const std::vector<double> &GetWaveform() {
+        if (!isWaveformCurrent_) {
+            waveform_.assign(traceSansBaseline_.begin() + waveformRange_.first,
+                             traceSansBaseline_.begin() + waveformRange_.second);
+            isWaveformCurrent_ = true;
+        }
+        return waveform_;
     }
 
     ///@return The bounds of the waveform in the trace
@@ -100,7 +144,7 @@ public:
     bool HasValidAnalysis() const { return hasValidAnalysis_; }
 
     ///@return True if the trace was saturated
-    bool IsSaturated() { return isSaturated_; }
+    bool IsSaturated() const { return isSaturated_; }
 
     ///Sets the baseline information for the trace (average and standard
     /// deviation)
@@ -154,7 +198,10 @@ public:
 
     ///Sets the baseline subtracted trace.
     ///@param[in] a : The vector that we are going to assign.
-    void SetTraceSansBaseline(const std::vector<double> &a) { traceSansBaseline_ = a; }
+    void SetTraceSansBaseline(const std::vector<double> &a) {
+        traceSansBaseline_ = a;
+        isWaveformCurrent_ = false;
+    }
 
     ///Sets the value of the tail-ratio method used for doing discrimination
     /// on signals that have a varying decay constant. This is generally
@@ -178,7 +225,10 @@ public:
 
     ///Sets the bounds for the waveform
     ///@param[in] a : the range we want to set
-    void SetWaveformRange(const std::pair<unsigned int, unsigned int> &a) { waveformRange_ = a; }
+    void SetWaveformRange(const std::pair<unsigned int, unsigned int> &a) {
+        waveformRange_ = a;
+        isWaveformCurrent_ = false;
+    }
 
 private:
     bool isSaturated_; ///< True if the trace was flagged as saturated.
@@ -196,9 +246,11 @@ private:
     std::pair<unsigned int, double> max_; ///< Max position and value sans baseline
     std::pair<unsigned int, double> extrapolatedMax_; ///< Max position and extrapolated value
     std::pair<unsigned int, unsigned int> waveformRange_; ///< Waveform Range
+    bool isWaveformCurrent_; ///< True if waveform_ matches the baseline subtracted trace and the waveform range
 
     std::vector<double> filteredEnergies_; ///< Energies from filtering the trc.
     std::vector<double> traceSansBaseline_; ///< Baseline subtracted trace
+    std::vector<double> waveform_; ///< The waveform copied out of the baseline subtracted trace
     std::vector<double> trigFilter_; ///< The trigger filter for the trace
     std::vector<double> esums_; ///< The Energy sums calculated from the trace
 
@@ -0,0 +1,45 @@
+///@file TraceUnpacking.hpp
+///@brief Widens the packed 16-bit trace samples from the Pixie-16 modules into 32-bit samples.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef PIXIESUITE_TRACEUNPACKING_HPP
+#define PIXIESUITE_TRACEUNPACKING_HPP
+
+#include <string>
+
+///The modules pack two 16-bit samples into every word of the trace. Traces are most of the data that we decode, so
+/// widening them into the 32-bit samples used by the analysis is done with SSE2 or AVX2 when the processor has them.
+/// The instruction set is picked the first time that we widen a trace.
+namespace TraceUnpacking {
+    ///The different ways that we know how to widen the samples.
+    enum WIDENING_PATH {
+        SCALAR, SSE2, AVX2
+    };
+
+    ///Widens the samples with the fastest path that the processor supports.
+    ///@param[in] samples : Pointer to the first packed sample
+    ///@param[out] trace : Pointer to the storage for the widened samples, it must hold at least length samples
+    ///@param[in] length : The number of samples to widen
+    void Widen(const unsigned short *samples, unsigned int *trace, const unsigned int &length);
+
+    ///Widens the samples with the requested path. This is used to test the paths against each other.
+    ///@param[in] path : The path to use, it has to be supported by the processor
+    ///@param[in] samples : Pointer to the first packed sample
+    ///@param[out] trace : Pointer to the storage for the widened samples, it must hold at least length samples
+    ///@param[in] length : The number of samples to widen
+    void Widen(const WIDENING_PATH &path, const unsigned short *samples, unsigned int *trace,
+               const unsigned int &length);
+
+    ///@return The fastest path that this processor supports
+    WIDENING_PATH GetBestPath();
+
+    ///@return True if the processor supports the path
+    ///@param[in] path : The path that we want to check
+    bool IsSupported(const WIDENING_PATH &path);
+
+    ///@return The name of the path, for printing
+    ///@param[in] path : The path that we want the name of
+    std::string GetPathName(const WIDENING_PATH &path);
+}
+
+#endif //PIXIESUITE_TRACEUNPACKING_HPP
@@ -13,11 +13,24 @@
 #ifndef UNPACKER_HPP
 #define UNPACKER_HPP
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <exception>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "BoundedQueue.hpp"
+#include "HitDump.hpp"
+#include "IntervalIndex.hpp"
+#include "XiaDataPool.hpp"
+#include "XiaListModeDataDecoder.hpp"
 #include "XiaListModeDataMask.hpp"
 
 #ifndef MAX_PIXIE_MOD
@@ -51,6 +64,14 @@ public:
     /// Return the time of the first fired channel event.
     double GetFirstTime() { return firstTime; }
 
+    /// Set the time of the first event in the run, for when we start reading part way through it. The first event
+    /// that we build will no longer replace it.
+    void SetFirstTime(const double &time) {
+        firstTime = time;
+        isFirstTimeSet_ = true;
+        isFirstTimeKnown_.store(true, std::memory_order_release);
+    }
+
     /// Get the start time of the current raw event.
     double GetEventStartTime() { return eventStartTime; }
 
@@ -72,15 +93,118 @@ public:
     /// Set the width of events in pixie16 clock ticks.
     void SetEventWidth(double width) { eventWidth_ = width; }
 
+    ///@brief Toggles pooled decoding. When enabled the XiaData objects are owned by a pool in the Unpacker and the
+    /// traces are views into the spill buffer. The events are only valid until ReadSpill returns, and children must
+    /// not delete the events that they receive in the rawEvent.
+    ///@param[in] state_ : True if we want to decode into the pool.
+    ///@return The state that was set.
+    bool SetPooledDecoding(bool state_ = true) { return (usePooledDecoding_ = state_); }
+
+    ///@return True if we are decoding events into the pool.
+    bool IsPooledDecoding() const { return usePooledDecoding_; }
+
+    ///@brief Sets the channels whose hits and traces are kept while decoding, everything else is skipped before it's
+    /// decoded, sorted or built into events. This has to be set before the first spill is read, since the decode
+    /// threads read the filter without locking. The hit dump needs every hit, so nothing is skipped while it's open,
+    /// and the traces are only skipped when it doesn't write them.
+    ///@param[in] filter : The filter to use, an empty filter keeps everything.
+    void SetChannelFilter(const XiaChannelFilter &filter) {
+        channelFilter_ = filter;
+        KeepHitDumpChannels();
+    }
+
+    ///@brief Sets the parts of the run whose events are thrown away. Each spill is checked against the regions
+    /// before it's decoded, and the spills that lie entirely inside one are skipped. The events are only checked one
+    /// by one when the hits that are being built reach into a region. This has to be set before the first spill is
+    /// read.
+    ///@param[in] regions : The regions in seconds from the first event in the run.
+    ///@param[in] clockInSeconds : The length of a pixie16 clock tick in seconds.
+    void SetRejectionRegions(const IntervalIndex &regions, const double &clockInSeconds) {
+        rejectionRegions_ = regions;
+        clockInSeconds_ = clockInSeconds;
+    }
+
+    ///@brief Writes the hits of every raw event that's built to a columnar file, so that they can be analyzed again
+    /// without decoding the list mode data. Events inside the rejection regions aren't written. This has to be
+    /// called before the first spill is read.
+    ///@param[in] filename : The file to write the hits to
+    ///@param[in] keepTraces : True if the traces are written along with the hits
+    ///@return True if the file was opened
+    bool OpenHitDump(const std::string &filename, const bool &keepTraces) {
+        if (!hitDump_.Open(filename, keepTraces))
+            return false;
+        KeepHitDumpChannels();
+        return true;
+    }
+
+    ///@brief Stops or starts writing the built events to the hit dump, e.g. while warming up. The events carried over
+    /// from the spills that were already read are flushed first, so they stay on the same side of the change as their
+    /// spills. An event that straddles the change is split there.
+    ///@param[in] paused : True if the events aren't written
+    void SetHitDumpPaused(const bool &paused);
+
+    ///@return The number of spills that were skipped since they were inside a rejection region.
+    unsigned long long GetNumRejectedSpills() const { return numRejectedSpills_; }
+
+    ///@return The number of events that were built and then thrown away since they were inside a rejection region.
+    unsigned long long GetNumRejectedEvents() const { return numRejectedEvents_; }
+
+    ///@brief Sets the lookahead window used when building events across spill boundaries. At the end of each spill
+    /// we only build the events that end before the latest hit of the slowest module minus this window. The remaining
+    /// hits are carried into the next spill. A negative window turns off cross-spill building, and all of the events
+    /// are built at the end of each spill.
+    ///@param[in] window : The lookahead window in pixie16 clock ticks.
+    void SetLookaheadWindow(const double &window) { lookaheadWindow_ = window; }
+
+    ///@return The lookahead window in pixie16 clock ticks. Negative if we are not building across spills.
+    double GetLookaheadWindow() const { return lookaheadWindow_; }
+
+    ///@return True if we carry unfinished events across spill boundaries.
+    bool IsBuildingAcrossSpills() const { return lookaheadWindow_ >= 0; }
+
+    ///@return The number of hits that are waiting for the next spill.
+    unsigned int GetNumCarriedHits() const;
+
+    ///@brief Builds and processes all of the hits that were carried over from the previous spill. This needs to be
+    /// called when we reach the end of the data (e.g. the end of a file), otherwise the last events are lost.
+    void FlushEventList();
+
+    ///@brief Sets the number of threads used to decode the module buffers. When this is non-zero the unpacking is
+    /// split into a pipeline: the thread calling ReadSpill only checks the spill and hands the module buffers to the
+    /// decode threads, a single builder thread time orders the hits and builds the raw events, and a consumer thread
+    /// calls ProcessRawEvent for each event in time order. The stages talk through bounded lock-free queues. Pooled
+    /// decoding is turned off when the pipeline starts. Zero (the default) unpacks everything in ReadSpill. An
+    /// exception thrown by any of the stages is rethrown by the next call to ReadSpill or FlushEventList, the events
+    /// that were built after it are dropped.
+    ///@param[in] num : The number of decode threads.
+    void SetDecodeThreads(const unsigned int &num) { numDecodeThreads_ = num; }
+
+    ///@return The number of decode threads, zero if we are not pipelined.
+    unsigned int GetDecodeThreads() const { return numDecodeThreads_; }
+
+    ///@return True if the pipeline threads are running.
+    bool IsPipelined() const { return pipelineRunning_; }
+
+    ///@brief Waits for the pipeline to process everything that it has been handed, stops the threads and prints the
+    /// throughput of each stage. Children that use resources in ProcessRawEvent must call this in their destructor
+    /// before those resources are released. Does nothing if the pipeline isn't running.
+    void StopPipeline();
+
     void InitializeDataMask(const std::string &firmware, const unsigned int &frequency = 0);
 
+    ///@brief Gets the length of a time stamp tick from the data masks, so InitializeDataMask has to be called first.
+    ///@return The length of one time stamp tick in seconds.
+    ///@throws invalid_argument if the modules in the map don't count time in the same units.
+    double GetTimestampTickInSeconds() const;
+
     /** ReadSpill is responsible for constructing a list of pixie16 events from
       * a raw data spill. This method performs sanity checks on the spill and
       * calls ReadBuffer in order to construct the event list.
       * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
       * \param[in]  nWords     The number of words in the array.
       * \param[in]  is_verbose Toggle the verbosity flag on/off.
-      * \return True if the spill was read successfully and false otherwise.
+      * \return False if the spill failed the sanity checks or was split between buffers, the same whether or not
+      *  we're pipelined. Its events are carried to the next spill or thrown away.
       */
     bool ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbose = true);
 
@@ -89,6 +213,21 @@ public:
       */
     void Write();
 
+    ///@return The number of hits that have been placed into raw events.
+    unsigned long long GetNumHitsBuilt() const { return numHitsBuilt_; }
+
+    ///@return The number of hits that arrived out of time order and had to be moved in their module's stream.
+    unsigned long long GetNumOutOfOrderHits() const { return numOutOfOrderHits_; }
+
+    ///@return The time spent time ordering the streams and building raw events in seconds.
+    double GetBuildTimeInSeconds() const { return buildTime_.count(); }
+
+    ///@brief Prints the number of hits built and the event building throughput to the screen.
+    void PrintBuildStatistics() const;
+
+    ///@brief Prints the amount of work done, the busy time and the number of stalls for each stage of the pipeline.
+    void PrintPipelineStatistics() const;
+
     /** Stop the scan. Unused by default.
       * \return Nothing.
       */
@@ -104,7 +243,7 @@ protected:
     std::vector<std::deque<XiaData *>> eventList; ///< The list of all events in a spill.
     double eventWidth_; ///< The width of the raw event in pixie clock ticks
     XiaListModeDataMask mask_; ///< Object providing the masks necessary to decode the data.
-    std::map<unsigned int, std::pair<std::string, unsigned int> > maskMap_;///< Maps firmware/frequency to module number
+    std::map<unsigned int, XiaListModeDataMask> maskMap_;///< Maps the firmware/frequency mask to module number
     unsigned int maxModuleNumberInFile_; ///< The maximum module number that we've encountered in the data file.
     std::deque<XiaData *> rawEvent; ///< The list of all events in the event window.
     bool running; ///< True if the scan is running.
@@ -140,20 +279,237 @@ private:
     unsigned int channel_counts[MAX_PIXIE_MOD + 1][MAX_PIXIE_CHAN + 1]; /// Counters for each channel in each module.
 
     double firstTime; /// The first recorded event time.
+    bool isFirstTimeSet_; ///< True if the first time was set with SetFirstTime.
+    std::atomic<bool> isFirstTimeKnown_; ///< Set once the first time is known, the reader may check it when pipelined
     double eventStartTime; /// The start time of the current raw event.
     double realStartTime; /// The time of the first xia event in the raw event.
     double realStopTime; /// The time of the last xia event in the raw event.
 
-    /** Scan the event list and sort it by timestamp.
+    bool usePooledDecoding_; ///< True if the events are owned by the pool instead of the heap.
+    XiaListModeDataDecoder decoder_; ///< Decodes the module buffers when we aren't pipelined
+    unsigned long numSpillsParsed_; ///< The number of spills that we've parsed
+    unsigned long numFullSpills_; ///< The number of parsed spills that had all of their module buffers
+    XiaChannelFilter channelFilter_; ///< The channels whose hits and traces we keep while decoding
+    IntervalIndex rejectionRegions_; ///< The regions of the run to throw away, in seconds from the first time
+    double clockInSeconds_; ///< The length of a clock tick, used to put the times into the rejection regions
+    unsigned long long numRejectedSpills_; ///< The number of spills skipped before they were decoded
+    unsigned long long numRejectedEvents_; ///< The number of events built and thrown away one by one
+    HitDumpWriter hitDump_; ///< Writes the hits of the built events, when it's open
+    std::atomic<bool> hitDumpPaused_; ///< True if the built events aren't written to the hit dump
+    XiaDataPool pools_[2]; ///< Owns all of the events when we're using pooled decoding, we swap when carrying hits.
+    unsigned int activePool_; ///< The index of the pool that we're currently decoding into.
+
+    double lookaheadWindow_; ///< The lookahead window for cross-spill building, negative if turned off.
+    double buildHorizon_; ///< We do not build events that extend past this time.
+    std::vector<unsigned int> numCarried_; ///< The number of hits in each module stream carried from the last spill.
+    std::vector<XiaData *> decodedList_; ///< Reused to hold the events decoded from a single module buffer.
+
+    unsigned long long numHitsBuilt_; ///< The number of hits placed into raw events.
+    unsigned long long numOutOfOrderHits_; ///< The number of hits that arrived out of order within their module.
+    std::chrono::duration<double> buildTime_; ///< Time spent ordering the streams and building the raw events.
+
+    ///The min-heap holding the time of the front of each module stream and the module's index in the eventList. We
+    /// only push modules that still have data, so the top of the heap is always the earliest hit in the spill.
+    std::vector<std::pair<double, unsigned int> > mergeHeap_;
+
+    ///The kinds of work that the reader hands down the pipeline. Everything except decoding is done by the builder,
+    /// the decode threads only pass it along. Items leave the decode threads in the order that they were dispatched.
+    enum PipelineItemType {
+        DECODE_BUFFER, ///< Decode a module buffer.
+        CLEAR_EVENTS, ///< Toss out the event list (e.g. a missing module buffer).
+        BUILD_SPILL, ///< The end of a spill, sort and build the events.
+        RELEASE_SPILL, ///< The reader is done with this spill buffer.
+        FLUSH_EVENTS, ///< Build everything that's left, the end of the data.
+        PIPELINE_ERROR, ///< A stage threw, the consumer hands the exception back to the reader.
+        STOP_PIPELINE ///< Shut down the thread.
+    };
+
+    ///A unit of work handed from the reader to the decode threads and on to the builder.
+    struct PipelineItem {
+        PipelineItem() : type(DECODE_BUFFER), buffer(NULL), fullSpill(false), verbose(false) {}
+
+        PipelineItemType type; ///< What needs to be done
+        unsigned int *buffer; ///< The module buffer to decode or the spill buffer to release
+        XiaListModeDataMask mask; ///< The mask for the module that the buffer came from
+        bool fullSpill; ///< True if the spill that we're building had all of its module buffers
+        bool verbose; ///< The verbosity of the ReadSpill call that handed us this item
+        std::vector<XiaData *> decoded; ///< The events decoded from the buffer
+        std::exception_ptr error; ///< Set if decoding the buffer threw
+    };
+
+    ///A raw event handed from the builder to the consumer.
+    struct BuiltEvent {
+        BuiltEvent() : startTime(0), realStartTime(0), realStopTime(0), type(DECODE_BUFFER) {}
+
+        std::deque<XiaData *> hits; ///< The hits in the event, in time order
+        double startTime; ///< The start time of the event window
+        double realStartTime; ///< The time of the first hit
+        double realStopTime; ///< The time of the last hit
+        PipelineItemType type; ///< DECODE_BUFFER for an event, otherwise the kind of marker
+        std::exception_ptr error; ///< The exception carried by a PIPELINE_ERROR marker
+    };
+
+    ///The work done by a single stage of the pipeline.
+    struct StageStatistics {
+        unsigned long long numItems; ///< Spills, buffers or events depending on the stage
+        unsigned long long numUnits; ///< Words or hits depending on the stage
+        unsigned long long numStalls; ///< The number of times the stage waited on a full downstream queue
+        std::chrono::duration<double> busyTime; ///< The time spent working, not including waiting for work
+    };
+
+    unsigned int numDecodeThreads_; ///< The number of decode threads, zero to unpack in ReadSpill.
+    bool pipelineRunning_; ///< True when the pipeline threads have been started.
+    unsigned int nextDecodeThread_; ///< The decode thread that gets the next item, items are dealt round robin.
+    std::vector<std::unique_ptr<BoundedQueue<PipelineItem> > > decodeInput_; ///< Reader to decode thread queues
+    std::vector<std::unique_ptr<BoundedQueue<PipelineItem> > > decodeOutput_; ///< Decode thread to builder queues
+    std::unique_ptr<BoundedQueue<BuiltEvent> > builtEvents_; ///< Builder to consumer queue
+    std::unique_ptr<BoundedQueue<unsigned int *> > freeSpills_; ///< Spill buffers returned from the builder
+    std::vector<std::vector<unsigned int> > spillBuffers_; ///< The preallocated copies of the spills
+    std::vector<std::thread> decodeThreads_; ///< The threads decoding the module buffers
+    std::thread builderThread_; ///< The thread ordering hits and building raw events
+    std::thread consumerThread_; ///< The thread calling ProcessRawEvent
+    std::mutex consumerMutex_; ///< Protects the flushes that the consumer has seen and the pipeline error
+    std::condition_variable consumerSignal_; ///< Signaled when the consumer sees a flush or an error
+    unsigned int flushesCompleted_; ///< The number of flushes that the consumer has seen
+    unsigned int flushesRequested_; ///< The number of flushes requested by the reader
+    std::exception_ptr pipelineError_; ///< The first exception thrown by a stage that the reader hasn't rethrown
+    std::atomic<bool> discardEvents_; ///< Set when we're shutting down, the consumer drops the events
+    unsigned long numBuilderEvents_; ///< The number of hits that the builder has decoded since the last spill
+    StageStatistics readerStats_; ///< The statistics of the thread calling ReadSpill
+    std::vector<StageStatistics> decodeStats_; ///< The statistics for each decode thread
+    StageStatistics builderStats_; ///< The statistics for the builder thread
+    StageStatistics consumerStats_; ///< The statistics for the consumer thread
+
+    /** Parses the spill, checks its sanity and reads each module buffer. This is the body of ReadSpill, when we're
+      * pipelined the buffers are handed to the decode threads instead of being read here.
+      * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
+      * \param[in]  nWords     The number of words in the array.
+      * \param[in]  is_verbose Toggle the verbosity flag on/off.
+      * \return False if the spill failed the sanity checks or was split between buffers.
+      */
+    bool ParseSpill(unsigned int *data, const unsigned int &nWords, const bool &is_verbose);
+
+    /** Checks if a spill lies entirely inside one of the rejection regions. Only the timestamps of the hits are
+      * looked at, nothing is decoded. We can't tell until the first time of the run is known.
+      * \param[in]  data   Pointer to the spill.
+      * \param[in]  nWords The number of words in the spill.
+      * \return True if the whole spill can be skipped.
+      */
+    bool IsSpillRejected(const unsigned int *data, const unsigned int &nWords) const;
+
+    /** Works out if the hits waiting in the event list reach into one of the rejection regions. When they don't
+      * there's no need to check the events that are built from them.
+      * \return True if the events that are built need to be checked one by one.
+      */
+    bool NeedsEventRejection();
+
+    /** \return True if the event starting at the time is inside one of the rejection regions.
+      * \param[in] startTime The start time of the event in clock ticks.
+      */
+    bool IsEventRejected(const double &startTime) const {
+        return rejectionRegions_.Contains((startTime - firstTime) * clockInSeconds_);
+    }
+
+    /** Builds and processes the events once all of the module buffers in a spill have been read. Called from
+      * ParseSpill, or by the builder thread when we're pipelined.
+      * \param[in] fullSpill  True if the spill had all of its module buffers.
+      * \param[in] numEvents  The number of hits decoded from the spill.
+      * \param[in] is_verbose Toggle the verbosity flag on/off.
+      * \return Nothing.
+      */
+    void ProcessSpill(const bool &fullSpill, const unsigned long &numEvents, const bool &is_verbose);
+
+    /** Builds all of the raw events up to the horizon. They are processed immediately, or sent to the consumer
+      * thread when we're pipelined.
+      * \return Nothing.
+      */
+    void BuildEvents();
+
+    /** Builds every event that's left in the event list and then clears the list.
+      * \return Nothing.
+      */
+    void BuildRemainingEvents();
+
+    /** Clears the event list, or asks the builder to clear it when we're pipelined.
+      * \return Nothing.
+      */
+    void DiscardSpill();
+
+    /** Opens up the channel filter for the hits and traces that the hit dump writes, if it's open.
+      * \return Nothing.
+      */
+    void KeepHitDumpChannels() {
+        if (!hitDump_.IsOpen())
+            return;
+        channelFilter_.keep.clear();
+        if (hitDump_.KeepsTraces())
+            channelFilter_.keepTrace.clear();
+    }
+
+    /** Does the bookkeeping for a spill that was skipped because it's inside a rejection region. The modules in the
+      * spill still count towards the largest module number. The hits carried from the spill before can't be
+      * finished by this one, so they're built now and the build horizon starts over, as if the run had a gap here.
+      * \param[in]  data   Pointer to the spill.
+      * \param[in]  nWords The number of words in the spill.
+      * \return Nothing.
+      */
+    void SkipRejectedSpill(const unsigned int *data, const unsigned int &nWords);
+
+    /** Allocates the queues and spill buffers and starts the pipeline threads.
+      * \return Nothing.
+      */
+    void StartPipeline();
+
+    /** Hands an item to the next decode thread, waiting if its queue is full.
+      * \param[in] item The item to hand off, it's moved into the queue.
+      * \return Nothing.
+      */
+    void Dispatch(PipelineItem &item);
+
+    /** The loop run by each decode thread.
+      * \param[in] idx The index of the thread.
+      * \return Nothing.
+      */
+    void DecodeLoop(const unsigned int idx);
+
+    /** The loop run by the builder thread. It collects the items from the decode threads in dispatch order.
+      * \return Nothing.
+      */
+    void BuilderLoop();
+
+    /** The loop run by the consumer thread.
+      * \return Nothing.
+      */
+    void ConsumerLoop();
+
+    /** Rethrows the exception that a pipeline stage handed to the consumer, if there is one. It's only thrown once.
+      * \return Nothing.
+      */
+    void RethrowPipelineError();
+
+    /** Ensure that each of the module streams is time ordered and seed the merge heap with the front of each stream.
+      * The Pixie FIFO data is very nearly time ordered, so we only move the hits that are out of order instead of
+      * sorting the entire stream.
       * \return Nothing.
       */
     void TimeSort();
 
-    /** Scan the time sorted event list and package the events into a raw
-      * event with a size governed by the event width.
+    /** Ensures that a single module stream is time ordered. Hits that are out of order are moved back to their
+      * proper place in the stream. If too much of the stream is out of order we fall back to a full sort.
+      * \param[in] stream The stream of hits from a single module.
+      * \return The number of hits that were out of order.
+      */
+    unsigned int OrderStream(std::deque<XiaData *> &stream);
+
+    /** Merge the time sorted module streams and package the events into a raw event with a size governed by the
+      * event width. The hits in the raw event are in time order.
+      * \param[out] event     The hits in the event, anything in here is cleared first.
+      * \param[out] startTime The start time of the event window.
+      * \param[out] realStart The time of the first hit in the event.
+      * \param[out] realStop  The time of the last hit in the event.
       * \return True if the event list is not empty and false otherwise.
       */
-    bool BuildRawEvent();
+    bool BuildRawEvent(std::deque<XiaData *> &event, double &startTime, double &realStart, double &realStop);
 
     /** Push an event into the event list.
       * \param[in]  event_ The XiaData to push onto the back of the event list.
@@ -162,11 +518,25 @@ private:
     bool AddEvent(XiaData *event_);
 
     /** Clear all events in the spill event list. WARNING! This method will delete all events in the
-      * event list. This could cause seg faults if the events are used elsewhere.
+      * event list. This could cause seg faults if the events are used elsewhere. When we are using pooled decoding
+      * all of the events in the spill are released back to the pool in one shot.
       * \return Nothing.
       */
     void ClearEventList();
 
+    /** Calculates the horizon for building the events in this spill. The horizon is the latest hit of the slowest
+      * module that had data in this spill minus the lookahead window. If we are not building across spills the
+      * horizon is infinite.
+      * \return Nothing.
+      */
+    void CalculateBuildHorizon();
+
+    /** Keep the hits that are left in the event list for the next spill. Pooled events are copied into the other
+      * pool along with their traces since the spill buffer will be overwritten.
+      * \return Nothing.
+      */
+    void CarryEventList();
+
     /** Clear all events in the raw event list. WARNING! This method will delete all events in the
       * event list. This could cause seg faults if the events are used elsewhere.
       * \return Nothing.
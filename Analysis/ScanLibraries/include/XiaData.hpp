@@ -4,8 +4,11 @@
 #ifndef XIADATA_HPP
 #define XIADATA_HPP
 
+#include <algorithm>
 #include <vector>
 
+#include "TraceUnpacking.hpp"
+
 /*! \brief A pixie16 channel event
  *
  * All data is grouped together into channels.  For each pixie16 channel that
@@ -23,6 +26,18 @@ public:
     ///Default Destructor.
     ~XiaData() {};
 
+    ///Default copy constructor
+    XiaData(const XiaData &) = default;
+
+    ///Default move constructor, the vectors are moved instead of copied.
+    XiaData(XiaData &&) = default;
+
+    ///Default copy assignment
+    XiaData &operator=(const XiaData &) = default;
+
+    ///Default move assignment, the vectors are moved instead of copied.
+    XiaData &operator=(XiaData &&) = default;
+
     ///@brief Equality operator that compares checks if we have the same
     /// channel (i.e. the ID and Time are identical)
     ///@param[in] rhs : The right hand side of the comparison
@@ -67,8 +82,8 @@ public:
     ///@return The status of the CFD Forced Trigger Bit
     bool GetCfdForcedTriggerBit() const { return cfdForceTrig_; }
 
-    ///@return The status of the CFD Trigger bit.
-    bool GetCfdTriggerSourceBit() const { return cfdTrigSource_; }
+    ///@return The ADC that the CFD triggered on. It's a single bit at 250 MS/s and three bits at 500 MS/s.
+    unsigned int GetCfdTriggerSource() const { return cfdTrigSource_; }
 
     ///@return True if we had a pileup detected on the module
     bool IsPileup() const { return isPileup_; }
@@ -139,8 +154,35 @@ public:
     ///@return the QDC recorded on the module
     std::vector<unsigned int> GetQdc() const { return qdc_; }
 
-    ///@return The trace that was sampled on the module
-    std::vector<unsigned int> GetTrace() const { return trace_; }
+    ///@return The trace that was sampled on the module. If the trace is only a view into the spill buffer we widen
+    /// the samples into a new vector here.
+    std::vector<unsigned int> GetTrace() const {
+        if (traceView_) {
+            std::vector<unsigned int> trace(traceViewLength_);
+            TraceUnpacking::Widen(traceView_, trace.data(), traceViewLength_);
+            return trace;
+        }
+        return trace_;
+    }
+
+    ///@return The number of samples in the trace, regardless of if we own the trace or have a view into the spill.
+    unsigned int GetTraceLength() const { return traceView_ ? traceViewLength_ : (unsigned int) trace_.size(); }
+
+    ///@return A pointer to the packed 16-bit samples in the spill buffer, or nullptr if we own the trace. This
+    /// pointer is only valid as long as the spill buffer that it was decoded from.
+    const unsigned short *GetTraceView() const { return traceView_; }
+
+    ///@brief Copies the trace into 16-bit samples, which is the size that the modules record them with.
+    ///@param[out] samples : Room for GetTraceLength samples
+    void CopyPackedTrace(unsigned short *samples) const {
+        if (traceView_)
+            std::copy(traceView_, traceView_ + traceViewLength_, samples);
+        else
+            std::copy(trace_.begin(), trace_.end(), samples);
+    }
+
+    ///@return True if the trace is a non-owning view into the spill buffer.
+    bool HasTraceView() const { return traceView_ != nullptr; }
 
     ///@brief This value is set to true if the CFD was forced to trigger
     ///@param[in] a : The value to set
@@ -161,7 +203,7 @@ public:
 
     ///@brief Sets the CFD trigger source
     ///@param[in] a : The value to set
-    void SetCfdTriggerSourceBit(const bool &a) { cfdTrigSource_ = a; }
+    void SetCfdTriggerSource(const unsigned int &a) { cfdTrigSource_ = a; }
 
     ///@brief Sets the channel number
     ///@param[in] a : The value to set
@@ -179,6 +221,12 @@ public:
     ///@param[in] a : The value to set
     void SetEnergySums(const std::vector<unsigned int> &a) { eSums_ = a; }
 
+    ///@brief Sets the energy sums from a range of words. This reuses the capacity that we already have, so a recycled
+    /// object will not allocate.
+    ///@param[in] begin : The first word of the energy sums
+    ///@param[in] end : One past the last word of the energy sums
+    void SetEnergySums(const unsigned int *begin, const unsigned int *end) { eSums_.assign(begin, end); }
+
     ///@brief Sets the upper 16 bits of the event time
     ///@param[in] a : The value to set
     void SetEventTimeHigh(const unsigned int &a) { eventTimeHigh_ = a; }
@@ -203,6 +251,12 @@ public:
     ///@param[in] a : The value to set
     void SetQdc(const std::vector<unsigned int> &a) { qdc_ = a; }
 
+    ///@brief Sets the QDCs from a range of words. This reuses the capacity that we already have, so a recycled
+    /// object will not allocate.
+    ///@param[in] begin : The first word of the QDCs
+    ///@param[in] end : One past the last word of the QDCs
+    void SetQdc(const unsigned int *begin, const unsigned int *end) { qdc_.assign(begin, end); }
+
     ///@brief Sets the saturation flag
     ///@param[in] a : True if we found a saturation on board
     void SetSaturation(const bool &a) { isSaturated_ = a; }
@@ -222,7 +276,62 @@ public:
 
     ///@brief Sets the trace recorded on board
     ///@param[in] a : The value to set
-    void SetTrace(const std::vector<unsigned int> &a) { trace_ = a; }
+    void SetTrace(const std::vector<unsigned int> &a) {
+        trace_ = a;
+        traceView_ = nullptr;
+        traceViewLength_ = 0;
+    }
+
+    ///@brief Points the trace at packed 16-bit samples in the spill buffer without copying them. The caller is
+    /// responsible for ensuring that the buffer outlives this object.
+    ///@param[in] a : Pointer to the first sample
+    ///@param[in] len : The number of samples in the trace
+    void SetTraceView(const unsigned short *a, const unsigned int &len) {
+        trace_.clear();
+        traceView_ = a;
+        traceViewLength_ = len;
+    }
+
+    ///@brief Copies the samples from the trace view into the trace that we own. After this call the object no longer
+    /// depends on the spill buffer that it was decoded from.
+    void DetachTraceView() {
+        if (!traceView_)
+            return;
+        const unsigned short *samples = traceView_;
+        const unsigned int length = traceViewLength_;
+        TraceUnpacking::Widen(samples, ResizeTrace(length), length);
+    }
+
+    ///@brief Sizes the trace that we own so that it can be filled in place, e.g. by widening the packed samples
+    /// straight into it. Any trace view is dropped.
+    ///@param[in] len : The number of samples in the trace
+    ///@return A pointer to the first sample of the trace
+    unsigned int *ResizeTrace(const unsigned int &len) {
+        trace_.resize(len);
+        traceView_ = nullptr;
+        traceViewLength_ = 0;
+        return trace_.data();
+    }
+
+    ///@brief Moves the trace that we own into a vector without copying the samples. A trace view is widened into the
+    /// vector instead. The vector's old storage is kept by us so that it can be reused, and we're left without a trace.
+    ///@param[in,out] trace : The vector that receives the samples
+    void MoveTraceInto(std::vector<unsigned int> &trace) {
+        if (traceView_) {
+            trace.resize(traceViewLength_);
+            TraceUnpacking::Widen(traceView_, trace.data(), traceViewLength_);
+        } else {
+            trace.swap(trace_);
+        }
+        trace_.clear();
+        traceView_ = nullptr;
+        traceViewLength_ = 0;
+    }
+
+    ///@brief Takes all of the values from another object without copying its energy sums, QDCs or trace. The other
+    /// object is handed our old vectors in return, cleared, so that a recycled object can reuse their capacity.
+    ///@param[in,out] other : The object that we take the values from. It must be initialized before it's used again.
+    void Adopt(XiaData &other);
 
     ///@brief Sets the flag for channels generated on-board
     ///@param[in] a : True if we this channel was generated on-board
@@ -233,7 +342,6 @@ public:
 
 private:
     bool cfdForceTrig_; /// CFD was forced to trigger.
-    bool cfdTrigSource_; /// The ADC that the CFD/FPGA synced with.
     bool isPileup_; /// Pile-up flag from Pixie.
     bool isSaturated_; /// Saturation flag from Pixie.
     bool isVirtualChannel_; /// Flagged if generated virtually in Pixie DSP.
@@ -245,6 +353,7 @@ private:
     double filterTime_; ///< The time of arrival of the signal sans CFD time.
 
     unsigned int cfdTime_; /// CFD trigger time
+    unsigned int cfdTrigSource_; /// The ADC that the CFD/FPGA synced with.
     unsigned int chanNum_; /// Channel number.
     unsigned int crateNum_; ///The Crate number for the channel
     unsigned int eventTimeHigh_; /// Upper 16 bits of pixie16 event time.
@@ -256,6 +365,9 @@ private:
     std::vector<unsigned int> eSums_;///Energy sums recorded by the module
     std::vector<unsigned int> qdc_; ///QDCs recorded by the module
     std::vector<unsigned int> trace_; /// ADC trace capture.
+
+    const unsigned short *traceView_; ///< Non-owning view of the trace in the spill buffer.
+    unsigned int traceViewLength_; ///< The number of samples in the trace view.
 };
 
 #endif
\ No newline at end of file
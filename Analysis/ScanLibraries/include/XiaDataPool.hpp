@@ -0,0 +1,54 @@
+///@file XiaDataPool.hpp
+///@brief A pool of recycled XiaData objects that are handed out while decoding a spill.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef PIXIESUITE_XIADATAPOOL_HPP
+#define PIXIESUITE_XIADATAPOOL_HPP
+
+#include <deque>
+
+#include "XiaData.hpp"
+
+///This class owns all of the XiaData objects that are decoded from a spill. Instead of allocating a new object for
+/// every hit, we hand out objects that were used in a previous spill. The objects keep the capacity of their energy
+/// sum and QDC vectors, so after a few spills decoding a hit requires no heap allocations. All of the objects are
+/// released in one shot with Reset(). Any pointer returned by Acquire() is invalidated by Reset().
+class XiaDataPool {
+public:
+    ///Default constructor
+    XiaDataPool() : numUsed_(0) {}
+
+    ///Default destructor
+    ~XiaDataPool() {}
+
+    ///@return A freshly initialized XiaData object that's owned by the pool.
+    XiaData *Acquire() {
+        if (numUsed_ == pool_.size()) {
+            pool_.emplace_back();
+            return &pool_[numUsed_++];
+        }
+        XiaData *data = &pool_[numUsed_++];
+        data->Initialize();
+        return data;
+    }
+
+    ///@brief Returns the most recently acquired objects to the pool. Used when we need to discard objects that we
+    /// just acquired (e.g. a statistics block or a corrupted buffer).
+    ///@param[in] num : The number of objects to return.
+    void ReleaseLast(const unsigned int &num = 1) { numUsed_ = num > numUsed_ ? 0 : numUsed_ - num; }
+
+    ///@brief Releases all of the objects in the pool so that they can be used again. We do not free any memory here.
+    void Reset() { numUsed_ = 0; }
+
+    ///@return The number of objects that are currently handed out.
+    unsigned int GetNumberInUse() const { return numUsed_; }
+
+    ///@return The total number of objects that the pool has allocated.
+    unsigned int GetCapacity() const { return pool_.size(); }
+
+private:
+    std::deque<XiaData> pool_; ///< The objects, a deque ensures that pointers stay valid as we grow.
+    unsigned int numUsed_; ///< The number of objects that have been handed out since the last reset.
+};
+
+#endif //PIXIESUITE_XIADATAPOOL_HPP
@@ -9,13 +9,68 @@
 #include <vector>
 
 #include "XiaData.hpp"
+#include "XiaDataPool.hpp"
 #include "XiaListModeDataMask.hpp"
 
+///The masks, shifts and time constants of one firmware and frequency. They're looked up from the XiaListModeDataMask
+/// once, so that the headers are decoded with straight-line shifts and masks instead of going through the firmware and
+/// frequency switches for every field of every hit. Fields that a firmware doesn't have get a mask of zero.
+struct XiaListModeDataLayout {
+    ///Default constructor, the layout has to be set from a mask before it's used.
+    XiaListModeDataLayout() : firmware(DataProcessing::UNKNOWN), frequency(0) {}
+
+    ///Constructor that looks up everything from the mask.
+    ///@param[in] mask : The mask for the firmware and frequency that we're decoding
+    explicit XiaListModeDataLayout(const XiaListModeDataMask &mask);
+
+    ///@return True if the layout was built for the firmware and frequency of the mask. A layout that was never set
+    /// doesn't match anything.
+    bool Matches(const XiaListModeDataMask &mask) const {
+        return firmware != DataProcessing::UNKNOWN && firmware == mask.GetFirmware() && frequency == mask.GetFrequency();
+    }
+
+    DataProcessing::FIRMWARE firmware; ///< The firmware that the layout was built for
+    unsigned int frequency; ///< The frequency that the layout was built for
+
+    unsigned int eventLengthMask; ///< Mask of the event length in word zero
+    unsigned int eventLengthShift; ///< Shift of the event length in word zero
+    unsigned int wordZeroOutOfRangeMask; ///< Mask of the trace-out-of-range flag when it's in word zero
+    unsigned int cfdFractionalTimeMask; ///< Mask of the CFD fractional time in word two
+    unsigned int cfdFractionalTimeShift; ///< Shift of the CFD fractional time in word two
+    unsigned int cfdForcedTriggerMask; ///< Mask of the CFD forced trigger bit in word two
+    unsigned int cfdTriggerSourceMask; ///< Mask of the CFD trigger source bits in word two
+    unsigned int cfdTriggerSourceShift; ///< Shift of the CFD trigger source bits in word two
+    unsigned int energyMask; ///< Mask of the energy in word three
+    unsigned int wordThreeOutOfRangeMask; ///< Mask of the trace-out-of-range flag when it's in word three
+    unsigned int traceLengthMask; ///< Mask of the trace length in word three
+    unsigned int traceLengthShift; ///< Shift of the trace length in word three
+
+    double cfdScale; ///< One over the size of the CFD fractional time, zero if there isn't one
+    double timeMultiplier; ///< Converts the filter time into samples
+    double triggerSourceCoefficient; ///< Multiplies the trigger source bits when we add them to the CFD time
+    double cfdOffset; ///< Added to the CFD time in samples
+};
+
+///The channels that the decoder keeps and the channels that need their traces. The lists are indexed with
+/// XiaData::GetId. Channels past the end of a list are kept, so an empty filter keeps everything.
+struct XiaChannelFilter {
+    std::vector<bool> keep; ///< True if the hits of the channel are kept
+    std::vector<bool> keepTrace; ///< True if the traces of the channel are kept
+
+    ///@return True if we keep the hits of the channel
+    ///@param[in] id : The id of the channel from XiaData::GetId
+    bool IsKept(const unsigned int &id) const { return id >= keep.size() || keep[id]; }
+
+    ///@return True if we keep the traces of the channel
+    ///@param[in] id : The id of the channel from XiaData::GetId
+    bool IsTraceKept(const unsigned int &id) const { return id >= keepTrace.size() || keepTrace[id]; }
+};
+
 ///Class to decode Xia List mode Data
 class XiaListModeDataDecoder {
 public:
     ///Default constructor
-    XiaListModeDataDecoder() {};
+    XiaListModeDataDecoder() : layout_(), filter_(nullptr) {};
 
     ///Default destructor
     ~XiaListModeDataDecoder() {};
@@ -26,6 +81,21 @@ public:
     ///@return A vector containing all of the decoded XiaData events.
     std::vector<XiaData *> DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask);
 
+    ///Decoding method that does not allocate memory for the events. The events are taken from the pool and the traces
+    /// are views into the buffer, so the buffer must outlive the decoded events.
+    ///@param[in] buf : Pointer to the beginning of the data buffer.
+    ///@param[in] mask : The mask set that we need to decode the data
+    ///@param[in] pool : The pool that owns the decoded events.
+    ///@param[out] events : The vector that we append the decoded events to. Nothing is appended if the buffer was bad.
+    ///@return The number of events that were appended to the events vector.
+    unsigned int DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool &pool,
+                              std::vector<XiaData *> &events);
+
+    ///Sets the filter that decides which hits and traces we keep. The hits of channels that aren't kept are skipped
+    /// once we've read their header, and traces that aren't kept are never decoded.
+    ///@param[in] filter : The filter, it has to outlive the decoder. Null keeps everything.
+    void SetChannelFilter(const XiaChannelFilter *filter) { filter_ = filter; }
+
     ///Method to calculate the arrival time of the signal in samples
     ///@param[in] mask : The data mask containing the necessary information
     /// to calculate the time.
@@ -33,41 +103,65 @@ public:
     ///@return A pair of doubles where the first element is the time
     /// calculated just using the trapezoidal filter (no CFD) and the second
     /// element is the time calculated using all available CFD information.
-    /// If the CFD information is unavailable these two elements are identical.
-    static std::pair<double, double> CalculateTimeInSamples(const XiaListModeDataMask &mask, const XiaData &data);
+    /// If the CFD information is unavailable these two elements are identical. The layout of the mask is kept like it
+    /// is when we decode, so it's only looked up again when the firmware or frequency changes.
+    std::pair<double, double> CalculateTimeInSamples(const XiaListModeDataMask &mask, const XiaData &data);
+
+    ///Method to calculate the arrival time of the signal in samples using a layout that we've already looked up.
+    ///@param[in] layout : The layout of the firmware and frequency that the data came from
+    ///@param[in] data : The data that we will use to calculate the time
+    ///@return The same pair as CalculateTimeInSamples(const XiaListModeDataMask &, const XiaData &)
+    static std::pair<double, double> CalculateTimeInSamples(const XiaListModeDataLayout &layout, const XiaData &data);
 
     ///Method to calculate the arrival time of the signal in nanoseconds
     ///@param[in] mask : The data mask containing the necessary information
     /// to calculate the time.
     ///@param[in] data : The data that we will use to calculate the time
     ///@return The calculated time in nanoseconds
-    static double CalculateTimeInNs(const XiaListModeDataMask &mask, const XiaData &data);
+    double CalculateTimeInNs(const XiaListModeDataMask &mask, const XiaData &data);
 
 private:
+    ///The layout of the last module that we decoded or timed. Most of the time every module has the same firmware and
+    /// frequency, so we only have to look it up again when they change.
+    XiaListModeDataLayout layout_;
+
+    const XiaChannelFilter *filter_; ///< Decides which hits and traces we keep, null keeps everything
+
+    ///Loops over the events in the buffer and decodes them.
+    ///@param[in] buf : Pointer to the beginning of the data buffer.
+    ///@param[in] mask : The mask set that we need to decode the data
+    ///@param[in] pool : The pool that owns the events, if this is null we allocate the events on the heap.
+    ///@param[out] events : The vector that we append the decoded events to.
+    ///@return The number of events that were appended to the events vector.
+    unsigned int DecodeEvents(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool *pool,
+                              std::vector<XiaData *> &events);
+
     ///Method to decode word zero from the header.
     ///@param[in] word : The word that we need to decode
     ///@param[in] data : The XiaData object that we are going to fill.
+    ///@param[in] layout : The layout to decode the data
     ///@return The pair of the header length and event length for use in
     /// subsequent processing.
     std::pair<unsigned int, unsigned int> DecodeWordZero(const unsigned int &word, XiaData &data,
-                                                         const XiaListModeDataMask &mask);
+                                                         const XiaListModeDataLayout &layout);
 
     ///Method to decode word two from the header.
     ///@param[in] word : The word that we need to decode
     ///@param[in] data : The XiaData object that we are going to fill.
-    ///@param[in] mask : The data mask to decode the data
-    void DecodeWordTwo(const unsigned int &word, XiaData &data, const XiaListModeDataMask &mask);
+    ///@param[in] layout : The layout to decode the data
+    void DecodeWordTwo(const unsigned int &word, XiaData &data, const XiaListModeDataLayout &layout);
 
     ///Method to decode word three from the header.
     ///@param[in] word : The word that we need to decode
     ///@param[in] data : The XiaData object that we are going to fill.
-    ///@param[in] mask : The data mask to decode the data
+    ///@param[in] layout : The layout to decode the data
     ///@return The trace length
-    unsigned int DecodeWordThree(const unsigned int &word, XiaData &data, const XiaListModeDataMask &mask);
+    unsigned int DecodeWordThree(const unsigned int &word, XiaData &data, const XiaListModeDataLayout &layout);
 
-    ///Method to decode word three from the header.
-    ///@param[in] word : The word that we need to decode
+    ///Method to widen the packed trace samples into the trace of the data.
+    ///@param[in] buf : Pointer to the first word of the trace
     ///@param[in] data : The XiaData object that we are going to fill.
+    ///@param[in] traceLength : The number of samples in the trace
     void DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength);
 };
 
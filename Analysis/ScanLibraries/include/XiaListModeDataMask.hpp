@@ -119,6 +119,11 @@ public:
     ///@return The current value of the internal frequency_ variable
     unsigned int GetFrequency() const { return frequency_; }
 
+    ///Getter for the length of one tick of the event time stamp. The 100 and 500 MS/s modules count time in 10 ns
+    /// ticks, the 250 MS/s modules in 8 ns ticks.
+    ///@return The length of one time stamp tick in seconds.
+    double GetTimestampTickInSeconds() const;
+
     ///Sets the firmware version
     ///@param[in] firmware : The firmware type that we would like to set.
     void SetFirmware(const DataProcessing::FIRMWARE &firmware) { firmware_ = firmware; }
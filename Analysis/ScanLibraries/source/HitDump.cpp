@@ -0,0 +1,206 @@
+///@file HitDump.cpp
+///@brief Writes the hits in the built raw events to a compact columnar file and reads them back.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <iostream>
+
+#include "HitDump.hpp"
+
+using namespace std;
+
+namespace {
+    const unsigned int fileMagic = 0x44544948; // "HITD"
+    const unsigned int chunkMagic = 0x4B484348; // "HCHK"
+    const unsigned int fileVersion = 2;
+    const unsigned int hasTracesFlag = 0x1;
+
+    template<typename T>
+    void WriteColumn(ofstream &file, const vector<T> &column) {
+        if (!column.empty())
+            file.write((const char *) column.data(), column.size() * sizeof(T));
+    }
+
+    template<typename T>
+    bool ReadColumn(ifstream &file, vector<T> &column, const size_t &size) {
+        column.resize(size);
+        if (size != 0)
+            file.read((char *) column.data(), size * sizeof(T));
+        return file.good();
+    }
+}
+
+void HitDumpChunk::Clear() {
+    eventNumber.clear();
+    crate.clear();
+    module.clear();
+    channel.clear();
+    timestamp.clear();
+    time.clear();
+    energy.clear();
+    cfdFraction.clear();
+    flags.clear();
+    traceLength.clear();
+    traceOffset.clear();
+    samples.clear();
+}
+
+void HitDumpChunk::Add(const XiaData &hit, const unsigned long long &event, const bool &keepTrace) {
+    eventNumber.push_back(event);
+    crate.push_back((unsigned char) hit.GetCrateNumber());
+    module.push_back((unsigned char) hit.GetModuleNumber());
+    channel.push_back((unsigned char) hit.GetChannelNumber());
+    timestamp.push_back((unsigned long long) hit.GetFilterTime());
+    time.push_back(hit.GetTime());
+    energy.push_back(hit.GetEnergy());
+    cfdFraction.push_back(hit.GetCfdFractionalTime());
+    flags.push_back((unsigned char) ((hit.IsPileup() ? PILEUP : 0) | (hit.IsSaturated() ? SATURATED : 0) |
+                                     (hit.GetCfdForcedTriggerBit() ? CFD_FORCED_TRIGGER : 0) |
+                                     ((hit.GetCfdTriggerSource() << cfdTriggerSourceShift) & CFD_TRIGGER_SOURCE)));
+
+    unsigned int length = keepTrace ? hit.GetTraceLength() : 0;
+    traceLength.push_back(length);
+    traceOffset.push_back(samples.size());
+    if (length != 0) {
+        samples.resize(samples.size() + length);
+        hit.CopyPackedTrace(&samples[samples.size() - length]);
+    }
+}
+
+const unsigned int HitDumpWriter::defaultChunkSize;
+
+HitDumpWriter::HitDumpWriter() : keepTraces_(false), chunkSize_(defaultChunkSize), numEvents_(0), numHits_(0) {}
+
+bool HitDumpWriter::Open(const std::string &filename, const bool &keepTraces, const unsigned int &chunkSize) {
+    Close();
+    file_.open(filename.c_str(), ios::binary | ios::trunc);
+    if (!file_.is_open() || !file_.good()) {
+        cout << "HitDumpWriter::Open - Unable to open " << filename << endl;
+        file_.close();
+        return false;
+    }
+
+    keepTraces_ = keepTraces;
+    chunkSize_ = chunkSize == 0 ? defaultChunkSize : chunkSize;
+    numEvents_ = numHits_ = 0;
+    chunk_.Clear();
+
+    unsigned int flags = keepTraces_ ? hasTracesFlag : 0;
+    file_.write((const char *) &fileMagic, 4);
+    file_.write((const char *) &fileVersion, 4);
+    file_.write((const char *) &flags, 4);
+    return file_.good();
+}
+
+///The chunk is only cut between events, so it can hold a few more hits than the chunk size.
+void HitDumpWriter::Add(const std::deque<XiaData *> &event) {
+    if (!file_.is_open())
+        return;
+
+    for (deque<XiaData *>::const_iterator it = event.begin(); it != event.end(); it++) {
+        if (!(*it))
+            continue;
+        chunk_.Add(**it, numEvents_, keepTraces_);
+        numHits_++;
+    }
+    numEvents_++;
+
+    if (chunk_.GetNumberOfHits() >= chunkSize_)
+        WriteChunk();
+}
+
+void HitDumpWriter::Close() {
+    if (!file_.is_open())
+        return;
+    WriteChunk();
+    file_.close();
+}
+
+void HitDumpWriter::WriteChunk() {
+    unsigned int numHits = (unsigned int) chunk_.GetNumberOfHits();
+    if (numHits == 0)
+        return;
+
+    unsigned long long numSamples = chunk_.samples.size();
+    file_.write((const char *) &chunkMagic, 4);
+    file_.write((const char *) &numHits, 4);
+    file_.write((const char *) &numSamples, 8);
+
+    WriteColumn(file_, chunk_.eventNumber);
+    WriteColumn(file_, chunk_.crate);
+    WriteColumn(file_, chunk_.module);
+    WriteColumn(file_, chunk_.channel);
+    WriteColumn(file_, chunk_.timestamp);
+    WriteColumn(file_, chunk_.time);
+    WriteColumn(file_, chunk_.energy);
+    WriteColumn(file_, chunk_.cfdFraction);
+    WriteColumn(file_, chunk_.flags);
+    if (keepTraces_) {
+        WriteColumn(file_, chunk_.traceLength);
+        WriteColumn(file_, chunk_.samples);
+    }
+
+    if (!file_.good())
+        cout << "HitDumpWriter::WriteChunk - Unable to write " << numHits << " hits to the file." << endl;
+    chunk_.Clear();
+}
+
+bool HitDumpReader::Open(const std::string &filename) {
+    file_.close();
+    file_.clear();
+    file_.open(filename.c_str(), ios::binary);
+    if (!file_.is_open() || !file_.good())
+        return false;
+
+    unsigned int magic = 0, version = 0, flags = 0;
+    file_.read((char *) &magic, 4);
+    file_.read((char *) &version, 4);
+    file_.read((char *) &flags, 4);
+    if (!file_.good() || magic != fileMagic || version != fileVersion) {
+        cout << "HitDumpReader::Open - " << filename << " is not a hit dump we know how to read." << endl;
+        file_.close();
+        return false;
+    }
+
+    hasTraces_ = (flags & hasTracesFlag) != 0;
+    return true;
+}
+
+bool HitDumpReader::ReadChunk(HitDumpChunk &chunk) {
+    chunk.Clear();
+    if (!file_.is_open())
+        return false;
+
+    unsigned int magic = 0, numHits = 0;
+    unsigned long long numSamples = 0;
+    if (!file_.read((char *) &magic, 4) || !file_.read((char *) &numHits, 4) || !file_.read((char *) &numSamples, 8))
+        return false;
+    if (magic != chunkMagic) {
+        cout << "HitDumpReader::ReadChunk - Lost our place in the file, the chunk header is missing." << endl;
+        return false;
+    }
+
+    bool good = ReadColumn(file_, chunk.eventNumber, numHits) && ReadColumn(file_, chunk.crate, numHits) &&
+                ReadColumn(file_, chunk.module, numHits) && ReadColumn(file_, chunk.channel, numHits) &&
+                ReadColumn(file_, chunk.timestamp, numHits) && ReadColumn(file_, chunk.time, numHits) &&
+                ReadColumn(file_, chunk.energy, numHits) && ReadColumn(file_, chunk.cfdFraction, numHits) &&
+                ReadColumn(file_, chunk.flags, numHits);
+    if (good && hasTraces_)
+        good = ReadColumn(file_, chunk.traceLength, numHits) && ReadColumn(file_, chunk.samples, numSamples);
+    else
+        chunk.traceLength.assign(numHits, 0);
+
+    if (!good) {
+        cout << "HitDumpReader::ReadChunk - The file ended part way through a chunk of " << numHits << " hits."
+             << endl;
+        chunk.Clear();
+        return false;
+    }
+
+    chunk.traceOffset.resize(numHits);
+    unsigned long long offset = 0;
+    for (unsigned int i = 0; i < numHits; i++) {
+        chunk.traceOffset[i] = offset;
+        offset += chunk.traceLength[i];
+    }
+    return true;
+}
@@ -10,6 +10,7 @@
  * \author C. R. Thornsberry, S. V. Paulauskas
  * \date Feb. 12th, 2016
  */
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -193,6 +194,12 @@ bool ScanInterface::rewind(const unsigned long &offset_/*=0*/) {
         return false;
     }
 
+    // The spill selection no longer applies once the user has moved around in the file.
+    spills_remaining = -1;
+    spills_to_skip = 0;
+    warmup_remaining = 0;
+    is_warming_up = false;
+
     // Move to the first word in the file.
     cout << " Seeking to word no. " << offset_ << " in file\n";
     input_file.seekg(offset_ * 4, input_file.beg);
@@ -239,6 +246,7 @@ bool ScanInterface::open_input_file(const string &fname_) {
     if (file_open) {
         cout << " Note: Closing previously opened file.\n";
         input_file.close();
+        mapped_file.Close();
     }
 
     file_open = true;
@@ -295,6 +303,17 @@ bool ScanInterface::open_input_file(const string &fname_) {
 
             pldHead.Print();
             cout << endl;
+
+            // The header is still read through the stream, the stream position tells us where the spills start.
+            if (mmap_mode && !mapped_file.Open(fname_))
+                cout << " WARNING! Unable to map the input file, falling back to reading it.\n";
+        }
+
+        if (!select_spills(fname_)) {
+            input_file.close();
+            mapped_file.Close();
+            file_open = false;
+            return false;
         }
     }
 
@@ -304,6 +323,97 @@ bool ScanInterface::open_input_file(const string &fname_) {
     return true;
 }
 
+/** The index lets us seek straight to the selected spills. A time range is converted into the spills that overlap
+  * it, so the first and last spills in the range may have events outside of it. Ldf spills are packed into the
+  * buffers, the index points at the start of the buffer holding the first chunk of the spill. Any spills that start
+  * earlier in that buffer are read in full and have to be skipped. The warm-up spills are scanned before the
+  * selected ones, the derived class decides what to keep from them.
+  * \param[in]  fname_ The input file that we've opened.
+  * \return False if a selection was requested and could not be made.
+  */
+bool ScanInterface::select_spills(const string &fname_) {
+    spills_remaining = -1;
+    spills_to_skip = 0;
+    warmup_remaining = 0;
+    is_warming_up = false;
+
+    if (first_spill < 0 && start_time < 0 && stop_time < 0)
+        return true;
+
+    string index_filename = SpillIndex::GetIndexFilename(fname_);
+    if (!spill_index.Load(index_filename)) {
+        cout << " ERROR! Unable to load the spill index '" << index_filename
+             << "'! Build it with indexBuilder to select spills or times.\n";
+        return false;
+    }
+
+    const vector<SpillIndexEntry> &entries = spill_index.GetEntries();
+    size_t first = 0, stop = entries.size();
+    if (first_spill >= 0) {
+        first = min((size_t) first_spill, entries.size());
+        stop = last_spill < 0 ? first + 1 : min((size_t) last_spill + 1, entries.size());
+    } else {
+        unsigned long long run_start = spill_index.GetStartTime();
+        if (start_time >= 0)
+            first = spill_index.FindFirstSpill(run_start + (unsigned long long) (start_time / clock_tick));
+        if (stop_time >= 0)
+            stop = spill_index.FindStopSpill(run_start + (unsigned long long) (stop_time / clock_tick));
+    }
+
+    if (first >= stop) {
+        cout << " ERROR! None of the " << entries.size() << " spills in the file are in the selected range.\n";
+        return false;
+    }
+
+    cout << msgHeader << "Scanning spills " << first << " to " << stop - 1 << " of " << entries.size() << ".\n";
+
+    warmup_remaining = min((size_t) warmup_spills, first);
+    is_warming_up = warmup_remaining != 0;
+    first -= warmup_remaining;
+    if (is_warming_up) {
+        cout << msgHeader << "Warming up with spills " << first << " to " << first + warmup_remaining - 1 << ".\n";
+        // The warm-up events are only there to rebuild the state of the scan, they don't belong in the hit dump.
+        if (unpacker_)
+            unpacker_->SetHitDumpPaused(true);
+    }
+
+    for (size_t i = first; i > 0 && entries[i - 1].offset == entries[first].offset; i--)
+        spills_to_skip++;
+
+    input_file.seekg(entries[first].offset, input_file.beg);
+    spills_remaining = stop - first;
+
+    // Times in the scan stay relative to the start of the run.
+    if (first != 0 && unpacker_)
+        unpacker_->SetFirstTime(spill_index.GetStartTime());
+    return true;
+}
+
+/// Spills that have been skipped are not counted against the selected spills.
+bool ScanInterface::skip_spill() {
+    if (spills_to_skip > 0) {
+        spills_to_skip--;
+        return true;
+    }
+
+    if (warmup_remaining > 0) {
+        warmup_remaining--;
+    } else if (is_warming_up) {
+        is_warming_up = false;
+        // The events carried over from the last warm-up spill are still warm-up events, they have to be processed
+        // before the derived class drops the warm-up output and before the hit dump is started again.
+        if (unpacker_)
+            unpacker_->FlushEventList();
+        Notify("WARMUP_DONE");
+        if (unpacker_)
+            unpacker_->SetHitDumpPaused(false);
+    }
+
+    if (spills_remaining > 0)
+        spills_remaining--;
+    return false;
+}
+
 /** Add a command line option to the option list.
   * \param[in]  opt_ The option to add to the list.
   * \return Nothing.
@@ -324,6 +434,13 @@ void ScanInterface::AddOption(optionExt opt_) {
     userOpts.push_back(opt_);
 }
 
+const optionExt &ScanInterface::GetUserOption(const string &name_) const {
+    for (vector<optionExt>::const_iterator iter = userOpts.begin(); iter != userOpts.end(); iter++)
+        if (name_ == iter->name)
+            return *iter;
+    throw invalid_argument("ScanInterface::GetUserOption - There is no option named \"" + name_ + "\".");
+}
+
 /** SyntaxStr is used to print a linux style usage message to the screen.
   * Prints a standard usage message by default.
   * \param[in]  name_ The name of the program.
@@ -376,6 +493,17 @@ ScanInterface::ScanInterface() {
     file_start_offset = 0;
     num_spills_recvd = 0;
 
+    first_spill = -1;
+    last_spill = -1;
+    start_time = -1;
+    stop_time = -1;
+    clock_tick = 10e-9;
+    warmup_spills = 0;
+    warmup_remaining = 0;
+    is_warming_up = false;
+    spills_remaining = -1;
+    spills_to_skip = 0;
+
     total_stopped = true;
     write_counts = false;
     is_running = false;
@@ -386,6 +514,7 @@ ScanInterface::ScanInterface() {
     batch_mode = false;
     scan_init = false;
     file_open = false;
+    mmap_mode = false;
 
     //Initialize the setup and output file names and path
     outputFilename_ = "";
@@ -405,6 +534,9 @@ ScanInterface::ScanInterface() {
             optionExt("counts", no_argument, NULL, 0, "", "Write all recorded channel counts to a file"),
             optionExt("debug", no_argument, NULL, 0, "", "Enable readout debug mode"),
             optionExt("dry-run", no_argument, NULL, 0, "", "Extract spills from file, but do no processing"),
+            optionExt("dump-hits", required_argument, NULL, 0, "<filename>",
+                      "Write the hits of every built event to a columnar file that can be read with HitDumpReader"),
+            optionExt("dump-traces", no_argument, NULL, 0, "", "Write the traces to the file given with --dump-hits"),
             optionExt("fast-fwd", required_argument, NULL, 0, "<word>",
                       "Skip ahead to a specified word in the file (start of file at zero)"),
             optionExt("firmware", required_argument, NULL, 'f', "<firmware>", "Sets the firmware revision for decoding the data. "
@@ -413,11 +545,29 @@ ScanInterface::ScanInterface() {
                       "Specifies the sampling frequency used to collect the data."),
             optionExt("help", no_argument, NULL, 'h', "", "Display this dialogue"),
             optionExt("input", required_argument, NULL, 'i', "<filename>", "Specifies the input file to analyze"),
+            optionExt("lookahead", required_argument, NULL, 0, "<clock ticks>",
+                      "Build events across spill boundaries. Events within this many clock ticks of the slowest "
+                              "module's last hit are held for the next spill."),
+            optionExt("mmap", no_argument, NULL, 0, "", "Map pld input files into memory and unpack the spills in place"),
             optionExt("output", required_argument, NULL, 'o', "<filename>",
                       "Specifies the name of the output file. Default is \"out\""),
             optionExt("quiet", no_argument, NULL, 'q', "", "Toggle off verbosity flag"),
             optionExt("shm", no_argument, NULL, 's', "", "Enable shared memory readout"),
-            optionExt("version", no_argument, NULL, 'v', "", "Display version information")
+            optionExt("spill", required_argument, NULL, 0, "<first[:last]>",
+                      "Only scan these spills, counted from zero. Requires the spill index for the file."),
+            optionExt("start-time", required_argument, NULL, 0, "<seconds>",
+                      "Start scanning at the spill holding this time after the first event. Requires the spill "
+                              "index for the file."),
+            optionExt("stop-time", required_argument, NULL, 0, "<seconds>",
+                      "Stop scanning after the spill holding this time after the first event. Requires the spill "
+                              "index for the file."),
+            optionExt("threads", required_argument, NULL, 0, "<number>",
+                      "Decode the module buffers with this many threads. Events are built and processed on their "
+                              "own threads. Default is 0, everything is done on the reading thread."),
+            optionExt("version", no_argument, NULL, 'v', "", "Display version information"),
+            optionExt("warmup", required_argument, NULL, 0, "<spills>",
+                      "Scan this many spills before the ones selected with --spill or --start-time so that state "
+                              "carried between events is rebuilt. What is kept from them is up to the scan code.")
     };
 
     knownArgumentMap_.insert(make_pair("debug", "Toggle debug mode flag (default=false)"));
@@ -443,6 +593,68 @@ ScanInterface::~ScanInterface() {
     Close();
 }
 
+/** The unpacker reads each spill where it sits in the mapping. It expects the spill to end with the two word end of
+  * spill marker, so we borrow the two words after the spill (the end of buffer flag and the start of the next
+  * buffer) while the unpacker has the spill and put them back afterwards. The mapping is private, so the file on
+  * disk never changes.
+  * \param[in]  data Storage for a spill that is too close to the end of the file to borrow the words after it.
+  */
+void ScanInterface::ScanMappedFile(unsigned int *data) {
+    size_t offset = input_file.tellg();
+    unsigned int *spill;
+    unsigned int nBytes;
+
+    while (spills_remaining != 0 &&
+           pldData.Read(mapped_file.GetData(), mapped_file.GetLength(), offset, spill, nBytes, 4 * max_spill_size)) {
+        if (kill_all == true) {
+            break;
+        } else if (!is_running) {
+            IdleTask();
+            usleep(100000); //0.1 seconds
+            continue;
+        }
+
+        skip_spill();
+
+        mapped_file.Advise(offset);
+
+        stringstream status;
+        status << "\033[0;32m" << "[READ] " << "\033[0m" << nBytes / 4 << " words ("
+               << 100 * offset / file_length << "%)";
+        if (!batch_mode) { term->SetStatus(status.str()); }
+        else { cout << "\r" << status.str(); }
+
+        if (debug_mode) {
+            cout << "debug: Retrieved spill of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
+            cout << "debug: Read up to word number " << offset / 4 << " in input file\n";
+        }
+
+        if (!dry_run_mode) {
+            unsigned int nWords = nBytes / 4;
+            if (offset + 4 <= mapped_file.GetLength()) {
+                unsigned int *end = spill + nWords;
+                unsigned int borrowed[2] = {end[0], end[1]};
+                end[0] = 2;
+                end[1] = 9999;
+                unpacker_->ReadSpill(spill, nWords + 2, is_verbose);
+                end[0] = borrowed[0];
+                end[1] = borrowed[1];
+            } else {
+                memcpy(data, spill, nBytes);
+                data[nWords] = 2;
+                data[nWords + 1] = 9999;
+                unpacker_->ReadSpill(data, nWords + 2, is_verbose);
+            }
+            IdleTask();
+        }
+        num_spills_recvd++;
+    }
+
+    // Leave the stream where we stopped so that the EOF buffer and a later rewind work as they do without the map.
+    input_file.clear();
+    input_file.seekg(offset, input_file.beg);
+}
+
 /// Main scan control method.
 void ScanInterface::RunControl() {
     // Notify that we are starting run control.
@@ -582,6 +794,9 @@ void ScanInterface::RunControl() {
             }
 
             delete[] shm_data;
+
+            if (!dry_run_mode)
+                unpacker_->FlushEventList();
         } else if (file_format == 0) {
             unsigned int *data = NULL;
             bool full_spill;
@@ -602,6 +817,11 @@ void ScanInterface::RunControl() {
                     continue;
                 }
 
+                if (spills_remaining == 0) {
+                    cout << msgHeader << "Finished scanning the selected spills.\n";
+                    break;
+                }
+
                 if (!databuff.Read(&input_file, (char *) data, nBytes, 1000000, full_spill, bad_spill, dry_run_mode)) {
                     if (databuff.GetRetval() == 1) {
                         if (debug_mode) {
@@ -640,6 +860,12 @@ void ScanInterface::RunControl() {
                 if (!batch_mode) { term->SetStatus(status.str()); }
                 else { cout << "\r" << status.str(); }
 
+                if (full_spill && skip_spill()) {
+                    if (debug_mode)
+                        cout << "debug: Skipping spill of " << nBytes / 4 << " words before the selected spills\n";
+                    continue;
+                }
+
                 if (full_spill) {
                     if (debug_mode) {
                         cout << "debug: Retrieved spill of " << nBytes << " bytes (" << nBytes / 4 << " words)\n";
@@ -661,7 +887,11 @@ void ScanInterface::RunControl() {
                 num_spills_recvd++;
             }
 
-            if (!dry_run_mode) { delete[] data; }
+            // Process anything that's still waiting for the next spill.
+            if (!dry_run_mode) {
+                unpacker_->FlushEventList();
+                delete[] data;
+            }
 
             if (!batch_mode) {
                 term->SetStatus("\033[0;33m[IDLE]\033[0m Finished scanning file.");
@@ -675,7 +905,11 @@ void ScanInterface::RunControl() {
             // Reset the buffer reader to default values.
             pldData.Reset();
 
-            while (pldData.Read(&input_file, (char *) data, nBytes, 4 * max_spill_size, dry_run_mode)) {
+            if (mapped_file.IsOpen())
+                ScanMappedFile(data);
+
+            while (!mapped_file.IsOpen() && spills_remaining != 0 &&
+                   pldData.Read(&input_file, (char *) data, nBytes, 4 * max_spill_size, dry_run_mode)) {
                 if (kill_all == true) {
                     break;
                 } else if (!is_running) {
@@ -684,6 +918,8 @@ void ScanInterface::RunControl() {
                     continue;
                 }
 
+                skip_spill();
+
                 stringstream status;
                 status << "\033[0;32m" << "[READ] " << "\033[0m" << nBytes / 4 << " words ("
                        << 100 * input_file.tellg() / file_length << "%)";
@@ -705,13 +941,19 @@ void ScanInterface::RunControl() {
                 num_spills_recvd++;
             }
 
-            if (eofbuff.ReadHeader(&input_file)) {
+            if (spills_remaining == 0) {
+                cout << msgHeader << "Finished scanning the selected spills.\n";
+            } else if (eofbuff.ReadHeader(&input_file)) {
                 cout << msgHeader << "Encountered EOF buffer.\n";
             } else {
                 cout << msgHeader << "Failed to find end of file buffer!\n";
             }
 
-            if (!dry_run_mode) { delete[] data; }
+            // Process anything that's still waiting for the next spill.
+            if (!dry_run_mode) {
+                unpacker_->FlushEventList();
+                delete[] data;
+            }
 
             if (!batch_mode) {
                 term->SetStatus("\033[0;33m[IDLE]\033[0m Finished scanning file.");
@@ -860,6 +1102,29 @@ void ScanInterface::OutputUnkownCommandMessage(const std::string &arg) {
     cout << "You've asked for help with \"" << arg << "\", which is unknown to us." << endl;
 }
 
+/** The table is only built the first time so that the options of the derived class are only added once.
+  * \param[out] shortOptions The short options in the form that getopt_long expects them.
+  * \return The long options, ending with the empty option that getopt_long needs.
+  */
+const vector<option> &ScanInterface::GetOptionTable(string &shortOptions) {
+    if (longOpts.empty()) {
+        // Add derived class options to the option list.
+        this->ArgHelp();
+
+        // Build the vector of all command line options.
+        for (vector<optionExt>::iterator iter = baseOpts.begin(); iter != baseOpts.end(); iter++)
+            longOpts.push_back(iter->getOption());
+        for (vector<optionExt>::iterator iter = userOpts.begin(); iter != userOpts.end(); iter++)
+            longOpts.push_back(iter->getOption());
+
+        // Append all zeros onto the option list. Required for getopt_long.
+        struct option zero_opt{0, 0, 0, 0};
+        longOpts.push_back(zero_opt);
+    }
+    shortOptions = optstr;
+    return longOpts;
+}
+
 /** Setup user options and initialize all required objects.
   * \param[in]  argc Number of arguments passed from the command line.
   * \param[in]  argv Array of strings passed as arguments from the command line.
@@ -874,25 +1139,15 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     shm_mode = false;
     num_spills_recvd = 0;
     unsigned int samplingFrequency = 0;
+    double lookaheadWindow = -1;
+    unsigned int numDecodeThreads = 0;
+    string hitDumpFilename = "";
+    bool dumpTraces = false;
     string firmware = "";
     string input_filename = "";
 
-    // Add derived class options to the option list.
-    this->ArgHelp();
-
-    // Build the vector of all command line options.
-    for (vector<optionExt>::iterator iter = baseOpts.begin();
-         iter != baseOpts.end(); iter++) {
-        longOpts.push_back(iter->getOption());
-    }
-    for (vector<optionExt>::iterator iter = userOpts.begin();
-         iter != userOpts.end(); iter++) {
-        longOpts.push_back(iter->getOption());
-    }
-
-    // Append all zeros onto the option list. Required for getopt_long.
-    struct option zero_opt{0, 0, 0, 0};
-    longOpts.push_back(zero_opt);
+    string shortOptions;
+    GetOptionTable(shortOptions);
 
     int idx = 0;
     int retval = 0;
@@ -900,7 +1155,7 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
     //getopt_long is not POSIX compliant. It is provided by GNU. This may mean
     //that we are not compatible with some systems. If we have enough
     //complaints we can either change it to getopt, or implement our own class.
-    while ((retval = getopt_long(argc, argv, optstr.c_str(), longOpts.data(),
+    while ((retval = getopt_long(argc, argv, shortOptions.c_str(), longOpts.data(),
                                  &idx)) != -1) {
         if (retval == 0x0) { // Long option
             if (strcmp("config", longOpts[idx].name) == 0) {
@@ -911,10 +1166,33 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
                 debug_mode = true;
             } else if (strcmp("dry-run", longOpts[idx].name) == 0) {
                 dry_run_mode = true;
+            } else if (strcmp("dump-hits", longOpts[idx].name) == 0) {
+                hitDumpFilename = optarg;
+            } else if (strcmp("dump-traces", longOpts[idx].name) == 0) {
+                dumpTraces = true;
             } else if (strcmp("fast-fwd", longOpts[idx].name) == 0) {
                 file_start_offset = atoll(optarg);
             } else if (strcmp("frequency", longOpts[idx].name) == 0)
                 samplingFrequency = (unsigned int) stoi(optarg);
+            else if (strcmp("lookahead", longOpts[idx].name) == 0)
+                lookaheadWindow = stod(optarg);
+            else if (strcmp("mmap", longOpts[idx].name) == 0)
+                mmap_mode = true;
+            else if (strcmp("spill", longOpts[idx].name) == 0) {
+                string range = optarg;
+                size_t colon = range.find(':');
+                first_spill = stoll(range.substr(0, colon));
+                last_spill = colon == string::npos ? first_spill : stoll(range.substr(colon + 1));
+                if (first_spill < 0 || last_spill < first_spill)
+                    throw invalid_argument("ScanInterface::Setup - The spill range \"" + range + "\" is not valid.");
+            } else if (strcmp("start-time", longOpts[idx].name) == 0)
+                start_time = stod(optarg);
+            else if (strcmp("stop-time", longOpts[idx].name) == 0)
+                stop_time = stod(optarg);
+            else if (strcmp("warmup", longOpts[idx].name) == 0)
+                warmup_spills = (unsigned long) stoul(optarg);
+            else if (strcmp("threads", longOpts[idx].name) == 0)
+                numDecodeThreads = (unsigned int) stoi(optarg);
             else if (strcmp("firmware", longOpts[idx].name) == 0)
                 firmware = optarg;
             else {
@@ -994,9 +1272,22 @@ bool ScanInterface::Setup(int argc, char *argv[], Unpacker *unpacker/*=NULL*/) {
         throw invalid_argument("ScanInterface::Setup - Firmware/Frequency Flags or Config file are not set properly. "
                                        "Cannot Initialize Data Mask.");
 
+    if (start_time >= 0 || stop_time >= 0)
+        clock_tick = unpacker_->GetTimestampTickInSeconds();
+
     if (debug_mode)
         unpacker_->SetDebugMode();
 
+    if (lookaheadWindow >= 0)
+        unpacker_->SetLookaheadWindow(lookaheadWindow);
+
+    unpacker_->SetDecodeThreads(numDecodeThreads);
+
+    if (dumpTraces && hitDumpFilename.empty())
+        throw invalid_argument("ScanInterface::Setup - --dump-traces needs the file given with --dump-hits.");
+    if (!hitDumpFilename.empty() && !unpacker_->OpenHitDump(hitDumpFilename, dumpTraces))
+        throw invalid_argument("ScanInterface::Setup - Unable to open the hit dump \"" + hitDumpFilename + "\".");
+
     // Parse for any extra arguments that are known to the derived class.
     ExtraArguments();
 
@@ -1119,6 +1410,7 @@ bool ScanInterface::Close() {
 
     if (input_file.good())
         input_file.close();
+    mapped_file.Close();
 
     // Clean up detector driver
     cout << "\n" << msgHeader << "Cleaning up...\n";
@@ -0,0 +1,110 @@
+///@file TraceUnpacking.cpp
+///@brief Widens the packed 16-bit trace samples from the Pixie-16 modules into 32-bit samples.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include "TraceUnpacking.hpp"
+
+//The vector paths are compiled with target attributes, so the rest of the library doesn't need to be built for a
+// processor that has AVX2.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TRACEUNPACKING_HAS_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    void WidenScalar(const unsigned short *samples, unsigned int *trace, const unsigned int &length) {
+        for (unsigned int i = 0; i < length; i++)
+            trace[i] = samples[i];
+    }
+
+#ifdef TRACEUNPACKING_HAS_X86
+    ///Interleaves eight samples with zeros to get eight 32-bit samples per 128-bit load.
+    __attribute__((target("sse2")))
+    void WidenSse2(const unsigned short *samples, unsigned int *trace, const unsigned int &length) {
+        const __m128i zero = _mm_setzero_si128();
+        unsigned int i = 0;
+        for (; i + 8 <= length; i += 8) {
+            __m128i packed = _mm_loadu_si128((const __m128i *) (samples + i));
+            _mm_storeu_si128((__m128i *) (trace + i), _mm_unpacklo_epi16(packed, zero));
+            _mm_storeu_si128((__m128i *) (trace + i + 4), _mm_unpackhi_epi16(packed, zero));
+        }
+        WidenScalar(samples + i, trace + i, length - i);
+    }
+
+    ///Zero extends sixteen samples per 256-bit load.
+    __attribute__((target("avx2")))
+    void WidenAvx2(const unsigned short *samples, unsigned int *trace, const unsigned int &length) {
+        unsigned int i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __m128i low = _mm_loadu_si128((const __m128i *) (samples + i));
+            __m128i high = _mm_loadu_si128((const __m128i *) (samples + i + 8));
+            _mm256_storeu_si256((__m256i *) (trace + i), _mm256_cvtepu16_epi32(low));
+            _mm256_storeu_si256((__m256i *) (trace + i + 8), _mm256_cvtepu16_epi32(high));
+        }
+        WidenScalar(samples + i, trace + i, length - i);
+    }
+#endif
+
+    TraceUnpacking::WIDENING_PATH FindBestPath() {
+        if (TraceUnpacking::IsSupported(TraceUnpacking::AVX2))
+            return TraceUnpacking::AVX2;
+        if (TraceUnpacking::IsSupported(TraceUnpacking::SSE2))
+            return TraceUnpacking::SSE2;
+        return TraceUnpacking::SCALAR;
+    }
+}
+
+TraceUnpacking::WIDENING_PATH TraceUnpacking::GetBestPath() {
+    //Initializing a static is thread safe, so the decode threads can all call this.
+    static const WIDENING_PATH best = FindBestPath();
+    return best;
+}
+
+bool TraceUnpacking::IsSupported(const WIDENING_PATH &path) {
+    switch (path) {
+        case SCALAR:
+            return true;
+#ifdef TRACEUNPACKING_HAS_X86
+        case SSE2:
+            return __builtin_cpu_supports("sse2") != 0;
+        case AVX2:
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        default:
+            return false;
+    }
+}
+
+string TraceUnpacking::GetPathName(const WIDENING_PATH &path) {
+    switch (path) {
+        case SSE2:
+            return "SSE2";
+        case AVX2:
+            return "AVX2";
+        default:
+            return "Scalar";
+    }
+}
+
+void TraceUnpacking::Widen(const unsigned short *samples, unsigned int *trace, const unsigned int &length) {
+    Widen(GetBestPath(), samples, trace, length);
+}
+
+void TraceUnpacking::Widen(const WIDENING_PATH &path, const unsigned short *samples, unsigned int *trace,
+                           const unsigned int &length) {
+    switch (path) {
+#ifdef TRACEUNPACKING_HAS_X86
+        case AVX2:
+            WidenAvx2(samples, trace, length);
+            break;
+        case SSE2:
+            WidenSse2(samples, trace, length);
+            break;
+#endif
+        default:
+            WidenScalar(samples, trace, length);
+            break;
+    }
+}
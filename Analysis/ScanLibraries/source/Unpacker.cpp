@@ -11,11 +11,13 @@
  */
 #include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
 
 #include <cstring>
 
+#include "SpillIndex.h"
 #include "Unpacker.hpp"
 #include "XiaData.hpp"
 #include "XiaListModeDataDecoder.hpp"
@@ -23,104 +25,162 @@
 
 using namespace std;
 
-void clearDeque(deque<XiaData *> &list) {
-    while (!list.empty()) {
-        delete list.front();
-        list.pop_front();
-    }
+///Clears the list of events, we only delete the events if they were allocated on the heap. Pooled events are
+/// released when we clear the event list.
+void clearDeque(deque<XiaData *> &list, const bool &isPooled) {
+    if (!isPooled)
+        for (deque<XiaData *>::iterator it = list.begin(); it != list.end(); it++)
+            delete *it;
+    list.clear();
 }
 
-///Scan the event list and sort it by timestamp.
+///The comparison used to keep the merge heap as a min-heap on the time of the front of each module stream.
+static const greater<pair<double, unsigned int> > heapCompare = greater<pair<double, unsigned int> >();
+
+///Ensures that each of the module streams is time ordered and seeds the merge heap with the front of each stream.
 /// @return Nothing.
 void Unpacker::TimeSort() {
-    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
-        sort(iter->begin(), iter->end(), &XiaData::CompareTime);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    mergeHeap_.clear();
+    for (unsigned int i = 0; i < eventList.size(); i++) {
+        if (eventList[i].empty())
+            continue;
+        numOutOfOrderHits_ += OrderStream(eventList[i]);
+        mergeHeap_.push_back(make_pair(eventList[i].front()->GetFilterTime(), i));
+    }
+    make_heap(mergeHeap_.begin(), mergeHeap_.end(), heapCompare);
+
+    buildTime_ += chrono::steady_clock::now() - start;
+}
+
+///We make a single pass over the stream to count the number of hits that are earlier than their predecessor. If
+/// there are none we're done. If there are only a few we move each of them back into place, which costs us the
+/// distance that they need to move. Otherwise the stream is badly out of order and we sort it.
+unsigned int Unpacker::OrderStream(deque<XiaData *> &stream) {
+    unsigned int numOutOfOrder = 0;
+    for (deque<XiaData *>::iterator it = stream.begin() + 1; it < stream.end(); it++)
+        if (XiaData::CompareTime(*it, *(it - 1)))
+            numOutOfOrder++;
+
+    if (numOutOfOrder == 0)
+        return 0;
+
+    ///If more than 1 in 16 hits is out of order it's cheaper to just sort the whole stream.
+    static const unsigned int maxFixupFraction = 16;
+    if (numOutOfOrder * maxFixupFraction > stream.size()) {
+        stable_sort(stream.begin(), stream.end(), &XiaData::CompareTime);
+        return numOutOfOrder;
+    }
+
+    for (deque<XiaData *>::iterator it = stream.begin() + 1; it < stream.end(); it++) {
+        if (!XiaData::CompareTime(*it, *(it - 1)))
+            continue;
+        deque<XiaData *>::iterator position = upper_bound(stream.begin(), it, *it, &XiaData::CompareTime);
+        rotate(position, it, it + 1);
+    }
+
+    return numOutOfOrder;
 }
 
-/** Scan the time sorted event list and package the events into a raw
+/** Merge the time sorted module streams and package the events into a raw
   * event with a size governed by the event width.
+  * \param[out] event     The hits in the event, anything in here is cleared first.
+  * \param[out] startTime The start time of the event window.
+  * \param[out] realStart The time of the first hit in the event.
+  * \param[out] realStop  The time of the last hit in the event.
   * \return True if the event list is not empty and false otherwise.
   */
-bool Unpacker::BuildRawEvent() {
-    if (!rawEvent.empty())
-        ClearRawEvent();
+bool Unpacker::BuildRawEvent(deque<XiaData *> &event, double &startTime, double &realStart, double &realStop) {
+    if (!event.empty())
+        clearDeque(event, usePooledDecoding_);
 
-    if (numRawEvt == 0) {// This is the first rawEvent. Do some special processing.
-        // Find the first XiaData event. The eventList is time sorted by module.
-        // The first component of each deque will be the earliest time from that module.
-        // The first event time will be the minimum of these first components.
-        if (!GetFirstTime(firstTime))
-            return false;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Move the event window forward to the next valid channel fire. This is the top of the merge heap since it
+    // holds the front of each module.
+    double nextStartTime;
+    if (!GetFirstTime(nextStartTime))
+        return false;
+
+    // Hits that would finish this event may still be in the next spill.
+    if (nextStartTime + eventWidth_ >= buildHorizon_)
+        return false;
+
+    startTime = nextStartTime;
+    if (numRawEvt == 0 && !isFirstTimeSet_) {// This is the first rawEvent. Do some special processing.
+        firstTime = startTime;
+        isFirstTimeKnown_.store(true, memory_order_release);
         std::cout << "BuildRawEvent: First event time is " << firstTime << " clock ticks.\n";
-        eventStartTime = firstTime;
-    } else {
-        // Move the event window forward to the next valid channel fire.
-        if (!GetFirstTime(eventStartTime))
-            return false;
     }
 
-    realStartTime = eventStartTime + eventWidth_;
-    realStopTime = eventStartTime;
+    realStart = startTime + eventWidth_;
+    realStop = startTime;
 
     unsigned int mod, chan;
-    string type, subtype, tag;
     XiaData *current_event = NULL;
 
-    // Loop over all  time-sorted modules.
-    for (vector<deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
-        if (iter->empty())
-            continue;
+    // Pull the earliest hit from the heap until it falls outside of the event window.
+    while (!mergeHeap_.empty()) {
+        double currtime = mergeHeap_.front().first;
 
-        // Loop over the list of channels that fired in this buffer
-        while (!iter->empty()) {
-            current_event = iter->front();
-            mod = current_event->GetModuleNumber();
-            chan = current_event->GetChannelNumber();
+        // If the time difference between the current and previous event is
+        // larger than the event width, finalize the current event, otherwise
+        // treat this as part of the current event
+        if ((currtime - startTime) > eventWidth_)
+            break;
 
-            if (mod > MAX_PIXIE_MOD ||
-                chan > MAX_PIXIE_CHAN) { // Skip this channel
-                cout << "BuildRawEvent: Encountered non-physical Pixie ID (mod = "
-                     << mod << ", chan = " << chan << ")\n";
-                delete current_event;
-                iter->pop_front();
-                continue;
-            }
+        unsigned int stream = mergeHeap_.front().second;
+        pop_heap(mergeHeap_.begin(), mergeHeap_.end(), heapCompare);
+        mergeHeap_.pop_back();
+
+        current_event = eventList[stream].front();
+        eventList[stream].pop_front();
 
-            double currtime = current_event->GetFilterTime();
+        // Put the next hit from this module back on the heap.
+        if (!eventList[stream].empty()) {
+            mergeHeap_.push_back(make_pair(eventList[stream].front()->GetFilterTime(), stream));
+            push_heap(mergeHeap_.begin(), mergeHeap_.end(), heapCompare);
+        }
+
+        mod = current_event->GetModuleNumber();
+        chan = current_event->GetChannelNumber();
 
-            // @TODO Check for backwards time-skip. This is un-handled currently and needs fixed CRT!!!
-            if (currtime < eventStartTime)
-                cout << "BuildRawEvent: Detected backwards time-skip from start=" << eventStartTime << " to "
-                     << current_event->GetFilterTime() << "???\n";
+        if (mod > MAX_PIXIE_MOD || chan > MAX_PIXIE_CHAN) { // Skip this channel
+            cout << "BuildRawEvent: Encountered non-physical Pixie ID (mod = "
+                 << mod << ", chan = " << chan << ")\n";
+            if (!usePooledDecoding_)
+                delete current_event;
+            continue;
+        }
 
-            // If the time difference between the current and previous event is
-            // larger than the event width, finalize the current event, otherwise
-            // treat this as part of the current event
-            if ((currtime - eventStartTime) > eventWidth_)
-                break;
+        // @TODO Check for backwards time-skip. This is un-handled currently and needs fixed CRT!!!
+        if (currtime < startTime)
+            cout << "BuildRawEvent: Detected backwards time-skip from start=" << startTime << " to "
+                 << currtime << "???\n";
 
-            // Check for the minimum time in this raw event.
-            if (currtime < realStartTime)
-                realStartTime = currtime;
+        // Check for the minimum time in this raw event.
+        if (currtime < realStart)
+            realStart = currtime;
 
-            // Check for the maximum time in this raw event.
-            if (currtime > realStopTime)
-                realStopTime = currtime;
+        // Check for the maximum time in this raw event.
+        if (currtime > realStop)
+            realStop = currtime;
 
-            // Update raw stats output with the new event before adding it to the raw event.
+        // Update raw stats output with the new event before adding it to the raw event. The consumer thread does
+        // this when we're pipelined since the statistics belong to the children.
+        if (!pipelineRunning_)
             RawStats(current_event);
 
-            // Push this channel event into the rawEvent.
-            rawEvent.push_back(current_event);
-
-            // Remove this event from the event list but do not delete it yet.
-            // Deleting of the channel events will be handled by clearing the rawEvent.
-            iter->pop_front();
-        }
+        // Push this channel event into the rawEvent. Deleting of the channel events will be handled by clearing the
+        // rawEvent.
+        event.push_back(current_event);
     }
 
+    numHitsBuilt_ += event.size();
     numRawEvt++;
 
+    buildTime_ += chrono::steady_clock::now() - start;
     return true;
 }
 
@@ -146,31 +206,227 @@ bool Unpacker::AddEvent(XiaData *event_) {
   * \return Nothing. */
 void Unpacker::ClearEventList() {
     for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++)
-        clearDeque((*iter));
+        clearDeque((*iter), usePooledDecoding_);
+    mergeHeap_.clear();
+
+    numCarried_.clear();
+
+    //The raw event cannot hold on to any events after the pool has been reset.
+    if (usePooledDecoding_) {
+        rawEvent.clear();
+        pools_[0].Reset();
+        pools_[1].Reset();
+    }
+}
+
+/// We remember how many hits are in each stream so that we know which modules had data in the next spill. The
+/// pooled events still point into the current spill buffer, so we copy them and their traces into the other pool.
+/// We then release the current pool so that it's ready for the spill after next.
+void Unpacker::CarryEventList() {
+    mergeHeap_.clear();
+
+    numCarried_.resize(eventList.size());
+    for (unsigned int i = 0; i < eventList.size(); i++)
+        numCarried_[i] = (unsigned int) eventList[i].size();
+
+    if (!usePooledDecoding_)
+        return;
+
+    XiaDataPool &nextPool = pools_[1 - activePool_];
+    nextPool.Reset();
+    for (vector<deque<XiaData *> >::iterator stream = eventList.begin(); stream != eventList.end(); stream++) {
+        for (deque<XiaData *>::iterator it = stream->begin(); it != stream->end(); it++) {
+            XiaData *carried = nextPool.Acquire();
+            *carried = **it;
+            carried->DetachTraceView();
+            *it = carried;
+        }
+    }
+
+    pools_[activePool_].Reset();
+    activePool_ = 1 - activePool_;
+}
+
+/// The slowest module is the module with data in this spill whose last hit is the earliest. Modules that did not
+/// have any new data in this spill had nothing in their FIFO, so their next hit will come after this one.
+void Unpacker::CalculateBuildHorizon() {
+    buildHorizon_ = numeric_limits<double>::max();
+    if (!IsBuildingAcrossSpills())
+        return;
+
+    for (unsigned int i = 0; i < eventList.size(); i++) {
+        unsigned int numCarried = i < numCarried_.size() ? numCarried_[i] : 0;
+        if (eventList[i].size() <= numCarried)
+            continue;
+        if (eventList[i].back()->GetFilterTime() < buildHorizon_)
+            buildHorizon_ = eventList[i].back()->GetFilterTime();
+    }
+
+    if (buildHorizon_ != numeric_limits<double>::max())
+        buildHorizon_ -= lookaheadWindow_;
+}
+
+unsigned int Unpacker::GetNumCarriedHits() const {
+    unsigned int numHits = 0;
+    for (vector<deque<XiaData *> >::const_iterator it = eventList.begin(); it != eventList.end(); it++)
+        numHits += it->size();
+    return numHits;
+}
+
+/// When we're pipelined the builder does the work, and we wait for the consumer to see the flush so that every
+/// event has been processed when we return.
+void Unpacker::FlushEventList() {
+    if (pipelineRunning_) {
+        PipelineItem item;
+        item.type = FLUSH_EVENTS;
+        Dispatch(item);
+        flushesRequested_++;
+        {
+            unique_lock<mutex> lock(consumerMutex_);
+            consumerSignal_.wait(lock, [this] { return flushesCompleted_ == flushesRequested_; });
+        }
+        RethrowPipelineError();
+        return;
+    }
+
+    if (!IsEmpty())
+        BuildRemainingEvents();
+}
+
+/// We ignore the horizon here since there's no more data coming that could finish the events.
+void Unpacker::BuildRemainingEvents() {
+    TimeSort();
+    buildHorizon_ = numeric_limits<double>::max();
+    BuildEvents();
+    ClearEventList();
+}
+
+///Flushing leaves the pipeline running, so toggling the dump doesn't restart the threads.
+void Unpacker::SetHitDumpPaused(const bool &paused) {
+    FlushEventList();
+    hitDumpPaused_ = paused;
+}
+
+void Unpacker::BuildEvents() {
+    const bool checkEvents = NeedsEventRejection();
+
+    if (!pipelineRunning_) {
+        while (BuildRawEvent(rawEvent, eventStartTime, realStartTime, realStopTime)) {
+            if (checkEvents && IsEventRejected(eventStartTime)) {
+                numRejectedEvents_++;
+                ClearRawEvent();
+                continue;
+            }
+            if (hitDump_.IsOpen() && !hitDumpPaused_)
+                hitDump_.Add(rawEvent);
+            ProcessRawEvent();
+        }
+        return;
+    }
+
+    BuiltEvent built;
+    built.type = DECODE_BUFFER;
+    while (BuildRawEvent(built.hits, built.startTime, built.realStartTime, built.realStopTime)) {
+        if (checkEvents && IsEventRejected(built.startTime)) {
+            numRejectedEvents_++;
+            continue;
+        }
+        if (hitDump_.IsOpen() && !hitDumpPaused_)
+            hitDump_.Add(built.hits);
+        if (builtEvents_->Push(built))
+            builderStats_.numStalls++;
+        builderStats_.numItems++;
+        built.hits.clear();
+        built.type = DECODE_BUFFER;
+    }
+    clearDeque(built.hits, usePooledDecoding_);
+}
+
+/// The span runs from the earliest hit waiting to be built to the latest one. The first time of the run is set by
+/// the first event that we build, which starts with the earliest hit.
+bool Unpacker::NeedsEventRejection() {
+    double first;
+    if (rejectionRegions_.IsEmpty() || !GetFirstTime(first))
+        return false;
+
+    double last = first;
+    for (vector<deque<XiaData *> >::iterator it = eventList.begin(); it != eventList.end(); it++)
+        if (!it->empty())
+            last = max(last, it->back()->GetFilterTime());
+
+    double origin = numRawEvt == 0 && !isFirstTimeSet_ ? first : firstTime;
+    return rejectionRegions_.Classify((first - origin) * clockInSeconds_, (last - origin) * clockInSeconds_)
+           != IntervalIndex::OUTSIDE;
+}
+
+/// The span is widened by an event width on both ends. Hits from the neighbouring spills that are that close could
+/// share an event with the hits in this one when we're building across spills, and the events that they start are
+/// inside the region too.
+bool Unpacker::IsSpillRejected(const unsigned int *data, const unsigned int &nWords) const {
+    if (rejectionRegions_.IsEmpty() || !isFirstTimeKnown_.load(memory_order_acquire))
+        return false;
+
+    unsigned long long first, last;
+    if (SpillIndex::ScanSpill(data, nWords, first, last) == 0)
+        return false;
+
+    return rejectionRegions_.Classify((first - eventWidth_ - firstTime) * clockInSeconds_,
+                                      (last + eventWidth_ - firstTime) * clockInSeconds_) == IntervalIndex::INSIDE;
+}
+
+void Unpacker::DiscardSpill() {
+    if (!pipelineRunning_) {
+        ClearEventList();
+        return;
+    }
+    PipelineItem item;
+    item.type = CLEAR_EVENTS;
+    Dispatch(item);
+}
+
+///We don't wait for the builder when we're pipelined, the next FlushEventList waits for this flush as well.
+void Unpacker::SkipRejectedSpill(const unsigned int *data, const unsigned int &nWords) {
+    const unsigned int maxVsn = 14; // No more than 14 pixie modules per crate
+    numRejectedSpills_++;
+
+    unsigned int nWords_read = 0;
+    while (nWords_read + 1 < nWords) {
+        if (data[nWords_read] == 0xFFFFFFFF) {
+            nWords_read++;
+            continue;
+        }
+        unsigned int lenRec = data[nWords_read];
+        unsigned int vsn = data[nWords_read + 1];
+        if (lenRec == 0 || lenRec > maxWords || vsn == 9999 || (vsn > maxVsn && vsn != 1000))
+            break;
+        if (vsn > maxModuleNumberInFile_ && vsn != 1000)
+            maxModuleNumberInFile_ = vsn;
+        nWords_read += lenRec;
+    }
+
+    if (pipelineRunning_) {
+        PipelineItem item;
+        item.type = FLUSH_EVENTS;
+        Dispatch(item);
+        flushesRequested_++;
+    } else if (!IsEmpty())
+        BuildRemainingEvents();
 }
 
 /** Clear all events in the raw event list. WARNING! This method will delete all events in the
   * event list. This could cause seg faults if the events are used elsewhere.
   * \return Nothing. */
 void Unpacker::ClearRawEvent() {
-    clearDeque(rawEvent);
+    clearDeque(rawEvent, usePooledDecoding_);
 }
 
-/** Get the minimum channel time from the event list.
+/** Get the minimum channel time from the event list. This is the top of the merge heap.
   * \param[out] time The minimum time from the event list in system clock ticks.
   * \return True if the event list is not empty and false otherwise. */
 bool Unpacker::GetFirstTime(double &time) {
-    if (IsEmpty())
+    if (mergeHeap_.empty())
         return false;
-
-    time = std::numeric_limits<double>::max();
-    for (std::vector<std::deque<XiaData *> >::iterator iter = eventList.begin(); iter != eventList.end(); iter++) {
-        if (iter->empty())
-            continue;
-        if (iter->front()->GetFilterTime() < time)
-            time = iter->front()->GetFilterTime();
-    }
-
+    time = mergeHeap_.front().first;
     return true;
 }
 
@@ -190,31 +446,59 @@ void Unpacker::ProcessRawEvent() {
 
 ///Called form ReadSpill. Scan the current spill and construct a list of events which fired by obtaining the module,
 /// channel, trace, etc. of the timestamped event. This method will construct the event list for later processing.
+/// When we're pipelined the buffer is handed to a decode thread along with its mask, so we don't know how many
+/// XiaDatas it holds. The builder thread keeps that count instead.
 ///@param[in] buf : Pointer to an array of unsigned ints containing raw buffer data.
-///@return The number of XiaDatas read from the buffer.
+///@return The number of XiaDatas read from the buffer, always zero when pipelined.
 int Unpacker::ReadBuffer(unsigned int *buf, const unsigned int &vsn) {
-    static XiaListModeDataDecoder decoder;
+    decoder_.SetChannelFilter(&channelFilter_);
 
     if (maskMap_.size() != 0) {
         auto found = maskMap_.find(vsn);
         if(found == maskMap_.end())
             throw invalid_argument("Unpacker::ReadBuffer - Unable to locate VSN = " + to_string(vsn)
                                    + " in the maskMap. Ensure that it's defined in your configuration file!");
-        mask_.SetFirmware((*found).second.first);
-        mask_.SetFrequency((*found).second.second);
+        mask_ = found->second;
     }
 
-    std::vector<XiaData *> decodedList = decoder.DecodeBuffer(buf, mask_);
+    if (pipelineRunning_) {
+        //ParseSpill would never get past a record with no length, so we can't leave it for the decode thread.
+        if (buf[0] == 0)
+            throw length_error("Unpacker::ReadBuffer - The buffer length was sized 0. This is a huge issue.");
+
+        PipelineItem item;
+        item.type = DECODE_BUFFER;
+        item.buffer = buf;
+        item.mask = mask_;
+        Dispatch(item);
+        return 0;
+    }
+
+    if (usePooledDecoding_) {
+        decodedList_.clear();
+        decoder_.DecodeBuffer(buf, mask_, pools_[activePool_], decodedList_);
+        for (vector<XiaData *>::iterator it = decodedList_.begin(); it != decodedList_.end(); it++)
+            AddEvent(*it);
+        return (int) decodedList_.size();
+    }
+
+    std::vector<XiaData *> decodedList = decoder_.DecodeBuffer(buf, mask_);
     for (vector<XiaData *>::iterator it = decodedList.begin(); it != decodedList.end(); it++)
         AddEvent(*it);
     return (int) decodedList.size();
 }
 
-Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), running(true),
+Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), maxModuleNumberInFile_(0), running(true),
                        TOTALREAD(1000000), // Maximum number of data words to read.
                        maxWords(131072), // Maximum number of data words for revision D.
                        numRawEvt(0), // Count of raw events read from file.
-                       firstTime(0), eventStartTime(0), realStartTime(0), realStopTime(0) {
+                       firstTime(0), isFirstTimeSet_(false), isFirstTimeKnown_(false), eventStartTime(0),
+                       realStartTime(0), realStopTime(0), usePooledDecoding_(false), numSpillsParsed_(0),
+                       numFullSpills_(0), clockInSeconds_(0),
+                       numRejectedSpills_(0), numRejectedEvents_(0), hitDumpPaused_(false), activePool_(0), lookaheadWindow_(-1),
+                       buildHorizon_(numeric_limits<double>::max()), numHitsBuilt_(0), numOutOfOrderHits_(0),
+                       buildTime_(0), numDecodeThreads_(0), pipelineRunning_(false), nextDecodeThread_(0),
+                       flushesCompleted_(0), flushesRequested_(0), discardEvents_(false), numBuilderEvents_(0) {
 
     for (unsigned int i = 0; i <= MAX_PIXIE_MOD; i++)
         for (unsigned int j = 0; j <= MAX_PIXIE_CHAN; j++)
@@ -222,6 +506,13 @@ Unpacker::Unpacker() : debug_mode(false), eventWidth_(62), running(true),
 }
 
 Unpacker::~Unpacker() {
+    // Our children are gone by now, so the consumer cannot call ProcessRawEvent on anything that's still in flight.
+    discardEvents_ = true;
+    StopPipeline();
+    hitDump_.Close();
+
+    if (numHitsBuilt_ > 0)
+        PrintBuildStatistics();
     ClearRawEvent();
     ClearEventList();
 }
@@ -241,9 +532,10 @@ void Unpacker::InitializeDataMask(const std::string &firmware, const unsigned in
                 throw invalid_argument("Unpacker::InitializeDataMask - Unable to read the \"frequency\" attribute from"
                                                " the /Configuration/Map/Module/" + to_string(modCounter));
 
+            //The firmware string is converted once here rather than for every buffer that we read.
             maskMap_.insert(make_pair(it->attribute("number").as_uint(),
-                                      make_pair(it->attribute("firmware").as_string(),
-                                                it->attribute("frequency").as_uint())));
+                                      XiaListModeDataMask(it->attribute("firmware").as_string(),
+                                                          it->attribute("frequency").as_uint())));
         }
     } else {
         mask_.SetFrequency(frequency);
@@ -251,31 +543,83 @@ void Unpacker::InitializeDataMask(const std::string &firmware, const unsigned in
     }
 }
 
+double Unpacker::GetTimestampTickInSeconds() const {
+    if (maskMap_.empty())
+        return mask_.GetTimestampTickInSeconds();
+
+    double tick = maskMap_.begin()->second.GetTimestampTickInSeconds();
+    for (map<unsigned int, XiaListModeDataMask>::const_iterator it = maskMap_.begin(); it != maskMap_.end(); ++it)
+        if (it->second.GetTimestampTickInSeconds() != tick)
+            throw invalid_argument("Unpacker::GetTimestampTickInSeconds - Module " + to_string(it->first) +
+                                   " does not count time in the same units as module " +
+                                   to_string(maskMap_.begin()->first) + ".");
+    return tick;
+}
+
 /** ReadSpill is responsible for constructing a list of pixie16 events from
   * a raw data spill. This method performs sanity checks on the spill and
   * calls ReadBuffer in order to construct the event list.
   * \param[in]  data       Pointer to an array of unsigned ints containing the spill data.
   * \param[in]  nWords     The number of words in the array.
   * \param[in]  is_verbose Toggle the verbosity flag on/off.
-  * \return True if the spill was read successfully and false otherwise.
+  * \return False if the spill failed the sanity checks or was split between buffers.
   */
 bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbose/*=true*/) {
+    // Spills inside a rejection region are never decoded.
+    if (IsSpillRejected(data, nWords)) {
+        SkipRejectedSpill(data, nWords);
+        return true;
+    }
+
+    if (numDecodeThreads_ == 0)
+        return ParseSpill(data, nWords, is_verbose);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (!pipelineRunning_)
+        StartPipeline();
+    RethrowPipelineError();
+
+    // The caller reuses data for the next spill, so the decode threads need their own copy. A spill this large
+    // would be rejected after parsing anyway, but we don't have room to copy it.
+    if (nWords > TOTALREAD) {
+        cout << "ReadSpill: Values of nn - " << nWords << " TOTALREAD - " << TOTALREAD << endl;
+        return false;
+    }
+
+    unsigned int *spill;
+    freeSpills_->Pop(spill);
+    memcpy(spill, data, nWords * sizeof(unsigned int));
+    // The parser may peek one record past the end of the spill. Make sure that it fails the sanity check.
+    spill[nWords] = maxWords + 1;
+    spill[nWords + 1] = 0;
+
+    bool retval = ParseSpill(spill, nWords, is_verbose);
+
+    PipelineItem release;
+    release.type = RELEASE_SPILL;
+    release.buffer = spill;
+    Dispatch(release);
+
+    readerStats_.numItems++;
+    readerStats_.numUnits += nWords;
+    readerStats_.busyTime += chrono::steady_clock::now() - start;
+    return retval;
+}
+
+///This is the body of ReadSpill. When we're pipelined the spill was copied into one of our buffers, ReadBuffer
+/// hands the module buffers to the decode threads, and the events are built by the builder thread.
+bool Unpacker::ParseSpill(unsigned int *data, const unsigned int &nWords, const bool &is_verbose) {
     const unsigned int maxVsn = 14; // No more than 14 pixie modules per crate
     unsigned int nWords_read = 0;
 
     int retval = 0; // return value from various functions
 
-    // Various event counters
     unsigned long numEvents = 0;
-    static int counter = 0; // the number of times this function is called
-    static int evCount;     // the number of times data is passed to ScanList
     unsigned int lastVsn = 0xFFFFFFFF; // the last vsn read from the data
     time_t theTime = 0;
 
-    if (counter == 0)
-        maxModuleNumberInFile_ = 0;
-
-    counter++;
+    numSpillsParsed_++;
 
     unsigned int lenRec = 0xFFFFFFFF;
     unsigned int vsn = 0xFFFFFFFF;
@@ -318,7 +662,7 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
                 if (is_verbose)
                     cout << "ReadSpill: MISSING BUFFER " << lastVsn + 1 << ", lastVsn = " << lastVsn << ", vsn = "
                          << vsn << ", lenrec = " << lenRec << endl;
-                ClearEventList();
+                DiscardSpill();
                 fullSpill = false; // WHY WAS THIS TRUE!?!? CRT
             }
 
@@ -331,11 +675,11 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
             //Print error message and reset variables if necessary
             if (retval <= -100) {
                 if (is_verbose)
-                    cout << "ReadSpill: READOUT PROBLEM " << retval << " in event " << counter << endl;
+                    cout << "ReadSpill: READOUT PROBLEM " << retval << " in event " << numSpillsParsed_ << endl;
                 if (retval == -100) {
                     if (is_verbose)
                         cout << "ReadSpill:  Remove list " << lastVsn << " " << vsn << endl;
-                    ClearEventList();
+                    DiscardSpill();
                 }
                 return false;
             } else if (retval > 0) {
@@ -385,46 +729,66 @@ bool Unpacker::ReadSpill(unsigned int *data, unsigned int nWords, bool is_verbos
     if (is_verbose && nWords_read != nWords)
         cout << "ReadSpill: Received spill of " << nWords << " words, but read " << nWords_read << " words\n";
 
-    // If there are events to process, continue
-    if (numEvents > 0) {
-        if (fullSpill) { // if full spill process events
-            // Sort the vector of pointers eventlist according to time
-            //double lastTimestamp = (*(eventList.rbegin()))->time;
+    // The builder thread works out what to do with the spill once it has all of the decoded buffers.
+    if (pipelineRunning_) {
+        PipelineItem item;
+        item.type = BUILD_SPILL;
+        item.fullSpill = fullSpill;
+        item.verbose = is_verbose;
+        Dispatch(item);
+    } else
+        ProcessSpill(fullSpill, numEvents, is_verbose);
+
+    if (fullSpill) {
+        // Update the event counter. Every once in a while (when evcount is a multiple of 1000) print the time
+        // elapsed doing the analysis
+        numFullSpills_++;
+        if ((numFullSpills_ % 1000 == 0 || numFullSpills_ == 1) && theTime != 0)
+            cout << endl << "ReadSpill: Data read up to poll status time " << ctime(&theTime);
+    }
+
+    // The builder hasn't seen the spill yet when we're pipelined, so both paths only report what parsing told us.
+    return fullSpill;
+}
 
+void Unpacker::ProcessSpill(const bool &fullSpill, const unsigned long &numEvents, const bool &is_verbose) {
+    // If there are events to process, continue. Hits carried from the previous spill are also processed.
+    if (numEvents > 0 || (fullSpill && !IsEmpty())) {
+        if (fullSpill) { // if full spill process events
             // Sort the event list in time
             TimeSort();
 
             // Once the vector of pointers eventlist is sorted based on time,
-            // begin the event processing in ScanList().
-            // ScanList will also clear the event list for us.
-            while (BuildRawEvent())
-                ProcessRawEvent();
-
-            ClearEventList();
-
-            // Once the eventlist has been scanned, reset the number
-            // of events to zero and update the event counter
-            numEvents = 0;
-            evCount++;
-
-            // Every once in a while (when evcount is a multiple of 1000)
-            // print the time elapsed doing the analysis
-            if ((evCount % 1000 == 0 || evCount == 1) && theTime != 0)
-                cout << endl << "ReadSpill: Data read up to poll status time " << ctime(&theTime);
-        } else {
+            // begin the event processing in ScanList(). When we're building
+            // across spills we stop at the horizon and keep the rest of the
+            // hits for the next spill.
+            CalculateBuildHorizon();
+            BuildEvents();
+
+            if (IsBuildingAcrossSpills())
+                CarryEventList();
+            else
+                ClearEventList();
+            return;
+        }
+
+        if (IsBuildingAcrossSpills()) {
+            // Keep the events, they'll be built along with the next spill.
+            CarryEventList();
             if (is_verbose)
-                cout << "ReadSpill: Spill split between buffers" << endl;
-            ClearEventList(); // This tosses out all events read into the deque so far
-            return false;
+                cout << "ReadSpill: Spill split between buffers, carrying " << GetNumCarriedHits()
+                     << " hits into the next spill" << endl;
+            return;
         }
-    } else if (retval != -10) {
         if (is_verbose)
-            cout << "ReadSpill: bad buffer, numEvents = " << numEvents << endl;
+            cout << "ReadSpill: Spill split between buffers" << endl;
         ClearEventList(); // This tosses out all events read into the deque so far
-        return false;
+        return;
     }
 
-    return true;
+    if (is_verbose)
+        cout << "ReadSpill: bad buffer, numEvents = " << numEvents << endl;
+    ClearEventList(); // This tosses out all events read into the deque so far
 }
 
 /** Write all recorded channel counts to a file.
@@ -439,3 +803,290 @@ void Unpacker::Write() {
         count_output.close();
     }
 }
+
+/// Prints the statistics about the event building. The throughput only includes the time that we spent ordering the
+/// streams and building the events, it does not include decoding the data or processing the events.
+void Unpacker::PrintBuildStatistics() const {
+    cout << "Unpacker::PrintBuildStatistics - Built " << numRawEvt << " raw events from " << numHitsBuilt_
+         << " hits in " << buildTime_.count() << " seconds";
+    if (buildTime_.count() > 0)
+        cout << " (" << numHitsBuilt_ / buildTime_.count() << " hits/s)";
+    cout << ". " << numOutOfOrderHits_ << " hits arrived out of order." << endl;
+    if (!rejectionRegions_.IsEmpty())
+        cout << "Unpacker::PrintBuildStatistics - Skipped " << numRejectedSpills_ << " spills and threw away "
+             << numRejectedEvents_ << " events inside the rejection regions." << endl;
+    if (hitDump_.GetNumberOfEvents() > 0)
+        cout << "Unpacker::PrintBuildStatistics - Wrote " << hitDump_.GetNumberOfHits() << " hits from "
+             << hitDump_.GetNumberOfEvents() << " events to the hit dump." << endl;
+}
+
+/// The queues only need to be deep enough to smooth out the differences between the stages. A spill holds a few
+/// dozen module buffers, so each decode thread can hold a couple of spills' worth of work.
+void Unpacker::StartPipeline() {
+    static const unsigned int numSpillBuffers = 4;
+    static const unsigned int decodeQueueDepth = 256;
+    static const unsigned int eventQueueDepth = 8192;
+
+    // The decode threads allocate the events on the heap so that they outlive the spill buffer.
+    usePooledDecoding_ = false;
+
+    spillBuffers_.assign(numSpillBuffers, vector<unsigned int>(TOTALREAD + maxWords + 2));
+    freeSpills_.reset(new BoundedQueue<unsigned int *>(numSpillBuffers));
+    for (vector<vector<unsigned int> >::iterator it = spillBuffers_.begin(); it != spillBuffers_.end(); it++) {
+        unsigned int *spill = it->data();
+        freeSpills_->TryPush(spill);
+    }
+
+    builtEvents_.reset(new BoundedQueue<BuiltEvent>(eventQueueDepth));
+    decodeInput_.clear();
+    decodeOutput_.clear();
+    for (unsigned int i = 0; i < numDecodeThreads_; i++) {
+        decodeInput_.emplace_back(new BoundedQueue<PipelineItem>(decodeQueueDepth));
+        decodeOutput_.emplace_back(new BoundedQueue<PipelineItem>(decodeQueueDepth));
+    }
+
+    StageStatistics empty = {0, 0, 0, chrono::duration<double>(0)};
+    readerStats_ = builderStats_ = consumerStats_ = empty;
+    decodeStats_.assign(numDecodeThreads_, empty);
+
+    nextDecodeThread_ = 0;
+    numBuilderEvents_ = 0;
+    flushesCompleted_ = flushesRequested_ = 0;
+    pipelineError_ = nullptr;
+    pipelineRunning_ = true;
+
+    for (unsigned int i = 0; i < numDecodeThreads_; i++)
+        decodeThreads_.push_back(thread(&Unpacker::DecodeLoop, this, i));
+    builderThread_ = thread(&Unpacker::BuilderLoop, this);
+    consumerThread_ = thread(&Unpacker::ConsumerLoop, this);
+
+    cout << "Unpacker::StartPipeline - Started the unpacking pipeline with " << numDecodeThreads_
+         << " decode thread(s)." << endl;
+}
+
+void Unpacker::Dispatch(PipelineItem &item) {
+    if (decodeInput_[nextDecodeThread_]->Push(item))
+        readerStats_.numStalls++;
+    nextDecodeThread_ = (nextDecodeThread_ + 1) % numDecodeThreads_;
+}
+
+/// Everything other than a module buffer is passed straight through so that the builder sees the items in the order
+/// that they were dispatched. An exception would take down the whole program from here, so it's passed along with
+/// the item and the reader rethrows it like ReadSpill would have when we're not pipelined.
+void Unpacker::DecodeLoop(const unsigned int idx) {
+    XiaListModeDataDecoder decoder;
+    decoder.SetChannelFilter(&channelFilter_);
+    StageStatistics &stats = decodeStats_[idx];
+    PipelineItem item;
+
+    while (true) {
+        decodeInput_[idx]->Pop(item);
+
+        if (item.type == DECODE_BUFFER) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            try {
+                item.decoded = decoder.DecodeBuffer(item.buffer, item.mask);
+            } catch (...) {
+                item.error = current_exception();
+                item.decoded.clear();
+            }
+            stats.numItems++;
+            stats.numUnits += item.decoded.size();
+            stats.busyTime += chrono::steady_clock::now() - start;
+        }
+
+        bool isStop = item.type == STOP_PIPELINE;
+        if (decodeOutput_[idx]->Push(item))
+            stats.numStalls++;
+        if (isStop)
+            return;
+    }
+}
+
+/// The builder owns the eventList, merge heap and horizon while the pipeline is running. Collecting the items from
+/// the decode threads in the same round robin order that the reader dealt them keeps the spills in order.
+void Unpacker::BuilderLoop() {
+    unsigned int next = 0, numStopped = 0;
+    PipelineItem item;
+
+    while (numStopped < numDecodeThreads_) {
+        decodeOutput_[next]->Pop(item);
+        next = (next + 1) % numDecodeThreads_;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        try {
+            if (item.error)
+                rethrow_exception(item.error);
+
+            switch (item.type) {
+                case DECODE_BUFFER:
+                    for (vector<XiaData *>::iterator it = item.decoded.begin(); it != item.decoded.end(); it++)
+                        if (!AddEvent(*it))
+                            delete *it;
+                    numBuilderEvents_ += item.decoded.size();
+                    builderStats_.numUnits += item.decoded.size();
+                    break;
+                case CLEAR_EVENTS:
+                    ClearEventList();
+                    break;
+                case BUILD_SPILL:
+                    ProcessSpill(item.fullSpill, numBuilderEvents_, item.verbose);
+                    numBuilderEvents_ = 0;
+                    break;
+                case RELEASE_SPILL:
+                    freeSpills_->Push(item.buffer);
+                    break;
+                case FLUSH_EVENTS:
+                    if (!IsEmpty())
+                        BuildRemainingEvents();
+                    break;
+                case PIPELINE_ERROR:
+                    break;
+                case STOP_PIPELINE:
+                    numStopped++;
+                    break;
+            }
+        } catch (...) {
+            BuiltEvent marker;
+            marker.type = PIPELINE_ERROR;
+            marker.error = current_exception();
+            builtEvents_->Push(marker);
+        }
+
+        //The reader is waiting on the flush, so it has to get through even if building the events threw.
+        if (item.type == FLUSH_EVENTS) {
+            BuiltEvent marker;
+            marker.type = FLUSH_EVENTS;
+            builtEvents_->Push(marker);
+        }
+        builderStats_.busyTime += chrono::steady_clock::now() - start;
+    }
+
+    BuiltEvent marker;
+    marker.type = STOP_PIPELINE;
+    builtEvents_->Push(marker);
+}
+
+/// The consumer puts each event where the children expect to find it, so ProcessRawEvent works the same as it does
+/// when we unpack in ReadSpill. Once a stage has thrown we drop the events until the reader has rethrown the
+/// exception, just like the events after the exception would never have been processed in ReadSpill.
+void Unpacker::ConsumerLoop() {
+    BuiltEvent built;
+
+    while (true) {
+        builtEvents_->Pop(built);
+
+        if (built.type == STOP_PIPELINE)
+            return;
+        if (built.type == FLUSH_EVENTS || built.type == PIPELINE_ERROR) {
+            {
+                lock_guard<mutex> lock(consumerMutex_);
+                if (built.type == FLUSH_EVENTS)
+                    flushesCompleted_++;
+                else if (!pipelineError_)
+                    pipelineError_ = built.error;
+            }
+            consumerSignal_.notify_all();
+            continue;
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        bool hasError;
+        {
+            lock_guard<mutex> lock(consumerMutex_);
+            hasError = (bool) pipelineError_;
+        }
+        if (hasError || discardEvents_.load(memory_order_relaxed)) {
+            clearDeque(built.hits, false);
+            continue;
+        }
+
+        rawEvent.swap(built.hits);
+        eventStartTime = built.startTime;
+        realStartTime = built.realStartTime;
+        realStopTime = built.realStopTime;
+
+        for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+            RawStats(*it);
+
+        consumerStats_.numItems++;
+        consumerStats_.numUnits += rawEvent.size();
+
+        try {
+            ProcessRawEvent();
+        } catch (...) {
+            {
+                lock_guard<mutex> lock(consumerMutex_);
+                if (!pipelineError_)
+                    pipelineError_ = current_exception();
+            }
+            consumerSignal_.notify_all();
+        }
+        ClearRawEvent();
+        consumerStats_.busyTime += chrono::steady_clock::now() - start;
+    }
+}
+
+void Unpacker::RethrowPipelineError() {
+    exception_ptr error;
+    {
+        lock_guard<mutex> lock(consumerMutex_);
+        swap(error, pipelineError_);
+    }
+    if (error)
+        rethrow_exception(error);
+}
+
+/// The stop items follow everything that's already been dispatched, so the threads finish their work before they
+/// exit. Anything left in the event list is not built, call FlushEventList first if you want it.
+void Unpacker::StopPipeline() {
+    if (!pipelineRunning_)
+        return;
+
+    for (unsigned int i = 0; i < numDecodeThreads_; i++) {
+        PipelineItem item;
+        item.type = STOP_PIPELINE;
+        Dispatch(item);
+    }
+
+    for (vector<thread>::iterator it = decodeThreads_.begin(); it != decodeThreads_.end(); it++)
+        it->join();
+    builderThread_.join();
+    consumerThread_.join();
+
+    decodeThreads_.clear();
+    decodeInput_.clear();
+    decodeOutput_.clear();
+    builtEvents_.reset();
+    freeSpills_.reset();
+    spillBuffers_.clear();
+    pipelineRunning_ = false;
+
+    PrintPipelineStatistics();
+}
+
+///Prints a single line of the pipeline statistics.
+static void PrintStage(const string &name, const unsigned long long &numItems, const string &itemName,
+                       const unsigned long long &numUnits, const string &unitName,
+                       const unsigned long long &numStalls, const chrono::duration<double> &busyTime) {
+    cout << "    " << name << " : " << numItems << " " << itemName << ", " << numUnits << " " << unitName << " in "
+         << busyTime.count() << " s";
+    if (busyTime.count() > 0)
+        cout << " (" << numUnits / busyTime.count() << " " << unitName << "/s)";
+    cout << ", " << numStalls << " stalls" << endl;
+}
+
+/// The busy time does not include the time that a stage spent waiting for work, so the stage with the lowest
+/// throughput is the bottleneck. A stage that stalls often is waiting on the stage after it.
+void Unpacker::PrintPipelineStatistics() const {
+    cout << "Unpacker::PrintPipelineStatistics - Throughput of each stage of the pipeline:" << endl;
+    PrintStage("Reader  ", readerStats_.numItems, "spills", readerStats_.numUnits, "words", readerStats_.numStalls,
+               readerStats_.busyTime);
+    for (unsigned int i = 0; i < decodeStats_.size(); i++)
+        PrintStage("Decode " + to_string(i), decodeStats_[i].numItems, "buffers", decodeStats_[i].numUnits, "hits",
+                   decodeStats_[i].numStalls, decodeStats_[i].busyTime);
+    PrintStage("Builder ", builderStats_.numItems, "events", builderStats_.numUnits, "hits",
+               builderStats_.numStalls, builderStats_.busyTime);
+    PrintStage("Consumer", consumerStats_.numItems, "events", consumerStats_.numUnits, "hits",
+               consumerStats_.numStalls, consumerStats_.busyTime);
+}
@@ -4,18 +4,39 @@
 ///@authors C. R. Thornsberry and S. V. Paulauskas
 #include "XiaData.hpp"
 
+#include <utility>
+
 ///Clears all of the variables. The vectors are all cleared using the clear() method. This method is called when the class is
 /// first initalizied so that it has some default values for the software to use in the event that they are needed.
 void XiaData::Initialize() {
-    cfdForceTrig_ = cfdTrigSource_ = isPileup_ = isSaturated_ = isVirtualChannel_ = false;
+    cfdForceTrig_ = isPileup_ = isSaturated_ = isVirtualChannel_ = false;
 
     filterBaseline_ = energy_ = time_ = filterTime_ = 0.0;
 
-    chanNum_ = crateNum_ = cfdTime_ = 0;
+    chanNum_ = crateNum_ = cfdTime_ = cfdTrigSource_ = 0;
     eventTimeHigh_ = eventTimeLow_ = externalTimestamp_ = externalTimeLow_ = externalTimeHigh_ = 0;
     slotNum_ = 2;
 
     eSums_.clear();
     qdc_.clear();
     trace_.clear();
-}
\ No newline at end of file
+    traceView_ = nullptr;
+    traceViewLength_ = 0;
+}
+///We hold on to our vectors while the other object's values are moved in, then hand them over once they've been
+/// cleared. Neither object allocates, which is what makes a pool of recycled objects on both sides pay off.
+void XiaData::Adopt(XiaData &other) {
+    std::vector<unsigned int> eSums, qdc, trace;
+    eSums.swap(eSums_);
+    qdc.swap(qdc_);
+    trace.swap(trace_);
+
+    *this = std::move(other);
+
+    eSums.clear();
+    qdc.clear();
+    trace.clear();
+    other.eSums_.swap(eSums);
+    other.qdc_.swap(qdc);
+    other.trace_.swap(trace);
+}
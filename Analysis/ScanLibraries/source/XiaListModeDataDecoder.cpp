@@ -7,6 +7,7 @@
 
 #include "HelperEnumerations.hpp"
 #include "HelperFunctions.hpp"
+#include "TraceUnpacking.hpp"
 
 #include <iostream>
 #include <sstream>
@@ -17,9 +18,95 @@
 using namespace std;
 using namespace DataProcessing;
 
+namespace {
+    //These fields are in the same place for every firmware and frequency.
+    const unsigned int channelNumberMask = 0x0000000F;
+    const unsigned int slotIdMask = 0x000000F0;
+    const unsigned int slotIdShift = 4;
+    const unsigned int crateIdMask = 0x00000F00;
+    const unsigned int crateIdShift = 8;
+    const unsigned int headerLengthMask = 0x0001F000;
+    const unsigned int headerLengthShift = 12;
+    const unsigned int finishCodeMask = 0x80000000;
+    const unsigned int eventTimeHighMask = 0x0000FFFF;
+}
+
+///The Trace-out-of-range flag is in word zero for the three oldest firmwares and in word three for the rest, we keep a
+/// mask for both words and leave the one that isn't used at zero.
+XiaListModeDataLayout::XiaListModeDataLayout(const XiaListModeDataMask &mask) :
+        firmware(mask.GetFirmware()), frequency(mask.GetFrequency()) {
+    eventLengthMask = mask.GetEventLengthMask().first;
+    eventLengthShift = mask.GetEventLengthMask().second;
+    cfdFractionalTimeMask = mask.GetCfdFractionalTimeMask().first;
+    cfdFractionalTimeShift = mask.GetCfdFractionalTimeMask().second;
+    cfdForcedTriggerMask = mask.GetCfdForcedTriggerBitMask().first;
+    cfdTriggerSourceMask = mask.GetCfdTriggerSourceMask().first;
+    cfdTriggerSourceShift = mask.GetCfdTriggerSourceMask().second;
+    energyMask = mask.GetEventEnergyMask().first;
+    traceLengthMask = mask.GetTraceLengthMask().first;
+    traceLengthShift = mask.GetTraceLengthMask().second;
+
+    switch (firmware) {
+        case R17562:
+        case R20466:
+        case R27361:
+            wordZeroOutOfRangeMask = mask.GetTraceOutOfRangeFlagMask().first;
+            wordThreeOutOfRangeMask = 0;
+            break;
+        default:
+            wordZeroOutOfRangeMask = 0;
+            wordThreeOutOfRangeMask = mask.GetTraceOutOfRangeFlagMask().first;
+            break;
+    }
+
+    double cfdSize = mask.GetCfdSize();
+    cfdScale = cfdSize != 0 ? 1. / cfdSize : 0;
+    timeMultiplier = 1;
+    triggerSourceCoefficient = cfdOffset = 0;
+    switch (frequency) {
+        case 100:
+            break;
+        case 250:
+            timeMultiplier = 2;
+            triggerSourceCoefficient = -1;
+            break;
+        case 500:
+            timeMultiplier = 10;
+            triggerSourceCoefficient = 1;
+            cfdOffset = -1;
+            break;
+        default:
+            cfdScale = 0;
+            break;
+    }
+}
+
 vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask) {
+    vector<XiaData *> events;
+    DecodeEvents(buf, mask, nullptr, events);
+    return events;
+}
+
+unsigned int XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool &pool,
+                                                  std::vector<XiaData *> &events) {
+    return DecodeEvents(buf, mask, &pool, events);
+}
 
+///Frees the events that we decoded from a bad buffer. Heap allocated events are deleted and pooled events are handed
+/// back to the pool.
+void DiscardEvents(vector<XiaData *> &events, const size_t &firstEvent, XiaDataPool *pool) {
+    if (pool)
+        pool->ReleaseLast(events.size() - firstEvent);
+    else
+        for (size_t i = firstEvent; i < events.size(); i++)
+            delete events[i];
+    events.resize(firstEvent);
+}
+
+unsigned int XiaListModeDataDecoder::DecodeEvents(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool *pool,
+                                                  std::vector<XiaData *> &events) {
     unsigned int *bufStart = buf;
+    const size_t firstEvent = events.size();
     ///@NOTE : These two pieces here are the Pixie Module Data Header. They
     /// tell us the number of words read from the module (bufLen) and the VSN
     /// of the module (module number).
@@ -30,30 +117,36 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
     if (bufLen == 0)
         throw length_error("Unpacker::ReadBuffer - The buffer length was sized 0. This is a huge issue.");
 
-    //For empty buffers we just return an empty vector.
+    //For empty buffers we don't add anything to the events.
     static const unsigned int emptyBufferLength = 2;
     if (bufLen == emptyBufferLength)
-        return vector<XiaData *>();
+        return 0;
 
-    stringstream msg;
-    vector<XiaData *> events;
     static unsigned int numSkippedBuffers = 0;
 
+    //We only look up the layout when the firmware or frequency changes between modules.
+    if (!layout_.Matches(mask))
+        layout_ = XiaListModeDataLayout(mask);
+    const XiaListModeDataLayout &layout = layout_;
+    const unsigned int numExternalTimestampWords = mask.GetNumberOfExternalTimestampWords();
+    const unsigned int numEnergySumWords = mask.GetNumberOfEnergySumWords();
+    const unsigned int numQdcWords = mask.GetNumberOfQdcWords();
+
     while (buf < bufStart + bufLen) {
-        XiaData *data = new XiaData();
+        XiaData *data = pool ? pool->Acquire() : new XiaData();
         bool hasExternalTimestamp = false;
         bool hasQdc = false;
         bool hasEnergySums = false;
 
-        pair<unsigned int, unsigned int> lengths = DecodeWordZero(buf[0], *data, mask);
+        pair<unsigned int, unsigned int> lengths = DecodeWordZero(buf[0], *data, layout);
         unsigned int headerLength = lengths.first;
         unsigned int eventLength = lengths.second;
 
         data->SetEventTimeLow(buf[1]);
-        DecodeWordTwo(buf[2], *data, mask);
-        unsigned int traceLength = DecodeWordThree(buf[3], *data, mask);
+        DecodeWordTwo(buf[2], *data, layout);
+        unsigned int traceLength = DecodeWordThree(buf[3], *data, layout);
 
-        unsigned int externalTimestampOffset = headerLength - mask.GetNumberOfExternalTimestampWords();
+        unsigned int externalTimestampOffset = headerLength - numExternalTimestampWords;
         unsigned int energySumsOffset = 0;
         unsigned int qdcOffset = 0;
 
@@ -63,6 +156,10 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
                 //stats.DoStatisticsBlock(&buf[1], modNum);
                 buf += eventLength;
                 //numEvents = -10;
+                if (pool)
+                    pool->ReleaseLast();
+                else
+                    delete data;
                 continue;
             case HEADER :
                 break;
@@ -71,30 +168,29 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
                 break;
             case HEADER_W_QDC :
                 hasQdc = true;
-                qdcOffset = headerLength - mask.GetNumberOfQdcWords();
+                qdcOffset = headerLength - numQdcWords;
                 break;
             case HEADER_W_ESUM :
                 hasEnergySums = true;
-                energySumsOffset = headerLength - mask.GetNumberOfEnergySumWords();
+                energySumsOffset = headerLength - numEnergySumWords;
                 break;
             case HEADER_W_ESUM_ETS :
                 hasExternalTimestamp = hasEnergySums = true;
-                energySumsOffset = headerLength - mask.GetNumberOfEnergySumWords() - mask.GetNumberOfExternalTimestampWords();
+                energySumsOffset = headerLength - numEnergySumWords - numExternalTimestampWords;
                 break;
             case HEADER_W_ESUM_QDC :
                 hasEnergySums = hasQdc = true;
-                energySumsOffset = headerLength - mask.GetNumberOfEnergySumWords() - mask.GetNumberOfQdcWords();
-                qdcOffset = headerLength - mask.GetNumberOfQdcWords();
+                energySumsOffset = headerLength - numEnergySumWords - numQdcWords;
+                qdcOffset = headerLength - numQdcWords;
                 break;
             case HEADER_W_ESUM_QDC_ETS :
                 hasEnergySums = hasExternalTimestamp = hasQdc = true;
-                energySumsOffset = headerLength - mask.GetNumberOfExternalTimestampWords() - mask.GetNumberOfQdcWords() -
-                                                                                             mask .GetNumberOfEnergySumWords();
-                qdcOffset = headerLength - mask.GetNumberOfExternalTimestampWords() - mask.GetNumberOfQdcWords();
+                energySumsOffset = headerLength - numExternalTimestampWords - numQdcWords - numEnergySumWords;
+                qdcOffset = headerLength - numExternalTimestampWords - numQdcWords;
                 break;
             case HEADER_W_QDC_ETS :
                 hasQdc = hasExternalTimestamp = true;
-                qdcOffset = headerLength - mask.GetNumberOfExternalTimestampWords() - mask.GetNumberOfQdcWords();
+                qdcOffset = headerLength - numExternalTimestampWords - numQdcWords;
                 break;
             default:
                 numSkippedBuffers++;
@@ -103,7 +199,40 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
                      << "Unexpected header length: " << headerLength << endl << "ReadBuffer:   Buffer " << modNum << " of length "
                      << bufLen << endl << "ReadBuffer:   CRATE:SLOT(MOD):CHAN " << data->GetCrateNumber() << ":"
                      << data->GetSlotNumber() << "(" << modNum << "):" << data->GetChannelNumber() << endl;
-                return vector<XiaData *>();
+                events.push_back(data);
+                DiscardEvents(events, firstEvent, pool);
+                return 0;
+        }
+
+        // Some events get a trace length of 32768, this shows up here as 32767. If we encounter a trace length of that
+        // size then we're going to set the trace length to 0. There's never a situation where a trace can have that
+        // many samples. For a 250 Ms/s module that corresponds to a trace length of 131 us.
+        if(traceLength == 32767)
+            traceLength = 0;
+
+        // One last check to ensure event length matches what we think it should be.
+        if (traceLength / 2 + headerLength != eventLength) {
+            numSkippedBuffers++;
+            cerr << "XiaListModeDataDecoder::ReadBuffer : Event"
+                    "length (" << eventLength << ") does not correspond to "
+                         "header length (" << headerLength
+                 << ") and trace length ("
+                 << traceLength / 2 << "). Skipped a total of "
+                 << numSkippedBuffers << " buffers in this file." << endl;
+            events.push_back(data);
+            DiscardEvents(events, firstEvent, pool);
+            return 0;
+        }
+
+        //Hits from channels that nobody wants are dropped before we decode anything else about them.
+        const unsigned int id = data->GetId();
+        if (filter_ && !filter_->IsKept(id)) {
+            buf += eventLength;
+            if (pool)
+                pool->ReleaseLast();
+            else
+                delete data;
+            continue;
         }
 
         if (hasExternalTimestamp) {
@@ -114,21 +243,13 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
         }
 
         if (hasEnergySums) {
-            vector<unsigned int> tmp;
-            for(unsigned int i = 0; i < mask.GetNumberOfEnergySumWords() - 1; i++)
-                tmp.push_back(buf[energySumsOffset + i]);
-            data->SetEnergySums(tmp);
+            data->SetEnergySums(&buf[energySumsOffset], &buf[energySumsOffset + numEnergySumWords - 1]);
             data->SetFilterBaseline(IeeeStandards::IeeeFloatingToDecimal(buf[energySumsOffset +
-                    mask.GetNumberOfEnergySumWords() - 1]));
+                    numEnergySumWords - 1]));
         }
 
-        if (hasQdc) {
-            vector<unsigned int> tmp;
-            for (unsigned int i = 0; i < mask.GetNumberOfQdcWords(); i++) {
-                tmp.push_back(buf[qdcOffset + i]);
-            }
-            data->SetQdc(tmp);
-        }
+        if (hasQdc)
+            data->SetQdc(&buf[qdcOffset], &buf[qdcOffset + numQdcWords]);
 
         ///@TODO Figure out where to put this...
         //channel_counts[modNum][chanNum]++;
@@ -140,127 +261,81 @@ vector<XiaData *> XiaListModeDataDecoder::DecodeBuffer(unsigned int *buf, const
             data->SetEnergy(65536);
 
         //We set the time according to the revision and firmware.
-        pair<double, double> times = CalculateTimeInSamples(mask, *data);
+        pair<double, double> times = CalculateTimeInSamples(layout, *data);
         data->SetFilterTime(times.first);
         data->SetTime(times.second);
 
-        // Some events get a trace length of 32768, this shows up here as 32767. If we encounter a trace length of that
-        // size then we're going to set the trace length to 0. There's never a situation where a trace can have that
-        // many samples. For a 250 Ms/s module that corresponds to a trace length of 131 us.
-        if(traceLength == 32767)
-            traceLength = 0;
+        //Advance the buffer past the header and to the trace
+        buf += headerLength;
 
-        // One last check to ensure event length matches what we think it should be.
-        if (traceLength / 2 + headerLength != eventLength) {
-            numSkippedBuffers++;
-            cerr << "XiaListModeDataDecoder::ReadBuffer : Event"
-                    "length (" << eventLength << ") does not correspond to "
-                         "header length (" << headerLength
-                 << ") and trace length ("
-                 << traceLength / 2 << "). Skipped a total of "
-                 << numSkippedBuffers << " buffers in this file." << endl;
-            return vector<XiaData *>();
-        } else //Advance the buffer past the header and to the trace
-            buf += headerLength;
-
-        if (traceLength > 0) {
-            DecodeTrace(buf, *data, traceLength);
+        //The trace is skipped without being looked at if nobody needs it.
+        if (traceLength > 0 && filter_ && !filter_->IsTraceKept(id)) {
+            buf += traceLength / 2;
+        } else if (traceLength > 0) {
+            //Pooled events only keep a view of the trace, the spill buffer is responsible for the samples.
+            if (pool)
+                data->SetTraceView((unsigned short *) buf, traceLength);
+            else
+                DecodeTrace(buf, *data, traceLength);
             buf += traceLength / 2;
         }
         events.push_back(data);
     }// while(buf < bufStart + bufLen)
-    return events;
+    return (unsigned int) (events.size() - firstEvent);
 }
 
 std::pair<unsigned int, unsigned int> XiaListModeDataDecoder::DecodeWordZero(const unsigned int &word, XiaData &data,
-                                                                             const XiaListModeDataMask &mask) {
-
-    data.SetChannelNumber(word & mask.GetChannelNumberMask().first);
-    data.SetSlotNumber((word & mask.GetSlotIdMask().first) >> mask.GetSlotIdMask().second);
-    data.SetCrateNumber((word & mask.GetCrateIdMask().first) >> mask.GetCrateIdMask().second);
-    data.SetPileup((word & mask.GetFinishCodeMask().first) != 0);
-
-    //We have to check if we have one of these three firmwares since they
-    // have the Trace-Out-of-Range flag in this word.
-    switch (mask.GetFirmware()) {
-        case R17562:
-        case R20466:
-        case R27361:
-            data.SetSaturation((bool) ((word & mask.GetTraceOutOfRangeFlagMask().first)
-                    >> mask.GetTraceOutOfRangeFlagMask().second));
-            break;
-        default:
-            break;
-    }
-
-    return make_pair((word & mask.GetHeaderLengthMask().first) >> mask.GetHeaderLengthMask().second,
-                     (word & mask.GetEventLengthMask().first) >> mask.GetEventLengthMask().second);
+                                                                             const XiaListModeDataLayout &layout) {
+    data.SetChannelNumber(word & channelNumberMask);
+    data.SetSlotNumber((word & slotIdMask) >> slotIdShift);
+    data.SetCrateNumber((word & crateIdMask) >> crateIdShift);
+    data.SetPileup((word & finishCodeMask) != 0);
+    data.SetSaturation((word & layout.wordZeroOutOfRangeMask) != 0);
+
+    return make_pair((word & headerLengthMask) >> headerLengthShift,
+                     (word & layout.eventLengthMask) >> layout.eventLengthShift);
 }
 
-void XiaListModeDataDecoder::DecodeWordTwo(const unsigned int &word, XiaData &data, const XiaListModeDataMask &mask) {
-    data.SetEventTimeHigh(word & mask.GetEventTimeHighMask().first);
-    data.SetCfdFractionalTime((word & mask.GetCfdFractionalTimeMask().first) >> mask.GetCfdFractionalTimeMask().second);
-    data.SetCfdForcedTriggerBit(
-            (bool) ((word & mask.GetCfdForcedTriggerBitMask().first) >> mask.GetCfdForcedTriggerBitMask().second));
-    data.SetCfdTriggerSourceBit(
-            (bool) (word & mask.GetCfdTriggerSourceMask().first) >> mask.GetCfdTriggerSourceMask().second);
+void XiaListModeDataDecoder::DecodeWordTwo(const unsigned int &word, XiaData &data,
+                                           const XiaListModeDataLayout &layout) {
+    data.SetEventTimeHigh(word & eventTimeHighMask);
+    data.SetCfdFractionalTime((word & layout.cfdFractionalTimeMask) >> layout.cfdFractionalTimeShift);
+    data.SetCfdForcedTriggerBit((word & layout.cfdForcedTriggerMask) != 0);
+    data.SetCfdTriggerSource((word & layout.cfdTriggerSourceMask) >> layout.cfdTriggerSourceShift);
 }
 
+///Word zero already set the saturation for the firmwares that keep the Trace-out-of-range flag there, for the others
+/// we take it from this word.
 unsigned int XiaListModeDataDecoder::DecodeWordThree(const unsigned int &word, XiaData &data,
-                                                     const XiaListModeDataMask &mask) {
-    data.SetEnergy(word & mask.GetEventEnergyMask().first);
-
-    //Reverse the logic that we used in DecodeWordZero, since if we do not
-    // have these three firmwares we need to check this word for the
-    // Trace-Out-of-Range flag.
-    switch (mask.GetFirmware()) {
-        case R17562:
-        case R20466:
-        case R27361:
-            break;
-        default:
-            data.SetSaturation((bool) ((word & mask.GetTraceOutOfRangeFlagMask().first)
-                    >> mask.GetTraceOutOfRangeFlagMask().second));
-            break;
-    }
-
-    return ((word & mask.GetTraceLengthMask().first) >> mask.GetTraceLengthMask().second);
+                                                     const XiaListModeDataLayout &layout) {
+    data.SetEnergy(word & layout.energyMask);
+    data.SetSaturation(data.IsSaturated() || (word & layout.wordThreeOutOfRangeMask) != 0);
+    return (word & layout.traceLengthMask) >> layout.traceLengthShift;
 }
 
+///The samples are widened straight into the storage of the trace, 2-bytes per sample, i.e. 2 samples per word.
 void XiaListModeDataDecoder::DecodeTrace(unsigned int *buf, XiaData &data, const unsigned int &traceLength) {
-    vector<unsigned int> tmp;
-    // sbuf points to the beginning of trace data
-    unsigned short *sbuf = (unsigned short *) buf;
-
-    // Read the trace data (2-bytes per sample, i.e. 2 samples per word)
-    for (unsigned int k = 0; k < traceLength; k++)
-        tmp.push_back((unsigned int &&) sbuf[k]);
-
-    data.SetTrace(tmp);
+    TraceUnpacking::Widen((const unsigned short *) buf, data.ResizeTrace(traceLength), traceLength);
 }
 
 pair<double, double> XiaListModeDataDecoder::CalculateTimeInSamples(const XiaListModeDataMask &mask,
                                                                     const XiaData &data) {
+    if (!layout_.Matches(mask))
+        layout_ = XiaListModeDataLayout(mask);
+    return CalculateTimeInSamples(layout_, data);
+}
+
+pair<double, double> XiaListModeDataDecoder::CalculateTimeInSamples(const XiaListModeDataLayout &layout,
+                                                                    const XiaData &data) {
     double filterTime = Conversions::ConcatenateWords(data.GetEventTimeLow(), data.GetEventTimeHigh(), 32);
 
     if (data.GetCfdFractionalTime() == 0 || data.GetCfdForcedTriggerBit())
         return make_pair(filterTime, filterTime);
 
-    double cfdTime = 0, multiplier = 1;
-    if (mask.GetFrequency() == 100)
-        cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize();
-
-    if (mask.GetFrequency() == 250) {
-        multiplier = 2;
-        cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize() - data.GetCfdTriggerSourceBit();
-    }
-
-    if (mask.GetFrequency() == 500) {
-        multiplier = 10;
-        cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize() + data.GetCfdTriggerSourceBit() - 1;
-    }
+    double cfdTime = data.GetCfdFractionalTime() * layout.cfdScale
+                     + layout.triggerSourceCoefficient * data.GetCfdTriggerSource() + layout.cfdOffset;
 
-    return make_pair(filterTime, filterTime * multiplier + cfdTime);
+    return make_pair(filterTime, filterTime * layout.timeMultiplier + cfdTime);
 }
 
 double XiaListModeDataDecoder::CalculateTimeInNs(const XiaListModeDataMask &mask, const XiaData &data) {
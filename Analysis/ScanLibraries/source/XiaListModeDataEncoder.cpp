@@ -93,7 +93,7 @@ unsigned int XiaListModeDataEncoder::EncodeWordTwo(
             mask.GetCfdFractionalTimeMask().first;
     word |= (data.GetCfdForcedTriggerBit() << mask.GetCfdForcedTriggerBitMask()
             .second) & mask.GetCfdForcedTriggerBitMask().first;
-    word |= (data.GetCfdTriggerSourceBit()
+    word |= (data.GetCfdTriggerSource()
             << mask.GetCfdTriggerSourceMask().second) &
             mask.GetCfdTriggerSourceMask().first;
     return word;
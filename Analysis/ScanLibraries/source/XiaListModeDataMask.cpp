@@ -291,6 +291,14 @@ string XiaListModeDataMask::BadMaskErrorMessage(const std::string &func) const {
     return msg.str();
 }
 
+double XiaListModeDataMask::GetTimestampTickInSeconds() const {
+    if (frequency_ == 100 || frequency_ == 500)
+        return 10e-9;
+    if (frequency_ == 250)
+        return 8e-9;
+    throw invalid_argument(BadMaskErrorMessage("GetTimestampTickInSeconds"));
+}
+
 double XiaListModeDataMask::GetCfdSize() const {
     if (firmware_ == UNKNOWN || frequency_ == 0)
         throw invalid_argument(BadMaskErrorMessage("GetCfdSize"));
@@ -0,0 +1,134 @@
+///@file unittest-HitDump.cpp
+///@brief A program that will execute unit tests on the HitDumpWriter and HitDumpReader
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "HitDump.hpp"
+#include "UnitTestSampleData.hpp"
+
+using namespace std;
+using namespace unittest_trace_variables;
+using namespace unittest_decoded_data;
+
+namespace {
+    const char *filename = "unittest-HitDump.dat";
+
+    ///Writes three events to the file, the second one has two hits. The chunk size is small enough that the
+    /// events end up in two chunks.
+    void WriteEvents(const bool &keepTraces, XiaData &first, XiaData &second) {
+        first.SetCrateNumber(crateId);
+        first.SetSlotNumber(slotId);
+        first.SetChannelNumber(channelNumber);
+        first.SetEnergy(energy);
+        first.SetFilterTime(1234567);
+        first.SetTime(1234567.25);
+        first.SetCfdFractionalTime(cfd_fractional_time);
+        first.SetPileup(true);
+        first.SetTrace(trace);
+
+        second.SetSlotNumber(slotId);
+        second.SetChannelNumber(channelNumber + 1);
+        second.SetEnergy(energy + 1);
+        second.SetFilterTime(1234600);
+        second.SetCfdForcedTriggerBit(true);
+        second.SetCfdTriggerSource(3);
+
+        deque<XiaData *> event;
+        event.push_back(&first);
+
+        HitDumpWriter writer;
+        CHECK(writer.Open(filename, keepTraces, 2));
+        writer.Add(event);
+        event.push_back(&second);
+        writer.Add(event);
+        event.pop_front();
+        writer.Add(event);
+        writer.Close();
+
+        CHECK_EQUAL(3u, writer.GetNumberOfEvents());
+        CHECK_EQUAL(4u, writer.GetNumberOfHits());
+    }
+}
+
+TEST(TestReadingWhatWeWrote) {
+    XiaData first, second;
+    WriteEvents(true, first, second);
+
+    HitDumpReader reader;
+    CHECK(reader.Open(filename));
+    CHECK(reader.HasTraces());
+
+    //The chunk is only cut once the whole event is in it.
+    HitDumpChunk chunk;
+    CHECK(reader.ReadChunk(chunk));
+    CHECK_EQUAL(3u, chunk.GetNumberOfHits());
+    CHECK_EQUAL(0u, chunk.eventNumber[0]);
+    CHECK_EQUAL(1u, chunk.eventNumber[1]);
+    CHECK_EQUAL(1u, chunk.eventNumber[2]);
+
+    CHECK_EQUAL(crateId, (unsigned int) chunk.crate[0]);
+    CHECK_EQUAL(first.GetModuleNumber(), (unsigned int) chunk.module[0]);
+    CHECK_EQUAL(channelNumber, (unsigned int) chunk.channel[0]);
+    CHECK_EQUAL(channelNumber + 1, (unsigned int) chunk.channel[2]);
+    CHECK_EQUAL(1234567u, chunk.timestamp[0]);
+    CHECK_EQUAL(1234567.25, chunk.time[0]);
+    CHECK_EQUAL(energy, chunk.energy[0]);
+    CHECK_EQUAL(energy + 1, chunk.energy[2]);
+    CHECK_EQUAL(cfd_fractional_time, chunk.cfdFraction[0]);
+    CHECK_EQUAL((unsigned char) HitDumpChunk::PILEUP, chunk.flags[0]);
+    CHECK_EQUAL((unsigned char) HitDumpChunk::CFD_FORCED_TRIGGER, chunk.flags[2] & ~HitDumpChunk::CFD_TRIGGER_SOURCE);
+    CHECK_EQUAL(3, (chunk.flags[2] & HitDumpChunk::CFD_TRIGGER_SOURCE) >> HitDumpChunk::cfdTriggerSourceShift);
+
+    CHECK_EQUAL(trace.size(), chunk.traceLength[0]);
+    CHECK_EQUAL(trace.size(), chunk.traceLength[1]);
+    CHECK_EQUAL(0u, chunk.traceLength[2]);
+    CHECK_EQUAL(trace.size(), chunk.traceOffset[1]);
+    CHECK_EQUAL(2 * trace.size(), chunk.samples.size());
+    CHECK_ARRAY_EQUAL(trace, vector<unsigned int>(chunk.samples.begin() + chunk.traceOffset[1],
+                                                  chunk.samples.end()), trace.size());
+
+    CHECK(reader.ReadChunk(chunk));
+    CHECK_EQUAL(1u, chunk.GetNumberOfHits());
+    CHECK_EQUAL(2u, chunk.eventNumber[0]);
+    CHECK_EQUAL(1234600u, chunk.timestamp[0]);
+
+    CHECK(!reader.ReadChunk(chunk));
+    remove(filename);
+}
+
+TEST(TestWithoutTraces) {
+    XiaData first, second;
+    WriteEvents(false, first, second);
+
+    HitDumpReader reader;
+    CHECK(reader.Open(filename));
+    CHECK(!reader.HasTraces());
+
+    HitDumpChunk chunk;
+    CHECK(reader.ReadChunk(chunk));
+    CHECK_EQUAL(3u, chunk.GetNumberOfHits());
+    CHECK_EQUAL(0u, chunk.traceLength[0]);
+    CHECK(chunk.samples.empty());
+    CHECK_EQUAL(energy + 1, chunk.energy[2]);
+    remove(filename);
+}
+
+TEST(TestNotAHitDump) {
+    HitDumpReader reader;
+    CHECK(!reader.Open("unittest-HitDump-missing.dat"));
+
+    FILE *file = fopen(filename, "w");
+    fputs("this is not a hit dump", file);
+    fclose(file);
+    CHECK(!reader.Open(filename));
+    remove(filename);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
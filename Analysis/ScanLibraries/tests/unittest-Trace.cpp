@@ -57,6 +57,46 @@ TEST_FIXTURE(Trace, TestingGettersAndSetters){
     CHECK_EQUAL(double_input, GetTau());
 }
 
+///The waveform is cached inside of the trace, so it needs to follow the baseline subtracted trace and the range.
+TEST(TestWaveformFollowsTraceSansBaseline) {
+    Trace tr(unittest_trace_variables::trace);
+    tr.SetWaveformRange(waveform_range);
+    tr.CalculateTraceSansBaseline(baseline_pair.first);
+    CHECK_ARRAY_CLOSE(trace_sans_baseline, tr.GetTraceSansBaseline(), trace_sans_baseline.size(), 0.01);
+    CHECK_ARRAY_CLOSE(waveform, tr.GetWaveform(), waveform.size(), 0.01);
+
+    //Asking for the waveform again shouldn't allocate anything new.
+    size_t capacity = tr.GetResultsCapacity();
+    tr.GetWaveform();
+    CHECK_EQUAL(capacity, tr.GetResultsCapacity());
+
+    tr.SetWaveformRange(make_pair(waveform_range.first, waveform_range.first + 2));
+    CHECK_EQUAL(2u, tr.GetWaveform().size());
+    CHECK_CLOSE(waveform[1], tr.GetWaveform()[1], 0.01);
+
+    tr.CalculateTraceSansBaseline(0.0);
+    CHECK_CLOSE(unittest_trace_variables::trace[waveform_range.first], tr.GetWaveform()[0], 0.01);
+}
+
+///A recycled trace has to forget everything about its last hit, but keep the memory that it had.
+TEST(TestReset) {
+    Trace tr(unittest_trace_variables::trace);
+    tr.SetWaveformRange(waveform_range);
+    tr.CalculateTraceSansBaseline(baseline_pair.first);
+    tr.GetWaveform();
+    tr.SetHasValidAnalysis(true);
+    tr.SetPhase(100.);
+    size_t capacity = tr.GetResultsCapacity();
+
+    tr.Reset();
+    CHECK(tr.empty());
+    CHECK(tr.GetTraceSansBaseline().empty());
+    CHECK(tr.GetWaveform().empty());
+    CHECK(!tr.HasValidAnalysis());
+    CHECK_EQUAL(0., tr.GetPhase());
+    CHECK_EQUAL(capacity, tr.GetResultsCapacity());
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
-}
\ No newline at end of file
+}
@@ -0,0 +1,85 @@
+///@file unittest-TraceUnpacking.cpp
+///@brief Checks that every way of widening the packed trace samples gives the same trace.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "TraceUnpacking.hpp"
+
+using namespace std;
+using namespace TraceUnpacking;
+
+namespace unittest_trace_unpacking {
+    static const vector<WIDENING_PATH> paths = {SCALAR, SSE2, AVX2};
+
+    ///@return Samples that use all 16 bits, so that a sign extension would show up.
+    vector<unsigned short> MakeSamples(const unsigned int &length) {
+        vector<unsigned short> samples;
+        unsigned int seed = 7;
+        for (unsigned int i = 0; i < length; i++) {
+            seed = seed * 1664525 + 1013904223;
+            samples.push_back((unsigned short) (seed >> 16));
+        }
+        return samples;
+    }
+}
+
+using namespace unittest_trace_unpacking;
+
+TEST(TestScalarPathIsAlwaysSupported) {
+    CHECK(IsSupported(SCALAR));
+    CHECK(IsSupported(GetBestPath()));
+}
+
+///The lengths cover the tails that are left over after the vector loops, including odd lengths.
+TEST(TestPathsAreBitIdentical) {
+    static const vector<unsigned int> lengths = {0, 1, 3, 7, 8, 9, 15, 16, 17, 31, 33, 124, 125, 1001};
+
+    for (auto length : lengths) {
+        vector<unsigned short> samples = MakeSamples(length);
+        vector<unsigned int> expected(samples.begin(), samples.end());
+
+        for (auto path : paths) {
+            if (!IsSupported(path))
+                continue;
+
+            //A guard sample after the trace makes sure that we don't write past the end.
+            vector<unsigned int> trace(length + 1, 0xDEADBEEF);
+            Widen(path, samples.data(), trace.data(), length);
+            CHECK_ARRAY_EQUAL(expected, trace, length);
+            CHECK_EQUAL(0xDEADBEEF, trace.back());
+        }
+
+        vector<unsigned int> trace(length);
+        Widen(samples.data(), trace.data(), length);
+        CHECK_ARRAY_EQUAL(expected, trace, length);
+    }
+}
+
+///Times the paths on a typical trace. We only print the timing since it depends on the machine.
+TEST(BenchmarkWidening) {
+    static const unsigned int length = 1000;
+    static const unsigned int numTraces = 100000;
+    vector<unsigned short> samples = MakeSamples(length);
+    vector<unsigned int> trace(length);
+
+    for (auto path : paths) {
+        if (!IsSupported(path))
+            continue;
+        auto start = chrono::steady_clock::now();
+        for (unsigned int i = 0; i < numTraces; i++)
+            Widen(path, samples.data(), trace.data(), length);
+        chrono::duration<double> time = chrono::steady_clock::now() - start;
+        CHECK_EQUAL(samples.back(), trace.back());
+        cout << "BenchmarkWidening - " << GetPathName(path) << " : " << time.count() / numTraces * 1e9
+             << " ns per " << length << " sample trace" << endl;
+    }
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
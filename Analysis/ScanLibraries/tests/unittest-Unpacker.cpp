@@ -0,0 +1,189 @@
+///@file unittest-Unpacker.cpp
+///@brief Checks that the pipelined Unpacker builds the same events and reports the same spills as the synchronous one.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <cstdio>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "HitDump.hpp"
+#include "Unpacker.hpp"
+#include "UnitTestSampleData.hpp"
+#include "XiaData.hpp"
+
+using namespace std;
+using namespace unittest_encoded_data::R30474_250;
+
+namespace {
+    typedef vector<pair<unsigned int, double> > Event; ///< The id and time of every hit in an event
+
+    const unsigned int numModules = 3;
+    const unsigned int numSpills = 4;
+
+    ///Keeps the events that it's handed, the pipeline has to be stopped before we're gone.
+    class RecordingUnpacker : public Unpacker {
+    public:
+        ~RecordingUnpacker() { StopPipeline(); }
+
+        vector<Event> events;
+
+    protected:
+        void ProcessRawEvent() {
+            Event event;
+            for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++)
+                event.push_back(make_pair((*it)->GetId(), (*it)->GetFilterTime()));
+            events.push_back(event);
+            Unpacker::ProcessRawEvent();
+        }
+    };
+
+    ///Adds the record of a module with a header only hit at each time, the slot is the module number plus two.
+    void AddRecord(vector<unsigned int> &spill, const unsigned int &module, const vector<unsigned int> &times) {
+        spill.push_back(2 + 4 * (unsigned int) times.size());
+        spill.push_back(module);
+        for (vector<unsigned int>::const_iterator it = times.begin(); it != times.end(); it++) {
+            spill.push_back((word0_header & ~0xF0u) | ((module + 2) << 4));
+            spill.push_back(*it);
+            spill.push_back(word2_energyOnly);
+            spill.push_back(word3_headerOnly);
+        }
+    }
+
+    ///@return A spill where every module has hits spread through it. The last module has a hit at the very end of
+    /// the spill that shares an event with the first hit of the next spill when we build across spills.
+    vector<unsigned int> MakeSpill(const unsigned int &number, const bool &isComplete = true) {
+        vector<unsigned int> spill;
+        for (unsigned int module = 0; module < numModules; module++) {
+            vector<unsigned int> times;
+            unsigned int start = 1000 * number + (module == 0 && number != 0 ? 2 : 50);
+            for (unsigned int i = 0; i < 5; i++)
+                times.push_back(start + 7 * module + 150 * i);
+            if (module == numModules - 1)
+                times.push_back(1000 * number + 998);
+            AddRecord(spill, module, times);
+        }
+        if (isComplete) {
+            spill.push_back(2);
+            spill.push_back(9999);
+        }
+        return spill;
+    }
+
+    ///Reads the spills like the scan does, the data past the end of a spill fails the sanity check like it does in
+    /// the copy that the pipeline makes.
+    bool ReadSpill(Unpacker &unpacker, vector<unsigned int> spill) {
+        const unsigned int nWords = (unsigned int) spill.size();
+        spill.push_back(1000000);
+        spill.push_back(0);
+        return unpacker.ReadSpill(spill.data(), nWords, false);
+    }
+
+    void SetupUnpacker(Unpacker &unpacker, const unsigned int &numThreads, const double &lookahead) {
+        unpacker.InitializeDataMask(test_firmware, test_frequency);
+        unpacker.SetEventWidth(10);
+        unpacker.SetLookaheadWindow(lookahead);
+        unpacker.SetDecodeThreads(numThreads);
+    }
+
+    ///Scans the spills, along with one that's split and one that's empty.
+    vector<bool> Scan(RecordingUnpacker &unpacker) {
+        vector<bool> results;
+        for (unsigned int i = 0; i < numSpills; i++)
+            results.push_back(ReadSpill(unpacker, MakeSpill(i)));
+        results.push_back(ReadSpill(unpacker, MakeSpill(numSpills, false)));
+        results.push_back(ReadSpill(unpacker, MakeSpill(numSpills + 1)));
+        vector<unsigned int> empty = {2, 9999};
+        results.push_back(ReadSpill(unpacker, empty));
+        unpacker.FlushEventList();
+        return results;
+    }
+}
+
+TEST(TestPipelineMatchesSynchronous) {
+    const vector<bool> expectedResults = {true, true, true, true, false, true, true};
+    const double lookaheads[] = {-1, 50};
+
+    for (unsigned int i = 0; i < 2; i++) {
+        RecordingUnpacker synchronous;
+        SetupUnpacker(synchronous, 0, lookaheads[i]);
+        vector<bool> results = Scan(synchronous);
+        CHECK(expectedResults == results);
+        CHECK(!synchronous.events.empty());
+
+        for (unsigned int numThreads = 1; numThreads <= 4; numThreads++) {
+            RecordingUnpacker pipelined;
+            SetupUnpacker(pipelined, numThreads, lookaheads[i]);
+            CHECK(expectedResults == Scan(pipelined));
+            pipelined.StopPipeline();
+            CHECK_EQUAL(synchronous.events.size(), pipelined.events.size());
+            CHECK(synchronous.events == pipelined.events);
+            CHECK_EQUAL(synchronous.GetMaxModuleInFile(), pipelined.GetMaxModuleInFile());
+        }
+    }
+}
+
+///The hit at the end of each spill only shares an event with the next spill's first hit when we build across spills.
+TEST(TestBuildingAcrossSpills) {
+    RecordingUnpacker unpacker;
+    SetupUnpacker(unpacker, 0, 50);
+    ReadSpill(unpacker, MakeSpill(0));
+    ReadSpill(unpacker, MakeSpill(1));
+    unpacker.FlushEventList();
+
+    bool foundStraddlingEvent = false;
+    for (vector<Event>::iterator it = unpacker.events.begin(); it != unpacker.events.end(); it++)
+        if (it->size() == 2 && it->back().second - it->front().second == 4)
+            foundStraddlingEvent = true;
+    CHECK(foundStraddlingEvent);
+}
+
+///The last hit of the final warm-up spill is carried over to the first selected spill. It has to be built and
+/// processed while the dump is still paused, otherwise it ends up in the dump alongside the selected spills.
+TEST(TestWarmupBoundary) {
+    const char *filename = "unittest-Unpacker.dat";
+    const unsigned int numWarmupSpills = 2;
+    const unsigned int hitsPerSpill = 5 * numModules + 1;
+
+    for (unsigned int numThreads = 0; numThreads <= 2; numThreads += 2) {
+        {
+            RecordingUnpacker unpacker;
+            SetupUnpacker(unpacker, numThreads, 50);
+            CHECK(unpacker.OpenHitDump(filename, false));
+
+            unpacker.SetHitDumpPaused(true);
+            for (unsigned int i = 0; i < numWarmupSpills; i++)
+                ReadSpill(unpacker, MakeSpill(i));
+
+            //This is what the scan does when it reaches the first selected spill.
+            unpacker.FlushEventList();
+            CHECK(!unpacker.events.empty());
+            CHECK_EQUAL(1u, unpacker.events.back().size());
+            CHECK_EQUAL(1000 * (numWarmupSpills - 1) + 998,
+                        (unsigned long long) unpacker.events.back().front().second & 0xFFFFFFFF);
+            unpacker.SetHitDumpPaused(false);
+
+            for (unsigned int i = numWarmupSpills; i < numSpills; i++)
+                ReadSpill(unpacker, MakeSpill(i));
+            unpacker.FlushEventList();
+        }
+
+        HitDumpReader reader;
+        CHECK(reader.Open(filename));
+        HitDumpChunk chunk;
+        size_t numHits = 0;
+        while (reader.ReadChunk(chunk)) {
+            for (size_t i = 0; i < chunk.GetNumberOfHits(); i++)
+                CHECK((chunk.timestamp[i] & 0xFFFFFFFF) >= 1000 * numWarmupSpills);
+            numHits += chunk.GetNumberOfHits();
+        }
+        CHECK_EQUAL((numSpills - numWarmupSpills) * hitsPerSpill, numHits);
+        remove(filename);
+    }
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -40,9 +40,11 @@ TEST_FIXTURE (XiaData, Test_GetSetCfdFractionalTime) {
     CHECK_EQUAL(cfd_fractional_time, GetCfdFractionalTime());
 }
 
-TEST_FIXTURE (XiaData, Test_GetSetCfdTriggerSourceBit) {
-    SetCfdTriggerSourceBit(cfd_source_trigger_bit);
-    CHECK (GetCfdTriggerSourceBit());
+TEST_FIXTURE (XiaData, Test_GetSetCfdTriggerSource) {
+    SetCfdTriggerSource(cfd_source_trigger_bit);
+    CHECK_EQUAL(cfd_source_trigger_bit, GetCfdTriggerSource());
+    SetCfdTriggerSource(4);
+    CHECK_EQUAL((unsigned int) 4, GetCfdTriggerSource());
 }
 
 TEST_FIXTURE (XiaData, Test_GetSetChannelNumber) {
@@ -115,6 +117,47 @@ TEST_FIXTURE (XiaData, Test_GetSetTrace) {
     CHECK_ARRAY_EQUAL(trace, GetTrace(), trace.size());
 }
 
+TEST_FIXTURE (XiaData, Test_DetachTraceView) {
+    vector<unsigned short> samples(trace.begin(), trace.end() - 1);
+    SetTraceView(samples.data(), (unsigned int) samples.size());
+    CHECK_ARRAY_EQUAL(trace, GetTrace(), samples.size());
+
+    DetachTraceView();
+    samples.assign(samples.size(), 0);
+    CHECK(!HasTraceView());
+    CHECK_EQUAL(trace.size() - 1, GetTraceLength());
+    CHECK_ARRAY_EQUAL(trace, GetTrace(), samples.size());
+}
+
+TEST (Test_Adopt) {
+    lhs.Initialize();
+    rhs.Initialize();
+    rhs.SetChannelNumber(channelNumber);
+    rhs.SetSlotNumber(slotId);
+    rhs.SetEnergy(energy);
+    rhs.SetQdc(qdc);
+    rhs.SetTrace(trace);
+
+    lhs.SetEnergySums(vector<unsigned int>(10, 1));
+    lhs.Adopt(rhs);
+    CHECK_EQUAL(channelNumber, lhs.GetChannelNumber());
+    CHECK_EQUAL(slotId, lhs.GetSlotNumber());
+    CHECK_EQUAL(energy, lhs.GetEnergy());
+    CHECK_ARRAY_EQUAL(qdc, lhs.GetQdc(), qdc.size());
+    CHECK_ARRAY_EQUAL(trace, lhs.GetTrace(), trace.size());
+    CHECK(lhs.GetEnergySums().empty());
+
+    //The other object got our old storage, but none of its values
+    CHECK(rhs.GetEnergySums().empty());
+    CHECK(rhs.GetQdc().empty());
+    CHECK_EQUAL((unsigned int)0, rhs.GetTraceLength());
+
+    vector<unsigned int> moved;
+    lhs.MoveTraceInto(moved);
+    CHECK_ARRAY_EQUAL(trace, moved, trace.size());
+    CHECK_EQUAL((unsigned int)0, lhs.GetTraceLength());
+}
+
 TEST_FIXTURE (XiaData, Test_GetSetVirtualChannel) {
     SetVirtualChannel(virtual_channel);
     CHECK (IsVirtualChannel());
@@ -5,10 +5,13 @@
 #include "XiaListModeDataDecoder.hpp"
 
 #include "HelperEnumerations.hpp"
+#include "HelperFunctions.hpp"
 #include "UnitTestSampleData.hpp"
 
 #include <UnitTest++.h>
 
+#include <chrono>
+#include <iostream>
 #include <stdexcept>
 
 using namespace std;
@@ -20,6 +23,217 @@ using namespace unittest_decoded_data;
 static const XiaListModeDataMask mask(R30474, 250);
 using namespace unittest_encoded_data::R30474_250;
 
+namespace unittest_decoder_layout {
+    static const vector<FIRMWARE> firmwares = {R17562, R20466, R27361, R29432, R30474, R30980, R30981, R34688};
+    static const vector<unsigned int> frequencies = {100, 250, 500};
+
+    ///@return The value of a field decoded with the mask and shift from the XiaListModeDataMask.
+    unsigned int Field(const unsigned int &word, const pair<unsigned int, unsigned int> &maskAndShift) {
+        return (word & maskAndShift.first) >> maskAndShift.second;
+    }
+
+    ///Decodes the header words with the XiaListModeDataMask getters, the way that the decoder did before it looked up
+    /// the layout once per module.
+    XiaData ReferenceDecode(const unsigned int *header, const XiaListModeDataMask &mask) {
+        XiaData data;
+        data.SetChannelNumber(Field(header[0], mask.GetChannelNumberMask()));
+        data.SetSlotNumber(Field(header[0], mask.GetSlotIdMask()));
+        data.SetCrateNumber(Field(header[0], mask.GetCrateIdMask()));
+        data.SetPileup(Field(header[0], mask.GetFinishCodeMask()) != 0);
+        data.SetEventTimeLow(header[1]);
+        data.SetEventTimeHigh(Field(header[2], mask.GetEventTimeHighMask()));
+        data.SetCfdFractionalTime(Field(header[2], mask.GetCfdFractionalTimeMask()));
+        data.SetCfdForcedTriggerBit(Field(header[2], mask.GetCfdForcedTriggerBitMask()) != 0);
+        data.SetCfdTriggerSource(Field(header[2], mask.GetCfdTriggerSourceMask()));
+        data.SetEnergy(Field(header[3], mask.GetEventEnergyMask()));
+
+        switch (mask.GetFirmware()) {
+            case R17562:
+            case R20466:
+            case R27361:
+                data.SetSaturation(Field(header[0], mask.GetTraceOutOfRangeFlagMask()) != 0);
+                break;
+            default:
+                data.SetSaturation(Field(header[3], mask.GetTraceOutOfRangeFlagMask()) != 0);
+                break;
+        }
+        if (data.IsSaturated())
+            data.SetEnergy(65536);
+
+        double filterTime = header[1] + (double) data.GetEventTimeHigh() * 4294967296.;
+        double time = filterTime;
+        if (data.GetCfdFractionalTime() != 0 && !data.GetCfdForcedTriggerBit()) {
+            double cfdTime = data.GetCfdFractionalTime() / mask.GetCfdSize();
+            if (mask.GetFrequency() == 100)
+                time = filterTime + cfdTime;
+            else if (mask.GetFrequency() == 250)
+                time = 2 * filterTime + cfdTime - data.GetCfdTriggerSource();
+            else if (mask.GetFrequency() == 500)
+                time = 10 * filterTime + cfdTime + data.GetCfdTriggerSource() - 1;
+        }
+        data.SetTime(time);
+        return data;
+    }
+
+    ///Decodes a module buffer into pooled events the way that the decoder did before it looked up the layout once per
+    /// module : every field goes through the XiaListModeDataMask getters, the header length through a switch and the
+    /// time through a branch on the frequency. The only change is that the trigger source keeps all of its bits, so
+    /// that the events match the ones from the decoder.
+    unsigned int LegacyDecodeBuffer(unsigned int *buf, const XiaListModeDataMask &mask, XiaDataPool &pool,
+                                    vector<XiaData *> &events) {
+        unsigned int *bufStart = buf;
+        unsigned int bufLen = *buf;
+        buf += 2;
+        const size_t firstEvent = events.size();
+
+        while (buf < bufStart + bufLen) {
+            XiaData *data = pool.Acquire();
+            unsigned int headerLength = Field(buf[0], mask.GetHeaderLengthMask());
+            unsigned int eventLength = Field(buf[0], mask.GetEventLengthMask());
+            data->SetChannelNumber(buf[0] & mask.GetChannelNumberMask().first);
+            data->SetSlotNumber(Field(buf[0], mask.GetSlotIdMask()));
+            data->SetCrateNumber(Field(buf[0], mask.GetCrateIdMask()));
+            data->SetPileup((buf[0] & mask.GetFinishCodeMask().first) != 0);
+            data->SetEventTimeLow(buf[1]);
+            data->SetEventTimeHigh(buf[2] & mask.GetEventTimeHighMask().first);
+            data->SetCfdFractionalTime(Field(buf[2], mask.GetCfdFractionalTimeMask()));
+            data->SetCfdForcedTriggerBit(Field(buf[2], mask.GetCfdForcedTriggerBitMask()) != 0);
+            data->SetCfdTriggerSource(Field(buf[2], mask.GetCfdTriggerSourceMask()));
+            data->SetEnergy(buf[3] & mask.GetEventEnergyMask().first);
+            unsigned int traceLength = Field(buf[3], mask.GetTraceLengthMask());
+
+            switch (mask.GetFirmware()) {
+                case R17562:
+                case R20466:
+                case R27361:
+                    data->SetSaturation(Field(buf[0], mask.GetTraceOutOfRangeFlagMask()) != 0);
+                    break;
+                default:
+                    data->SetSaturation(Field(buf[3], mask.GetTraceOutOfRangeFlagMask()) != 0);
+                    break;
+            }
+
+            const unsigned int numEts = mask.GetNumberOfExternalTimestampWords();
+            const unsigned int numQdc = mask.GetNumberOfQdcWords();
+            const unsigned int numEsums = mask.GetNumberOfEnergySumWords();
+            bool hasExternalTimestamp = false, hasQdc = false, hasEnergySums = false;
+            unsigned int externalTimestampOffset = headerLength - numEts, energySumsOffset = 0, qdcOffset = 0;
+            switch (headerLength) {
+                case HEADER :
+                    break;
+                case HEADER_W_ETS :
+                    hasExternalTimestamp = true;
+                    break;
+                case HEADER_W_QDC :
+                    hasQdc = true;
+                    qdcOffset = headerLength - numQdc;
+                    break;
+                case HEADER_W_ESUM :
+                    hasEnergySums = true;
+                    energySumsOffset = headerLength - numEsums;
+                    break;
+                case HEADER_W_ESUM_ETS :
+                    hasExternalTimestamp = hasEnergySums = true;
+                    energySumsOffset = headerLength - numEsums - numEts;
+                    break;
+                case HEADER_W_ESUM_QDC :
+                    hasEnergySums = hasQdc = true;
+                    energySumsOffset = headerLength - numEsums - numQdc;
+                    qdcOffset = headerLength - numQdc;
+                    break;
+                case HEADER_W_ESUM_QDC_ETS :
+                    hasEnergySums = hasExternalTimestamp = hasQdc = true;
+                    energySumsOffset = headerLength - numEts - numQdc - numEsums;
+                    qdcOffset = headerLength - numEts - numQdc;
+                    break;
+                case HEADER_W_QDC_ETS :
+                    hasQdc = hasExternalTimestamp = true;
+                    qdcOffset = headerLength - numEts - numQdc;
+                    break;
+                default:
+                    pool.ReleaseLast(events.size() - firstEvent + 1);
+                    events.resize(firstEvent);
+                    return 0;
+            }
+
+            if (hasExternalTimestamp) {
+                data->SetExternalTimeLow(buf[externalTimestampOffset]);
+                data->SetExternalTimeHigh(buf[externalTimestampOffset + 1]);
+                data->SetExternalTimestamp(Conversions::ConcatenateWords(data->GetExternalTimeLow(),
+                                                                         data->GetExternalTimeHigh(), 32));
+            }
+            if (hasEnergySums) {
+                data->SetEnergySums(&buf[energySumsOffset], &buf[energySumsOffset + numEsums - 1]);
+                data->SetFilterBaseline(IeeeStandards::IeeeFloatingToDecimal(buf[energySumsOffset + numEsums - 1]));
+            }
+            if (hasQdc)
+                data->SetQdc(&buf[qdcOffset], &buf[qdcOffset + numQdc]);
+            if (data->IsSaturated())
+                data->SetEnergy(65536);
+
+            double filterTime = Conversions::ConcatenateWords(data->GetEventTimeLow(), data->GetEventTimeHigh(), 32);
+            double time = filterTime;
+            if (data->GetCfdFractionalTime() != 0 && !data->GetCfdForcedTriggerBit()) {
+                double cfdTime = 0, multiplier = 1;
+                if (mask.GetFrequency() == 100)
+                    cfdTime = data->GetCfdFractionalTime() / mask.GetCfdSize();
+                if (mask.GetFrequency() == 250) {
+                    multiplier = 2;
+                    cfdTime = data->GetCfdFractionalTime() / mask.GetCfdSize() - data->GetCfdTriggerSource();
+                }
+                if (mask.GetFrequency() == 500) {
+                    multiplier = 10;
+                    cfdTime = data->GetCfdFractionalTime() / mask.GetCfdSize() + data->GetCfdTriggerSource() - 1;
+                }
+                time = filterTime * multiplier + cfdTime;
+            }
+            data->SetFilterTime(filterTime);
+            data->SetTime(time);
+
+            if (traceLength == 32767)
+                traceLength = 0;
+            if (traceLength / 2 + headerLength != eventLength) {
+                pool.ReleaseLast(events.size() - firstEvent + 1);
+                events.resize(firstEvent);
+                return 0;
+            }
+            buf += headerLength;
+            if (traceLength > 0) {
+                data->SetTraceView((unsigned short *) buf, traceLength);
+                buf += traceLength / 2;
+            }
+            events.push_back(data);
+        }
+        return (unsigned int) (events.size() - firstEvent);
+    }
+
+    ///@return A module buffer with a single four word header that has random values in every field but the lengths.
+    vector<unsigned int> RandomHeader(unsigned int &seed, const XiaListModeDataMask &mask) {
+        vector<unsigned int> buffer = {6, 0};
+        for (unsigned int i = 0; i < 4; i++) {
+            seed = seed * 1664525 + 1013904223;
+            buffer.push_back(seed);
+        }
+        buffer[2] &= ~(mask.GetHeaderLengthMask().first | mask.GetEventLengthMask().first);
+        buffer[2] |= (4 << mask.GetHeaderLengthMask().second) | (4 << mask.GetEventLengthMask().second);
+        buffer[5] &= ~mask.GetTraceLengthMask().first;
+        return buffer;
+    }
+
+    ///@return A module buffer that repeats the sample events until it has at least the requested number of events.
+    vector<unsigned int> MakeModuleBuffer(const unsigned int &numEvents) {
+        const vector<vector<unsigned int> *> samples = {&headerWithCfd, &headerWithEnergySumsQdcExternalTimestamp,
+                                                        &headerWithTrace, &headerWithExternalTimestamp};
+        vector<unsigned int> buffer = {0, 0};
+        for (unsigned int i = 0; i < numEvents; i++)
+            buffer.insert(buffer.end(), samples[i % samples.size()]->begin() + 2, samples[i % samples.size()]->end());
+        buffer[0] = (unsigned int) buffer.size();
+        return buffer;
+    }
+}
+
+using namespace unittest_decoder_layout;
+
 TEST_FIXTURE(XiaListModeDataDecoder, TestBufferLengthChecks) {
     CHECK_THROW(DecodeBuffer(&empty_buffer[0], mask), length_error);
     CHECK_EQUAL(empty_buffer[1], DecodeBuffer(&empty_module_buffer[0], mask).size());
@@ -93,12 +307,184 @@ TEST_FIXTURE(XiaListModeDataDecoder, TestTraceDecoding) {
     CHECK_ARRAY_EQUAL(unittest_trace_variables::trace, result.GetTrace(), unittest_trace_variables::trace.size());
 }
 
+///A trace length of 32768 shows up as 32767, we treat it as an event without a trace.
+TEST_FIXTURE(XiaListModeDataDecoder, TestTraceLengthSentinel) {
+    vector<unsigned int> buffer = header;
+    buffer[5] |= 32767 << 16;
+
+    vector<XiaData *> result = DecodeBuffer(&buffer[0], mask);
+    CHECK_EQUAL((unsigned int) 1, result.size());
+    CHECK(result.front()->GetTrace().empty());
+    CHECK_EQUAL(energy, result.front()->GetEnergy());
+    delete result.front();
+
+    XiaDataPool pool;
+    vector<XiaData *> events;
+    CHECK_EQUAL((unsigned int) 1, DecodeBuffer(&buffer[0], mask, pool, events));
+    CHECK(!events.front()->HasTraceView());
+    CHECK_EQUAL((unsigned int) 0, events.front()->GetTraceLength());
+}
+
 TEST_FIXTURE(XiaListModeDataDecoder, TestCfdTimeCalculation) {
     XiaData result = *(DecodeBuffer(&headerWithCfd[0], mask).front());
     CHECK_EQUAL(cfd_fractional_time, result.GetCfdFractionalTime());
     CHECK_CLOSE(unittest_decoded_data::R30474_250::ts_w_cfd, result.GetTime(), 1e-5);
 }
 
+TEST_FIXTURE(XiaListModeDataDecoder, TestPooledDecoding) {
+    XiaDataPool pool;
+    vector<XiaData *> events;
+
+    CHECK_EQUAL((unsigned int)0, DecodeBuffer(&header_w_bad_eventlen[0], mask, pool, events));
+    CHECK_EQUAL((unsigned int)0, pool.GetNumberInUse());
+    CHECK(events.empty());
+
+    CHECK_EQUAL((unsigned int)1, DecodeBuffer(&headerWithTrace[0], mask, pool, events));
+    CHECK_EQUAL((unsigned int)1, pool.GetNumberInUse());
+    CHECK(events.front()->HasTraceView());
+    CHECK_EQUAL(unittest_trace_variables::trace.size(), events.front()->GetTraceLength());
+    CHECK_ARRAY_EQUAL(unittest_trace_variables::trace, events.front()->GetTrace(),
+                      unittest_trace_variables::trace.size());
+
+    //After a reset we should get back the same object, without the trace from the previous spill.
+    XiaData *previous = events.front();
+    pool.Reset();
+    events.clear();
+
+    CHECK_EQUAL((unsigned int)1, DecodeBuffer(&headerWithEnergySumsQdc[0], mask, pool, events));
+    CHECK_EQUAL(previous, events.front());
+    CHECK(!events.front()->HasTraceView());
+    CHECK_EQUAL((unsigned int)0, events.front()->GetTraceLength());
+    CHECK_ARRAY_EQUAL(unittest_decoded_data::energy_sums, events.front()->GetEnergySums(),
+                      unittest_decoded_data::energy_sums.size());
+    CHECK_ARRAY_EQUAL(qdc, events.front()->GetQdc(), qdc.size());
+}
+
+TEST_FIXTURE(XiaListModeDataDecoder, TestChannelFilter) {
+    const unsigned int id = crateId * 208 + (slotId - 2) * 16 + channelNumber;
+    XiaChannelFilter filter;
+    filter.keep.assign(id + 1, true);
+    filter.keepTrace.assign(id + 1, true);
+    SetChannelFilter(&filter);
+
+    //Dropping the trace still leaves us with everything from the header.
+    filter.keepTrace[id] = false;
+    vector<XiaData *> result = DecodeBuffer(&headerWithTrace[0], mask);
+    CHECK_EQUAL((unsigned int) 1, result.size());
+    CHECK_EQUAL((unsigned int) 0, result.front()->GetTraceLength());
+    CHECK_EQUAL(energy, result.front()->GetEnergy());
+    CHECK_EQUAL(unittest_decoded_data::R30474_250::ts, result.front()->GetTime());
+    delete result.front();
+
+    //Channels that aren't kept don't leave anything behind in the pool.
+    filter.keep[id] = false;
+    XiaDataPool pool;
+    vector<XiaData *> events;
+    CHECK_EQUAL((unsigned int) 0, DecodeBuffer(&headerWithTrace[0], mask, pool, events));
+    CHECK(events.empty());
+    CHECK_EQUAL((unsigned int) 0, pool.GetNumberInUse());
+
+    SetChannelFilter(nullptr);
+    CHECK_EQUAL((unsigned int) 1, DecodeBuffer(&headerWithTrace[0], mask, pool, events));
+    CHECK_EQUAL(unittest_trace_variables::trace.size(), events.front()->GetTraceLength());
+}
+
+TEST_FIXTURE(XiaListModeDataDecoder, TestAllFirmwareLayouts) {
+    CHECK_THROW(DecodeBuffer(&header[0], XiaListModeDataMask()), invalid_argument);
+
+    unsigned int seed = 42;
+    for (auto firmware : firmwares) {
+        for (auto frequency : frequencies) {
+            XiaListModeDataMask layoutMask(firmware, frequency);
+            for (unsigned int i = 0; i < 200; i++) {
+                vector<unsigned int> buffer = RandomHeader(seed, layoutMask);
+                vector<XiaData *> result = DecodeBuffer(buffer.data(), layoutMask);
+                CHECK_EQUAL(1u, result.size());
+                if (result.empty())
+                    continue;
+
+                XiaData expected = ReferenceDecode(&buffer[2], layoutMask);
+                CHECK_EQUAL(expected.GetChannelNumber(), result[0]->GetChannelNumber());
+                CHECK_EQUAL(expected.GetSlotNumber(), result[0]->GetSlotNumber());
+                CHECK_EQUAL(expected.GetCrateNumber(), result[0]->GetCrateNumber());
+                CHECK_EQUAL(expected.IsPileup(), result[0]->IsPileup());
+                CHECK_EQUAL(expected.IsSaturated(), result[0]->IsSaturated());
+                CHECK_EQUAL(expected.GetEnergy(), result[0]->GetEnergy());
+                CHECK_EQUAL(expected.GetEventTimeHigh(), result[0]->GetEventTimeHigh());
+                CHECK_EQUAL(expected.GetCfdFractionalTime(), result[0]->GetCfdFractionalTime());
+                CHECK_EQUAL(expected.GetCfdForcedTriggerBit(), result[0]->GetCfdForcedTriggerBit());
+                CHECK_EQUAL(expected.GetCfdTriggerSource(), result[0]->GetCfdTriggerSource());
+                CHECK_CLOSE(expected.GetTime(), result[0]->GetTime(), 1e-3);
+                delete result[0];
+            }
+        }
+    }
+}
+
+///The 500 MS/s modules record which of the five ADCs the CFD triggered on in three bits, so the source has to survive
+/// being decoded and shift the time by the whole number of samples.
+TEST_FIXTURE(XiaListModeDataDecoder, Test500MspsTriggerSource) {
+    XiaListModeDataMask mask500(R30474, 500);
+    const unsigned int source = 3;
+    const unsigned int cfdFraction = 4096;
+    unsigned int word2 = (source << mask500.GetCfdTriggerSourceMask().second) |
+                         (cfdFraction << mask500.GetCfdFractionalTimeMask().second) | ts_high;
+    vector<unsigned int> buffer = {6, 0, word0_header, word1, word2, word3_headerOnly};
+
+    vector<XiaData *> result = DecodeBuffer(buffer.data(), mask500);
+    CHECK_EQUAL(1u, result.size());
+    if (result.empty())
+        return;
+
+    CHECK_EQUAL(source, result[0]->GetCfdTriggerSource());
+    CHECK_EQUAL(cfdFraction, result[0]->GetCfdFractionalTime());
+    double filterTime = word1 + (double) ts_high * 4294967296.;
+    CHECK_CLOSE(10 * filterTime + 0.5 + source - 1, CalculateTimeInSamples(mask500, *result[0]).second, 1e-3);
+    delete result[0];
+}
+
+///Times the decoding of a module buffer built from the sample events with the layout that we look up once per module
+/// and with the decoding that we did before, then checks that both give the same events. We only print the timing
+/// since it depends on the machine.
+TEST_FIXTURE(XiaListModeDataDecoder, BenchmarkDecoding) {
+    static const unsigned int numEvents = 4000;
+    static const unsigned int numBuffers = 200;
+    vector<unsigned int> buffer = MakeModuleBuffer(numEvents);
+
+    XiaDataPool pool;
+    vector<XiaData *> events;
+    auto start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < numBuffers; i++) {
+        pool.Reset();
+        events.clear();
+        CHECK_EQUAL(numEvents, DecodeBuffer(buffer.data(), mask, pool, events));
+    }
+    chrono::duration<double> layoutTime = chrono::steady_clock::now() - start;
+
+    XiaDataPool legacyPool;
+    vector<XiaData *> legacyEvents;
+    start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < numBuffers; i++) {
+        legacyPool.Reset();
+        legacyEvents.clear();
+        CHECK_EQUAL(numEvents, LegacyDecodeBuffer(buffer.data(), mask, legacyPool, legacyEvents));
+    }
+    chrono::duration<double> legacyTime = chrono::steady_clock::now() - start;
+
+    CHECK_EQUAL(events.size(), legacyEvents.size());
+    for (size_t i = 0; i < events.size() && i < legacyEvents.size(); i++) {
+        CHECK_EQUAL(legacyEvents[i]->GetId(), events[i]->GetId());
+        CHECK_EQUAL(legacyEvents[i]->GetEnergy(), events[i]->GetEnergy());
+        CHECK_EQUAL(legacyEvents[i]->GetTime(), events[i]->GetTime());
+        CHECK_EQUAL(legacyEvents[i]->GetTraceLength(), events[i]->GetTraceLength());
+        CHECK(legacyEvents[i]->GetQdc() == events[i]->GetQdc());
+        CHECK(legacyEvents[i]->GetEnergySums() == events[i]->GetEnergySums());
+    }
+
+    cout << "BenchmarkDecoding - Layout : " << numEvents * numBuffers / layoutTime.count() / 1e6
+         << " Mhits/s, previous decoder : " << numEvents * numBuffers / legacyTime.count() / 1e6 << " Mhits/s" << endl;
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
\ No newline at end of file
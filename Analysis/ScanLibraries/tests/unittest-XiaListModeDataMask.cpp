@@ -213,6 +213,18 @@ TEST_FIXTURE(XiaListModeDataMask, Test_Cfd_Size_Mask) {
     }
 }
 
+TEST_FIXTURE(XiaListModeDataMask, Test_Timestamp_Tick) {
+    SetFrequency(0);
+    CHECK_THROW(GetTimestampTickInSeconds(), invalid_argument);
+
+    SetFrequency(100);
+    CHECK_EQUAL(10e-9, GetTimestampTickInSeconds());
+    SetFrequency(250);
+    CHECK_EQUAL(8e-9, GetTimestampTickInSeconds());
+    SetFrequency(500);
+    CHECK_EQUAL(10e-9, GetTimestampTickInSeconds());
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
\ No newline at end of file
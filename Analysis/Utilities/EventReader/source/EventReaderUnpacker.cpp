@@ -71,7 +71,7 @@ bool EventReaderUnpacker::AddEvent(XiaData *event_){
             displayBool(" Pileup:        ", event_->IsPileup());
             displayBool(" Saturated:     ", event_->IsSaturated());
             displayBool(" CFD Force:     ", event_->GetCfdForcedTriggerBit());
-            displayBool(" CFD Trig:      ", event_->GetCfdTriggerSourceBit());
+            std::cout << " CFD Trig:      " << event_->GetCfdTriggerSource() << std::endl;
         }
 
         if(showTrace_ && !event_->GetTrace().empty()){
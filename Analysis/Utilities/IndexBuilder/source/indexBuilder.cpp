@@ -0,0 +1,117 @@
+/// @file indexBuilder.cpp
+/// @brief Builds the spill index for pld and ldf files that were written without one.
+/// @author S. V. Paulauskas
+/// @date October 18, 2026
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include <string.h>
+
+#include "ScanInterface.hpp"
+#include "SpillIndex.h"
+#include "hribf_buffers.h"
+
+void help(char *name_) {
+    std::cout << "  SYNTAX: " << name_ << " <files ...>\n";
+    std::cout << "   Writes <file>.idx next to every input file, which lets the scan codes\n";
+    std::cout << "   seek to a spill (--spill) or a time in the run (--start-time, --stop-time).\n";
+}
+
+/// The index entries point at the start of each pld DATA buffer.
+unsigned int IndexPld(std::ifstream &file, SpillIndex &index) {
+    PLD_header pldHead;
+    PLD_data pldData;
+    pldHead.Read(&file);
+
+    std::vector<unsigned int> data(pldHead.GetMaxSpillSize() + 2);
+    unsigned int nBytes;
+    unsigned int numSpills = 0;
+    unsigned long long offset = file.tellg();
+    while (pldData.Read(&file, (char *) data.data(), nBytes, 4 * pldHead.GetMaxSpillSize())) {
+        index.Add(offset, data.data(), nBytes / 4);
+        numSpills++;
+        offset = file.tellg();
+    }
+    return numSpills;
+}
+
+/// The spills are packed into the ldf buffers, so the index entries point at the start of the buffer holding the
+/// first chunk of each spill. Spill fragments, e.g. from a file that was split during a run, are not indexed.
+unsigned int IndexLdf(std::ifstream &file, SpillIndex &index) {
+    DIR_buffer ldfDir;
+    HEAD_buffer ldfHead;
+    DATA_buffer ldfData;
+    ldfDir.Read(&file);
+    ldfHead.Read(&file);
+
+    std::vector<unsigned int> data(250000);
+    const unsigned long long dataStart = file.tellg();
+    const unsigned long long bufferBytes = 4 * ACTUAL_BUFF_SIZE;
+    unsigned int nBytes;
+    bool full_spill, bad_spill;
+    unsigned int numSpills = 0;
+    while (true) {
+        if (!ldfData.Read(&file, (char *) data.data(), nBytes, 4 * data.size(), full_spill, bad_spill)) {
+            // Stop at the end of the file or when we can't read, everything else is a bad chunk that's skipped.
+            if (ldfData.GetRetval() == 2 || ldfData.GetRetval() == 6)
+                break;
+            continue;
+        }
+
+        if (!full_spill)
+            continue;
+
+        // The spill comes with the two word end of spill marker, which isn't part of the spill that poll wrote.
+        index.Add(dataStart + ldfData.GetSpillStartBuffer() * bufferBytes, data.data(), nBytes / 4 - 2);
+        numSpills++;
+    }
+    return numSpills;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cout << " Error: Invalid number of arguments to " << argv[0]
+                  << ". Expected 1, received " << argc - 1 << ".\n";
+        help(argv[0]);
+        return 1;
+    }
+
+    int retval = 0;
+    std::string dummy, extension;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            help(argv[0]);
+            return 0;
+        }
+
+        extension = get_extension(argv[i], dummy);
+        if (extension != "ldf" && extension != "pld") {
+            std::cout << " ERROR! Invalid file extension '" << extension << "' for " << argv[i] << ".\n";
+            retval = 1;
+            continue;
+        }
+
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file.is_open() || !file.good()) {
+            std::cout << " ERROR! Failed to open input file " << argv[i]
+                      << "! Check that the path is correct.\n";
+            retval = 1;
+            continue;
+        }
+
+        std::string index_filename = SpillIndex::GetIndexFilename(argv[i]);
+        SpillIndex index;
+        if (!index.Create(index_filename)) {
+            retval = 1;
+            continue;
+        }
+
+        unsigned int numSpills = extension == "pld" ? IndexPld(file, index) : IndexLdf(file, index);
+        index.Close();
+
+        std::cout << " Indexed " << numSpills << " spills from " << argv[i] << " into " << index_filename << ".\n";
+    }
+
+    return retval;
+}
@@ -29,8 +29,19 @@ public:
     * \param [in] tagMap : the map of tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return True if the timing driver keeps no state between traces */
+    bool IsEventParallel(void) const { return isEventParallel_; }
+
+    /** \return False since we only work on the waveform found by the
+     * WaveformAnalyzer, which asks for the traces that it needs */
+    bool UsesTrace(const ChannelConfiguration &) const { return false; }
+
+    /** \return True since the phase only depends on the waveform */
+    bool IsCacheable(void) const { return true; }
+
 private:
     TimingDriver *driver_;
+    bool isEventParallel_; ///< The polynomial CFD keeps no state, the others keep a scratch vector.
 };
 
 #endif
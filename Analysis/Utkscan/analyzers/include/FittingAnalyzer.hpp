@@ -32,6 +32,13 @@ public:
      * \param [in] tagMap : the map of tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return False since we only fit traces that the WaveformAnalyzer
+     * analyzed, which asks for the traces that it needs */
+    bool UsesTrace(const ChannelConfiguration &) const { return false; }
+
+    /** \return True since the phase only depends on the waveform */
+    bool IsCacheable(void) const { return true; }
+
 private:
     TimingDriver *driver_;
 };
@@ -30,6 +30,9 @@ public:
     * \param [in] tagMap : the map of tags for the channel */
     virtual void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return True since tau only depends on the trace */
+    bool IsCacheable(void) const { return true; }
+
 private:
     std::string type; //!< the detector type
     std::string subtype;//!< the detector subtype
@@ -6,8 +6,9 @@
 #ifndef __TRACEANALYZER_HPP_
 #define __TRACEANALYZER_HPP_
 
+#include <atomic>
+#include <mutex>
 #include <string>
-#include <sys/times.h>
 
 #include "ChannelConfiguration.hpp"
 #include "Plots.hpp"
@@ -54,9 +55,39 @@ public:
     /** \return the level of the trace analysis */
     int GetLevel() { return level; }
 
+    /** \return the name of the analyzer */
+    const std::string &GetName() const { return name; }
+
+    /** \return True if the analyzer has histogram ids to plot into */
+    bool HasPlots() const { return histo.GetRange() != 0; }
+
+    /** Analyzers that return true here may analyze traces from several
+     * events at once. To opt in, Analyze must only modify the trace that it
+     * is handed and fill histograms.
+     * \return True if the analyzer can run on several threads at once */
+    virtual bool IsEventParallel(void) const { return false; }
+
+    /** Traces are only decoded for the channels that an analyzer or a
+     * processor uses them for. Analyzers that only work on some channels
+     * should say so here.
+     * \param [in] cfg : the configuration of the channel
+     * \return True if the analyzer uses the traces of the channel */
+    virtual bool UsesTrace(const ChannelConfiguration &cfg) const { return true; }
+
+    /** The results of analyzers that return true here may be stored in and
+     * restored from the trace cache instead of running Analyze again. To opt
+     * in, Analyze must only depend on the samples and the configuration of
+     * the channel, and only leave results in the trace that TraceResult keeps.
+     * Analyze isn't called for the traces that are restored from the cache,
+     * so an analyzer that plots can't opt in, the histograms would differ
+     * from a scan without the cache. DetectorDriver::OpenTraceCache refuses
+     * to use the cache with a cacheable analyzer that has plots.
+     * \return True if the results of the analyzer can be cached */
+    virtual bool IsCacheable(void) const { return false; }
+
 protected:
     int level;                ///< the level of analysis to proceed with
-    static int numTracesAnalyzed;    ///< rownumber for DAMM spectrum 850
+    static std::atomic<int> numTracesAnalyzed;    ///< rownumber for DAMM spectrum 850
     std::string name;         ///< name of the analyzer
 
     /** Plots class for given Processor, takes care of declaration
@@ -100,11 +131,20 @@ protected:
     * \param [in] row : the row to plot the trace into
     * \param [in] offset : the offset for the trace*/
     void OffsetPlot(const std::vector<unsigned int> &trc, int id, int row, double offset);
+
+    /** Counts a regrowth if storing our results grew the capacity of the
+     * trace's result buffers. Heap allocations made anywhere else aren't seen.
+     * \param [in] before : the capacity of the trace's results before we stored ours
+     * \param [in] after : the capacity of the trace's results after we stored ours */
+    void CountBufferRegrowth(const size_t &before, const size_t &after) {
+        if (after > before)
+            numBufferRegrowths++;
+    }
 private:
-    tms tmsBegin;             ///< time at which the analyzer began
+    std::mutex timingMutex_;  ///< protects the totals when we're running on several threads
     double userTime;          ///< user time used by this class
     double systemTime;        ///< system time used by this class
-    double clocksPerSecond;   ///< frequency of system clock
+    std::atomic<unsigned long> numBufferRegrowths; ///< number of times that our results grew a trace's buffers
 };
 
 #endif // __TRACEANALYZER_HPP_
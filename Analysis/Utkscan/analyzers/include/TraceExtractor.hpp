@@ -38,6 +38,12 @@ public:
     * \param [in] tags : the map of tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return True if the channel is the type, subtype and tag that we plot
+     * \param [in] cfg : the configuration of the channel */
+    bool UsesTrace(const ChannelConfiguration &cfg) const {
+        return type_ == cfg.GetType() && subtype_ == cfg.GetSubtype() && cfg.HasTag(tag_);
+    }
+
 private:
     static const unsigned int traceBins_; //!< The number of bins for the trace length
     static const unsigned int numTraces_; //!< The number of traces to analyze
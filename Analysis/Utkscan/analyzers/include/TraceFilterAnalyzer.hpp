@@ -12,6 +12,7 @@
 
 #include "Trace.hpp"
 #include "TraceAnalyzer.hpp"
+#include "TraceFilter.hpp"
 #include "TrapFilterParameters.hpp"
 
 //! \brief A class to perform trapezoidal filters on the traces
@@ -43,5 +44,6 @@ private:
     TrapFilterParameters enPars_; //!< energy filter parametersf
     std::vector<double> fastFilter;   //!< fast filter of trace
     std::vector<double> energyFilter; //!< slow filter of trace
+    TraceFilter filter_; //!< The filter that we reuse for every trace
 };
 #endif // __TRACEFILTERER_HPP_
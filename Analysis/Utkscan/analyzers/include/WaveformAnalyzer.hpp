@@ -30,6 +30,18 @@ public:
     * \param [in] tags : the map of the tags for the channel */
     void Analyze(Trace &trace, const ChannelConfiguration &cfg);
 
+    /** \return True since the analysis only depends on the trace */
+    bool IsEventParallel(void) const { return true; }
+
+    /** \return True unless the type of the channel is ignored
+     * \param [in] cfg : the configuration of the channel */
+    bool UsesTrace(const ChannelConfiguration &cfg) const {
+        return ignoredTypes_.find(cfg.GetType()) == ignoredTypes_.end();
+    }
+
+    /** \return True since the analysis only depends on the trace */
+    bool IsCacheable(void) const { return true; }
+
 private:
     std::set<std::string> ignoredTypes_;
 };
@@ -18,9 +18,11 @@ using namespace std;
 
 CfdAnalyzer::CfdAnalyzer(const std::string &s) : TraceAnalyzer() {
     name = "CfdAnalyzer";
-    if (s == "polynomial" || s == "poly")
+    isEventParallel_ = false;
+    if (s == "polynomial" || s == "poly") {
         driver_ = new PolynomialCfd();
-    else if (s == "traditional" || s == "trad")
+        isEventParallel_ = true;
+    } else if (s == "traditional" || s == "trad")
         driver_ = new TraditionalCfd();
     else if (s == "xia" || s == "XIA")
         driver_ = new XiaCfd();
@@ -36,12 +38,16 @@ void CfdAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
         return;
     }
 
+    //The waveform is only copied out of the trace the first time that we ask for it.
+    size_t capacity = trace.GetResultsCapacity();
     if (trace.IsSaturated() || trace.empty() || trace.GetWaveform().empty()) {
+        CountBufferRegrowth(capacity, trace.GetResultsCapacity());
         EndAnalyze();
         return;
     }
 
     trace.SetPhase(driver_->CalculatePhase(trace.GetWaveform(), cfg.GetTimingConfiguration(),
                                            trace.GetExtrapolatedMaxInfo(), trace.GetBaselineInfo()) + trace.GetMaxInfo().first);
+    CountBufferRegrowth(capacity, trace.GetResultsCapacity());
     EndAnalyze();
 }
@@ -59,7 +59,9 @@ void FittingAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
     if (cfg.GetType() == "beta" && cfg.GetSubtype() == "double" && cfg.HasTag("timing"))
         timingConfiguration.SetIsFastSiPm(true);
 
+    size_t capacity = trace.GetResultsCapacity();
     trace.SetPhase(driver_->CalculatePhase(trace.GetWaveform(), timingConfiguration, trace.GetMaxInfo(),
                                            trace.GetBaselineInfo()) + trace.GetMaxInfo().first);
+    CountBufferRegrowth(capacity, trace.GetResultsCapacity());
     EndAnalyze();
 }
\ No newline at end of file
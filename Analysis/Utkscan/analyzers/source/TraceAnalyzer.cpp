@@ -14,7 +14,7 @@
 
 #include <cmath>
 
-#include <unistd.h>
+#include <sys/resource.h>
 
 #include "DammPlotIds.hpp"
 #include "Trace.hpp"
@@ -22,19 +22,27 @@
 
 using namespace std;
 
-int TraceAnalyzer::numTracesAnalyzed = -1; //!< number of analyzed traces
+atomic<int> TraceAnalyzer::numTracesAnalyzed(-1); //!< number of analyzed traces
 
-TraceAnalyzer::TraceAnalyzer() : histo(0, 0, "generic"), userTime(0.), systemTime(0.) {
-    clocksPerSecond = sysconf(_SC_CLK_TCK);
+namespace {
+    ///The CPU time of the calling thread when the analyzer began. The analyzers on a thread run one after the other,
+    /// so they can share it, and the event threads don't see each other's.
+    thread_local rusage analysisBegin;
+
+    ///@return The difference between two times in seconds
+    double Seconds(const timeval &end, const timeval &begin) {
+        return (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) * 1e-6;
+    }
 }
 
+TraceAnalyzer::TraceAnalyzer() : histo(0, 0, "generic"), userTime(0.), systemTime(0.), numBufferRegrowths(0) {}
+
 TraceAnalyzer::TraceAnalyzer(const unsigned int &offset, const unsigned int &range, const std::string &name) :
-        histo(offset, range, name), userTime(0.), systemTime(0.) {
-    clocksPerSecond = sysconf(_SC_CLK_TCK);
-}
+        histo(offset, range, name), userTime(0.), systemTime(0.), numBufferRegrowths(0) {}
 
 TraceAnalyzer::~TraceAnalyzer() {
-    cout << name << " analyzer : " << userTime << " user time, " << systemTime << " system time" << endl;
+    cout << name << " analyzer : " << userTime << " user time, " << systemTime << " system time, "
+         << numBufferRegrowths << " result buffer regrowths" << endl;
 }
 
 void TraceAnalyzer::Plot(const vector<unsigned int> &trc, const int &id) {
@@ -68,7 +76,7 @@ void TraceAnalyzer::OffsetPlot(const vector<unsigned int> &trc, int id, int row,
 }
 
 void TraceAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
-    times(&tmsBegin);
+    getrusage(RUSAGE_THREAD, &analysisBegin);
     numTracesAnalyzed++;
     EndAnalyze(trace);
     return;
@@ -78,14 +86,17 @@ void TraceAnalyzer::EndAnalyze(Trace &trace) {
     EndAnalyze();
 }
 
+///The times are for the calling thread only, so the totals are the time that we spent on every thread.
 void TraceAnalyzer::EndAnalyze(void) {
-    tms tmsEnd;
-    times(&tmsEnd);
-
-    userTime += (tmsEnd.tms_utime - tmsBegin.tms_utime) / clocksPerSecond;
-    systemTime += (tmsEnd.tms_stime - tmsBegin.tms_stime) / clocksPerSecond;
+    rusage analysisEnd;
+    getrusage(RUSAGE_THREAD, &analysisEnd);
+    {
+        lock_guard<mutex> lock(timingMutex_);
+        userTime += Seconds(analysisEnd.ru_utime, analysisBegin.ru_utime);
+        systemTime += Seconds(analysisEnd.ru_stime, analysisBegin.ru_stime);
+    }
 
     // reset the beginning time so multiple calls of EndAnalyze from
     //   derived classes work properly
-    times(&tmsBegin);
+    analysisBegin = analysisEnd;
 }
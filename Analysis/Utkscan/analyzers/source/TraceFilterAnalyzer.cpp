@@ -26,7 +26,8 @@ namespace dammIds {
 }
 
 TraceFilterAnalyzer::TraceFilterAnalyzer(const bool &analyzePileup) :
-        TraceAnalyzer(OFFSET, RANGE, "TraceFilterAnalyzer") {
+        TraceAnalyzer(OFFSET, RANGE, "TraceFilterAnalyzer"),
+        filter_(0, TrapFilterParameters(), TrapFilterParameters(), analyzePileup) {
     analyzePileup_ = analyzePileup;
     name = "TraceFilterAnalyzer";
 }
@@ -47,10 +48,11 @@ void TraceFilterAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg)
     static int numPileup = 0;
     static unsigned short numTraces = S7;
 
-    //Want to put filter clock units of ns/Sample
-    TraceFilter filter(globs->GetFilterClockInSeconds() * 1e9, cfg.GetTriggerFilterParameters(),
-                       cfg.GetEnergyFilterParameters(), analyzePileup_);
-    unsigned int retval = filter.CalcFilters(&trace);
+    //Want to put filter clock units of ns/Sample. We reuse the same filter for every trace so that its buffers only
+    // grow when we see a longer trace.
+    filter_.SetAdcSample(globs->GetFilterClockInSeconds() * 1e9);
+    filter_.SetFilterParameters(cfg.GetTriggerFilterParameters(), cfg.GetEnergyFilterParameters());
+    unsigned int retval = filter_.CalcFilters(&trace);
     histo.Plot(D_RETVALS, retval);
 
     if (retval != 0) {
@@ -60,13 +62,15 @@ void TraceFilterAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg)
         return;
     }
 
-    trace.SetTriggerFilter(filter.GetTriggerFilter());
-    trace.SetTriggerPositions(filter.GetTriggers());
-    trace.SetFilteredEnergies(filter.GetEnergies());
-    trace.SetEnergySums(filter.GetEnergySums());
-    trace.SetFilteredBaseline(filter.GetBaseline());
+    size_t capacity = trace.GetResultsCapacity();
+    trace.SetTriggerFilter(filter_.GetTriggerFilter());
+    trace.SetTriggerPositions(filter_.GetTriggers());
+    trace.SetFilteredEnergies(filter_.GetEnergies());
+    trace.SetEnergySums(filter_.GetEnergySums());
+    trace.SetFilteredBaseline(filter_.GetBaseline());
+    CountBufferRegrowth(capacity, trace.GetResultsCapacity());
 
-    if (filter.GetHasPileup() && numPileup < numTraces)
+    if (filter_.GetHasPileup() && numPileup < numTraces)
         histo.Plot(DD_PILEUP, numPileup++);
 
     ///@TODO : We have not enabled users to set histograms with a weight in ROOT. In this routine, we're trying to
@@ -74,7 +78,7 @@ void TraceFilterAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg)
 //    static int numTrigFilters = 0;
 //    unsigned int xval = 0;
 //    if(numTrigFilters == 0) {
-//        for (const auto &val : filter.GetTriggerFilter())
+//        for (const auto &val : filter_.GetTriggerFilter())
 //            histo.Plot(DD_TRIGGER_FILTER, xval++, numTrigFilters, val);
 //    }
 //    numTrigFilters++;
@@ -80,14 +80,17 @@ void WaveformAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
         //Subtract the baseline from the maximum value.
         max.second -= baseline.first;
 
-        vector<double> traceNoBaseline;
-        for (unsigned int i = 0; i < trace.size(); i++)
-            traceNoBaseline.push_back(trace[i] - baseline.first);
+        //The baseline subtracted trace is written straight into the trace's own storage. The channel is recycled by
+        // the ChanEventPool for the rest of the scan, so the storage outlives the event just like the analyzer does,
+        // and it only grows when a trace is longer than any that the recycled channel has held before.
+        size_t capacity = trace.GetResultsCapacity();
+        trace.CalculateTraceSansBaseline(baseline.first);
+        CountBufferRegrowth(capacity, trace.GetResultsCapacity());
 
         //Finally, we calculate the QDC in the waveform range and subtract
         // the baseline from it.
         pair<unsigned int, unsigned int> waveformRange(max.first - range.first, max.first + range.second);
-        double qdc = TraceFunctions::CalculateQdc(traceNoBaseline, waveformRange);
+        double qdc = TraceFunctions::CalculateQdc(trace.GetTraceSansBaseline(), waveformRange);
 
         //Now we are going to set all the different values into the trace.
         trace.SetQdc(qdc);
@@ -95,7 +98,6 @@ void WaveformAnalyzer::Analyze(Trace &trace, const ChannelConfiguration &cfg) {
         trace.SetMax(max);
         trace.SetExtrapolatedMax(make_pair(max.first,
                                            TraceFunctions::ExtrapolateMaximum(trace, max).first - baseline.first));
-        trace.SetTraceSansBaseline(traceNoBaseline);
         trace.SetWaveformRange(waveformRange);
         trace.SetHasValidAnalysis(true);
     } catch (range_error &ex) {
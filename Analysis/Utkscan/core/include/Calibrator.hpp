@@ -35,6 +35,17 @@ struct CalibrationParams {
     std::vector<double> parameters; //!< coefficients for calibration eqn.
 };
 
+/** \brief A calibration range in the tables that are compiled for the
+ * channels. The linear, quadratic and cubic models are compiled into the
+ * polynomial model, which is evaluated with Horner's method. */
+struct CompiledCalibration {
+    CalibrationModel model; //!< Calibration model to use
+    double min;//!< Minimum of range for calibration
+    double max;//!< Maximum of range for calibration
+    unsigned int firstParameter; //!< Index of the first coefficient in the table of coefficients
+    unsigned int numParameters; //!< Number of coefficients
+};
+
 /** \brief Class to handle energy calibrations
  *
  * The Calibrator class returns calibrated energy for the raw channel
@@ -65,12 +76,50 @@ public:
      * \param [in] raw : the raw value to use for the calibration */
     double GetCalEnergy(const ChannelConfiguration &chanID, double raw) const;
 
+    /** Compiles the calibrations into tables that are indexed by the
+     * position of the channel in the DetectorLibrary, so that calibrating a
+     * hit doesn't need to compare any configurations. This has to be called
+     * again after channels are added.
+     * \param [in] channels : the channels in the order of the DetectorLibrary */
+    void Compile(const std::vector<ChannelConfiguration> &channels);
+
+    /** \return calibrated energy for the channel from the compiled tables.
+     * Channels that weren't compiled aren't calibrated.
+     * \param [in] id : the index of the channel in the DetectorLibrary
+     * \param [in] raw : the raw value to use for the calibration */
+    double GetCalEnergy(const unsigned int &id, double raw) const {
+        if (id + 1 >= firstCalibration_.size())
+            return raw;
+        return Evaluate(firstCalibration_[id], firstCalibration_[id + 1], raw);
+    }
+
+    /** Calibrates the hits of a whole event with the compiled tables.
+     * \param [in] ids : the index of the channel of every hit
+     * \param [in] raw : the raw value of every hit
+     * \param [out] calibrated : the calibrated energy of every hit
+     * \param [in] numHits : the number of hits */
+    void GetCalEnergies(const unsigned int *ids, const double *raw, double *calibrated,
+                        const size_t &numHits) const;
+
 private:
     /** Map where key is a channel ChannelConfiguration
      * and value is a vector holding struct with calibration range
      * and calibration model and parameters.*/
     std::map<ChannelConfiguration, std::vector<CalibrationParams>> channels_;
 
+    std::vector<unsigned int> firstCalibration_; //!< The first range of every channel, and one past the last range
+    std::vector<CompiledCalibration> calibrations_; //!< The compiled ranges of all the channels
+    std::vector<double> coefficients_; //!< The coefficients of all the compiled ranges
+
+    /** Calibrates a value with the compiled ranges of a channel. Values
+     * outside of all of the ranges are zeroed, while channels without any
+     * ranges aren't calibrated.
+     * \param [in] first : the index of the first range of the channel
+     * \param [in] last : one past the index of the last range of the channel
+     * \param [in] raw : the raw value to calibrate
+     * \return Calibrated energy */
+    double Evaluate(const unsigned int &first, const unsigned int &last, double raw) const;
+
     /** Use if you want to switch off the calibration.
      * \param [in] raw : the raw value to calibrate
      * \return the raw channel number. */
@@ -86,7 +135,7 @@ private:
      * \param [in] par : the vector of calibration coeffs
      * \param [in] raw : the raw value to calibrate
      * \return Calibrated energy */
-    double ModelLinear(const std::vector<double> &par, double raw) const;
+    double ModelLinear(const double *par, double raw) const;
 
     /** Quadratic calibration, parameters are assumed to be sorted
      * in order par0, par1, par2
@@ -94,7 +143,7 @@ private:
      * \param [in] par : the vector of calibration coeffs
      * \param [in] raw : the raw value to calibrate
      * \return Calibrated energy */
-    double ModelQuadratic(const std::vector<double> &par, double raw) const;
+    double ModelQuadratic(const double *par, double raw) const;
 
     /** Cubic calibration, parameters are assumed to be sorted
      * in order par0, par1, par2, par3
@@ -102,19 +151,19 @@ private:
      * \param [in] par : the vector of calibration coeffs
      * \param [in] raw : the raw value to calibrate
      * \return Calibrated energy */
-    double ModelCubic(const std::vector<double> &par, double raw) const;
+    double ModelCubic(const double *par, double raw) const;
 
     /** Polynomial calibration, where parameters are assumed to be sorted
      * from the lowest order to the highest
      * f(x) = par0 + par1 * x + par2 * x^2 + ...
      *
-     * Note that this model covers also Linear and Quadratic, however
-     * it is slower due to looping over unknown apriori number
-     * of parameters.
+     * The polynomial is evaluated with Horner's method, so it covers the
+     * Linear, Quadratic and Cubic models in the compiled tables.
      * \param [in] par : the vector of calibration coeffs
+     * \param [in] numPar : the number of coefficients
      * \param [in] raw : the raw value to calibrate
      * \return Calibrated energy */
-    double ModelPolynomial(const std::vector<double> &par, double raw) const;
+    double ModelPolynomial(const double *par, const unsigned int &numPar, double raw) const;
 
     /** Linear plus hyperbolic calibration,
      * parameters are assumed to be sorted
@@ -123,14 +172,14 @@ private:
      * \param [in] par : the vector of calibration coeffs
      * \param [in] raw : the raw value to calibrate
      * \return Calibrated energy */
-    double ModelHypLin(const std::vector<double> &par, double raw) const;
+    double ModelHypLin(const double *par, double raw) const;
 
     /** Exponential (for logarithmic preamp)
      * f(x) = par0 * exp(x / par[1]) + par2
      * \param [in] par : the vector of calibration coeffs
      * \param [in] raw : the raw value to calibrate
      * \return Calibrated energy */
-    double ModelExp(const std::vector<double> &par, double raw) const;
+    double ModelExp(const double *par, double raw) const;
 };
 
 #endif
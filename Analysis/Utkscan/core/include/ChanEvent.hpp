@@ -25,23 +25,42 @@
 class ChanEvent : public ProcessedXiaData {
 public:
     /** Default constructor that zeroes all values */
-    ChanEvent() {}
+    ChanEvent() : descriptor_(NULL) {}
 
     ///Constructor taking the base class as an argument so that we can set
-    /// the trace information properly
+    /// the trace information properly. The descriptor of the channel is looked up once here.
     ///@param[in] evt : The event that we are going to assign here.
-    ChanEvent(XiaData &evt) : ProcessedXiaData(evt) {}
+    ChanEvent(XiaData &evt) : ProcessedXiaData(evt), descriptor_(DetectorLibrary::get()->GetDescriptor(
+            DetectorLibrary::get()->GetIndex(GetModuleNumber(), GetChannelNumber()))) {}
 
     ///Default Destructor
     ~ChanEvent() {}
 
+    ///Takes over the decoded hit without copying its trace, energy sums or QDCs, see ProcessedXiaData::Adopt. This
+    /// is how the channels from the ChanEventPool are filled.
+    ///@param[in,out] evt : The decoded hit, it's left with our old storage.
+    void Adopt(XiaData &evt) {
+        ProcessedXiaData::Adopt(evt);
+        descriptor_ = DetectorLibrary::get()->GetDescriptor(
+                DetectorLibrary::get()->GetIndex(GetModuleNumber(), GetChannelNumber()));
+    }
+
     //! \return The channelConfiguration in the map for the channel event
     const ChannelConfiguration &GetChanID() const {
+        if (descriptor_)
+            return *descriptor_->configuration;
         return DetectorLibrary::get()->at(GetModuleNumber(), GetChannelNumber());
     }
 
+    ///@return The descriptor of the channel, or NULL if the channel isn't in the map
+    const ChannelDescriptor *GetDescriptor() const { return descriptor_; }
+
     /** \return the channel id defined as pixie module # * 16 + channel number */
-    unsigned int GetID() const { return DetectorLibrary::get()->GetIndex(GetModuleNumber(), GetChannelNumber()); }
+    unsigned int GetID() const {
+        if (descriptor_)
+            return descriptor_->id;
+        return DetectorLibrary::get()->GetIndex(GetModuleNumber(), GetChannelNumber());
+    }
 
     ///Equality operator, we only check to see if the module number, channel number, and times are equal.
     ///@param [in] rhs : the configuration to compare to
@@ -69,5 +88,8 @@ public:
     ///@param[in] rhs : The right hand side that we are comparing with.
     ///@return The negative of the less than operator.
     bool operator>(const ChanEvent &rhs) const { return !operator<(rhs); }
+
+private:
+    const ChannelDescriptor *descriptor_; ///< The descriptor of the channel in the DetectorLibrary
 };
 #endif
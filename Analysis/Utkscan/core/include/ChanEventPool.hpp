@@ -0,0 +1,62 @@
+///@file ChanEventPool.hpp
+///@brief A pool of recycled ChanEvent objects that are handed out to build the raw events.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef __CHANEVENTPOOL_HPP__
+#define __CHANEVENTPOOL_HPP__
+
+#include <vector>
+
+#include "ChanEvent.hpp"
+
+///Every hit in an event used to be copied into a ChanEvent allocated on the heap, which was deleted again once the
+/// event was processed. The pool keeps the channels of processed events instead. They keep the capacity of their
+/// trace, its analysis results, the energy sums and the QDCs, so after a few events filling a channel with
+/// ChanEvent::Adopt requires no heap allocations. Every thread has its own pool so that no locking is needed. A
+/// channel may be released on a different thread than it was acquired on, it then belongs to that thread's pool.
+class ChanEventPool {
+public:
+    ///@return The pool of the calling thread.
+    static ChanEventPool *get() {
+        static thread_local ChanEventPool pool;
+        return &pool;
+    }
+
+    ///Deletes the channels that are in the pool. Channels that are still handed out aren't owned by the pool.
+    ~ChanEventPool() {
+        for (std::vector<ChanEvent *>::iterator it = free_.begin(); it != free_.end(); it++)
+            delete *it;
+    }
+
+    ///@return A channel that's owned by the caller until it's released. A recycled channel still holds the values of
+    /// its last hit, so it has to be filled with ChanEvent::Adopt.
+    ChanEvent *Acquire() {
+        if (free_.empty())
+            return new ChanEvent();
+        ChanEvent *chan = free_.back();
+        free_.pop_back();
+        return chan;
+    }
+
+    ///Returns all of the channels in the list to the pool in one shot and clears the list. The channels need to have
+    /// been allocated with new, but they don't have to come from Acquire.
+    ///@param[in,out] chans : The channels that we're returning.
+    void Release(std::vector<ChanEvent *> &chans) {
+        free_.insert(free_.end(), chans.begin(), chans.end());
+        chans.clear();
+    }
+
+    ///@return The number of channels that are waiting to be handed out.
+    unsigned int GetNumberFree() const { return free_.size(); }
+
+private:
+    ///Default constructor, only used by get()
+    ChanEventPool() {}
+
+    ChanEventPool(const ChanEventPool &); //!< Not copyable
+    ChanEventPool &operator=(const ChanEventPool &); //!< Not copyable
+
+    std::vector<ChanEvent *> free_; ///< The channels that are ready to be handed out
+};
+
+#endif //__CHANEVENTPOOL_HPP__
@@ -0,0 +1,46 @@
+///@file ChannelDescriptor.hpp
+///@brief A compact description of a channel that is built once from its ChannelConfiguration.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef __CHANNELDESCRIPTOR_HPP__
+#define __CHANNELDESCRIPTOR_HPP__
+
+#include "ChannelConfiguration.hpp"
+
+///The ChannelConfiguration keeps the type, subtype and tags of a channel as strings. Comparing those for every hit is
+/// expensive, so the DetectorLibrary interns them into integer ids once the map is read and keeps one of these for
+/// every channel. A ChanEvent carries a pointer to the descriptor of its channel.
+struct ChannelDescriptor {
+    ///The largest number of different tags that we can keep in the tag bits.
+    static const unsigned int maximumNumberOfTags = 64;
+
+    ///The id used for names that weren't interned and for summaries that a channel doesn't have.
+    static const unsigned int unknownId = 0xFFFFFFFF;
+
+    ///Default constructor
+    ChannelDescriptor() : configuration(nullptr), id(0), typeId(0), subtypeId(0), tags(0), isIgnored(true),
+                          isLogic(false), hasStartTag(false), adcClockInSeconds(0), filterClockInSeconds(0),
+                          typeSummary(unknownId), subtypeSummary(unknownId), startSummary(unknownId) {}
+
+    ///@return True if the channel has the tag
+    ///@param[in] tagId : The id of the tag from DetectorLibrary::GetTagId
+    bool HasTag(const unsigned int &tagId) const {
+        return tagId < maximumNumberOfTags && (tags & (1ULL << tagId)) != 0;
+    }
+
+    const ChannelConfiguration *configuration; ///< The configuration of the channel in the DetectorLibrary
+    unsigned int id; ///< The index of the channel in the DetectorLibrary
+    unsigned int typeId; ///< The interned type of the channel
+    unsigned int subtypeId; ///< The interned subtype of the channel
+    unsigned long long tags; ///< One bit for every interned tag that the channel has
+    bool isIgnored; ///< True if the channel's type is empty or "ignore"
+    bool isLogic; ///< True if the channel's type is "logic"
+    bool hasStartTag; ///< True if the channel has the "start" tag
+    double adcClockInSeconds; ///< The ADC clock of the channel
+    double filterClockInSeconds; ///< The filter clock of the channel
+    unsigned int typeSummary; ///< The id of the type summary
+    unsigned int subtypeSummary; ///< The id of the type:subtype summary
+    unsigned int startSummary; ///< The id of the type:subtype:start summary, if the channel has the start tag
+};
+
+#endif //__CHANNELDESCRIPTOR_HPP__
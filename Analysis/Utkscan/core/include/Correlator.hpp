@@ -7,6 +7,9 @@
 #ifndef __CORRELATOR_HPP_
 #define __CORRELATOR_HPP_
 
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -60,8 +63,8 @@ struct EventInfo {
     EventInfo(double t, double e, LogicProcessor *lp);
 };
 
-//! The list of correlations
-class CorrelationList : public std::vector<EventInfo> {
+//! The list of correlations. The implant is always the first entry.
+class CorrelationList : public std::deque<EventInfo> {
 private:
     bool flagged;//!< flag telling if something has been flagged
 public:
@@ -74,6 +77,12 @@ public:
     /** \return the implant time */
     double GetImplantTime(void) const;
 
+    /** Adds an event to the end of the list. Once the list is full the
+     * oldest decay is dropped, the implant at the front is always kept.
+     * \param [in] info : the event to add
+     * \param [in] maxSize : the largest number of events kept in the list */
+    void Add(const EventInfo &info, const size_t &maxSize);
+
     /** flag an event */
     void Flag(void);
 
@@ -87,17 +96,64 @@ public:
     void PrintDecayList(void) const;
 };
 
+//! A set of keys from 0 to a fixed size that can be added, removed and listed in constant time per key.
+class KeySet {
+public:
+    /** Constructor
+     * \param [in] numKeys : the number of possible keys */
+    explicit KeySet(const unsigned int &numKeys = 0) : positions_(numKeys, absent) {}
+
+    /** Adds a key to the set, keys that are already in the set are ignored
+     * \param [in] key : the key to add */
+    void Insert(const unsigned int &key) {
+        if (positions_[key] != absent)
+            return;
+        positions_[key] = members_.size();
+        members_.push_back(key);
+    }
+
+    /** Removes a key from the set, the last member takes its place
+     * \param [in] key : the key to remove */
+    void Erase(const unsigned int &key) {
+        unsigned int position = positions_[key];
+        if (position == absent)
+            return;
+        members_[position] = members_.back();
+        positions_[members_.back()] = position;
+        members_.pop_back();
+        positions_[key] = absent;
+    }
+
+    /** \return the keys in the set in ascending order */
+    std::vector<unsigned int> GetSortedMembers() const {
+        std::vector<unsigned int> sorted(members_);
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+
+private:
+    static const unsigned int absent = 0xFFFFFFFF; //!< The position of keys that aren't in the set
+    std::vector<unsigned int> members_; //!< The keys in the set
+    std::vector<unsigned int> positions_; //!< The position of every key in members_
+};
+
 /*!
   \brief correlate decays with previous implants
 
-  The class controls the correlations of decays with previous implants.  There
-  are arrays of size MAX_STRIP %x MAX_STRIP that store implants and decays.
-  When an event has been identified as either an implant or decay, its
-  information is placed in the appropriate array based on its pixel location.
-  If a decay was identified, it is correlated with a previous implant.  The
-  correlator checks to make sure that the time between implants is
-  sufficiently long and that the correlation time has not been exceeded
-  before correlating an implant with a decay.
+  The class controls the correlations of decays with previous implants. The
+  detector is divided into a configurable number of front and back strips,
+  and a list of implants and decays is only kept for the pixels that had an
+  implant. When an event has been identified as either an implant or decay,
+  its information is placed in the list of its pixel. If a decay was
+  identified, it is correlated with a previous implant.  The correlator checks
+  to make sure that the time between implants is sufficiently long and that
+  the correlation time has not been exceeded before correlating an implant
+  with a decay.
+
+  The pixels with a list are indexed by their front and back strips, so a
+  decay without a full position is only correlated with the pixels that had
+  an implant. The lists are bounded in size, and the lists whose implant is
+  older than the expiry time are dropped as the run goes on.
 */
 class Correlator {
 public:
@@ -112,8 +168,20 @@ public:
         UNKNOWN_CONDITION = 100
     };
 
-    /** Default Constructor */
-    Correlator();
+    /// The number of front and back strips when they aren't provided
+    static const unsigned int defaultNumStrips = 40;
+
+    /// The largest number of events in the list of a pixel when it isn't provided
+    static const size_t defaultMaxListSize = 1000;
+
+    /** Constructor
+     * \param [in] numFront : the number of front strips
+     * \param [in] numBack : the number of back strips
+     * \param [in] maxListSize : the largest number of events kept for a pixel
+     * \param [in] expiryTime : the age in seconds at which an implant is dropped, this should be at least the
+     * correlation time */
+    Correlator(const unsigned int &numFront = defaultNumStrips, const unsigned int &numBack = defaultNumStrips,
+               const size_t &maxListSize = defaultMaxListSize, const double &expiryTime = corrTime);
 
     /** Default Destructor */
     virtual ~Correlator();
@@ -218,8 +286,6 @@ private:
         histo.DeclareHistogram2D(dammId, xSize, ySize, title);
     }
 
-    static const size_t arraySize = 40; /**< Size of the 2D array to hold the decay lists */
-
     static const double minImpTime; /**< The minimum amount of time that must
 				       pass before an implant will be considered
 				       for correlation in clock ticks */
@@ -229,11 +295,53 @@ private:
     static const double fastTime;   /**< Times shorter than this are output as
                                          a fast decay */
 
-    EventInfo *lastImplant;  ///< last implant processed by correlator
-    EventInfo *lastDecay;    ///< last decay procssed by correlator
+    double lastImplantTime;  ///< time of the last implant processed by correlator
+    double lastDecayTime;    ///< time since implant of the last decay processed by correlator
 
     EConditions condition;     ///< condition for last processed event
-    CorrelationList decaylist[arraySize][arraySize]; ///< list of event data for a particular pixel since implant
+
+    unsigned int numFront_; ///< The number of front strips
+    unsigned int numBack_; ///< The number of back strips
+    size_t maxListSize_; ///< The largest number of events kept for a pixel
+    double expiryTime_; ///< The age in seconds at which an implant is dropped
+    double lastExpiry_; ///< The time of the last check for old implants in clock ticks
+
+    std::unordered_map<unsigned int, CorrelationList> decayLists_; ///< The lists of the pixels that had an implant
+    std::vector<KeySet> pixelsByFront_; ///< The back strips with a list for every front strip
+    std::vector<KeySet> pixelsByBack_; ///< The front strips with a list for every back strip
+
+    /** \return the index of a pixel in decayLists_
+     * \param [in] fch : the front strip
+     * \param [in] bch : the back strip */
+    unsigned int GetPixel(const unsigned int &fch, const unsigned int &bch) const { return fch * numBack_ + bch; }
+
+    /** \return the list of a pixel, or NULL if the pixel doesn't have one
+     * \param [in] fch : the front strip
+     * \param [in] bch : the back strip */
+    const CorrelationList *FindList(const unsigned int &fch, const unsigned int &bch) const;
+
+    /** Adds an event to the list of a pixel, the list is made if it doesn't exist
+     * \param [in] fch : the front strip
+     * \param [in] bch : the back strip
+     * \param [in] event : the event to add */
+    void AddToList(const unsigned int &fch, const unsigned int &bch, const EventInfo &event);
+
+    /** Drops the list of a pixel
+     * \param [in] fch : the front strip
+     * \param [in] bch : the back strip */
+    void ClearList(const unsigned int &fch, const unsigned int &bch);
+
+    /** Drops the lists whose implant is older than the expiry time. Flagged lists are printed first.
+     * \param [in] time : the current time in clock ticks */
+    void ExpireLists(const double &time);
+
+    /** Correlates an event with a list of pixels that share a strip, in the order of the strips
+     * \param [in] event : the event to correlate
+     * \param [in] strips : the strips of the pixels
+     * \param [in] other : the strip that the pixels share
+     * \param [in] isFront : true if the strips are front strips */
+    void CorrelateStrips(EventInfo &event, const std::vector<unsigned int> &strips, const unsigned int &other,
+                         const bool &isFront);
 };
 
 #endif // __CORRELATOR_PROCESSOR_HPP_
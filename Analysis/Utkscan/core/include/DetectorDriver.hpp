@@ -33,17 +33,23 @@
 #ifndef __DETECTORDRIVER_HPP_
 #define __DETECTORDRIVER_HPP_
 
+#include <exception>
+#include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "BoundedQueue.hpp"
 #include "Calibrator.hpp"
 #include "ChanEvent.hpp"
 #include "Globals.hpp"
 #include "Messenger.hpp"
 #include "Plots.hpp"
+#include "TraceResultCache.hpp"
 #include "WalkCorrector.hpp"
+#include "XiaListModeDataDecoder.hpp"
 
 class Calibration;
 
@@ -51,6 +57,8 @@ class RawEvent;
 
 class EventProcessor;
 
+class Place;
+
 class TraceAnalyzer;
 
 /*! \brief DetectorDriver controls event processing
@@ -66,6 +74,7 @@ public:
 
     const WalkCorrector *walk_; //!< Instance of the walk correction
     const Calibrator *cali_;//!< Instance of the calibrator
+    std::vector<Place *> channelPlaces_; //!< The basic place of every channel, in the order of the DetectorLibrary
     Plots histo_;//!< Instance of the histogram class
 
     /*! \brief Control of the event processing
@@ -82,6 +91,41 @@ public:
     * \param [in] rawev : the raw event to process */
     void ProcessEvent(RawEvent &rawev);
 
+    /*! \brief Starts the threads that process events in parallel
+     *
+     * Each thread calibrates the channels, analyzes the traces and runs the
+     * processors that opt in with EventProcessor::IsEventParallel on its own
+     * raw event, filling its own shard of the histograms. Activating the
+     * places in the TreeCorrelator and the remaining processors are done in
+     * event order by the thread that submits the events. We stay serial if
+     * any of the trace analyzers can't run in parallel. Must be called after
+     * Init.
+     * \param [in] numThreads : the number of threads, zero to process the
+     * events serially with ProcessEvent */
+    void StartEventThreads(const unsigned int &numThreads);
+
+    /*! Finishes all of the events that have been submitted and stops the
+     * event threads. */
+    void StopEventThreads();
+
+    /*! \return True if the events are processed by the event threads */
+    bool IsEventParallel() const { return !eventThreads_.empty(); }
+
+    /*! \brief Get an empty raw event to fill and hand to SubmitEvent
+     *
+     * If all of the events are in use we finish the oldest submitted event
+     * to free one up.
+     * \return A pointer to the empty raw event */
+    RawEvent *AcquireEvent();
+
+    /*! \brief Hands an event to the event threads for processing
+     *
+     * Any submitted events that the threads are done with are finished
+     * before we return. The channels in the event are deleted once it's
+     * been finished.
+     * \param [in] event : the event from AcquireEvent to process */
+    void SubmitEvent(RawEvent *event);
+
     /*! \brief Check threshold and calibrate each channel.
      * Check the thresholds and calibrate the energy for each channel using the
      * calibrations contained in the calibration vector filled during ReadCal()
@@ -141,6 +185,21 @@ public:
      * \param [in] name : the name of the processor to return */
     EventProcessor *GetProcessor(const std::string &name) const;
 
+    /** Works out which channels the Unpacker has to decode. The hits of
+     * ignored channels are dropped, and traces are only kept for the channels
+     * that a trace analyzer or a processor uses them for. Channels that
+     * aren't in the map are kept so that we can complain about them.
+     * \return The filter to hand to the Unpacker */
+    XiaChannelFilter GetChannelFilter() const;
+
+    /** Restores the results of the cacheable trace analyzers from a file
+     * instead of running them, and stores the results of the traces that
+     * weren't in it. The DetectorLibrary and the analyzers have to be loaded.
+     * Throws invalid_argument if a cacheable analyzer has plots.
+     * \param [in] filename : the file that holds the cache
+     * \return False if the file exists but couldn't be read */
+    bool OpenTraceCache(const std::string &filename);
+
     /** \return the set of detectors used in the analysis */
     const std::set<std::string> &GetUsedDetectors(void) const;
 
@@ -175,6 +234,56 @@ private:
                    be used as detector types */
     std::string cfg_; //!< The configuration file to read
     std::pair<double, time_t> pixieToWallClock; /**< rough estimate of pixie to wall clock */
+    TraceResultCache traceCache_; //!< The results of the trace analysis from earlier scans of the run
+
+    //! An event handed between the submitting thread and an event thread
+    struct EventTask {
+        RawEvent *event; //!< The event, null tells the thread to stop
+        std::exception_ptr error; //!< Set if the event thread failed while processing the event
+    };
+
+    RawEvent *mainEvent_; //!< The event that the processors were initialized with
+    std::vector<EventProcessor *> parallelProcessors_; //!< Processors run by the event threads
+    std::vector<EventProcessor *> orderedProcessors_; //!< Processors run in event order
+    std::vector<std::thread> eventThreads_; //!< The threads processing events in parallel
+    std::vector<std::unique_ptr<BoundedQueue<EventTask> > > toEventThreads_; //!< Submitted events for each thread
+    std::vector<std::unique_ptr<BoundedQueue<EventTask> > > fromEventThreads_; //!< Processed events from each thread
+    std::vector<std::unique_ptr<RawEvent> > eventPool_; //!< All of the events used by the event threads
+    std::vector<RawEvent *> freeEvents_; //!< The events that are ready to be filled
+    unsigned int nextSubmission_; //!< The thread that gets the next event, events are dealt round robin
+    unsigned int nextCompletion_; //!< The thread that has the oldest unfinished event
+    unsigned int numInFlight_; //!< The number of events submitted but not yet finished
+
+    /*! Plots, calibrates and analyzes the traces of a single channel
+     * \param [in] chan : the channel to calibrate
+     * \param [in] rawev : the event that the channel belongs to */
+    void CalibrateChannel(ChanEvent *chan, RawEvent &rawev);
+
+    /*! Activates the basic place in the TreeCorrelator for the channel
+     * \param [in] chan : the channel to activate the place for */
+    void ActivatePlace(const ChanEvent *chan);
+
+    /*! Clears the resetable places in the TreeCorrelator that were activated in the event */
+    void ResetPlaces();
+
+    /*! The part of the event processing that's done on the event threads
+     * \param [in] event : the event to process */
+    void ProcessEventInParallel(RawEvent &event);
+
+    /*! The part of the event processing that has to be done in event
+     * order. The event is swapped into the event that the processors were
+     * initialized with, and its channels are deleted.
+     * \param [in] event : the event to finish */
+    void FinishEvent(RawEvent &event);
+
+    /*! Finishes the oldest submitted event
+     * \param [in] wait : true if we should wait for the event thread
+     * \return True if an event was finished */
+    bool CompleteEvent(const bool &wait);
+
+    /*! The loop run by each of the event threads
+     * \param [in] idx : the index of the thread */
+    void EventThreadLoop(const unsigned int idx);
 };
 
 #endif // __DETECTORDRIVER_HPP_
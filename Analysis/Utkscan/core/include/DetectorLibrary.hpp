@@ -13,6 +13,7 @@
 
 #include "Calibrator.hpp"
 #include "ChannelConfiguration.hpp"
+#include "ChannelDescriptor.hpp"
 #include "WalkCorrector.hpp"
 
 //! A class to define a library of detectors known to the analysis
@@ -132,6 +133,36 @@ public:
 
     typedef std::string mapkey_t; //!< typedef for a mapkey
 
+    /** The descriptors are built once the map has been read, they stay valid for the life of the library.
+     * \param [in] idx : the index of the channel
+     * \return the descriptor of the channel, or NULL if the index is outside of the map */
+    const ChannelDescriptor *GetDescriptor(size_type idx) const {
+        return idx < descriptors_.size() ? &descriptors_[idx] : NULL;
+    }
+
+    /** \return the interned id of the type, or ChannelDescriptor::unknownId if no channel has it
+     * \param [in] type : the type to look for */
+    unsigned int GetTypeId(const std::string &type) const;
+
+    /** \return the interned id of the tag, which can be checked with ChannelDescriptor::HasTag. Tags that no channel
+     * has return ChannelDescriptor::maximumNumberOfTags, which no channel has.
+     * \param [in] tag : the tag to look for */
+    unsigned int GetTagId(const std::string &tag) const;
+
+    /** \return the name of an interned summary, e.g. type:subtype
+     * \param [in] id : the id of the summary from a ChannelDescriptor */
+    const std::string &GetSummaryName(const unsigned int &id) const { return summaryNames_.at(id); }
+
+    /** Resolves a summary name to its handle, so that a processor can look the summary up once when it's built and
+     * get it from every event with RawEvent::GetSummary(id) without building or comparing strings. Names that no
+     * channel fills get a handle as well. This isn't safe to call while events are processed on several threads.
+     * \return the id of the summary
+     * \param [in] name : the name of the summary, e.g. type:subtype */
+    unsigned int GetSummaryId(const std::string &name) { return InternSummary(name); }
+
+    /** \return the number of interned summaries */
+    unsigned int GetNumberOfSummaries() const { return (unsigned int) summaryNames_.size(); }
+
     ///@return A pointer to the Calibrator object containing all of the
     /// calibrations.
     const Calibrator *GetCalibrations() const { return &energyCalibrations_; }
@@ -140,13 +171,19 @@ public:
     /// corrections.
     const WalkCorrector *GetWalkCorrections() const { return &walkCorrections_; }
 
-    ///Sets the pointer to the Calibration object
+    ///Sets the pointer to the Calibration object and compiles its tables for the channels in the library
     ///param[in] a : The pointer that we intend to set
-    void SetCalibrations(const Calibrator &a) { energyCalibrations_ = a; }
+    void SetCalibrations(const Calibrator &a) {
+        energyCalibrations_ = a;
+        energyCalibrations_.Compile(*this);
+    }
 
-    ///Sets the pointer to the Calibration object
+    ///Sets the pointer to the Calibration object and compiles its tables for the channels in the library
     ///param[in] a : The pointer that we intend to set
-    void SetWalkCorrection(const WalkCorrector &a) { walkCorrections_ = a; }
+    void SetWalkCorrection(const WalkCorrector &a) {
+        walkCorrections_ = a;
+        walkCorrections_.Compile(*this);
+    }
 
 private:
     DetectorLibrary();//!< Default Constructor
@@ -160,6 +197,18 @@ private:
      * \return the constructed map key */
     mapkey_t MakeKey(const std::string &type, const std::string &subtype) const;
 
+    /** Builds the descriptor of every channel in the library. */
+    void BuildDescriptors();
+
+    /** \return the id of the name, it's added to the ids if we haven't seen it before
+     * \param [in] ids : the ids that we've given out so far
+     * \param [in] name : the name that we want the id of */
+    static unsigned int Intern(std::map<std::string, unsigned int> &ids, const std::string &name);
+
+    /** \return the id of the summary name, it's added to the summaries if we haven't seen it before
+     * \param [in] name : the name of the summary */
+    unsigned int InternSummary(const std::string &name);
+
     std::map<mapkey_t, std::set<int>> locations; ///< collection of all used locations for a given type and subtype
     static std::set<int> emptyLocations; ///< dummy locations to return when map key does not exist
 
@@ -172,6 +221,13 @@ private:
 
     WalkCorrector walkCorrections_;
     Calibrator energyCalibrations_;
+
+    std::vector<ChannelDescriptor> descriptors_; //!< The descriptor of every channel, in the same order as the library
+    std::map<std::string, unsigned int> typeIds_; //!< The interned types
+    std::map<std::string, unsigned int> subtypeIds_; //!< The interned subtypes
+    std::map<std::string, unsigned int> tagIds_; //!< The interned tags
+    std::map<std::string, unsigned int> summaryIds_; //!< The interned summary names
+    std::vector<std::string> summaryNames_; //!< The summary names in the order of their ids
 };
 
 #endif // __DETECTORLIBRARY_HPP_
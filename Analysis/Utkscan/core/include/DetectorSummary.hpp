@@ -33,6 +33,15 @@ public:
     ///@param [in] ev : the event to add 
     void AddEvent(ChanEvent *ev);
 
+    ///Sets the list that the summary adds itself to when it gets its first event. The RawEvent uses this to only
+    /// zero the summaries that were filled.
+    ///@param [in] list : the list of filled summaries, or NULL to not keep track
+    void SetDirtyList(std::vector<DetectorSummary *> *list) { dirtyList_ = list; }
+
+    ///Exchanges the events and the max event with another summary. The name and the dirty list stay where they are.
+    ///@param [in] other : the summary to exchange the contents with
+    void SwapContents(DetectorSummary &other);
+
     /// Set the detector name
     ///@param [in] a : the name of the detector 
     void SetName(const std::string &a) { name_ = a; }
@@ -67,6 +76,7 @@ private:
     std::string tag_; //!<detector tag associated with this summary
     std::vector<ChanEvent *> eventList_; //!<list of events associated with this detector group 
     ChanEvent *maxEvent_; //!<event with maximum energy deposition
+    std::vector<DetectorSummary *> *dirtyList_; //!<list that we add ourselves to when we get our first event
 };
 
 #endif
@@ -63,6 +63,9 @@ public:
     ///@return the filter clock in seconds 
     double GetFilterClockInSeconds() const { return filterClockInSeconds_; }
 
+    ///@return The time between histogram flushes in seconds, periodic flushes are disabled if it's 0.
+    double GetFlushIntervalInSeconds() const { return flushIntervalInSeconds_; }
+
     ///@return returns name of specified output file
     std::string GetOutputFileName() const { return outputFilename_; }
 
@@ -73,7 +76,7 @@ public:
     std::string GetPixieRevision() const { return revision_; }
 
     ///@return rejection regions to exclude from scan.
-    std::vector<std::pair<unsigned int, unsigned int> > GetRejectionRegions() const { return reject_; }
+    const std::vector<std::pair<unsigned int, unsigned int> > &GetRejectionRegions() const { return reject_; }
 
     ///@return the frequency of the system clock in Hz
     double GetSystemClockFreqInHz() const { return sysClockFreqInHz_; }
@@ -102,6 +105,9 @@ public:
     ///@return true if we will define the raw histograms
     bool HasRawHistogramsDefined() const { return hasRawHistogramsDefined_; }
 
+    ///@return The number of threads that process events in parallel, 0 if events are processed serially.
+    unsigned int GetNumberOfEventThreads() const { return numEventThreads_; }
+
     ///Sets the Pixie-16 ADC clock speed in seconds.
     ///@param[in] a : The parameter that we are going to set
     void SetAdcClockInSeconds(const double &a) { adcClockInSeconds_ = a; }
@@ -122,10 +128,18 @@ public:
     ///@param[in] a : The parameter that we are going to set
     void SetFilterClockInSeconds(const double &a) { filterClockInSeconds_ = a; }
 
+    ///Sets the time between histogram flushes.
+    ///@param[in] a : The interval in seconds, 0 disables the periodic flushes.
+    void SetFlushIntervalInSeconds(const double &a) { flushIntervalInSeconds_ = a; }
+
     ///Sets a flag that controls if we output the raw histograms to DAMM
     ///@param[in] a : The parameter that we are going to set
     void SetHasRawHistogramsDefined(const bool &a) { hasRawHistogramsDefined_ = a; }
 
+    ///Sets the number of threads that will process events in parallel.
+    ///@param[in] a : The number of threads, 0 processes the events serially.
+    void SetNumberOfEventThreads(const unsigned int &a) { numEventThreads_ = a; }
+
     ///Sets output Filename from scan interface
     ///@param[in] a : The parameter that we are going to set
     void SetOutputFilename(const std::string &a) { outputFilename_ = a; }
@@ -180,7 +194,9 @@ private:
     double eventLengthInSeconds_;//!< event width in seconds
     unsigned int eventLengthInTicks_; //!< the size of the events
     double filterClockInSeconds_;//!< filter clock in seconds
+    double flushIntervalInSeconds_; //!< The time between histogram flushes in seconds
     bool hasRawHistogramsDefined_; //!< True if we are plotting Raw Histograms
+    unsigned int numEventThreads_; //!< The number of threads processing events in parallel
     std::string outputFilename_; //!<Output Filename
     std::string outputPath_; //!< The path to additional configuration files
     std::string revision_; //!< the pixie revision
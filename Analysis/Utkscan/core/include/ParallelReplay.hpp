@@ -0,0 +1,81 @@
+///@file ParallelReplay.hpp
+///@brief Splits a run into pieces that are scanned by separate utkscan processes and merges their output.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef __PARALLELREPLAY_HPP__
+#define __PARALLELREPLAY_HPP__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <getopt.h>
+#include <sys/types.h>
+
+#include "SpillIndex.h"
+
+///Scans a single run file with several processes. The spill index of the file is used to split the run into
+/// contiguous ranges of spills with about the same number of words. Every range is scanned by its own utkscan
+/// process with its own histograms, which is started with the same arguments as we were plus the range. Each
+/// process first scans a few spills before its range to rebuild the state that's carried between events (e.g. the
+/// places in the TreeCorrelator or the beam state in the LogicProcessor) and drops their output. The histograms and
+/// trees of the processes are merged into the usual output files once they're all done. If any of the processors
+/// keeps state for the whole run the workers refuse to start and we scan the run in order instead.
+class ParallelReplay {
+public:
+    ///The exit code of a worker that found a processor that needs the run to be scanned in order.
+    static const int sequentialOnlyExitCode = 3;
+
+    ///The number of warm-up spills that each worker scans when they aren't set with --warmup.
+    static const unsigned int defaultWarmupSpills = 10;
+
+    ///Constructor that picks the options that we need out of the command line.
+    ///@param[in] argc : The number of arguments
+    ///@param[in] argv : The arguments that utkscan was started with
+    ///@param[in] options : The long options known to utkscan, from ScanInterface::GetOptionTable
+    ///@param[in] shortOptions : The short options known to utkscan, from ScanInterface::GetOptionTable
+    ParallelReplay(int argc, char *argv[], const std::vector<option> &options, const std::string &shortOptions);
+
+    ///@return True if the user asked for more than one worker.
+    bool IsRequested() const { return numWorkers_ > 1; }
+
+    ///Starts the workers, waits for them and merges their output.
+    ///@return The exit code for utkscan
+    int Run();
+
+private:
+    std::string program_; //!< The path of the utkscan executable
+    std::vector<std::string> arguments_; //!< The arguments that we were started with, except for --workers
+    std::string inputFilename_; //!< The run that we're scanning
+    std::string outputName_; //!< The output file name, including the path, without the -hist.root
+    unsigned int numWorkers_; //!< The number of processes that scan the run
+    bool hasWarmup_; //!< True if the user set the number of warm-up spills
+    bool hasSelection_; //!< True if the user selected spills or times, which we can't split
+    std::string sharedFileOption_; //!< The option naming a file that the workers can't all write to, if one was given
+
+    ///Splits the run into ranges with about the same number of words.
+    ///@param[in] entries : The spills in the run
+    ///@return The first and last spill of every range
+    std::vector<std::pair<size_t, size_t> > SplitRun(const std::vector<SpillIndexEntry> &entries) const;
+
+    ///@return The output name used by a worker
+    std::string GetWorkerOutputName(const unsigned int &worker) const;
+
+    ///Starts a worker on a range of spills. Its output to the screen goes to a log file next to its histograms.
+    ///@param[in] worker : The number of the worker
+    ///@param[in] range : The first and last spill that the worker scans
+    ///@return The process id of the worker, or -1 if it couldn't be started.
+    pid_t StartWorker(const unsigned int &worker, const std::pair<size_t, size_t> &range) const;
+
+    ///Merges one kind of output file from all of the workers.
+    ///@param[in] suffix : The suffix of the file, e.g. -hist.root
+    ///@param[in] numWorkers : The number of workers that wrote the file
+    ///@return True if the merged file was written
+    bool Merge(const std::string &suffix, const unsigned int &numWorkers) const;
+
+    ///Replaces this process with a normal scan of the run.
+    ///@return Only returns if the scan couldn't be started
+    int RunSequentially() const;
+};
+
+#endif //__PARALLELREPLAY_HPP__
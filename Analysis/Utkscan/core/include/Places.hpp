@@ -31,6 +31,7 @@ public:
         resetable_ = resetable;
         max_size_ = max_size;
         status_ = false;
+        activeList_ = NULL;
     }
 
     /** Default Destructor */
@@ -61,7 +62,7 @@ public:
      * \param [in] info : the info to use for the activation */
     virtual void activate(EventData &info) {
         if (!status_) {
-            status_ = true;
+            setActive_();
             add_info_(info);
             report_(info);
         } else {
@@ -170,6 +171,15 @@ public:
         return resetable_;
     }
 
+    /** Sets the list that a resetable place adds itself to when it's
+     * activated. The TreeCorrelator uses the list to only reset the places
+     * that were activated in the event.
+     * \param [in] list : the list of activated places, or NULL to not
+     * keep track of the activations */
+    void setActiveList(std::vector<Place *> *list) {
+        activeList_ = list;
+    }
+
     /** Pythonic style private field. Use it if you must,
      * but perhaps you should not. Stores information on past
      * events in a given Place.*/
@@ -203,6 +213,14 @@ protected:
             (*it)->check_(info);
     }
 
+    /** Sets the status to true, a resetable place is added to the list of
+     * activated places so that it's reset at the end of the event. */
+    void setActive_() {
+        status_ = true;
+        if (resetable_ && activeList_)
+            activeList_->push_back(this);
+    }
+
     /** Add information to the place
     * \param [in] info : the information to add */
     virtual void add_info_(const EventData &info) {
@@ -229,6 +247,9 @@ protected:
      * should be reported.
      */
     std::vector<Place *> parents_;
+
+    /** The list that we add ourselves to when we're activated */
+    std::vector<Place *> *activeList_;
 };
 
 /** \brief "Lazy" Place does not store multiple activation or deactivation events.
@@ -246,7 +267,7 @@ public:
      * \param [in] info : the information to use to activate the place */
     virtual void activate(EventData &info) {
         if (!status_) {
-            status_ = true;
+            setActive_();
             add_info_(info);
             report_(info);
         }
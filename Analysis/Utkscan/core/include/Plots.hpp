@@ -11,6 +11,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "PlotsRegister.hpp"
 #include "RootHandler.hpp"
@@ -27,6 +28,9 @@ public:
     /** \return the offset for a given processor */
     int GetOffset() { return offset_; }
 
+    /** \return the number of histogram ids set aside for the processor */
+    int GetRange() const { return range_; }
+
     /** Prints out the non empty histograms in the analysis
      * \param [in] hislog : the file stream to print to */
     void PrintNonEmpty(std::ofstream &hislog);
@@ -160,6 +164,8 @@ private:
     std::map<std::string, int> mneList;
     /** Map of dammid -> title, helps debugging duplicated dammids*/
     std::map<int, std::string> titleList;
+    /** Handles of the declared histograms indexed by the relative dammId, NULL if the id wasn't declared */
+    std::vector<RootHandler::HistogramHandle *> handles_;
 };
 
 #endif // __PLOTS_HPP_
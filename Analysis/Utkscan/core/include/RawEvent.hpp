@@ -36,7 +36,16 @@
 class RawEvent {
 public:
     /** Default Constructor */
-    RawEvent() {};
+    RawEvent() : summaryGeneration_(0) {};
+
+    /** Copy constructor, the copy looks up its own summaries by id since the cached pointers belong to the original.
+    * \param [in] other : the event to copy */
+    RawEvent(const RawEvent &other);
+
+    /** Assignment operator, the cached summaries are dropped for the same reason as in the copy constructor.
+    * \param [in] other : the event to copy
+    * \return a reference to this event */
+    RawEvent &operator=(const RawEvent &other);
 
     /** Default Destructor */
     ~RawEvent() {};
@@ -59,10 +68,20 @@ public:
 
     /** \brief Raw event zeroing
     *
-    * For any detector type that was used in the event, zero the appropriate
-    * detector summary in the map, and clear the event list
-    * \param [in] usedev : the detector summary to zero */
-    void Zero(const std::set<std::string> &usedev);
+    * Zeroes the detector summaries that were filled in this event, returns the channels to the ChanEventPool and
+    * clears the event list.
+    * The summaries add themselves to the list of filled summaries when they get their first channel, so the ones
+    * that weren't used aren't touched. */
+    void Zero();
+
+    /** \brief Exchange the contents of two raw events
+    *
+    * The channels and the contents of the detector summaries are exchanged, but the summaries themselves stay where
+    * they are. Pointers and references to a summary (or its list) remain valid and see the new event. Only the
+    * summaries that were filled in one of the events are exchanged, if the other event doesn't have the summary yet
+    * it's created first.
+    * \param [in] other : the event to exchange contents with */
+    void Swap(RawEvent &other);
 
     /** \brief Get a pointer to a specific detector summary
     *
@@ -77,15 +96,39 @@ public:
     * \param [in] a : the name of the summary that you would like */
     const DetectorSummary *GetSummary(const std::string &a) const;
 
+    /** \brief Get a pointer to a detector summary using the id that the DetectorLibrary interned for it
+    *
+    * The pointer is cached the first time that we find the summary, so that the channels don't need to build the
+    * summary names for every hit. A summary that didn't exist is only looked up by name again after a new summary
+    * was added to the event, or when we're asked to construct it.
+    * \param [in] id : the id of the summary from a ChannelDescriptor
+    * \param [in] construct : flag indicating if we need to construct the summary
+    * \return a pointer to the summary */
+    DetectorSummary *GetSummary(const unsigned int &id, bool construct = true);
+
     /** \return the list of events */
     const std::vector<ChanEvent *> &GetEventList(void) const { return eventList; }
 
 private:
+    /** Points the summaries at our list of filled summaries and rebuilds the list, this is needed after the summaries
+    * were copied from another event. */
+    void AttachSummaries();
+
+    /** \return the summary with the name, an empty one is added if we don't have it
+    * \param [in] name : the name of the summary */
+    DetectorSummary *FindOrAddEmptySummary(const std::string &name);
+
     std::map<std::string, DetectorSummary> sumMap; /**< An STL map containing DetectorSummary classes
 					    associated with detector types */
     mutable std::set<std::string> nullSummaries;   /**< Summaries which were requested but don't exist */
     std::vector<ChanEvent *> eventList; /**< Pointers to all the channels that are close
                                             enough in time to be considered a single event */
+
+    std::vector<DetectorSummary *> dirtySummaries_; ///< The summaries that have channels in this event
+
+    std::vector<DetectorSummary *> summaryCache_; ///< The summaries that we've found, indexed by their interned id
+    std::vector<unsigned int> summaryCacheGeneration_; ///< The value of summaryGeneration_ when we looked up the id
+    unsigned int summaryGeneration_; ///< Counts the summaries that were added to sumMap
 };
 
 #endif // __RAWEVENT_HPP_
@@ -11,12 +11,28 @@
 #include <TH2.h>
 #include <TH3.h>
 
+#include <condition_variable>
 #include <map>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 //! A Class to handle outputting things into ROOT, registering histograms, filling trees, all that jazzy stuff.
 class RootHandler {
 public:
+    ///A histogram that's been looked up once, along with the fills that we haven't given to ROOT yet. Buffering the
+    /// fills lets us skip the lookup and the cast on every Plot, and lets ROOT fill 1D and 2D histograms in bulk.
+    /// Handles are owned by the RootHandler and are valid until it's deleted.
+    struct HistogramHandle {
+        unsigned int id; //!< The id of the histogram
+        TH1 *histogram; //!< The histogram that the fills go into
+        int dimension; //!< The dimension of the histogram
+        bool dirty; //!< True if the histogram may have changed since it was last given to the writer.
+        std::vector<double> xvals; //!< The buffered x values
+        std::vector<double> yvals; //!< The buffered y values, these are the z values if the y value was skipped.
+        std::vector<double> zvals; //!< The buffered z values, only used by 3D histograms
+    };
+
     ///Get method that initializes the RootHandler with a default name for the ROOT File: histograms.root.
     ///@return a pointer to the instance of RootHandler
     static RootHandler *get();
@@ -64,6 +80,26 @@ public:
     /// @return true if successful
     bool Plot(const unsigned int &id, const double &xval, const double &yval = -1, const double &zval = -1);
 
+    ///Plots into the histogram referenced by the handle. This follows the same conventions as the id based Plot. The
+    /// fill is buffered and only shows up in the histogram after ApplyFills, Flush or one of the Get*Histogram
+    /// methods is called.
+    /// @param [in] handle : The handle of the histogram that we're going to fill, from GetHandle.
+    /// @param [in] xval : the x value
+    /// @param [in] yval : the y value or -1 if unused
+    /// @param [in] zval : the z value or -1 if unused
+    /// @return true if successful
+    bool Plot(HistogramHandle &handle, const double &xval, const double &yval = -1, const double &zval = -1);
+
+    ///Looks up the handle for a histogram, creating it the first time it's requested. This should be done once when
+    /// the histogram is declared, not every time that it's filled.
+    ///@param[in] id : The id of the histogram that we want the handle for.
+    ///@throws invalid_argument if the histogram hasn't been registered.
+    ///@return A pointer to the handle for the histogram.
+    HistogramHandle *GetHandle(const unsigned int &id);
+
+    ///Gives all of the buffered fills to ROOT. Only call this from the thread that fills the histograms.
+    void ApplyFills();
+
     /// Wrapper function for the ROOT TH* constructors. We've simplified things to make it look more like DAMM for now.
     ///@param[in] id : The numerical ID of the histogram to register. The method prepends it with an "h", ex. h1
     ///@param[in] title : The Title of the histogram
@@ -81,10 +117,28 @@ public:
     /// TTree if one was inserted.
     TTree *RegisterTree(const std::string &name, const std::string &description = "");
 
-    ///Method that will update all the trees and histograms in the system. It spawns a new thread that writes histograms
-    ///  to disk. It locks the histogramFile_ for writing. Trees write to disk serially due to the complex memory
+    ///Gives the calling thread a private shard of the histograms. From now on, every Plot made by this thread goes
+    /// into the thread's own copy of the histogram, which is created the first time that the thread fills it. The
+    /// shards are added to the histograms in the file by MergeShards. Threads that never call this fill the
+    /// histograms in the file directly. Histograms retrieved with the Get*Histogram methods are never sharded.
+    void AttachShard();
+
+    ///Adds the contents of every shard to the histograms in the file and resets the shards. The histograms
+    /// must not be filled directly while we're merging, so call this from the thread that fills them.
+    void MergeShards();
+
+    ///Throws away everything that's been filled so far: the histograms, their buffered fills and shards, and the
+    /// entries in the trees. This is used to drop the output of the warm-up spills when we scan part of a run. Call
+    /// this from the thread that fills the histograms once nothing else is filling them.
+    void Reset();
+
+    ///Method that will update all the trees and histograms in the system. We take a snapshot of every histogram that
+    ///  changed since the last flush and hand the snapshots to a background thread that writes them to disk, so we
+    ///  can keep filling while they're written. If the writer is still busy with the last flush we skip the
+    ///  histograms, they'll be picked up by the next flush. Trees write to disk serially due to the complex memory
     ///  management necessary to write them in parallel. BEWARE: This could become a time sink if you have a lot of
-    ///  big trees defined in the system.
+    ///  big trees defined in the system. The buffered fills are applied and the histogram shards are merged
+    ///  before the snapshots are taken.
     void Flush();
 
 private:
@@ -106,14 +160,60 @@ private:
     ///@returns a pointer to the histogram in the list if we found it.
     TH1 *GetHistogramFromList(const unsigned int &id, const std::string &callingFunctionName);
 
-    ///Method that loops through histogramList_ and calls Write() on everything that has a non-zero number of entries.
-    static void AsyncFlush();
+    ///The loop run by the writer thread. It waits for Flush to hand it snapshots, then writes and deletes them.
+    static void WriteSnapshots();
+
+    ///Hands out a histogram that the caller may fill directly. Any buffered fills are applied first.
+    ///@param[in] id : The id of the histogram that we're after.
+    ///@param[in] callingFunctionName : The name of the function that called this one, for the throw message.
+    ///@throws invalid_argument if we couldn't find the histogram in the list
+    ///@return A pointer to the histogram
+    TH1 *HandOutHistogram(const unsigned int &id, const std::string &callingFunctionName);
+
+    ///Fills the histogram with the provided values following the conventions used by Plot.
+    ///@param[in] histogram : The histogram to fill
+    ///@param[in] xval : the x value
+    ///@param[in] yval : the y value or -1 if unused
+    ///@param[in] zval : the z value or -1 if unused
+    static void Fill(TH1 *histogram, const double &xval, const double &yval, const double &zval);
+
+    ///Gives the buffered fills of a single histogram to ROOT.
+    ///@param[in] handle : The handle whose fills we're applying.
+    static void ApplyFills(HistogramHandle &handle);
+
+    ///A private copy of the histograms filled by a single thread.
+    struct HistogramShard {
+        std::mutex mutex; //!< Held while the shard is being filled or merged.
+        std::map<unsigned int, TH1 *> histograms; //!< The thread's copies of the histograms, keyed by id.
+    };
+
+    ///Finds the calling thread's copy of the histogram, creating it if this is the first time that it's used.
+    ///@param[in] shard : The shard belonging to the calling thread.
+    ///@param[in] id : The id of the histogram
+    ///@param[in] histogram : The histogram in the file that the shard copies.
+    ///@return A pointer to the thread's copy of the histogram.
+    static TH1 *GetShardHistogram(HistogramShard *shard, const unsigned int &id, TH1 *histogram);
+
+    ///Copies a histogram without adding the copy to any directory, so that making it never touches the file.
+    ///@param[in] histogram : The histogram to copy.
+    ///@return The copy, owned by the caller.
+    static TH1 *Detach(const TH1 *histogram);
 
     static TFile *histogramFile_; //!< ROOT file storing user registered histograms
     static std::map<unsigned int, TH1 *> histogramList_; //!< List of user registered histograms
+    static std::map<unsigned int, HistogramHandle *> handleList_; //!< The handles that we've given out, keyed by id.
     static TFile *treeFile_; //!< ROOT File storing user registered trees.
     static std::map<std::string, TTree *> treeList_; //!< The list of user registered trees
-    static std::mutex flushMutex_; //!< Ensures only one thread writes to histogramFile_
+    static std::mutex fileMutex_; //!< Held while histogramFile_ or its list of histograms is changed or written
+    static std::thread writer_; //!< The thread that writes the histogram snapshots to histogramFile_
+    static std::mutex writerMutex_; //!< Protects snapshots_, isWriting_ and stopWriter_
+    static std::condition_variable writerCondition_; //!< Wakes the writer when there are snapshots or we're stopping
+    static std::vector<TH1 *> snapshots_; //!< The snapshots waiting for the writer, owned by us.
+    static bool isWriting_; //!< True while the writer is writing snapshots
+    static bool stopWriter_; //!< Tells the writer to exit once it's written everything that it was given.
+    static std::vector<HistogramShard *> shards_; //!< Every shard that's been attached, owned by us.
+    static std::mutex shardMutex_; //!< Protects shards_ and the creation of the shard histograms.
+    static thread_local HistogramShard *threadShard_; //!< The shard of the calling thread, null if it has none.
 };
 
 #endif // __ROOTHANDLER_HPP_
\ No newline at end of file
@@ -0,0 +1,134 @@
+///@file TraceResultCache.hpp
+///@brief Keeps the results of the trace analysis in a file so that replays of a run can skip the trace analyzers.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef __TRACERESULTCACHE_HPP__
+#define __TRACERESULTCACHE_HPP__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChannelConfiguration.hpp"
+#include "Trace.hpp"
+#include "pugixml.hpp"
+
+///Everything that the cacheable trace analyzers leave in a Trace. The TraceFilterAnalyzer runs on every trace, so its
+/// results aren't kept. The baseline subtracted trace isn't kept either, it's rebuilt from the samples and the
+/// baseline when it's restored.
+struct TraceResult {
+    ///Default constructor
+    TraceResult();
+
+    ///Copies the results out of an analyzed trace.
+    ///@param[in] trace : The trace that the analyzers were run on
+    ///@param[in] rawEnergy : The energy from the module, used to check that the result belongs to the hit
+    void Store(const Trace &trace, const double &rawEnergy);
+
+    ///Puts the results back into a trace that holds the same samples as the one that they were stored from.
+    ///@param[out] trace : The trace to fill
+    void Restore(Trace &trace) const;
+
+    double rawEnergy; ///< The energy that the module recorded for the hit
+    unsigned int traceLength; ///< The number of samples in the trace
+    bool hasValidAnalysis; ///< Trace::HasValidAnalysis
+    bool isSaturated; ///< Trace::IsSaturated
+    bool hasTraceSansBaseline; ///< True if the baseline subtracted trace had been calculated
+    double phase; ///< Trace::GetPhase
+    double qdc; ///< Trace::GetQdc
+    double tailRatio; ///< Trace::GetTailRatio
+    double tau; ///< Trace::GetTau
+    std::pair<double, double> baseline; ///< Trace::GetBaselineInfo
+    std::pair<unsigned int, double> max; ///< Trace::GetMaxInfo
+    std::pair<unsigned int, double> extrapolatedMax; ///< Trace::GetExtrapolatedMaxInfo
+    std::pair<unsigned int, unsigned int> waveformRange; ///< Trace::GetWaveformRange
+};
+
+///An opt-in cache of the trace analysis results for a single run. The results are found by the channel and the
+/// timestamp of the hit, which stay the same however the run is split into spills or events, and they're checked
+/// against the hit's energy and trace length before they're used. The file records a hash of the analyzers that
+/// were loaded and a hash of the trace settings of every channel. When the analyzers change the whole cache is
+/// thrown away, when only a channel's settings change just that channel's results are. Everything that's in the
+/// file is held in memory while we scan, and the file is written again when the cache is closed if anything was
+/// added. Results can be looked up and stored from several threads at once.
+class TraceResultCache {
+public:
+    ///Default constructor
+    TraceResultCache();
+
+    ///Default destructor, closes the cache.
+    ~TraceResultCache() { Close(); }
+
+    ///@return A hash of a string, used for the analyzer settings
+    ///@param[in] text : The string to hash
+    ///@param[in] seed : The hash to continue from, so that several strings can be chained
+    static unsigned long long Hash(const std::string &text, const unsigned long long &seed = hashSeed);
+
+    ///@return A hash of a number, used for the global settings
+    ///@param[in] value : The number to hash
+    ///@param[in] seed : The hash to continue from
+    static unsigned long long Hash(const double &value, const unsigned long long &seed);
+
+    ///@return A hash of a node in the configuration, its attributes, its text and all of the nodes below it
+    ///@param[in] node : The node to hash
+    ///@param[in] seed : The hash to continue from
+    static unsigned long long Hash(const pugi::xml_node &node, const unsigned long long &seed = hashSeed);
+
+    ///@return A hash of the settings of a channel that the trace analyzers use
+    ///@param[in] cfg : The configuration of the channel
+    static unsigned long long Hash(const ChannelConfiguration &cfg);
+
+    ///Loads the cache from a file. A file that doesn't exist yet is fine, it's created when we close.
+    ///@param[in] filename : The file that holds the cache
+    ///@param[in] analyzerHash : The hash of the analyzers that are loaded
+    ///@param[in] channelHashes : The hash of the configuration of every channel, in the order of their ids
+    ///@return False if the file exists but isn't a cache that we can read
+    bool Open(const std::string &filename, const unsigned long long &analyzerHash,
+              const std::vector<unsigned long long> &channelHashes);
+
+    ///@return True if the cache has been opened
+    bool IsOpen() const { return !filename_.empty(); }
+
+    ///Fills a trace with the results stored for the hit.
+    ///@param[in] id : The id of the channel
+    ///@param[in] timestamp : The timestamp of the hit in clock ticks
+    ///@param[in] rawEnergy : The energy that the module recorded for the hit
+    ///@param[in,out] trace : The trace of the hit, it's only changed if we had a result for it
+    ///@return True if the trace was filled
+    bool Restore(const unsigned int &id, const double &timestamp, const double &rawEnergy, Trace &trace);
+
+    ///Stores the results of analyzing the trace of a hit.
+    ///@param[in] id : The id of the channel
+    ///@param[in] timestamp : The timestamp of the hit in clock ticks
+    ///@param[in] rawEnergy : The energy that the module recorded for the hit
+    ///@param[in] trace : The trace after all of the analyzers have run on it
+    void Store(const unsigned int &id, const double &timestamp, const double &rawEnergy, const Trace &trace);
+
+    ///Writes the file if anything has changed and prints how useful the cache was.
+    void Close();
+
+private:
+    static const unsigned long long hashSeed = 14695981039346656037ULL; ///< The FNV-1a offset basis
+
+    std::string filename_; ///< The file that holds the cache
+    unsigned long long analyzerHash_; ///< The hash of the analyzers that are loaded
+    std::vector<unsigned long long> channelHashes_; ///< The hash of every channel's configuration
+    std::unordered_map<unsigned long long, TraceResult> loaded_; ///< The results read from the file, never changed
+    std::unordered_map<unsigned long long, TraceResult> added_; ///< The results stored while we scan
+    std::mutex addedMutex_; ///< Protects the results that are stored while we scan
+    unsigned long long numDropped_; ///< The results in the file that were made with different settings
+    std::atomic<unsigned long long> numRestored_; ///< The number of traces that were filled from the cache
+
+    ///@return The key of a hit
+    static unsigned long long MakeKey(const unsigned int &id, const double &timestamp) {
+        return ((unsigned long long) id << 48) | ((unsigned long long) timestamp & 0xFFFFFFFFFFFFULL);
+    }
+
+    ///Writes everything that we know to the file.
+    ///@return True if the file was written
+    bool Write() const;
+};
+
+#endif //__TRACERESULTCACHE_HPP__
@@ -48,6 +48,11 @@ public:
     */
     void buildTree();
 
+    /** Resets the resetable places that were activated since the last
+     * reset. The places add themselves to the list when they're activated,
+     * so the idle places aren't touched. */
+    void resetPlaces();
+
     /** Default Destructor */
     ~TreeCorrelator();
 
@@ -64,6 +69,7 @@ private:
     static TreeCorrelator *instance; //!< A static instance of the tree correlator
 
     static PlaceBuilder builder; //!< Instance of the PlaceBuilder
+    std::vector<Place *> activePlaces_; //!< The resetable places that were activated since the last reset
 
     /** Splits name string into the vector of string. Assumes that if
     * the last token (delimiter being "_") is in format "X-Y,Z" where
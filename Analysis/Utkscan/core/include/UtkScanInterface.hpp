@@ -22,8 +22,28 @@ public:
      * \param[in]  prefix_ String to append to the beginning of system output.
      * \return True upon successfully initializing and false otherwise. */
     bool Initialize(std::string prefix_ = "");
+
+    /** Add the options used to split a run between several processes,
+     * which are handled by ParallelReplay before the scan is set up, and
+     * the option that turns on the trace cache. */
+    void ArgHelp();
+
+    /** Read the options that were added by ArgHelp. */
+    void ExtraArguments();
+
+    /** Drop everything that was filled during the warm-up spills once
+     * they've been processed.
+     * \param[in] code_ The notification code passed from ScanInterface. */
+    void Notify(const std::string &code_ = "");
+
+    /** \return True if we were started by ParallelReplay but one of the
+     * processors needs the run to be scanned in order from the start. */
+    bool IsSequentialOnly() const { return sequentialOnly_; }
 private:
     std::string outputFname_; /// The output histogram filename prefix.
+    bool isReplayWorker_; /// True if we were started by ParallelReplay to scan part of a run.
+    bool sequentialOnly_; /// True if a replay worker found a processor that is sequential only.
+    std::string traceCacheFilename_; /// The file holding the results of the trace analysis, empty if not used.
 };
 
 #endif //__UTK_SCAN_INTERFACE_HPP__
@@ -59,7 +59,34 @@ public:
      * \param [in] chanID : The channel channelConfiguration to get
      * \param [in] raw : The raw value to perform the correction on
      * \return The walk corrected value of raw */
-    double GetCorrection(ChannelConfiguration &chanID, double raw) const;
+    double GetCorrection(const ChannelConfiguration &chanID, double raw) const;
+
+    /** Compiles the corrections into tables that are indexed by the
+     * position of the channel in the DetectorLibrary, so that correcting a
+     * hit doesn't need to compare any configurations. This has to be called
+     * again after channels are added.
+     * \param [in] channels : the channels in the order of the DetectorLibrary */
+    void Compile(const std::vector<ChannelConfiguration> &channels);
+
+    /** Returns the time correction from the compiled tables, channels that
+     * weren't compiled aren't corrected.
+     * \param [in] id : The index of the channel in the DetectorLibrary
+     * \param [in] raw : The raw value to perform the correction on
+     * \return The walk correction of the channel */
+    double GetCorrection(const unsigned int &id, double raw) const {
+        if (id + 1 >= firstCorrection_.size())
+            return 0;
+        return Evaluate(firstCorrection_[id], firstCorrection_[id + 1], raw);
+    }
+
+    /** Returns the time corrections for the hits of a whole event from the
+     * compiled tables.
+     * \param [in] ids : The index of the channel of every hit
+     * \param [in] raw : The raw value of every hit
+     * \param [out] corrections : The walk correction of every hit
+     * \param [in] numHits : The number of hits */
+    void GetCorrections(const unsigned int *ids, const double *raw, double *corrections,
+                        const size_t &numHits) const;
 
 protected:
     /** \return always 0.
@@ -142,6 +169,21 @@ private:
      * and value is a vector holding struct with calibration range
      * and walk correction model and parameters. */
     std::map<ChannelConfiguration, std::vector<CorrectionParams>> channels_;
+
+    std::vector<unsigned int> firstCorrection_; //!< The first range of every channel, and one past the last range
+    std::vector<CorrectionParams> corrections_; //!< The ranges of all the channels, in the order of the channels
+
+    /** \return the correction from the first of the ranges that contains
+     * the raw value, or 0 if none of them do.
+     * \param [in] first : the index of the first range of the channel
+     * \param [in] last : one past the index of the last range of the channel
+     * \param [in] raw : The raw value to perform the correction on */
+    double Evaluate(const unsigned int &first, const unsigned int &last, double raw) const;
+
+    /** \return the correction from the model of a single range
+     * \param [in] cf : the range with the model and its parameters
+     * \param [in] raw : The raw value to perform the correction on */
+    double EvaluateModel(const CorrectionParams &cf, double raw) const;
 };
 
 #endif
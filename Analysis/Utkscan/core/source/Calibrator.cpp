@@ -93,6 +93,7 @@ double Calibrator::GetCalEnergy(const ChannelConfiguration &chanID, double raw)
         if (itf == itch->second.end()) {
             return 0;
         }
+        const double *par = itf->parameters.data();
         switch (itf->model) {
             case cal_raw:
                 return ModelRaw(raw);
@@ -101,22 +102,22 @@ double Calibrator::GetCalEnergy(const ChannelConfiguration &chanID, double raw)
                 return ModelOff();
                 break;
             case cal_linear:
-                return ModelLinear(itf->parameters, raw);
+                return ModelLinear(par, raw);
                 break;
             case cal_quadratic:
-                return ModelQuadratic(itf->parameters, raw);
+                return ModelQuadratic(par, raw);
                 break;
             case cal_cubic:
-                return ModelCubic(itf->parameters, raw);
+                return ModelCubic(par, raw);
                 break;
             case cal_polynomial:
-                return ModelPolynomial(itf->parameters, raw);
+                return ModelPolynomial(par, itf->parameters.size(), raw);
                 break;
             case cal_hyplin:
-                return ModelHypLin(itf->parameters, raw);
+                return ModelHypLin(par, raw);
                 break;
             case cal_exp:
-                return ModelExp(itf->parameters, raw);
+                return ModelExp(par, raw);
                 break;
             default:
                 break;
@@ -125,6 +126,88 @@ double Calibrator::GetCalEnergy(const ChannelConfiguration &chanID, double raw)
     return raw;
 }
 
+/// The ranges of every channel are copied next to each other, and all of the
+/// coefficients go into a single table. The linear, quadratic and cubic models
+/// only keep as many coefficients as they use, so that they can be evaluated
+/// as polynomials.
+void Calibrator::Compile(const std::vector<ChannelConfiguration> &channels) {
+    firstCalibration_.assign(1, 0);
+    calibrations_.clear();
+    coefficients_.clear();
+
+    for (vector<ChannelConfiguration>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+        map<ChannelConfiguration, vector<CalibrationParams> >::const_iterator itch = channels_.find(*it);
+        if (itch != channels_.end()) {
+            for (vector<CalibrationParams>::const_iterator itf = itch->second.begin(); itf != itch->second.end();
+                 ++itf) {
+                CompiledCalibration compiled;
+                compiled.model = itf->model;
+                compiled.min = itf->min;
+                compiled.max = itf->max;
+                compiled.firstParameter = coefficients_.size();
+                compiled.numParameters = itf->parameters.size();
+
+                switch (itf->model) {
+                    case cal_linear:
+                        compiled.numParameters = 2;
+                        compiled.model = cal_polynomial;
+                        break;
+                    case cal_quadratic:
+                        compiled.numParameters = 3;
+                        compiled.model = cal_polynomial;
+                        break;
+                    case cal_cubic:
+                        compiled.numParameters = 4;
+                        compiled.model = cal_polynomial;
+                        break;
+                    default:
+                        break;
+                }
+
+                coefficients_.insert(coefficients_.end(), itf->parameters.begin(),
+                                     itf->parameters.begin() + compiled.numParameters);
+                calibrations_.push_back(compiled);
+            }
+        }
+        firstCalibration_.push_back(calibrations_.size());
+    }
+}
+
+double Calibrator::Evaluate(const unsigned int &first, const unsigned int &last, double raw) const {
+    if (first == last)
+        return raw;
+
+    for (unsigned int i = first; i < last; i++) {
+        const CompiledCalibration &cal = calibrations_[i];
+        if (!(cal.min <= raw && raw <= cal.max))
+            continue;
+
+        const double *par = coefficients_.data() + cal.firstParameter;
+        switch (cal.model) {
+            case cal_polynomial:
+                return ModelPolynomial(par, cal.numParameters, raw);
+            case cal_raw:
+                return ModelRaw(raw);
+            case cal_off:
+                return ModelOff();
+            case cal_hyplin:
+                return ModelHypLin(par, raw);
+            case cal_exp:
+                return ModelExp(par, raw);
+            default:
+                return raw;
+        }
+    }
+    // Parts of spectrum that are not within some min-max range are zeroed
+    return 0;
+}
+
+void Calibrator::GetCalEnergies(const unsigned int *ids, const double *raw, double *calibrated,
+                                const size_t &numHits) const {
+    for (size_t i = 0; i < numHits; i++)
+        calibrated[i] = GetCalEnergy(ids[i], raw[i]);
+}
+
 double Calibrator::ModelRaw(double raw) const {
     return raw;
 }
@@ -133,44 +216,33 @@ double Calibrator::ModelOff() const {
     return 0;
 }
 
-double Calibrator::ModelLinear(const std::vector<double> &par,
-                               double raw) const {
+double Calibrator::ModelLinear(const double *par, double raw) const {
     return par[0] + par[1] * raw;
 }
 
-double Calibrator::ModelQuadratic(const std::vector<double> &par,
-                                  double raw) const {
-    return par[0] + par[1] * raw + par[2] * raw * raw;
+double Calibrator::ModelQuadratic(const double *par, double raw) const {
+    return par[0] + raw * (par[1] + raw * par[2]);
 }
 
-double Calibrator::ModelCubic(const std::vector<double> &par,
-                              double raw) const {
-    return (par[0] + par[1] * raw + par[2] * raw * raw +
-            par[3] * raw * raw * raw);
+double Calibrator::ModelCubic(const double *par, double raw) const {
+    return par[0] + raw * (par[1] + raw * (par[2] + raw * par[3]));
 }
 
-double Calibrator::ModelPolynomial(const std::vector<double> &par,
-                                   double raw) const {
-    int p = 0;
+double Calibrator::ModelPolynomial(const double *par, const unsigned int &numPar, double raw) const {
     double r = 0;
-    for (vector<double>::const_iterator it = par.begin(); it != par.end();
-         ++it) {
-        r += (*it) * pow(raw, p);
-        ++p;
-    }
+    for (unsigned int p = numPar; p > 0; p--)
+        r = r * raw + par[p - 1];
     return r;
 }
 
-double Calibrator::ModelHypLin(const std::vector<double> &par,
-                               double raw) const {
+double Calibrator::ModelHypLin(const double *par, double raw) const {
     if (raw > 0)
         return par[0] / raw + par[1] + par[2] * raw;
     else
         return 0;
 }
 
-double Calibrator::ModelExp(const std::vector<double> &par,
-                            double raw) const {
+double Calibrator::ModelExp(const double *par, double raw) const {
     if (raw > 0)
         return par[0] * exp(raw / par[1]) + par[2];
     else
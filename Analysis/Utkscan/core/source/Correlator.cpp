@@ -37,12 +37,23 @@ namespace dammIds {
     }
 } // correlator namespace
 
+const unsigned int KeySet::absent;
+const unsigned int Correlator::defaultNumStrips;
+const size_t Correlator::defaultMaxListSize;
+
 // all in seconds
 const double Correlator::minImpTime = 5e-3;
 const double Correlator::corrTime = 60; // used to be 3300
 const double Correlator::fastTime = 40e-6;
 
-Correlator::Correlator() : histo(OFFSET, RANGE, "correlator"), lastImplant(NULL), lastDecay(NULL), condition(UNKNOWN_CONDITION) {
+Correlator::Correlator(const unsigned int &numFront, const unsigned int &numBack, const size_t &maxListSize,
+                       const double &expiryTime) : histo(OFFSET, RANGE, "correlator"), lastImplantTime(NAN),
+                                                   lastDecayTime(NAN), condition(UNKNOWN_CONDITION),
+                                                   numFront_(numFront), numBack_(numBack),
+                                                   maxListSize_(max(maxListSize, (size_t) 2)),
+                                                   expiryTime_(max(expiryTime, corrTime)), lastExpiry_(NAN),
+                                                   pixelsByFront_(numFront, KeySet(numBack)),
+                                                   pixelsByBack_(numBack, KeySet(numFront)) {
 }
 
 EventInfo::EventInfo() {
@@ -59,7 +70,7 @@ EventInfo::EventInfo() {
     generation = 0;
 }
 
-CorrelationList::CorrelationList() : std::vector<EventInfo>() {
+CorrelationList::CorrelationList() : std::deque<EventInfo>() {
     flagged = false;
 }
 
@@ -78,6 +89,12 @@ double CorrelationList::GetImplantTime() const {
         return front().time;
 }
 
+void CorrelationList::Add(const EventInfo &info, const size_t &maxSize) {
+    if (size() >= maxSize && size() > 1)
+        erase(begin() + 1);
+    push_back(info);
+}
+
 void CorrelationList::Flag() {
     if (!empty())
         back().flagged = true;
@@ -90,7 +107,7 @@ bool CorrelationList::IsFlagged() const {
 
 void CorrelationList::clear() {
     flagged = false;
-    vector<EventInfo>::clear();
+    deque<EventInfo>::clear();
 }
 
 void CorrelationList::PrintDecayList() const {
@@ -157,12 +174,13 @@ void CorrelationList::PrintDecayList() const {
 
 Correlator::~Correlator() {
     // dump any flagged decay lists which have not been output
-    for (unsigned int i = 0; i < arraySize; i++) {
-        for (unsigned int j = 0; j < arraySize; j++) {
-            if (IsFlagged(i, j))
-                PrintDecayList(i, j);
-        }
-    }
+    vector<unsigned int> pixels;
+    for (const auto &list : decayLists_)
+        pixels.push_back(list.first);
+    sort(pixels.begin(), pixels.end());
+    for (const auto &pixel : pixels)
+        if (IsFlagged(pixel / numBack_, pixel % numBack_))
+            PrintDecayList(pixel / numBack_, pixel % numBack_);
 }
 
 void Correlator::DeclarePlots() {
@@ -175,26 +193,26 @@ void Correlator::DeclarePlots() {
 
 void Correlator::Correlate(EventInfo &event, unsigned int fch,
                            unsigned int bch) {
-    if (fch >= arraySize || bch >= arraySize) {
+    if (fch >= numFront_ || bch >= numBack_) {
         plot(D_CONDITION, INVALID_LOCATION);
         return;
     }
 
-    CorrelationList &theList = decaylist[fch][bch];
-
     double lastTime = NAN;
     double clockInSeconds = Globals::get()->GetFilterClockInSeconds();
 
+    ExpireLists(event.time);
+
     switch (event.type) {
         case EventInfo::IMPLANT_EVENT:
-            if (theList.IsFlagged())
+            if (IsFlagged(fch, bch))
                 PrintDecayList(fch, bch);
 
             lastTime = GetImplantTime(fch, bch);
-            theList.clear();
+            ClearList(fch, bch);
             condition = VALID_IMPLANT;
-            if (lastImplant != NULL) {
-                double dt = event.time - lastImplant->time;
+            if (!std::isnan(lastImplantTime)) {
+                double dt = event.time - lastImplantTime;
                 plot(D_TIME_BW_ALL_IMPLANTS, dt * clockInSeconds / 1e-6);
             }
             if (!std::isnan(lastTime)) {
@@ -205,12 +223,14 @@ void Correlator::Correlate(EventInfo &event, unsigned int fch,
                 event.dtime = INFINITY;
             }
             event.generation = 0;
-            theList.push_back(event);
-            lastImplant = &theList.back();
+            AddToList(fch, bch, event);
+            lastImplantTime = event.time;
             break;
         default:
-            if (theList.empty())
+            unordered_map<unsigned int, CorrelationList>::iterator it = decayLists_.find(GetPixel(fch, bch));
+            if (it == decayLists_.end())
                 break;
+            CorrelationList &theList = it->second;
 
             if (std::isnan(theList.GetImplantTime())) {
                 cout << "No implant time for decay list" << endl;
@@ -232,13 +252,7 @@ void Correlator::Correlate(EventInfo &event, unsigned int fch,
                          << "\n  DT: " << dt << endl;
                     // PIXIE's clock has most likely been zeroed due to a file marker
                     //   no chance of doing correlations
-                    for (unsigned int i = 0; i < arraySize; i++) {
-                        for (unsigned int j = 0; j < arraySize; j++) {
-                            if (IsFlagged(i, j))
-                                PrintDecayList(i, j);
-                            decaylist[i][j].clear();
-                        }
-                    }
+                    ExpireLists(-INFINITY);
                 } else if (event.type != EventInfo::GAMMA_EVENT) {
                     // since gammas are processed at a different time than everything else
                     cout << "negative correlation time, DECAY: " << event.time
@@ -262,7 +276,7 @@ void Correlator::Correlate(EventInfo &event, unsigned int fch,
             if (condition == VALID_DECAY)
                 event.generation = theList.back().generation + 1;
 
-            theList.push_back(event);
+            theList.Add(event, maxListSize_);
 
             if (event.energy == 0 && std::isnan(event.time))
                 cout << " Adding zero decay event " << endl;
@@ -271,68 +285,141 @@ void Correlator::Correlate(EventInfo &event, unsigned int fch,
                 theList.Flag();
 
             if (condition == VALID_DECAY)
-                lastDecay = &theList.back();
+                lastDecayTime = event.dtime;
             else if (condition == DECAY_TOO_LATE)
-                theList.clear();
+                ClearList(fch, bch);
 
             break;
     }
     plot(D_CONDITION, condition);
 }
 
+///The pixels are visited in the same order as the strips, so the condition that's left at the end is the same as when
+/// every pixel of the detector was checked.
 void Correlator::CorrelateAll(EventInfo &event) {
-    for (unsigned int fch = 0; fch < arraySize; fch++) {
-        for (unsigned int bch = 0; bch < arraySize; bch++) {
-            if (decaylist[fch][bch].size() == 0)
-                continue;
-            if (event.time - decaylist[fch][bch].back().time < 10e-6 / Globals::get()->GetFilterClockInSeconds())
-                Correlate(event, fch, bch);
-        }
-    }
+    vector<unsigned int> pixels;
+    for (const auto &list : decayLists_)
+        if (event.time - list.second.back().time < 10e-6 / Globals::get()->GetFilterClockInSeconds())
+            pixels.push_back(list.first);
+    sort(pixels.begin(), pixels.end());
+    for (const auto &pixel : pixels)
+        Correlate(event, pixel / numBack_, pixel % numBack_);
 }
 
+///Implants start a new list in every pixel of the strip, decays only need the pixels that have a list.
 void Correlator::CorrelateAllX(EventInfo &event, unsigned int bch) {
-    for (unsigned int fch = 0; fch < arraySize; fch++)
-        Correlate(event, fch, bch);
+    if (bch >= numBack_) {
+        plot(D_CONDITION, INVALID_LOCATION);
+        return;
+    }
+    if (event.type == EventInfo::IMPLANT_EVENT) {
+        for (unsigned int fch = 0; fch < numFront_; fch++)
+            Correlate(event, fch, bch);
+    } else
+        CorrelateStrips(event, pixelsByBack_[bch].GetSortedMembers(), bch, true);
 }
 
 void Correlator::CorrelateAllY(EventInfo &event, unsigned int fch) {
-    for (unsigned int bch = 0; bch < arraySize; bch++)
-        Correlate(event, fch, bch);
+    if (fch >= numFront_) {
+        plot(D_CONDITION, INVALID_LOCATION);
+        return;
+    }
+    if (event.type == EventInfo::IMPLANT_EVENT) {
+        for (unsigned int bch = 0; bch < numBack_; bch++)
+            Correlate(event, fch, bch);
+    } else
+        CorrelateStrips(event, pixelsByFront_[fch].GetSortedMembers(), fch, false);
+}
+
+void Correlator::CorrelateStrips(EventInfo &event, const std::vector<unsigned int> &strips, const unsigned int &other,
+                                 const bool &isFront) {
+    for (const auto &strip : strips) {
+        if (isFront)
+            Correlate(event, strip, other);
+        else
+            Correlate(event, other, strip);
+    }
 }
 
 double Correlator::GetDecayTime(void) const {
-    if (lastDecay == NULL)
-        return NAN;
-    else
-        return lastDecay->dtime;
+    return lastDecayTime;
 }
 
 double Correlator::GetDecayTime(int fch, int bch) const {
-    return decaylist[fch][bch].GetDecayTime();
+    const CorrelationList *list = FindList(fch, bch);
+    return list == NULL ? NAN : list->GetDecayTime();
 }
 
 double Correlator::GetImplantTime(void) const {
-    if (lastImplant == NULL)
-        return NAN;
-    else
-        return lastImplant->time;
+    return lastImplantTime;
 }
 
 double Correlator::GetImplantTime(int fch, int bch) const {
-    return decaylist[fch][bch].GetImplantTime();
+    const CorrelationList *list = FindList(fch, bch);
+    return list == NULL ? NAN : list->GetImplantTime();
 }
 
 void Correlator::Flag(int fch, int bch) {
-    if (!decaylist[fch][bch].empty())
-        decaylist[fch][bch].Flag();
+    if (FindList(fch, bch) != NULL)
+        decayLists_[GetPixel(fch, bch)].Flag();
 }
 
 bool Correlator::IsFlagged(int fch, int bch) {
-    return decaylist[fch][bch].IsFlagged();
+    const CorrelationList *list = FindList(fch, bch);
+    return list != NULL && list->IsFlagged();
 }
 
 void Correlator::PrintDecayList(unsigned int fch, unsigned int bch) const {
     cout << "Current decay list for " << fch << " , " << bch << " : " << endl;
-    decaylist[fch][bch].PrintDecayList();
+    const CorrelationList *list = FindList(fch, bch);
+    if (list == NULL)
+        cout << "    EMPTY" << endl;
+    else
+        list->PrintDecayList();
+}
+
+const CorrelationList *Correlator::FindList(const unsigned int &fch, const unsigned int &bch) const {
+    if (fch >= numFront_ || bch >= numBack_)
+        return NULL;
+    unordered_map<unsigned int, CorrelationList>::const_iterator it = decayLists_.find(GetPixel(fch, bch));
+    return it == decayLists_.end() ? NULL : &it->second;
+}
+
+void Correlator::AddToList(const unsigned int &fch, const unsigned int &bch, const EventInfo &event) {
+    decayLists_[GetPixel(fch, bch)].Add(event, maxListSize_);
+    pixelsByFront_[fch].Insert(bch);
+    pixelsByBack_[bch].Insert(fch);
+}
+
+void Correlator::ClearList(const unsigned int &fch, const unsigned int &bch) {
+    decayLists_.erase(GetPixel(fch, bch));
+    pixelsByFront_[fch].Erase(bch);
+    pixelsByBack_[bch].Erase(fch);
+}
+
+///We only look for old implants once a tenth of the expiry time has passed, so the cost of the check is spread over
+/// many events. A time of -INFINITY drops every list, which we use when the clock has been reset.
+void Correlator::ExpireLists(const double &time) {
+    double expiryTicks = expiryTime_ / Globals::get()->GetFilterClockInSeconds();
+    if (!std::isinf(time)) {
+        if (std::isnan(lastExpiry_) || time < lastExpiry_)
+            lastExpiry_ = time;
+        if (time - lastExpiry_ < expiryTicks / 10)
+            return;
+        lastExpiry_ = time;
+    }
+
+    vector<unsigned int> pixels;
+    for (const auto &list : decayLists_)
+        if (std::isinf(time) || time - list.second.front().time >= expiryTicks)
+            pixels.push_back(list.first);
+    sort(pixels.begin(), pixels.end());
+
+    for (const auto &pixel : pixels) {
+        unsigned int fch = pixel / numBack_;
+        unsigned int bch = pixel % numBack_;
+        if (IsFlagged(fch, bch))
+            PrintDecayList(fch, bch);
+        ClearList(fch, bch);
+    }
 }
@@ -14,8 +14,10 @@
 #include "HighResTimingData.hpp"
 #include "RandomInterface.hpp"
 #include "RawEvent.hpp"
+#include "RootHandler.hpp"
 #include "TraceAnalyzer.hpp"
 #include "TreeCorrelator.hpp"
+#include "XmlInterface.hpp"
 
 #include <algorithm>
 #include <fstream>
@@ -25,6 +27,7 @@
 #include <limits>
 #include <map>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 using namespace dammIds::raw;
@@ -37,7 +40,8 @@ DetectorDriver *DetectorDriver::get() {
     return instance;
 }
 
-DetectorDriver::DetectorDriver() : histo_(OFFSET, RANGE, "DetectorDriver") {
+DetectorDriver::DetectorDriver() : histo_(OFFSET, RANGE, "DetectorDriver"), mainEvent_(NULL), nextSubmission_(0),
+                                   nextCompletion_(0), numInFlight_(0) {
     try {
         DetectorDriverXmlParser parser;
         parser.ParseNode(this);
@@ -55,6 +59,9 @@ DetectorDriver::DetectorDriver() : histo_(OFFSET, RANGE, "DetectorDriver") {
 }
 
 DetectorDriver::~DetectorDriver() {
+    StopEventThreads();
+    traceCache_.Close();
+
     for (vector<EventProcessor *>::iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
         delete (*it);
     vecProcess.clear();
@@ -79,31 +86,29 @@ void DetectorDriver::Init(RawEvent &rawev) {
     for (vector<EventProcessor *>::iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
         (*it)->Init(rawev);
 
+    mainEvent_ = &rawev;
     walk_ = DetectorLibrary::get()->GetWalkCorrections();
     cali_ = DetectorLibrary::get()->GetCalibrations();
+
+    ///The TreeCorrelator was built before the first event, so none of the places will be replaced anymore.
+    DetectorLibrary *lib = DetectorLibrary::get();
+    map<string, Place *> &places = TreeCorrelator::get()->places_;
+    channelPlaces_.assign(lib->size(), NULL);
+    for (DetectorLibrary::size_type i = 0; i < lib->size(); i++) {
+        if (!lib->HasValue(i))
+            continue;
+        map<string, Place *>::iterator it = places.find(lib->at(i).GetPlaceName());
+        if (it != places.end())
+            channelPlaces_[i] = it->second;
+    }
 }
 
 void DetectorDriver::ProcessEvent(RawEvent &rawev) {
     histo_.Plot(dammIds::raw::D_NUMBER_OF_EVENTS, dammIds::GENERIC_CHANNEL);
     try {
         for (vector<ChanEvent *>::const_iterator it = rawev.GetEventList().begin(); it != rawev.GetEventList().end(); ++it) {
-            PlotRaw((*it));
-            ThreshAndCal((*it), rawev);
-            PlotCal((*it));
-
-            string place = (*it)->GetChanID().GetPlaceName();
-            if (place == "__9999")
-                continue;
-
-            if ((*it)->IsSaturated() || (*it)->IsPileup())
-                continue;
-
-            double time = (*it)->GetTime();
-            double energy = (*it)->GetCalibratedEnergy();
-            int location = (*it)->GetChanID().GetLocation();
-
-            EventData data(time, energy, location);
-            TreeCorrelator::get()->place(place)->activate(data);
+            CalibrateChannel((*it), rawev);
+            ActivatePlace((*it));
         }
 
         //!First round is preprocessing, where process result must be guaranteed
@@ -117,10 +122,7 @@ void DetectorDriver::ProcessEvent(RawEvent &rawev) {
             if ((*iProc)->HasEvent())
                 (*iProc)->Process(rawev);
         // Clear all places in correlator (if of resetable type)
-        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
-             it != TreeCorrelator::get()->places_.end(); ++it)
-            if ((*it).second->resetable())
-                (*it).second->reset();
+        ResetPlaces();
     } catch (PaassWarning &w) {
         cout << Display::WarningStr("Warning caught at DetectorDriver::ProcessEvent") << endl;
         cout << "\t" << Display::WarningStr(w.what()) << endl;
@@ -132,6 +134,226 @@ void DetectorDriver::ProcessEvent(RawEvent &rawev) {
     }
 }
 
+void DetectorDriver::CalibrateChannel(ChanEvent *chan, RawEvent &rawev) {
+    PlotRaw(chan);
+    ThreshAndCal(chan, rawev);
+    PlotCal(chan);
+}
+
+///The basic places of the channels are found once in Init. Channels that didn't have a place then are looked up by
+/// name, which throws if the place still doesn't exist.
+void DetectorDriver::ActivatePlace(const ChanEvent *chan) {
+    if (chan->IsSaturated() || chan->IsPileup())
+        return;
+
+    unsigned int id = chan->GetID();
+    Place *place = id < channelPlaces_.size() ? channelPlaces_[id] : NULL;
+    if (!place) {
+        string name = chan->GetChanID().GetPlaceName();
+        if (name == "__9999")
+            return;
+        place = TreeCorrelator::get()->place(name);
+    }
+
+    double time = chan->GetTime();
+    double energy = chan->GetCalibratedEnergy();
+    int location = chan->GetChanID().GetLocation();
+
+    EventData data(time, energy, location);
+    place->activate(data);
+}
+
+void DetectorDriver::ResetPlaces() {
+    TreeCorrelator::get()->resetPlaces();
+}
+
+/// Each thread owns a handful of events so that the submitting thread rarely has to wait on a slow event. The queues
+/// can hold every event that a thread owns, so handing an event over never blocks.
+void DetectorDriver::StartEventThreads(const unsigned int &numThreads) {
+    static const unsigned int eventsPerThread = 64;
+
+    if (numThreads == 0 || IsEventParallel())
+        return;
+
+    if (!mainEvent_)
+        throw invalid_argument("DetectorDriver::StartEventThreads - Init must be called before we can start the "
+                                       "event threads.");
+
+    for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++) {
+        if (!(*it)->IsEventParallel()) {
+            cout << Display::WarningStr("DetectorDriver::StartEventThreads - At least one of the trace analyzers "
+                                                "cannot run in parallel, events will be processed serially.") << endl;
+            return;
+        }
+    }
+
+    parallelProcessors_.clear();
+    orderedProcessors_.clear();
+    for (vector<EventProcessor *>::const_iterator it = vecProcess.begin(); it != vecProcess.end(); it++) {
+        if ((*it)->IsEventParallel())
+            parallelProcessors_.push_back(*it);
+        else
+            orderedProcessors_.push_back(*it);
+    }
+
+    //Make sure that the singletons used by the threads exist before they start.
+    RandomInterface::get();
+    RootHandler::get();
+
+    for (unsigned int i = 0; i < numThreads * eventsPerThread; i++) {
+        eventPool_.emplace_back(new RawEvent(*mainEvent_));
+        freeEvents_.push_back(eventPool_.back().get());
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++) {
+        toEventThreads_.emplace_back(new BoundedQueue<EventTask>(eventsPerThread));
+        fromEventThreads_.emplace_back(new BoundedQueue<EventTask>(eventsPerThread));
+    }
+
+    nextSubmission_ = nextCompletion_ = numInFlight_ = 0;
+    for (unsigned int i = 0; i < numThreads; i++)
+        eventThreads_.push_back(thread(&DetectorDriver::EventThreadLoop, this, i));
+
+    cout << "DetectorDriver::StartEventThreads - Processing events on " << numThreads << " threads with "
+         << parallelProcessors_.size() << " of " << vecProcess.size() << " processors running in parallel." << endl;
+}
+
+void DetectorDriver::StopEventThreads() {
+    if (!IsEventParallel())
+        return;
+
+    while (CompleteEvent(true));
+
+    for (unsigned int i = 0; i < eventThreads_.size(); i++) {
+        EventTask task = {NULL, exception_ptr()};
+        toEventThreads_[i]->Push(task);
+    }
+
+    for (vector<thread>::iterator it = eventThreads_.begin(); it != eventThreads_.end(); it++)
+        it->join();
+
+    eventThreads_.clear();
+    toEventThreads_.clear();
+    fromEventThreads_.clear();
+    freeEvents_.clear();
+    eventPool_.clear();
+}
+
+RawEvent *DetectorDriver::AcquireEvent() {
+    if (freeEvents_.empty())
+        CompleteEvent(true);
+
+    RawEvent *event = freeEvents_.back();
+    freeEvents_.pop_back();
+    return event;
+}
+
+void DetectorDriver::SubmitEvent(RawEvent *event) {
+    EventTask task = {event, exception_ptr()};
+    toEventThreads_[nextSubmission_]->Push(task);
+    nextSubmission_ = (nextSubmission_ + 1) % eventThreads_.size();
+    numInFlight_++;
+
+    while (CompleteEvent(false));
+}
+
+/// The events are collected in the same round robin order that they were submitted, so they're finished in event
+/// order. An exception thrown on an event thread is rethrown here.
+bool DetectorDriver::CompleteEvent(const bool &wait) {
+    if (numInFlight_ == 0)
+        return false;
+
+    EventTask task;
+    if (wait)
+        fromEventThreads_[nextCompletion_]->Pop(task);
+    else if (!fromEventThreads_[nextCompletion_]->TryPop(task))
+        return false;
+
+    nextCompletion_ = (nextCompletion_ + 1) % eventThreads_.size();
+    numInFlight_--;
+    freeEvents_.push_back(task.event);
+
+    if (task.error) {
+        task.event->Zero();
+        cout << endl << Display::ErrorStr("Exception caught at DetectorDriver::ProcessEventInParallel") << endl;
+        rethrow_exception(task.error);
+    }
+
+    FinishEvent(*task.event);
+    return true;
+}
+
+void DetectorDriver::EventThreadLoop(const unsigned int idx) {
+    RootHandler::get()->AttachShard();
+
+    EventTask task;
+    while (true) {
+        toEventThreads_[idx]->Pop(task);
+        if (!task.event)
+            return;
+
+        try {
+            ProcessEventInParallel(*task.event);
+        } catch (PaassWarning &w) {
+            cout << Display::WarningStr("Warning caught at DetectorDriver::ProcessEventInParallel") << endl;
+            cout << "\t" << Display::WarningStr(w.what()) << endl;
+        } catch (...) {
+            task.error = current_exception();
+        }
+
+        fromEventThreads_[idx]->Push(task);
+    }
+}
+
+void DetectorDriver::ProcessEventInParallel(RawEvent &event) {
+    histo_.Plot(dammIds::raw::D_NUMBER_OF_EVENTS, dammIds::GENERIC_CHANNEL);
+
+    for (vector<ChanEvent *>::const_iterator it = event.GetEventList().begin(); it != event.GetEventList().end(); ++it)
+        CalibrateChannel((*it), event);
+
+    for (vector<EventProcessor *>::iterator iProc = parallelProcessors_.begin(); iProc != parallelProcessors_.end();
+         iProc++)
+        if ((*iProc)->HasEventIn(event))
+            (*iProc)->PreProcess(event);
+    for (vector<EventProcessor *>::iterator iProc = parallelProcessors_.begin(); iProc != parallelProcessors_.end();
+         iProc++)
+        if ((*iProc)->HasEventIn(event))
+            (*iProc)->Process(event);
+}
+
+/// The processors that run in order were initialized with mainEvent_ and keep pointers to its summaries. Swapping
+/// the contents in keeps those pointers valid. The event that we hand back holds the empty contents of mainEvent_.
+void DetectorDriver::FinishEvent(RawEvent &event) {
+    try {
+        for (vector<ChanEvent *>::const_iterator it = event.GetEventList().begin(); it != event.GetEventList().end();
+             ++it)
+            ActivatePlace((*it));
+
+        mainEvent_->Swap(event);
+
+        for (vector<EventProcessor *>::iterator iProc = orderedProcessors_.begin(); iProc != orderedProcessors_.end();
+             iProc++)
+            if ((*iProc)->HasEvent())
+                (*iProc)->PreProcess(*mainEvent_);
+        for (vector<EventProcessor *>::iterator iProc = orderedProcessors_.begin(); iProc != orderedProcessors_.end();
+             iProc++)
+            if ((*iProc)->HasEvent())
+                (*iProc)->Process(*mainEvent_);
+        ResetPlaces();
+    } catch (PaassWarning &w) {
+        cout << Display::WarningStr("Warning caught at DetectorDriver::FinishEvent") << endl;
+        cout << "\t" << Display::WarningStr(w.what()) << endl;
+    } catch (PaassException &e) {
+        mainEvent_->Zero();
+        event.Zero();
+        cout << endl << Display::ErrorStr("Exception caught at DetectorDriver::FinishEvent") << endl;
+        throw;
+    }
+
+    mainEvent_->Zero();
+    event.Zero();
+}
+
 /// Declare some of the raw and basic plots that are going to be used in the
 /// analysis of the data. These include raw and calibrated energy spectra,
 /// information about the run time, and count rates on the detectors. This
@@ -184,30 +406,37 @@ void DetectorDriver::DeclarePlots() {
     }
 }
 
+///Everything that we need to know about the channel comes from its descriptor, so we don't touch any strings for the
+/// hit. Channels that were made by hand without a descriptor get one from the library.
 int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
-    ChannelConfiguration chanCfg = chan->GetChanID();
-    int id = chan->GetID();
-    string type = chanCfg.GetType();
-    string subtype = chanCfg.GetSubtype();
-    set<string> tags = chanCfg.GetTags();
-    bool hasStartTag = chanCfg.HasTag("start");
+    const ChannelDescriptor *descriptor = chan->GetDescriptor();
+    if (!descriptor)
+        descriptor = DetectorLibrary::get()->GetDescriptor(chan->GetID());
+    if (!descriptor || descriptor->isIgnored)
+        return (0);
+
+    const ChannelConfiguration &chanCfg = *descriptor->configuration;
+    int id = descriptor->id;
     Trace &trace = chan->GetTrace();
 
     RandomInterface *randoms = RandomInterface::get();
 
     double energy = 0.0;
 
-    if (type == "ignore" || type == "")
-        return (0);
-
     if (!trace.empty()) {
         histo_.Plot(D_HAS_TRACE, id);
 
+        //A trace restored from the cache only needs the analyzers whose results aren't kept.
+        bool isCached = traceCache_.IsOpen() &&
+                        traceCache_.Restore(chan->GetID(), chan->GetFilterTime(), chan->GetEnergy(), trace);
         for (vector<TraceAnalyzer *>::iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
-            (*it)->Analyze(trace, chanCfg);
+            if (!isCached || !(*it)->IsCacheable())
+                (*it)->Analyze(trace, chanCfg);
+        if (traceCache_.IsOpen() && !isCached)
+            traceCache_.Store(chan->GetID(), chan->GetFilterTime(), chan->GetEnergy(), trace);
 
         //We are going to handle the filtered energies here.
-        vector<double> filteredEnergies = trace.GetFilteredEnergies();
+        const vector<double> &filteredEnergies = trace.GetFilteredEnergies();
         if (filteredEnergies.empty()) {
             energy = chan->GetEnergy() + randoms->Generate();
         } else {
@@ -216,8 +445,8 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
         }
 
         //Saves the time in nanoseconds
-        chan->SetHighResTime((trace.GetPhase() * Globals::get()->GetAdcClockInSeconds() +
-                chan->GetFilterTime() * Globals::get()->GetFilterClockInSeconds()) * 1e9);
+        chan->SetHighResTime((trace.GetPhase() * descriptor->adcClockInSeconds +
+                chan->GetFilterTime() * descriptor->filterClockInSeconds) * 1e9);
     } else {
         /// otherwise, use the Pixie on-board calculated energy and high res
         /// time is zero.
@@ -229,24 +458,24 @@ int DetectorDriver::ThreshAndCal(ChanEvent *chan, RawEvent &rawev) {
     double time, walk_correction;
     if (chan->GetHighResTimeInNs() == 0.0) {
         time = chan->GetTime(); //time is in clock ticks
-        walk_correction = walk_->GetCorrection(chanCfg, energy);
+        walk_correction = walk_->GetCorrection(descriptor->id, energy);
     } else {
         time = chan->GetHighResTimeInNs(); //time here is in ns
-        walk_correction = walk_->GetCorrection(chanCfg, trace.GetQdc());
+        walk_correction = walk_->GetCorrection(descriptor->id, trace.GetQdc());
     }
 
-    chan->SetCalibratedEnergy(cali_->GetCalEnergy(chanCfg, energy));
+    chan->SetCalibratedEnergy(cali_->GetCalEnergy(descriptor->id, energy));
     chan->SetWalkCorrectedTime(time - walk_correction);
 
-    rawev.GetSummary(type)->AddEvent(chan);
+    rawev.GetSummary(descriptor->typeSummary)->AddEvent(chan);
     DetectorSummary *summary;
 
-    summary = rawev.GetSummary(type + ':' + subtype, false);
+    summary = rawev.GetSummary(descriptor->subtypeSummary, false);
     if (summary != NULL)
         summary->AddEvent(chan);
 
-    if (hasStartTag && type != "logic") {
-        summary = rawev.GetSummary(type + ':' + subtype + ':' + "start", false);
+    if (descriptor->startSummary != ChannelDescriptor::unknownId) {
+        summary = rawev.GetSummary(descriptor->startSummary, false);
         if (summary != NULL)
             summary->AddEvent(chan);
     }
@@ -269,3 +498,58 @@ EventProcessor *DetectorDriver::GetProcessor(const std::string &name) const {
             return (*it);
     return (NULL);
 }
+
+///A channel needs its trace if any of the analyzers or any of the processors of its type read it. Channels with an
+/// empty type aren't dropped since that's done by ThreshAndCal, but nobody looks at their traces.
+XiaChannelFilter DetectorDriver::GetChannelFilter() const {
+    DetectorLibrary *modChan = DetectorLibrary::get();
+    const unsigned int ignoreTypeId = modChan->GetTypeId("ignore");
+
+    XiaChannelFilter filter;
+    filter.keep.assign(modChan->size(), true);
+    filter.keepTrace.assign(modChan->size(), false);
+    for (unsigned int i = 0; i < modChan->size(); i++) {
+        const ChannelDescriptor *descriptor = modChan->GetDescriptor(i);
+        if (descriptor->typeId == ignoreTypeId) {
+            filter.keep[i] = false;
+            continue;
+        }
+        if (descriptor->isIgnored)
+            continue;
+
+        const ChannelConfiguration &cfg = *descriptor->configuration;
+        for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
+            if ((*it)->UsesTrace(cfg))
+                filter.keepTrace[i] = true;
+        for (vector<EventProcessor *>::const_iterator it = vecProcess.begin(); it != vecProcess.end(); it++)
+            if ((*it)->UsesTraces() && (*it)->GetTypes().count(cfg.GetType()) != 0)
+                filter.keepTrace[i] = true;
+    }
+    return filter;
+}
+
+///The analyzers are hashed from the whole DetectorDriver node, so changing an analyzer, any of its settings, or any
+/// of the nodes below it throws away the whole cache. The clocks that the analyzers convert their times with go into
+/// the same hash. The trace delay and the waveform (QDC) windows are set for each channel, so they're in the hash of
+/// the channel along with its other trace settings, and the length of the trace is checked against every result.
+bool DetectorDriver::OpenTraceCache(const std::string &filename) {
+    for (vector<TraceAnalyzer *>::const_iterator it = vecAnalyzer.begin(); it != vecAnalyzer.end(); it++)
+        if ((*it)->IsCacheable() && (*it)->HasPlots())
+            throw invalid_argument("DetectorDriver::OpenTraceCache - " + (*it)->GetName() + " has plots, they "
+                                           "wouldn't be filled for the traces that are restored from the cache.");
+
+    Globals *globals = Globals::get();
+    pugi::xml_node node = XmlInterface::get()->GetDocument()->child("Configuration").child("DetectorDriver");
+    unsigned long long analyzerHash = TraceResultCache::Hash(globals->GetPixieRevision(), TraceResultCache::Hash(node));
+    analyzerHash = TraceResultCache::Hash(globals->GetClockInSeconds(), analyzerHash);
+    analyzerHash = TraceResultCache::Hash(globals->GetFilterClockInSeconds(), analyzerHash);
+    analyzerHash = TraceResultCache::Hash(globals->GetAdcClockInSeconds(), analyzerHash);
+
+    DetectorLibrary *modChan = DetectorLibrary::get();
+    vector<unsigned long long> channelHashes(modChan->size(), 0);
+    for (unsigned int i = 0; i < modChan->size(); i++)
+        if (modChan->GetDescriptor(i)->configuration)
+            channelHashes[i] = TraceResultCache::Hash(*modChan->GetDescriptor(i)->configuration);
+
+    return traceCache_.Open(filename, analyzerHash, channelHashes);
+}
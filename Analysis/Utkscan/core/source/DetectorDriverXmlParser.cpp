@@ -105,7 +105,10 @@ vector<EventProcessor *> DetectorDriverXmlParser::ParseProcessors(const pugi::xm
         } else if (name == "DoubleBetaProcessor") {
             vecProcess.push_back(new DoubleBetaProcessor());
         } else if (name == "DssdProcessor") {
-            vecProcess.push_back(new DssdProcessor());
+            vecProcess.push_back(new DssdProcessor(
+                    processor.attribute("front_strips").as_uint(Correlator::defaultNumStrips),
+                    processor.attribute("back_strips").as_uint(Correlator::defaultNumStrips),
+                    processor.attribute("max_list_size").as_uint(Correlator::defaultMaxListSize)));
         } else if (name == "GeProcessor") {
             vecProcess.push_back(new GeProcessor());
         } else if (name == "Hen3Processor") {
@@ -11,6 +11,7 @@
 
 #include "Constants.hpp"
 #include "DetectorLibrary.hpp"
+#include "Globals.hpp"
 #include "MapNodeXmlParser.hpp"
 #include "Messenger.hpp"
 
@@ -33,6 +34,71 @@ DetectorLibrary::DetectorLibrary() : vector<ChannelConfiguration>(), locations()
     } catch (invalid_argument &ia) {
         throw;
     }
+    BuildDescriptors();
+}
+
+///The ids for the summaries are handed out in the same way that ThreshAndCal names them. The start summary is only
+/// used for channels that aren't logic signals.
+void DetectorLibrary::BuildDescriptors() {
+    descriptors_.assign(size(), ChannelDescriptor());
+
+    for (size_type i = 0; i < size(); i++) {
+        const ChannelConfiguration &cfg = vector<ChannelConfiguration>::at(i);
+        ChannelDescriptor &descriptor = descriptors_[i];
+        const string type = cfg.GetType();
+        const string subtype = cfg.GetSubtype();
+
+        descriptor.configuration = &cfg;
+        descriptor.id = (unsigned int) i;
+        descriptor.typeId = Intern(typeIds_, type);
+        descriptor.subtypeId = Intern(subtypeIds_, subtype);
+        descriptor.isIgnored = type == "ignore" || type == "";
+        descriptor.isLogic = type == "logic";
+        descriptor.hasStartTag = cfg.HasTag("start");
+        descriptor.adcClockInSeconds = Globals::get()->GetAdcClockInSeconds();
+        descriptor.filterClockInSeconds = Globals::get()->GetFilterClockInSeconds();
+
+        set<string> tags = cfg.GetTags();
+        for (set<string>::const_iterator it = tags.begin(); it != tags.end(); it++) {
+            unsigned int tagId = Intern(tagIds_, *it);
+            if (tagId < ChannelDescriptor::maximumNumberOfTags)
+                descriptor.tags |= 1ULL << tagId;
+            else
+                cout << "DetectorLibrary::BuildDescriptors - More than " << ChannelDescriptor::maximumNumberOfTags
+                     << " different tags are used, the tag " << *it << " can only be checked through the "
+                     << "ChannelConfiguration." << endl;
+        }
+
+        if (descriptor.isIgnored)
+            continue;
+
+        descriptor.typeSummary = InternSummary(type);
+        descriptor.subtypeSummary = InternSummary(type + ':' + subtype);
+        if (descriptor.hasStartTag && !descriptor.isLogic)
+            descriptor.startSummary = InternSummary(type + ':' + subtype + ':' + "start");
+    }
+}
+
+unsigned int DetectorLibrary::Intern(map<string, unsigned int> &ids, const string &name) {
+    return ids.insert(make_pair(name, (unsigned int) ids.size())).first->second;
+}
+
+unsigned int DetectorLibrary::InternSummary(const string &name) {
+    pair<map<string, unsigned int>::iterator, bool> result =
+            summaryIds_.insert(make_pair(name, (unsigned int) summaryNames_.size()));
+    if (result.second)
+        summaryNames_.push_back(name);
+    return result.first->second;
+}
+
+unsigned int DetectorLibrary::GetTypeId(const std::string &type) const {
+    map<string, unsigned int>::const_iterator it = typeIds_.find(type);
+    return it == typeIds_.end() ? ChannelDescriptor::unknownId : it->second;
+}
+
+unsigned int DetectorLibrary::GetTagId(const std::string &tag) const {
+    map<string, unsigned int>::const_iterator it = tagIds_.find(tag);
+    return it == tagIds_.end() ? ChannelDescriptor::maximumNumberOfTags : it->second;
 }
 
 DetectorLibrary::const_reference DetectorLibrary::at(DetectorLibrary::size_type idx) const {
@@ -3,6 +3,7 @@
 ///@author D. Miller, K. Miernik, S. V. Paulauskas
 ///@date May 28, 2017
 #include <stdexcept>
+#include <utility>
 
 #include "DetectorSummary.hpp"
 #include "StringManipulationFunctions.hpp"
@@ -16,6 +17,7 @@ void DetectorSummary::Zero() {
 
 DetectorSummary::DetectorSummary() {
     maxEvent_ = NULL;
+    dirtyList_ = NULL;
 }
 
 DetectorSummary::DetectorSummary(const std::string &str, const std::vector<ChanEvent *> &fullList) : name_(str) {
@@ -23,6 +25,7 @@ DetectorSummary::DetectorSummary(const std::string &str, const std::vector<ChanE
         throw invalid_argument("DetectorSummary::DetectorSummary : Received a request using an empty summary name.");
 
     maxEvent_ = NULL;
+    dirtyList_ = NULL;
 
     vector<string> tokens = StringManipulation::TokenizeString(str, ":");
 
@@ -51,9 +54,17 @@ DetectorSummary::DetectorSummary(const std::string &str, const std::vector<ChanE
 }
 
 void DetectorSummary::AddEvent(ChanEvent *ev) {
+    if (eventList_.empty() && dirtyList_)
+        dirtyList_->push_back(this);
+
     eventList_.push_back(ev);
 
     if (maxEvent_ == NULL || ev->GetCalibratedEnergy() > maxEvent_->GetCalibratedEnergy())
         maxEvent_ = ev;
 }
 
+
+void DetectorSummary::SwapContents(DetectorSummary &other) {
+    eventList_.swap(other.eventList_);
+    swap(maxEvent_, other.maxEvent_);
+}
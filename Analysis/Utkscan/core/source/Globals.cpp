@@ -55,6 +55,8 @@ Globals::Globals(const std::string &file) {
 void Globals::InitializeMemberVariables() {
     sysClockFreqInHz_ = sysconf(_SC_CLK_TCK);
     hasRawHistogramsDefined_ = true;
+    numEventThreads_ = 0;
+    flushIntervalInSeconds_ = 2;
     outputFilename_ = outputPath_ = revision_ = "";
     eventLengthInTicks_ = 0;
     adcClockInSeconds_ = clockInSeconds_ = eventLengthInSeconds_ =
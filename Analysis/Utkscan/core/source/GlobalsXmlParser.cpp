@@ -103,7 +103,23 @@ void GlobalsXmlParser::ParseGlobalNode(const pugi::xml_node &node, Globals *glob
     else
         globals->SetHasRawHistogramsDefined(true);
 
-    set <string> knownNodes = {"Revision", "EventWidth", "HasRaw"};
+    if (!node.child("EventThreads").empty()) {
+        globals->SetNumberOfEventThreads(node.child("EventThreads").attribute("value").as_uint(0));
+        sstream_ << "Processing events with " << globals->GetNumberOfEventThreads() << " threads.";
+        messenger_.detail(sstream_.str());
+        sstream_.str("");
+    }
+
+    if (!node.child("FlushInterval").empty()) {
+        globals->SetFlushIntervalInSeconds(Conversions::ConvertSecondsWithPrefix(
+                node.child("FlushInterval").attribute("value").as_double(2),
+                node.child("FlushInterval").attribute("unit").as_string("s")));
+        sstream_ << "Histograms will be flushed every " << globals->GetFlushIntervalInSeconds() << " s.";
+        messenger_.detail(sstream_.str());
+        sstream_.str("");
+    }
+
+    set <string> knownNodes = {"Revision", "EventWidth", "HasRaw", "EventThreads", "FlushInterval"};
     WarnOfUnknownChildren(node, knownNodes);
 }
 
@@ -0,0 +1,246 @@
+///@file ParallelReplay.cpp
+///@brief Splits a run into pieces that are scanned by separate utkscan processes and merges their output.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include "ParallelReplay.hpp"
+
+#include <TFileMerger.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Display.h"
+
+using namespace std;
+
+///The command line is parsed with the same table as ScanInterface::Setup, so the options are read the same way by
+/// both, whether their values are attached, after an equals sign or in the next argument. The options are handed to
+/// the workers in the order that they were given, only --workers is taken out.
+ParallelReplay::ParallelReplay(int argc, char *argv[], const std::vector<option> &options,
+                               const std::string &shortOptions) :
+        numWorkers_(0), hasWarmup_(false), hasSelection_(false) {
+    program_ = argv[0];
+
+    //The leading dash keeps getopt_long from reordering the arguments, so each option is followed by the arguments
+    // that it used. The colon and opterr silence the errors, Setup will report them if they matter.
+    string optionString = "-:" + shortOptions;
+    vector<char *> args(argv, argv + argc);
+    int savedOpterr = opterr;
+    opterr = 0;
+    optind = 0;
+
+    int idx = 0;
+    int retval = 0;
+    int first = 1;
+    while ((retval = getopt_long(argc, args.data(), optionString.c_str(), options.data(), &idx)) != -1) {
+        string name = retval == 0 ? options[idx].name : "";
+        if (name == "workers") {
+            numWorkers_ = (unsigned int) atoi(optarg);
+            first = optind;
+            continue;
+        }
+
+        if (retval == 'i')
+            inputFilename_ = optarg;
+        else if (retval == 'o')
+            outputName_ = optarg;
+        else if (retval == 's' || name == "spill" || name == "start-time" || name == "stop-time")
+            hasSelection_ = true;
+        else if (name == "warmup")
+            hasWarmup_ = true;
+        else if (name == "dump-hits" || name == "trace-cache")
+            sharedFileOption_ = name;
+
+        for (; first < optind; first++)
+            arguments_.push_back(args[first]);
+    }
+    for (; first < argc; first++)
+        arguments_.push_back(args[first]);
+
+    //Setup parses the command line again from the start.
+    optind = 0;
+    opterr = savedOpterr;
+}
+
+int ParallelReplay::Run() {
+    if (inputFilename_.empty() || outputName_.empty()) {
+        cerr << Display::ErrorStr("ParallelReplay::Run - The input and output files are needed to use --workers.")
+             << endl;
+        return 1;
+    }
+    if (hasSelection_) {
+        cerr << Display::ErrorStr("ParallelReplay::Run - --workers splits the whole run, it can't be used with "
+                                          "--spill, --start-time, --stop-time or --shm.") << endl;
+        return 1;
+    }
+    if (!sharedFileOption_.empty()) {
+        cerr << Display::ErrorStr("ParallelReplay::Run - The workers can't share the file given with --"
+                                  + sharedFileOption_ + ", scan the run without --workers to use it.") << endl;
+        return 1;
+    }
+
+    SpillIndex index;
+    if (!index.Load(SpillIndex::GetIndexFilename(inputFilename_))) {
+        cerr << Display::ErrorStr("ParallelReplay::Run - Unable to load the spill index for " + inputFilename_
+                                  + ", build it with indexBuilder.") << endl;
+        return 1;
+    }
+
+    vector<pair<size_t, size_t> > ranges = SplitRun(index.GetEntries());
+    if (ranges.size() < 2) {
+        cout << "ParallelReplay::Run - The run is too short to split, scanning it in order." << endl;
+        return RunSequentially();
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<pid_t> workers;
+    for (unsigned int i = 0; i < ranges.size(); i++) {
+        pid_t pid = StartWorker(i, ranges[i]);
+        if (pid < 0) {
+            cerr << Display::ErrorStr("ParallelReplay::Run - Unable to start worker " + to_string(i)) << endl;
+            // The workers are reaped so that they aren't left as zombies for as long as we're around.
+            for (auto worker : workers)
+                kill(worker, SIGTERM);
+            for (auto worker : workers)
+                waitpid(worker, NULL, 0);
+            return 1;
+        }
+        cout << "ParallelReplay::Run - Worker " << i << " is scanning spills " << ranges[i].first << " to "
+             << ranges[i].second << ", its output is in " << GetWorkerOutputName(i) << ".log" << endl;
+        workers.push_back(pid);
+    }
+
+    bool failed = false;
+    bool sequentialOnly = false;
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        int status;
+        if (waitpid(workers[i], &status, 0) < 0 || !WIFEXITED(status)) {
+            failed = true;
+            continue;
+        }
+        if (WEXITSTATUS(status) == sequentialOnlyExitCode)
+            sequentialOnly = true;
+        else if (WEXITSTATUS(status) != 0)
+            failed = true;
+    }
+
+    if (sequentialOnly) {
+        cout << "ParallelReplay::Run - A processor needs the run to be scanned in order, scanning it with a single "
+                "process." << endl;
+        return RunSequentially();
+    }
+    if (failed) {
+        cerr << Display::ErrorStr("ParallelReplay::Run - At least one of the workers failed, check their logs.")
+             << endl;
+        return 1;
+    }
+
+    if (!Merge("-hist.root", workers.size()) || !Merge("-tree.root", workers.size()))
+        return 1;
+
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        remove((GetWorkerOutputName(i) + "-hist.root").c_str());
+        remove((GetWorkerOutputName(i) + "-tree.root").c_str());
+    }
+
+    cout << "ParallelReplay::Run - Scanned " << index.GetEntries().size() << " spills with " << workers.size()
+         << " workers in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s." << endl;
+    return 0;
+}
+
+///The ranges are cut once they reach their share of the words, so that the workers finish at about the same time
+/// even if the spills have different sizes.
+vector<pair<size_t, size_t> > ParallelReplay::SplitRun(const vector<SpillIndexEntry> &entries) const {
+    unsigned long long totalWords = 0;
+    for (const auto &entry : entries)
+        totalWords += entry.nWords;
+
+    vector<pair<size_t, size_t> > ranges;
+    size_t first = 0;
+    unsigned long long words = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        words += entries[i].nWords;
+        if (words * numWorkers_ >= totalWords * (ranges.size() + 1) || i + 1 == entries.size()) {
+            ranges.push_back(make_pair(first, i));
+            first = i + 1;
+        }
+    }
+    return ranges;
+}
+
+string ParallelReplay::GetWorkerOutputName(const unsigned int &worker) const {
+    return outputName_ + "-part" + to_string(worker);
+}
+
+pid_t ParallelReplay::StartWorker(const unsigned int &worker, const pair<size_t, size_t> &range) const {
+    vector<string> arguments;
+    arguments.push_back(program_);
+    arguments.insert(arguments.end(), arguments_.begin(), arguments_.end());
+
+    //The last output name on the command line is the one that's used.
+    arguments.push_back("--output");
+    arguments.push_back(GetWorkerOutputName(worker));
+    arguments.push_back("--spill");
+    arguments.push_back(to_string(range.first) + ":" + to_string(range.second));
+    if (!hasWarmup_) {
+        arguments.push_back("--warmup");
+        arguments.push_back(to_string(defaultWarmupSpills));
+    }
+    arguments.push_back("--batch");
+    arguments.push_back("--replay-worker");
+
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    int log = open((GetWorkerOutputName(worker) + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log >= 0) {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+    }
+
+    vector<char *> argv;
+    for (auto &argument : arguments)
+        argv.push_back(const_cast<char *>(argument.c_str()));
+    argv.push_back(nullptr);
+    execvp(program_.c_str(), argv.data());
+    _exit(1);
+}
+
+///The workers' files are merged in the order of their ranges, so the tree entries stay in time order.
+bool ParallelReplay::Merge(const std::string &suffix, const unsigned int &numWorkers) const {
+    TFileMerger merger(false);
+    if (!merger.OutputFile((outputName_ + suffix).c_str(), "RECREATE")) {
+        cerr << Display::ErrorStr("ParallelReplay::Merge - Unable to open " + outputName_ + suffix) << endl;
+        return false;
+    }
+    for (unsigned int i = 0; i < numWorkers; i++)
+        merger.AddFile((GetWorkerOutputName(i) + suffix).c_str(), false);
+
+    if (!merger.Merge()) {
+        cerr << Display::ErrorStr("ParallelReplay::Merge - Unable to merge the " + suffix + " files.") << endl;
+        return false;
+    }
+    return true;
+}
+
+int ParallelReplay::RunSequentially() const {
+    vector<char *> argv;
+    argv.push_back(const_cast<char *>(program_.c_str()));
+    for (auto &argument : arguments_)
+        argv.push_back(const_cast<char *>(argument.c_str()));
+    argv.push_back(nullptr);
+    execvp(program_.c_str(), argv.data());
+
+    cerr << Display::ErrorStr("ParallelReplay::RunSequentially - Unable to start " + program_) << endl;
+    return 1;
+}
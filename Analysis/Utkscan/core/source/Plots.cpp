@@ -21,8 +21,8 @@ Plots::Plots(int offset, int range, std::string name) {
     range_ = range;
     name_ = name;
     PlotsRegister::get()->Add(offset_, range_, name_);
-    if(!rootHandler_)
-        rootHandler_ = RootHandler::get();
+    rootHandler_ = RootHandler::get();
+    handles_.assign(range_ > 0 ? range_ : 0, NULL);
 }
 
 bool Plots::BananaTest(const int &id, const double &x, const double &y) {
@@ -76,6 +76,7 @@ bool Plots::DeclareHistogram1D(int dammId, int xSize, const char *title, int hal
     hd1d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength, xLow, xHigh, title, strlen(title));
 #endif
     rootHandler_->RegisterHistogram(dammId + offset_, title, xHistLength);
+    handles_[dammId] = rootHandler_->GetHandle(dammId + offset_);
     titleList.insert(pair<int, string>(dammId, string(title)));
     return true;
 }
@@ -117,6 +118,7 @@ bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *tit
     hd2d_(dammId + offset_, halfWordsPerChan, xSize, xHistLength, xLow, xHigh, ySize, yHistLength, yLow, yHigh, title, strlen(title));
 #endif
     rootHandler_->RegisterHistogram(dammId + offset_, title, xSize, ySize);
+    handles_[dammId] = rootHandler_->GetHandle(dammId + offset_);
     titleList.insert(pair<int, string>(dammId, string(title)));
     return true;
 }
@@ -132,8 +134,9 @@ bool Plots::DeclareHistogram2D(int dammId, int xSize, int ySize, const char *tit
                               xSize / xContraction - 1, ySize / yContraction, 0, ySize / yContraction - 1, mne);
 }
 
+/// The handle was looked up when the histogram was declared, so all that's left to do is bounds check the id.
 bool Plots::Plot(int dammId, double val1, double val2, double val3, const char *name) {
-    if (!Exists(dammId)) {
+    if (!CheckRange(dammId) || !handles_[dammId]) {
 #ifdef VERBOSE
         std::cerr << "Tried to fill histogram ID " << dammId << "belonging to " << name_
         << ", which is not known to us. You MUST fix this " << "before continuing with execution." << endl;
@@ -141,7 +144,7 @@ bool Plots::Plot(int dammId, double val1, double val2, double val3, const char *
         return false;
     }
 
-    rootHandler_->Plot(dammId + offset_, val1, val2, val3);
+    rootHandler_->Plot(*handles_[dammId], val1, val2, val3);
 #ifdef USE_HRIBF
     if (val2 == -1 && val3 == -1)
         count1cc_(dammId + offset_, int(val1), 1);
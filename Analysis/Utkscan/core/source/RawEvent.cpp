@@ -2,13 +2,52 @@
  *  \brief defines functions associated with a rawevent
  *  @authors D. Miller, K. Miernik, S. V. Paulauskas
  */
+#include <mutex>
 #include <sstream>
 
+#include "ChanEventPool.hpp"
+#include "DetectorLibrary.hpp"
 #include "RawEvent.hpp"
 #include "Messenger.hpp"
 
 using namespace std;
 
+///Events are processed on several threads when the DetectorDriver is running in parallel, so we guard the lists
+/// that make sure that each message is only printed once.
+///@param[in] reported : The list of summaries that we've already reported
+///@param[in] name : The name of the summary that we want to report
+///@return True if this is the first time that we've seen the summary.
+static bool IsFirstReport(set<string> &reported, const string &name) {
+    static mutex reportMutex;
+    lock_guard<mutex> lock(reportMutex);
+    return reported.insert(name).second;
+}
+
+RawEvent::RawEvent(const RawEvent &other) : sumMap(other.sumMap), nullSummaries(other.nullSummaries),
+                                             eventList(other.eventList), summaryGeneration_(0) {
+    AttachSummaries();
+}
+
+RawEvent &RawEvent::operator=(const RawEvent &other) {
+    sumMap = other.sumMap;
+    nullSummaries = other.nullSummaries;
+    eventList = other.eventList;
+    summaryCache_.clear();
+    summaryCacheGeneration_.clear();
+    summaryGeneration_++;
+    AttachSummaries();
+    return *this;
+}
+
+void RawEvent::AttachSummaries() {
+    dirtySummaries_.clear();
+    for (map<string, DetectorSummary>::iterator it = sumMap.begin(); it != sumMap.end(); it++) {
+        it->second.SetDirtyList(&dirtySummaries_);
+        if (it->second.GetMult() > 0)
+            dirtySummaries_.push_back(&it->second);
+    }
+}
+
 void RawEvent::Init(const std::set<std::string> &usedTypes) {
     /*! initialize the map of used detectors. This will associate the name of a
        detector type (such as dssd_front, ge ...) with a detector summary.
@@ -20,38 +59,45 @@ void RawEvent::Init(const std::set<std::string> &usedTypes) {
 
     for (set<string>::const_iterator it = usedTypes.begin(); it != usedTypes.end(); it++) {
         ds.SetName(*it);
-        sumMap.insert(make_pair(*it, ds));
+        sumMap.insert(make_pair(*it, ds)).first->second.SetDirtyList(&dirtySummaries_);
     }
+    summaryGeneration_++;
 }
 
-void RawEvent::Zero(const std::set<std::string> &usedev) {
-    for (map<string, DetectorSummary>::iterator it = sumMap.begin(); it != sumMap.end(); it++)
-        (*it).second.Zero();
+void RawEvent::Zero() {
+    for (vector<DetectorSummary *>::iterator it = dirtySummaries_.begin(); it != dirtySummaries_.end(); it++)
+        (*it)->Zero();
+    dirtySummaries_.clear();
 
-    for (vector<ChanEvent *>::iterator it = eventList.begin(); it != eventList.end(); it++)
-        delete *it;
-
-    eventList.clear();
+    ChanEventPool::get()->Release(eventList);
 }
 
 DetectorSummary *RawEvent::GetSummary(const std::string &s, bool construct) {
     map<string, DetectorSummary>::iterator it = sumMap.find(s);
-    static set <string> nullSummaries;
+    static set <string> constructedSummaries;
+    static set <string> reportedNullSummaries;
 
-    Messenger m;
-    stringstream ss;
     if (it == sumMap.end()) {
+        Messenger m;
+        stringstream ss;
         if (construct) {
             // construct the summary
-            ss << "Constructing detector summary for type " << s;
-            m.detail(ss.str());
-            sumMap.insert(make_pair(s, DetectorSummary(s, eventList)));
-            it = sumMap.find(s);
+            if (IsFirstReport(constructedSummaries, s)) {
+                ss << "Constructing detector summary for type " << s;
+                m.detail(ss.str());
+            }
+            it = sumMap.insert(make_pair(s, DetectorSummary(s, eventList))).first;
+            it->second.SetDirtyList(&dirtySummaries_);
+            if (it->second.GetMult() > 0)
+                dirtySummaries_.push_back(&it->second);
+            summaryGeneration_++;
         } else {
             if (nullSummaries.count(s) == 0) {
-                ss << "Returning NULL detector summary for type " << s;
-                m.detail(ss.str());
                 nullSummaries.insert(s);
+                if (IsFirstReport(reportedNullSummaries, s)) {
+                    ss << "Returning NULL detector summary for type " << s;
+                    m.detail(ss.str());
+                }
             }
             return NULL;
         }
@@ -59,6 +105,45 @@ DetectorSummary *RawEvent::GetSummary(const std::string &s, bool construct) {
     return &(it->second);
 }
 
+///A summary is in the list of filled summaries when it has channels. The filled summaries of the other event whose
+/// counterpart here is empty are exchanged first, then all of our filled summaries are exchanged with their
+/// counterparts. Doing it in this order exchanges every pair once, even if both of them were filled.
+void RawEvent::Swap(RawEvent &other) {
+    vector<DetectorSummary *> ours, theirs;
+    ours.swap(dirtySummaries_);
+    theirs.swap(other.dirtySummaries_);
+
+    for (vector<DetectorSummary *>::iterator it = theirs.begin(); it != theirs.end(); it++) {
+        DetectorSummary *counterpart = FindOrAddEmptySummary((*it)->GetName());
+        if (counterpart->GetMult() > 0)
+            continue;
+        counterpart->SwapContents(**it);
+        dirtySummaries_.push_back(counterpart);
+    }
+
+    for (vector<DetectorSummary *>::iterator it = ours.begin(); it != ours.end(); it++) {
+        DetectorSummary *counterpart = other.FindOrAddEmptySummary((*it)->GetName());
+        (*it)->SwapContents(*counterpart);
+        if ((*it)->GetMult() > 0)
+            dirtySummaries_.push_back(*it);
+        other.dirtySummaries_.push_back(counterpart);
+    }
+
+    eventList.swap(other.eventList);
+}
+
+DetectorSummary *RawEvent::FindOrAddEmptySummary(const std::string &name) {
+    map<string, DetectorSummary>::iterator it = sumMap.find(name);
+    if (it != sumMap.end())
+        return &it->second;
+
+    static const vector<ChanEvent *> noEvents;
+    it = sumMap.insert(make_pair(name, DetectorSummary(name, noEvents))).first;
+    it->second.SetDirtyList(&dirtySummaries_);
+    summaryGeneration_++;
+    return &it->second;
+}
+
 const DetectorSummary *RawEvent::GetSummary(const std::string &s) const {
     map<string, DetectorSummary>::const_iterator it = sumMap.find(s);
 
@@ -71,3 +156,18 @@ const DetectorSummary *RawEvent::GetSummary(const std::string &s) const {
     }
     return &(it->second);
 }
+
+DetectorSummary *RawEvent::GetSummary(const unsigned int &id, bool construct) {
+    if (id >= summaryCache_.size()) {
+        summaryCache_.resize(id + 1, NULL);
+        summaryCacheGeneration_.resize(id + 1, summaryGeneration_ - 1);
+    }
+
+    //A summary that we didn't find is only known to be missing if we aren't going to construct it.
+    if (summaryCache_[id] || (!construct && summaryCacheGeneration_[id] == summaryGeneration_))
+        return summaryCache_[id];
+
+    summaryCache_[id] = GetSummary(DetectorLibrary::get()->GetSummaryName(id), construct);
+    summaryCacheGeneration_[id] = summaryGeneration_;
+    return summaryCache_[id];
+}
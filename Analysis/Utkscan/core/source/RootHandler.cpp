@@ -4,17 +4,31 @@
 ///@date January 2010
 #include "RootHandler.hpp"
 
+#include <TROOT.h>
+
 #include <iostream>
-#include <thread>
 
 using namespace std;
 
+///The number of fills that a handle buffers before they're given to ROOT.
+static const size_t fillBufferSize = 512;
+
 RootHandler *RootHandler::instance_ = nullptr; //!< The ONLY instance of this class.
 TFile *RootHandler::histogramFile_ = nullptr; //!< ROOT file storing user registered histograms
 TFile *RootHandler::treeFile_ = nullptr; //!< ROOT File storing user registered trees.
 map<std::string, TTree *> RootHandler::treeList_; //!< The list of user registered trees
 map<unsigned int, TH1 *> RootHandler::histogramList_; //!< List of user registered histograms
-mutex RootHandler::flushMutex_; //!< Ensures only one thread writes to histogramFile_
+map<unsigned int, RootHandler::HistogramHandle *> RootHandler::handleList_; //!< The handles that we've given out.
+mutex RootHandler::fileMutex_; //!< Held while histogramFile_ or its list of histograms is changed or written
+thread RootHandler::writer_; //!< The thread that writes the histogram snapshots to histogramFile_
+mutex RootHandler::writerMutex_; //!< Protects snapshots_, isWriting_ and stopWriter_
+condition_variable RootHandler::writerCondition_; //!< Wakes the writer
+vector<TH1 *> RootHandler::snapshots_; //!< The snapshots waiting for the writer
+bool RootHandler::isWriting_ = false; //!< True while the writer is writing snapshots
+bool RootHandler::stopWriter_ = false; //!< Tells the writer to exit
+vector<RootHandler::HistogramShard *> RootHandler::shards_; //!< Every shard that's been attached.
+mutex RootHandler::shardMutex_; //!< Protects shards_ and the creation of the shard histograms.
+thread_local RootHandler::HistogramShard *RootHandler::threadShard_ = nullptr; //!< The shard of the calling thread.
 
 RootHandler *RootHandler::get() {
     if (!instance_)
@@ -28,21 +42,34 @@ RootHandler *RootHandler::get(const std::string &fileName) {
     return (instance_);
 }
 
+///ROOT is not thread safe by default, so we turn on its internal locking before the writer starts. That doesn't cover
+/// the bookkeeping of a directory, so everything that changes or writes histogramFile_ also takes fileMutex_.
 RootHandler::RootHandler(const std::string &fileName) {
+    ROOT::EnableThreadSafety();
     histogramFile_ = new TFile((fileName+"-hist.root").c_str(), "recreate");
     treeFile_ = new TFile((fileName+"-tree.root").c_str(), "recreate");
+
+    stopWriter_ = isWriting_ = false;
+    writer_ = thread(WriteSnapshots);
 }
 
+///The writer finishes the last flush before we write the final version of every histogram. Writing the file writes
+/// every histogram that's attached to it once, so histograms that were emptied by Reset still replace anything that a
+/// flush wrote before the reset.
 RootHandler::~RootHandler() {
+    {
+        lock_guard<mutex> lock(writerMutex_);
+        stopWriter_ = true;
+    }
+    writerCondition_.notify_one();
+    if (writer_.joinable())
+        writer_.join();
+
     if(histogramFile_) {
-        while(!flushMutex_.try_lock())
-            usleep(1000000);
+        ApplyFills();
+        MergeShards();
 
         histogramFile_->cd();
-        for(const auto &hist : histogramList_)
-            if(hist.second->GetEntries() > 0)
-                hist.second->Write(nullptr, TObject::kWriteDelete);
-
         histogramFile_->Write(nullptr, TObject::kWriteDelete);
         histogramFile_->Close();
         delete histogramFile_;
@@ -55,19 +82,39 @@ RootHandler::~RootHandler() {
         delete treeFile_;
     }
 
+    for (auto shard : shards_) {
+        for (auto &hist : shard->histograms)
+            delete hist.second;
+        delete shard;
+    }
+    shards_.clear();
+
+    for (auto &handle : handleList_)
+        delete handle.second;
+    handleList_.clear();
+
     instance_ = nullptr;
 }
 
 TH1D *RootHandler::Get1DHistogram(const unsigned int &id) {
-    return dynamic_cast<TH1D*>(GetHistogramFromList(id, "Get1DHistogram"));
+    return dynamic_cast<TH1D*>(HandOutHistogram(id, "Get1DHistogram"));
 }
 
 TH2D *RootHandler::Get2DHistogram(const unsigned int &id) {
-    return dynamic_cast<TH2D*>(GetHistogramFromList(id, "Get2DHistogram"));
+    return dynamic_cast<TH2D*>(HandOutHistogram(id, "Get2DHistogram"));
 }
 
 TH3D *RootHandler::Get3DHistogram(const unsigned int &id) {
-    return dynamic_cast<TH3D*>(GetHistogramFromList(id, "Get2DHistogram"));
+    return dynamic_cast<TH3D*>(HandOutHistogram(id, "Get3DHistogram"));
+}
+
+///We can't see what the caller does with the histogram, so we assume that it's going to change.
+TH1 *RootHandler::HandOutHistogram(const unsigned int &id, const std::string &callingFunctionName) {
+    GetHistogramFromList(id, callingFunctionName);
+    HistogramHandle *handle = GetHandle(id);
+    ApplyFills(*handle);
+    handle->dirty = true;
+    return handle->histogram;
 }
 
 void RootHandler::RegisterBranch(const std::string &treeName, const std::string &name, void *address, const std::string &leaflist) {
@@ -89,15 +136,98 @@ TTree *RootHandler::RegisterTree(const std::string &name, const std::string &des
 }
 
 bool RootHandler::Plot(const unsigned int &id, const double &xval, const double &yval/*=-1*/, const double &zval/*=-1*/) {
-    TH1 *histogram = nullptr;
     try {
-        histogram = GetHistogramFromList(id, "Plot");
+        //Threads with a shard can't create handles, so they go straight to the histogram.
+        if (threadShard_) {
+            TH1 *histogram = GetHistogramFromList(id, "Plot");
+            lock_guard<mutex> lock(threadShard_->mutex);
+            Fill(GetShardHistogram(threadShard_, id, histogram), xval, yval, zval);
+            return true;
+        }
+        return Plot(*GetHandle(id), xval, yval, zval);
     } catch(invalid_argument &invalidArgument) {
         ///@TODO Really we want to rethrow here, but for now we're just going to emulate what happened with DAMM. We
         /// just silently ignored any Plot request to an unknown histogram id.
         return false;
     }
+}
+
+///Fills that don't match the dimension of the histogram (ex. a weight for a 1D histogram) aren't buffered, they take
+/// the same path that they always have.
+bool RootHandler::Plot(HistogramHandle &handle, const double &xval, const double &yval/*=-1*/,
+                       const double &zval/*=-1*/) {
+    if (threadShard_) {
+        lock_guard<mutex> lock(threadShard_->mutex);
+        Fill(GetShardHistogram(threadShard_, handle.id, handle.histogram), xval, yval, zval);
+        return true;
+    }
+
+    bool hasYval = yval != -1;
+    bool hasZval = zval != -1;
+    if (handle.dimension == 1 && !hasYval && !hasZval) {
+        handle.xvals.push_back(xval);
+    } else if (handle.dimension == 2 && hasYval != hasZval) {
+        handle.xvals.push_back(xval);
+        handle.yvals.push_back(hasYval ? yval : zval);
+    } else if (handle.dimension == 3 && hasYval && hasZval) {
+        handle.xvals.push_back(xval);
+        handle.yvals.push_back(yval);
+        handle.zvals.push_back(zval);
+    } else {
+        Fill(handle.histogram, xval, yval, zval);
+        handle.dirty = true;
+        return true;
+    }
+
+    if (handle.xvals.size() >= fillBufferSize)
+        ApplyFills(handle);
+    return true;
+}
+
+RootHandler::HistogramHandle *RootHandler::GetHandle(const unsigned int &id) {
+    auto handle = handleList_.find(id);
+    if (handle != handleList_.end())
+        return handle->second;
+
+    HistogramHandle *pTempHandle = new HistogramHandle();
+    pTempHandle->id = id;
+    pTempHandle->histogram = GetHistogramFromList(id, "GetHandle");
+    pTempHandle->dimension = pTempHandle->histogram->GetDimension();
+    pTempHandle->dirty = false;
+    pTempHandle->xvals.reserve(fillBufferSize);
+    if (pTempHandle->dimension > 1)
+        pTempHandle->yvals.reserve(fillBufferSize);
+    if (pTempHandle->dimension > 2)
+        pTempHandle->zvals.reserve(fillBufferSize);
+    return handleList_.emplace(make_pair(id, pTempHandle)).first->second;
+}
+
+void RootHandler::ApplyFills() {
+    for (auto &handle : handleList_)
+        ApplyFills(*handle.second);
+}
+
+///ROOT doesn't provide a bulk fill for 3D histograms, so those are filled one at a time.
+void RootHandler::ApplyFills(HistogramHandle &handle) {
+    if (handle.xvals.empty())
+        return;
+
+    if (handle.dimension == 1)
+        handle.histogram->FillN(handle.xvals.size(), handle.xvals.data(), nullptr);
+    else if (handle.dimension == 2)
+        static_cast<TH2 *>(handle.histogram)->FillN(handle.xvals.size(), handle.xvals.data(), handle.yvals.data(),
+                                                    nullptr);
+    else
+        for (size_t i = 0; i < handle.xvals.size(); i++)
+            static_cast<TH3 *>(handle.histogram)->Fill(handle.xvals[i], handle.yvals[i], handle.zvals[i]);
+
+    handle.xvals.clear();
+    handle.yvals.clear();
+    handle.zvals.clear();
+    handle.dirty = true;
+}
 
+void RootHandler::Fill(TH1 *histogram, const double &xval, const double &yval, const double &zval) {
     bool hasYval = yval != -1;
     bool hasZval = zval != -1;
     if(!hasYval && !hasZval)
@@ -108,7 +238,77 @@ bool RootHandler::Plot(const unsigned int &id, const double &xval, const double
         dynamic_cast<TH2D*>(histogram)->Fill(xval, zval);
     if(hasYval && hasZval)
         dynamic_cast<TH3D*>(histogram)->Fill(xval, yval, zval);
-    return true;
+}
+
+///The copies are detached from the file so that only the merged histograms get written.
+void RootHandler::AttachShard() {
+    if (threadShard_)
+        return;
+
+    lock_guard<mutex> lock(shardMutex_);
+    threadShard_ = new HistogramShard();
+    shards_.push_back(threadShard_);
+}
+
+TH1 *RootHandler::GetShardHistogram(HistogramShard *shard, const unsigned int &id, TH1 *histogram) {
+    auto copy = shard->histograms.find(id);
+    if (copy != shard->histograms.end())
+        return copy->second;
+
+    lock_guard<mutex> lock(shardMutex_);
+    TH1 *pTempHistogram = Detach(histogram);
+    pTempHistogram->Reset();
+    return shard->histograms.emplace(make_pair(id, pTempHistogram)).first->second;
+}
+
+///The histograms are only ever created on one thread at a time, so turning off ROOT's directory registration for the
+/// copy doesn't affect anybody else.
+TH1 *RootHandler::Detach(const TH1 *histogram) {
+    lock_guard<mutex> lock(fileMutex_);
+    bool addDirectory = TH1::AddDirectoryStatus();
+    TH1::AddDirectory(false);
+    TH1 *pTempHistogram = dynamic_cast<TH1 *>(histogram->Clone());
+    TH1::AddDirectory(addDirectory);
+    return pTempHistogram;
+}
+
+void RootHandler::MergeShards() {
+    lock_guard<mutex> lock(shardMutex_);
+    for (auto shard : shards_) {
+        lock_guard<mutex> shardLock(shard->mutex);
+        for (auto &hist : shard->histograms) {
+            if (hist.second->GetEntries() == 0)
+                continue;
+            HistogramHandle *handle = GetHandle(hist.first);
+            handle->histogram->Add(hist.second);
+            handle->dirty = true;
+            hist.second->Reset();
+        }
+    }
+}
+
+void RootHandler::Reset() {
+    for (auto &handle : handleList_) {
+        handle.second->xvals.clear();
+        handle.second->yvals.clear();
+        handle.second->zvals.clear();
+        handle.second->dirty = true;
+    }
+
+    for (auto &hist : histogramList_)
+        hist.second->Reset();
+
+    {
+        lock_guard<mutex> lock(shardMutex_);
+        for (auto shard : shards_) {
+            lock_guard<mutex> shardLock(shard->mutex);
+            for (auto &hist : shard->histograms)
+                hist.second->Reset();
+        }
+    }
+
+    for (const auto &tree : treeList_)
+        tree.second->Reset();
 }
 
 ///@TODO Update this so that we're being a little more flexible with our histogramming. At the moment, I'm wanting to
@@ -119,6 +319,10 @@ TH1 *RootHandler::RegisterHistogram(const unsigned int &id, const std::string &t
     if (histogram != histogramList_.end())
         return histogram->second;
 
+    //The histogram is attached to histogramFile_ by hand, it must not land in whatever directory is current.
+    lock_guard<mutex> lock(fileMutex_);
+    bool addDirectory = TH1::AddDirectoryStatus();
+    TH1::AddDirectory(false);
     TH1 *pTempHistogram = nullptr;
 
     if (!yBins && !zBins)
@@ -130,27 +334,72 @@ TH1 *RootHandler::RegisterHistogram(const unsigned int &id, const std::string &t
     else
         pTempHistogram = histogramList_.emplace(make_pair(id, new TH3D(("h"+to_string(id)).c_str(), title.c_str(), xBins, 0, xBins, yBins, 0, yBins, zBins, 0, zBins))).first->second;
 
+    TH1::AddDirectory(addDirectory);
     pTempHistogram->SetDirectory(histogramFile_);
     return pTempHistogram;
 }
 
-void RootHandler::AsyncFlush() {
-    for(const auto &hist : histogramList_) {
-        histogramFile_->cd();
-        if(hist.second->GetEntries() > 0)
-            hist.second->Write(nullptr, TObject::kWriteDelete);
+///The snapshots are detached from the file, so the writer owns them outright. The histograms that we're filling
+/// are never touched by the writer. Each snapshot is written under fileMutex_ so that the file's list of keys and
+/// histograms isn't changed while it's being written.
+void RootHandler::WriteSnapshots() {
+    vector<TH1 *> snapshots;
+    unique_lock<mutex> lock(writerMutex_);
+    while (true) {
+        writerCondition_.wait(lock, [] { return stopWriter_ || !snapshots_.empty(); });
+        if (snapshots_.empty())
+            return;
+
+        snapshots.swap(snapshots_);
+        isWriting_ = true;
+        lock.unlock();
+
+        for (auto snapshot : snapshots) {
+            {
+                lock_guard<mutex> fileLock(fileMutex_);
+                histogramFile_->cd();
+                snapshot->Write(nullptr, TObject::kWriteDelete);
+            }
+            delete snapshot;
+        }
+        snapshots.clear();
+
+        lock.lock();
+        isWriting_ = false;
     }
-    flushMutex_.unlock();
 }
 
+///Only the calling thread touches the histograms and the dirty flags, so the snapshots are taken without holding the
+/// writer's lock.
 void RootHandler::Flush() {
     for(const auto &tree : treeList_)
         tree.second->AutoSave("overwrite");
 
-    if(flushMutex_.try_lock()) {
-        thread worker0(AsyncFlush);
-        worker0.detach();
+    ApplyFills();
+    MergeShards();
+
+    {
+        lock_guard<mutex> lock(writerMutex_);
+        if (isWriting_ || !snapshots_.empty())
+            return;
+    }
+
+    vector<TH1 *> snapshots;
+    for (auto &handle : handleList_) {
+        if (!handle.second->dirty)
+            continue;
+        snapshots.push_back(Detach(handle.second->histogram));
+        handle.second->dirty = false;
+    }
+
+    if (snapshots.empty())
+        return;
+
+    {
+        lock_guard<mutex> lock(writerMutex_);
+        snapshots_.swap(snapshots);
     }
+    writerCondition_.notify_one();
 }
 
 TH1 *RootHandler::GetHistogramFromList(const unsigned int &id, const std::string &callingFunctionName) {
@@ -0,0 +1,282 @@
+///@file TraceResultCache.cpp
+///@brief Keeps the results of the trace analysis in a file so that replays of a run can skip the trace analyzers.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include "TraceResultCache.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+    const unsigned int cacheMagic = 0x43435254; // "TRCC"
+    const unsigned int cacheVersion = 2;
+    const unsigned long long hashPrime = 1099511628211ULL;
+
+    ///Adds the bytes of a value to an FNV-1a hash.
+    template<typename T>
+    unsigned long long HashValue(const T &value, unsigned long long hash) {
+        const unsigned char *bytes = (const unsigned char *) &value;
+        for (size_t i = 0; i < sizeof(T); i++)
+            hash = (hash ^ bytes[i]) * hashPrime;
+        return hash;
+    }
+
+    template<typename T>
+    void WriteValue(ofstream &file, const T &value) {
+        file.write((const char *) &value, sizeof(T));
+    }
+
+    template<typename T>
+    bool ReadValue(ifstream &file, T &value) {
+        return (bool) file.read((char *) &value, sizeof(T));
+    }
+
+    template<typename T>
+    void WriteVector(ofstream &file, const vector<T> &values) {
+        unsigned int size = (unsigned int) values.size();
+        WriteValue(file, size);
+        if (size != 0)
+            file.write((const char *) values.data(), size * sizeof(T));
+    }
+
+    template<typename T>
+    bool ReadVector(ifstream &file, vector<T> &values) {
+        unsigned int size;
+        if (!ReadValue(file, size))
+            return false;
+        values.resize(size);
+        return size == 0 || (bool) file.read((char *) values.data(), size * sizeof(T));
+    }
+
+    void WriteResult(ofstream &file, const unsigned long long &key, const TraceResult &result) {
+        unsigned char flags = (unsigned char) ((result.hasValidAnalysis ? 0x1 : 0) | (result.isSaturated ? 0x2 : 0) |
+                                               (result.hasTraceSansBaseline ? 0x4 : 0));
+        WriteValue(file, key);
+        WriteValue(file, result.rawEnergy);
+        WriteValue(file, result.traceLength);
+        WriteValue(file, flags);
+        WriteValue(file, result.phase);
+        WriteValue(file, result.qdc);
+        WriteValue(file, result.tailRatio);
+        WriteValue(file, result.tau);
+        WriteValue(file, result.baseline.first);
+        WriteValue(file, result.baseline.second);
+        WriteValue(file, result.max.first);
+        WriteValue(file, result.max.second);
+        WriteValue(file, result.extrapolatedMax.first);
+        WriteValue(file, result.extrapolatedMax.second);
+        WriteValue(file, result.waveformRange.first);
+        WriteValue(file, result.waveformRange.second);
+    }
+
+    bool ReadResult(ifstream &file, unsigned long long &key, TraceResult &result) {
+        unsigned char flags = 0;
+        bool good = ReadValue(file, key) && ReadValue(file, result.rawEnergy) && ReadValue(file, result.traceLength)
+                    && ReadValue(file, flags) && ReadValue(file, result.phase) && ReadValue(file, result.qdc)
+                    && ReadValue(file, result.tailRatio) && ReadValue(file, result.tau)
+                    && ReadValue(file, result.baseline.first) && ReadValue(file, result.baseline.second)
+                    && ReadValue(file, result.max.first) && ReadValue(file, result.max.second)
+                    && ReadValue(file, result.extrapolatedMax.first) && ReadValue(file, result.extrapolatedMax.second)
+                    && ReadValue(file, result.waveformRange.first) && ReadValue(file, result.waveformRange.second);
+        result.hasValidAnalysis = (flags & 0x1) != 0;
+        result.isSaturated = (flags & 0x2) != 0;
+        result.hasTraceSansBaseline = (flags & 0x4) != 0;
+        return good;
+    }
+}
+
+const unsigned long long TraceResultCache::hashSeed;
+
+TraceResult::TraceResult() : rawEnergy(0), traceLength(0), hasValidAnalysis(false), isSaturated(false),
+                             hasTraceSansBaseline(false), phase(0), qdc(0), tailRatio(0), tau(0), baseline(0, 0),
+                             max(0, 0), extrapolatedMax(0, 0), waveformRange(0, 0) {}
+
+void TraceResult::Store(const Trace &trace, const double &energy) {
+    rawEnergy = energy;
+    traceLength = (unsigned int) trace.size();
+    hasValidAnalysis = trace.HasValidAnalysis();
+    isSaturated = trace.IsSaturated();
+    hasTraceSansBaseline = !trace.GetTraceSansBaseline().empty();
+    phase = trace.GetPhase();
+    qdc = trace.GetQdc();
+    tailRatio = trace.GetTailRatio();
+    tau = trace.GetTau();
+    baseline = trace.GetBaselineInfo();
+    max = trace.GetMaxInfo();
+    extrapolatedMax = trace.GetExtrapolatedMaxInfo();
+    waveformRange = trace.GetWaveformRange();
+}
+
+///The waveform range is set after the baseline subtracted trace so that the waveform is cut from the new samples.
+void TraceResult::Restore(Trace &trace) const {
+    trace.SetHasValidAnalysis(hasValidAnalysis);
+    trace.SetIsSaturated(isSaturated);
+    trace.SetPhase(phase);
+    trace.SetQdc(qdc);
+    trace.SetTailRatio(tailRatio);
+    trace.SetTau(tau);
+    trace.SetBaseline(baseline);
+    trace.SetMax(max);
+    trace.SetExtrapolatedMax(extrapolatedMax);
+    if (hasTraceSansBaseline)
+        trace.CalculateTraceSansBaseline(baseline.first);
+    trace.SetWaveformRange(waveformRange);
+}
+
+TraceResultCache::TraceResultCache() : analyzerHash_(0), numDropped_(0), numRestored_(0) {}
+
+unsigned long long TraceResultCache::Hash(const std::string &text, const unsigned long long &seed) {
+    unsigned long long hash = seed;
+    for (string::const_iterator it = text.begin(); it != text.end(); it++)
+        hash = HashValue(*it, hash);
+    //The length keeps "ab" + "c" from hashing the same as "a" + "bc".
+    return HashValue(text.size(), hash);
+}
+
+unsigned long long TraceResultCache::Hash(const double &value, const unsigned long long &seed) {
+    return HashValue(value, seed);
+}
+
+///The end of every node is marked so that a child can't be mistaken for a sibling that follows it.
+unsigned long long TraceResultCache::Hash(const pugi::xml_node &node, const unsigned long long &seed) {
+    unsigned long long hash = Hash(node.value(), Hash(node.name(), HashValue((int) node.type(), seed)));
+    for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
+        hash = Hash(attr.value(), Hash(attr.name(), hash));
+    for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+        hash = Hash(child, hash);
+    return HashValue(0, hash);
+}
+
+///The location and the place name don't change how a trace is analyzed, so they're left out.
+unsigned long long TraceResultCache::Hash(const ChannelConfiguration &cfg) {
+    unsigned long long hash = Hash(cfg.GetSubtype(), Hash(cfg.GetType()));
+    set<string> tags = cfg.GetTags();
+    for (set<string>::const_iterator it = tags.begin(); it != tags.end(); it++)
+        hash = Hash(*it, hash);
+
+    hash = HashValue(cfg.GetBaselineThreshold(), hash);
+    hash = HashValue(cfg.GetDiscriminationStartInSamples(), hash);
+    hash = HashValue(cfg.GetTraceDelayInSamples(), hash);
+    hash = HashValue(cfg.GetWaveformBoundsInSamples().first, hash);
+    hash = HashValue(cfg.GetWaveformBoundsInSamples().second, hash);
+
+    TrapFilterParameters filters[2] = {cfg.GetTriggerFilterParameters(), cfg.GetEnergyFilterParameters()};
+    for (unsigned int i = 0; i < 2; i++) {
+        hash = HashValue(filters[i].GetRisetime(), hash);
+        hash = HashValue(filters[i].GetFlattop(), hash);
+        hash = HashValue(filters[i].GetT(), hash);
+    }
+
+    TimingConfiguration timing = cfg.GetTimingConfiguration();
+    hash = HashValue(timing.GetBeta(), hash);
+    hash = HashValue(timing.GetGamma(), hash);
+    hash = HashValue(timing.GetFraction(), hash);
+    hash = HashValue(timing.GetDelay(), hash);
+    hash = HashValue(timing.GetGap(), hash);
+    hash = HashValue(timing.GetLength(), hash);
+    return HashValue(timing.IsFastSiPm(), hash);
+}
+
+bool TraceResultCache::Open(const std::string &filename, const unsigned long long &analyzerHash,
+                            const std::vector<unsigned long long> &channelHashes) {
+    filename_ = filename;
+    analyzerHash_ = analyzerHash;
+    channelHashes_ = channelHashes;
+    loaded_.clear();
+    added_.clear();
+    numDropped_ = 0;
+    numRestored_ = 0;
+
+    ifstream file(filename.c_str(), ios::binary);
+    if (!file.is_open()) {
+        cout << "TraceResultCache::Open - " << filename << " doesn't exist yet, it will be created." << endl;
+        return true;
+    }
+
+    unsigned int magic = 0, version = 0;
+    unsigned long long fileAnalyzerHash = 0;
+    vector<unsigned long long> fileChannelHashes;
+    if (!ReadValue(file, magic) || !ReadValue(file, version) || magic != cacheMagic || version != cacheVersion ||
+        !ReadValue(file, fileAnalyzerHash) || !ReadVector(file, fileChannelHashes)) {
+        cout << "TraceResultCache::Open - " << filename << " is not a trace cache we know how to read." << endl;
+        filename_.clear();
+        return false;
+    }
+
+    //Any change to the analyzers can change every result, so we start over.
+    bool analyzersMatch = fileAnalyzerHash == analyzerHash_;
+    unsigned long long key;
+    TraceResult result;
+    while (ReadResult(file, key, result)) {
+        unsigned int id = (unsigned int) (key >> 48);
+        if (analyzersMatch && id < channelHashes_.size() && id < fileChannelHashes.size() &&
+            channelHashes_[id] == fileChannelHashes[id])
+            loaded_.insert(make_pair(key, result));
+        else
+            numDropped_++;
+    }
+
+    cout << "TraceResultCache::Open - Loaded " << loaded_.size() << " results from " << filename << ", "
+         << numDropped_ << " were made with different settings and will be recalculated." << endl;
+    return true;
+}
+
+bool TraceResultCache::Restore(const unsigned int &id, const double &timestamp, const double &rawEnergy,
+                               Trace &trace) {
+    auto found = loaded_.find(MakeKey(id, timestamp));
+    if (found == loaded_.end() || found->second.rawEnergy != rawEnergy || found->second.traceLength != trace.size())
+        return false;
+    found->second.Restore(trace);
+    numRestored_++;
+    return true;
+}
+
+void TraceResultCache::Store(const unsigned int &id, const double &timestamp, const double &rawEnergy,
+                             const Trace &trace) {
+    TraceResult result;
+    result.Store(trace, rawEnergy);
+    lock_guard<mutex> lock(addedMutex_);
+    added_[MakeKey(id, timestamp)] = result;
+}
+
+void TraceResultCache::Close() {
+    if (!IsOpen())
+        return;
+
+    cout << "TraceResultCache::Close - Restored " << numRestored_ << " traces from the cache and analyzed "
+         << added_.size() << " new ones." << endl;
+    if ((!added_.empty() || numDropped_ != 0) && !Write())
+        cout << "TraceResultCache::Close - Unable to write " << filename_ << ", the new results are lost." << endl;
+
+    filename_.clear();
+    loaded_.clear();
+    added_.clear();
+}
+
+///We write to a temporary file first so that a scan that dies part way through doesn't ruin the cache.
+bool TraceResultCache::Write() const {
+    string temporary = filename_ + ".tmp";
+    ofstream file(temporary.c_str(), ios::binary | ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    WriteValue(file, cacheMagic);
+    WriteValue(file, cacheVersion);
+    WriteValue(file, analyzerHash_);
+    WriteVector(file, channelHashes_);
+    for (auto it = loaded_.begin(); it != loaded_.end(); it++)
+        if (added_.find(it->first) == added_.end())
+            WriteResult(file, it->first, it->second);
+    for (auto it = added_.begin(); it != added_.end(); it++)
+        WriteResult(file, it->first, it->second);
+
+    file.close();
+    if (!file.good()) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return rename(temporary.c_str(), filename_.c_str()) == 0;
+}
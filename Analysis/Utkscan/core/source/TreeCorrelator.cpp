@@ -5,6 +5,8 @@
  * \author K. A. Miernik
  * \date August 19, 2012
  */
+#include <algorithm>
+
 #include "PaassExceptions.hpp"
 #include "Globals.hpp"
 #include "Messenger.hpp"
@@ -67,6 +69,8 @@ void TreeCorrelator::createPlace(std::map<std::string, std::string> &params, boo
                        << ", it doesn't exist";
                     throw TreeCorrelatorException(ss.str());
                 }
+                activePlaces_.erase(remove(activePlaces_.begin(), activePlaces_.end(), places_[(*it)]),
+                                    activePlaces_.end());
                 delete places_[(*it)];
                 if (verbose) {
                     Messenger m;
@@ -88,6 +92,7 @@ void TreeCorrelator::createPlace(std::map<std::string, std::string> &params, boo
                 }
             }
             Place *current = builder.create(params, verbose);
+            current->setActiveList(&activePlaces_);
             places_[(*it)] = current;
             if (StringToBool(params["init"]))
                 current->activate(0.0);
@@ -110,6 +115,12 @@ void TreeCorrelator::buildTree() {
     m.done();
 }
 
+void TreeCorrelator::resetPlaces() {
+    for (vector<Place *>::iterator it = activePlaces_.begin(); it != activePlaces_.end(); ++it)
+        (*it)->reset();
+    activePlaces_.clear();
+}
+
 vector<string> TreeCorrelator::split_names(std::string name) {
     vector<string> names;
     vector<string> name_tokens = TokenizeString(name, "_");
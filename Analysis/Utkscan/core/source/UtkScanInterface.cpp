@@ -7,6 +7,7 @@
 
 #include "DetectorDriver.hpp"
 #include "Display.h"
+#include "EventProcessor.hpp"
 #include "RootHandler.hpp"
 #include "TreeCorrelator.hpp"
 #include "UtkScanInterface.hpp"
@@ -16,7 +17,7 @@
 using namespace std;
 
 /// Default constructor.
-UtkScanInterface::UtkScanInterface() : ScanInterface() {}
+UtkScanInterface::UtkScanInterface() : ScanInterface(), isReplayWorker_(false), sequentialOnly_(false) {}
 
 /// Destructor.
 UtkScanInterface::~UtkScanInterface() {
@@ -45,6 +46,13 @@ bool UtkScanInterface::Initialize(string prefix_) {
     }
 
     unpacker_->SetEventWidth(Globals::get()->GetEventLengthInTicks());
+
+    //The Unpacker skips the spills inside the rejection regions before they're decoded.
+    IntervalIndex rejectionRegions;
+    for (const auto &region : Globals::get()->GetRejectionRegions())
+        rejectionRegions.Add(region.first, region.second);
+    unpacker_->SetRejectionRegions(rejectionRegions, Globals::get()->GetClockInSeconds());
+
     Globals::get()->SetOutputFilename(GetOutputFilename());
     Globals::get()->SetOutputPath(GetOutputPath());
     RootHandler::get(GetOutputPath() + GetOutputFilename());
@@ -63,12 +71,72 @@ bool UtkScanInterface::Initialize(string prefix_) {
          *  calibration and walk correction factors.
          */
         DetectorDriver::get()->DeclarePlots();
+
+        //The hits and traces that nobody uses are skipped while decoding, so the filter has to be set before the
+        // first spill is read.
+        unpacker_->SetChannelFilter(DetectorDriver::get()->GetChannelFilter());
+
+        if (!traceCacheFilename_.empty() && !DetectorDriver::get()->OpenTraceCache(traceCacheFilename_))
+            throw invalid_argument("UtkScanInterface::Initialize - Unable to use " + traceCacheFilename_
+                                   + " as the trace cache.");
     } catch (exception &e) {
         cout << Display::ErrorStr(
                 prefix_ + "Exception caught at UtkScanInterface::Initialize")
              << endl;
         throw;
     }
+
+    //Starting part way through the run breaks processors that keep state for the whole run. That's fatal for the
+    // replay workers, the parent will scan the run in order instead.
+    if (isReplayWorker_ || IsStartingPartWay()) {
+        for (const auto &processor : DetectorDriver::get()->GetProcessors()) {
+            if (!processor->IsSequentialOnly())
+                continue;
+            if (isReplayWorker_) {
+                cout << Display::ErrorStr(prefix_ + "UtkScanInterface::Initialize - The " + processor->GetName()
+                                          + " processor needs the run to be scanned in order.") << endl;
+                sequentialOnly_ = true;
+                return false;
+            }
+            cout << Display::WarningStr(prefix_ + "UtkScanInterface::Initialize - The " + processor->GetName()
+                                        + " processor keeps state for the whole run, its results will be "
+                                                "incomplete since we don't start at the beginning.") << endl;
+        }
+    }
 #endif
     return (scan_init = true);
+}
+
+void UtkScanInterface::ArgHelp() {
+    AddOption(optionExt("workers", required_argument, NULL, 0, "<number>",
+                        "Split the run into this many pieces using its spill index, scan them in parallel and "
+                                "merge the histograms. Each piece is warmed up with the spills before it."));
+    AddOption(optionExt("replay-worker", no_argument, NULL, 0, "", "Set on the processes started by --workers"));
+    AddOption(optionExt("trace-cache", required_argument, NULL, 0, "<filename>",
+                        "Keep the results of the trace analysis in this file. Later scans of the same run restore "
+                                "them instead of analyzing the traces again."));
+}
+
+///The number of workers is read by ParallelReplay before we get here, we only need to know if we're one of them.
+void UtkScanInterface::ExtraArguments() {
+    isReplayWorker_ = GetUserOption("replay-worker").active;
+    const optionExt &traceCache = GetUserOption("trace-cache");
+    if (traceCache.active)
+        traceCacheFilename_ = traceCache.argument;
+}
+
+///The unpacker has processed every warm-up event by the time that we're notified, but the event threads may still
+/// be working on some of them, so they're drained before the output is reset.
+void UtkScanInterface::Notify(const std::string &code_) {
+    if (code_ != "WARMUP_DONE")
+        return;
+
+    DetectorDriver *driver = DetectorDriver::get();
+    if (driver->IsEventParallel()) {
+        driver->StopEventThreads();
+        driver->StartEventThreads(Globals::get()->GetNumberOfEventThreads());
+    }
+
+    RootHandler::get()->Reset();
+    cout << "UtkScanInterface::Notify - Finished the warm-up spills, their output has been dropped." << endl;
 }
\ No newline at end of file
@@ -5,16 +5,21 @@
 ///@date June 17, 2016
 #include "UtkUnpacker.hpp"
 
+#include "ChanEventPool.hpp"
 #include "DammPlotIds.hpp"
 #include "Places.hpp"
 #include "TreeCorrelator.hpp"
 #include "UtkScanInterface.hpp"
 
+#include <stdexcept>
+
 using namespace std;
 using namespace dammIds::raw;
 
+///We decode into the pool since every hit is handed to a ChanEvent before the end of the spill. This saves us from
+/// allocating and freeing memory for every hit, and the ChanEvent swaps its old storage back into the pool.
 UtkUnpacker::UtkUnpacker()  : Unpacker() {
-    ///Does nothing at all
+    SetPooledDecoding(true);
 }
 
 ///The only thing that we do here is call the destructor of the
@@ -23,6 +28,8 @@ UtkUnpacker::UtkUnpacker()  : Unpacker() {
 /// the amount of time spent in each processor is output to the screen at the
 /// end of execution.
 UtkUnpacker::~UtkUnpacker() {
+    //The consumer thread uses the DetectorDriver, so it has to finish before we delete it.
+    StopPipeline();
     if(driver_)
         delete DetectorDriver::get();
 }
@@ -44,11 +51,11 @@ void UtkUnpacker::ProcessRawEvent() {
     static RawEvent rawev;
     static Messenger m;
     static stringstream ss;
-    static set<string> usedDetectors;
 
     ///@TODO This should be dependent on the module configuration that's specified in the config. This is
     /// dependent on the Revision node in the configuration file. This will not work properly for mixed module systems.
     static const auto pixieClockInSeconds = Globals::get()->GetClockInSeconds();
+    static const auto flushIntervalInSeconds = Globals::get()->GetFlushIntervalInSeconds();
 
     if(eventCounter == 0) {
         driver_ = DetectorDriver::get();
@@ -58,31 +65,22 @@ void UtkUnpacker::ProcessRawEvent() {
         lastFlushTime = chrono::steady_clock::now();
     }
 
+    static const unsigned int ignoreTypeId = detectorLibrary_->GetTypeId("ignore");
+
     processingTime = chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - systemStartTime);
     ///@TODO Add a verbosity flag here to hide this information if the user wishes it.
     if (eventCounter % 100000 == 0 || eventCounter == 1) {
         PrintProcessingTimeInformation(GetEventStartTime(), eventCounter, processingTime);
     }
 
-    if(chrono::duration_cast<chrono::duration<int>>(chrono::steady_clock::now() - lastFlushTime).count() == 2) {
+    if(flushIntervalInSeconds > 0 &&
+       chrono::duration<double>(chrono::steady_clock::now() - lastFlushTime).count() >= flushIntervalInSeconds) {
         RootHandler::get()->Flush();
         lastFlushTime = chrono::steady_clock::now();
     }
 
     eventCounter++;
 
-    if (Globals::get()->HasRejectionRegion()) {
-        double eventTime = (GetEventStartTime() - GetFirstTime()) * pixieClockInSeconds;
-        vector <pair<unsigned int, unsigned int>> rejectRegions = Globals::get()->GetRejectionRegions();
-
-        for (vector<pair<unsigned int, unsigned int> >::iterator region = rejectRegions.begin();
-             region != rejectRegions.end(); ++region)
-            if (eventTime > region->first && eventTime < region->second)
-                return;
-    }
-
-    ///@TODO : Need to figure out why the plot command is so obnoxiously slow. I'm commenting these out for now until
-    /// we can figure out the issues. These histograms are not used very often anyway.
     static double lastTimeOfPreviousEvent;
     static const auto pixieClockInNanoseconds = pixieClockInSeconds * 1e9;
     driver_->histo_.Plot(D_EVENT_GAP, (GetRealStopTime() - lastTimeOfPreviousEvent) * pixieClockInNanoseconds);
@@ -91,6 +89,10 @@ void UtkUnpacker::ProcessRawEvent() {
     driver_->histo_.Plot(D_EVENT_MULTIPLICITY, rawEvent.size());
     lastTimeOfPreviousEvent = GetRealStopTime();
 
+    //When the driver processes events in parallel we fill one of its events instead of our own. The driver hands
+    // the event back to us once it has been processed.
+    RawEvent *event = driver_->IsEventParallel() ? driver_->AcquireEvent() : &rawev;
+
     //loop over the list of channels that fired in this event
     for (deque<XiaData *>::iterator it = rawEvent.begin(); it != rawEvent.end(); it++) {
 
@@ -107,31 +109,34 @@ void UtkUnpacker::ProcessRawEvent() {
         }
 
         ///@TODO this will fail if the user does not define enough modules in the map. Related to pixie16/paass:#103
-        if (detectorLibrary_->at((*it)->GetId()).GetType() == "ignore")
+        const ChannelDescriptor *descriptor = detectorLibrary_->GetDescriptor((*it)->GetId());
+        if (!descriptor)
+            throw out_of_range("UtkUnpacker::ProcessRawEvent - Channel " + to_string((*it)->GetId())
+                               + " is not defined in the map.");
+        if (descriptor->typeId == ignoreTypeId)
             continue;
 
-        ///@TODO we need to ensure that all of the memory is getting freed
-        /// appropriately at the end of processing an event. I'm not sure
-        /// that it is right now.
-        ChanEvent *event = new ChanEvent(*(*it));
-
-        ///@TODO This will also fail if the user doesn't define enough modules in the map. Related to pixie16/paass:#103
-        usedDetectors.insert((*detectorLibrary_)[(*it)->GetId()].GetType());
-        rawev.AddChan(event);
+        //The channel takes the hit's trace and vectors instead of copying them, and goes back to the pool when the
+        // event is zeroed.
+        ChanEvent *chan = ChanEventPool::get()->Acquire();
+        chan->Adopt(*(*it));
+        event->AddChan(chan);
 
         ///@TODO Add back in the processing for the dtime.
     }//for(deque<PixieData*>::iterator
 
+    if (driver_->IsEventParallel()) {
+        driver_->SubmitEvent(event);
+        return;
+    }
+
     try {
         driver_->ProcessEvent(rawev);
-        rawev.Zero(usedDetectors);
-        usedDetectors.clear();
-
-        ///@TODO I think that this is done twice, it needs to be investigated.
-        for (map<string, Place *>::iterator it = TreeCorrelator::get()->places_.begin();
-             it != TreeCorrelator::get()->places_.end(); ++it)
-            if ((*it).second->resetable())
-                (*it).second->reset();
+        rawev.Zero();
+
+        ///ProcessEvent resets the places as well, this catches the events where a warning stopped it before it got
+        /// there. Only the places that were activated are reset, so the second call doesn't cost anything.
+        TreeCorrelator::get()->resetPlaces();
     } catch (exception &ex) {
         throw;
     }
@@ -189,6 +194,7 @@ void UtkUnpacker::InitializeDriver(DetectorDriver *driver, DetectorLibrary *detl
 
     //detlib->PrintUsedDetectors(rawev);
     driver->Init(rawev);
+    driver->StartEventThreads(Globals::get()->GetNumberOfEventThreads());
 
     try {
         driver->SanityCheck();
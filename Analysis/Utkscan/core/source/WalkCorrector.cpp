@@ -107,7 +107,7 @@ void WalkCorrector::AddChannel(const ChannelConfiguration &chanID, const std::st
     }
 }
 
-double WalkCorrector::GetCorrection(ChannelConfiguration &chanID, double raw) const {
+double WalkCorrector::GetCorrection(const ChannelConfiguration &chanID, double raw) const {
     map < ChannelConfiguration, vector < CorrectionParams > > ::const_iterator itch = channels_.find(chanID);
     if (itch != channels_.end()) {
         vector<CorrectionParams>::const_iterator itf;
@@ -117,42 +117,61 @@ double WalkCorrector::GetCorrection(ChannelConfiguration &chanID, double raw) co
         }
         if (itf == itch->second.end())
             return 0;
+        return EvaluateModel(*itf, raw);
+    }
+    return 0;
+}
 
-        switch (itf->model) {
-            case none:
-                return Model_None();
-                break;
-            case A:
-                return Model_A(itf->parameters, raw);
-                break;
-            case B1:
-                return Model_B1(itf->parameters, raw);
-                break;
-            case B2:
-                return Model_B2(itf->parameters, raw);
-                break;
-            case VS:
-                return Model_VS(itf->parameters, raw);
-                break;
-            case VM:
-                return Model_VM(itf->parameters, raw);
-                break;
-            case VL:
-                return Model_VL(itf->parameters, raw);
-                break;
-            case VD:
-                return Model_VD(itf->parameters, raw);
-                break;
-            case VB:
-                return Model_VB(itf->parameters, raw);
-                break;
-            default:
-                break;
-        }
+void WalkCorrector::Compile(const std::vector<ChannelConfiguration> &channels) {
+    firstCorrection_.assign(1, 0);
+    corrections_.clear();
+
+    for (vector<ChannelConfiguration>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+        map<ChannelConfiguration, vector<CorrectionParams> >::const_iterator itch = channels_.find(*it);
+        if (itch != channels_.end())
+            corrections_.insert(corrections_.end(), itch->second.begin(), itch->second.end());
+        firstCorrection_.push_back(corrections_.size());
     }
+}
+
+double WalkCorrector::Evaluate(const unsigned int &first, const unsigned int &last, double raw) const {
+    for (unsigned int i = first; i < last; i++)
+        if (corrections_[i].min <= raw && raw <= corrections_[i].max)
+            return EvaluateModel(corrections_[i], raw);
     return 0;
 }
 
+void WalkCorrector::GetCorrections(const unsigned int *ids, const double *raw, double *corrections,
+                                   const size_t &numHits) const {
+    for (size_t i = 0; i < numHits; i++)
+        corrections[i] = GetCorrection(ids[i], raw[i]);
+}
+
+double WalkCorrector::EvaluateModel(const CorrectionParams &cf, double raw) const {
+    switch (cf.model) {
+        case none:
+            return Model_None();
+        case A:
+            return Model_A(cf.parameters, raw);
+        case B1:
+            return Model_B1(cf.parameters, raw);
+        case B2:
+            return Model_B2(cf.parameters, raw);
+        case VS:
+            return Model_VS(cf.parameters, raw);
+        case VM:
+            return Model_VM(cf.parameters, raw);
+        case VL:
+            return Model_VL(cf.parameters, raw);
+        case VD:
+            return Model_VD(cf.parameters, raw);
+        case VB:
+            return Model_VB(cf.parameters, raw);
+        default:
+            return 0;
+    }
+}
+
 double WalkCorrector::Model_None() const {
     return (0.0);
 }
@@ -5,6 +5,7 @@
 
 // Local files
 #include "Display.h"
+#include "ParallelReplay.hpp"
 #include "UtkScanInterface.hpp"
 #include "UtkUnpacker.hpp"
 
@@ -14,6 +15,15 @@ int main(int argc, char *argv[]) {
     // Define the unpacker and scan objects.
     cout << "utkscan.cpp : Instancing the UtkScanInterface" << endl;
     UtkScanInterface scanner;
+
+    // Splitting the run between several processes happens before we set anything up in this one. The command line
+    // is read with the scan's own option table.
+    string shortOptions;
+    const vector<option> &options = scanner.GetOptionTable(shortOptions);
+    ParallelReplay replay(argc, argv, options, shortOptions);
+    if (replay.IsRequested())
+        return replay.Run();
+
     cout << "utkscan.cpp : Instancing the UtkUnpacker" << endl;
     UtkUnpacker unpacker;
 
@@ -21,21 +31,27 @@ int main(int argc, char *argv[]) {
     cout << "utkscan.cpp : Setting the Program Name" << endl;
     scanner.SetProgramName("utkscan");
 
+    int retval = 0;
     try {
         // Initialize the scanner.
         cout << "utkscan.cpp : Performing the setup routine" << endl;
-        if(!scanner.Setup(argc, argv, &unpacker))
-            throw PaassException("utkscan.cpp : Unspecified error while inside UtkScanInterface::Setup.");
-
-        // Run the main loop.
-        cout << "utkscan.cpp : Performing Execute method" << endl;
-        scanner.Execute();
+        if(!scanner.Setup(argc, argv, &unpacker)) {
+            if (scanner.IsSequentialOnly())
+                retval = ParallelReplay::sequentialOnlyExitCode;
+            else
+                throw PaassException("utkscan.cpp : Unspecified error while inside UtkScanInterface::Setup.");
+        } else {
+            // Run the main loop.
+            cout << "utkscan.cpp : Performing Execute method" << endl;
+            scanner.Execute();
+        }
     } catch (std::exception &ex) {
         cerr << Display::ErrorStr(ex.what()) << endl;
+        retval = 1;
     }
 
     cout << "utkscan.cpp : Closing things out" << endl;
     scanner.Close();
 
-    return 0;
+    return retval;
 }
@@ -0,0 +1,52 @@
+///@file unittest-CacheableAnalyzers.cpp
+///@brief Checks that the analyzers that are skipped for cached traces don't have any plots to fill.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <set>
+#include <string>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "CfdAnalyzer.hpp"
+#include "FittingAnalyzer.hpp"
+#include "RootHandler.hpp"
+#include "TauAnalyzer.hpp"
+#include "TraceExtractor.hpp"
+#include "TraceFilterAnalyzer.hpp"
+#include "WaaAnalyzer.hpp"
+#include "WaveformAnalyzer.hpp"
+
+using namespace std;
+
+///Analyze isn't called for a trace that's restored from the cache, so a cacheable analyzer with plots would leave
+/// its histograms short of what a scan without the cache fills.
+TEST(TestCacheableAnalyzersHaveNoPlots) {
+    vector<TraceAnalyzer *> analyzers = {new CfdAnalyzer("poly"), new FittingAnalyzer("gsl"), new TauAnalyzer(),
+                                         new TraceExtractor("", "", "trace"), new TraceFilterAnalyzer(false),
+                                         new WaaAnalyzer(), new WaveformAnalyzer(set<string>())};
+
+    unsigned int numCacheable = 0;
+    for (vector<TraceAnalyzer *>::iterator it = analyzers.begin(); it != analyzers.end(); it++) {
+        if ((*it)->IsCacheable()) {
+            CHECK(!(*it)->HasPlots());
+            numCacheable++;
+        }
+    }
+    CHECK_EQUAL(4u, numCacheable);
+
+    //The trace filter plots its return values and pileups, which the cache doesn't keep.
+    TraceFilterAnalyzer *filter = dynamic_cast<TraceFilterAnalyzer *>(analyzers[4]);
+    CHECK(filter->HasPlots());
+    CHECK(!filter->IsCacheable());
+
+    for (vector<TraceAnalyzer *>::iterator it = analyzers.begin(); it != analyzers.end(); it++)
+        delete *it;
+}
+
+int main(int argv, char *argc[]) {
+    RootHandler::get("/tmp/unittest-CacheableAnalyzers");
+    int result = UnitTest::RunAllTests();
+    delete RootHandler::get();
+    return result;
+}
@@ -0,0 +1,70 @@
+///@file unittest-Calibrator.cpp
+///@brief Checks that the compiled calibration tables give the same energies as the calibrations that they came from.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <vector>
+
+#include <cmath>
+
+#include <UnitTest++.h>
+
+#include "Calibrator.hpp"
+#include "ChannelConfiguration.hpp"
+#include "PaassExceptions.hpp"
+
+using namespace std;
+
+TEST(Test_Polynomials) {
+    Calibrator cal;
+    ChannelConfiguration linear("unit", "linear", 0), cubic("unit", "cubic", 0), polynomial("unit", "polynomial", 0);
+    cal.AddChannel(linear, "linear", 0., 1000., {1.5, 0.25});
+    cal.AddChannel(cubic, "cubic", 0., 1000., {1.5, 0.25, 1e-3, 2e-6});
+    cal.AddChannel(polynomial, "polynomial", 0., 1000., {1.5, 0.25, 1e-3, 2e-6, 3e-9});
+
+    double raw = 300.5;
+    CHECK_CLOSE(1.5 + 0.25 * raw, cal.GetCalEnergy(linear, raw), 1e-9);
+    CHECK_CLOSE(1.5 + 0.25 * raw + 1e-3 * pow(raw, 2) + 2e-6 * pow(raw, 3), cal.GetCalEnergy(cubic, raw), 1e-9);
+    CHECK_CLOSE(1.5 + 0.25 * raw + 1e-3 * pow(raw, 2) + 2e-6 * pow(raw, 3) + 3e-9 * pow(raw, 4),
+                cal.GetCalEnergy(polynomial, raw), 1e-9);
+}
+
+TEST(Test_CompiledTables) {
+    vector<ChannelConfiguration> channels;
+    channels.push_back(ChannelConfiguration("unit", "test", 0));
+    channels.push_back(ChannelConfiguration("unit", "test", 1));
+    channels.push_back(ChannelConfiguration("unit", "test", 2));
+    channels.push_back(ChannelConfiguration("unit", "test", 3));
+
+    Calibrator cal;
+    cal.AddChannel(channels[0], "quadratic", 0., 100., {1.5, 0.25, 1e-3, 7.});
+    cal.AddChannel(channels[0], "hyplin", 100., 1000., {1.5, 0.25, 1e-3});
+    cal.AddChannel(channels[1], "off", 0., 1000., {});
+    cal.AddChannel(channels[3], "exp", 0., 1000., {1.5, 250., 3.});
+    cal.Compile(channels);
+
+    const unsigned int ids[] = {0, 0, 0, 1, 2, 3, 4};
+    const double raw[] = {20.3, 300., 2000., 20.3, 20.3, 20.3, 20.3};
+    double calibrated[7];
+    cal.GetCalEnergies(ids, raw, calibrated, 7);
+
+    for (unsigned int i = 0; i < 6; i++) {
+        CHECK_CLOSE(cal.GetCalEnergy(channels[ids[i]], raw[i]), calibrated[i], 1e-9);
+        CHECK_EQUAL(calibrated[i], cal.GetCalEnergy(ids[i], raw[i]));
+    }
+    CHECK_EQUAL(0.0, calibrated[2]);
+    CHECK_EQUAL(0.0, calibrated[3]);
+    CHECK_EQUAL(20.3, calibrated[4]);
+    CHECK_EQUAL(20.3, calibrated[6]);
+}
+
+TEST(Test_BadCalibrations) {
+    Calibrator cal;
+    ChannelConfiguration cfg("unit", "test", 0);
+    CHECK_THROW(cal.AddChannel(cfg, "unknown", 0., 1000., {}), PaassException);
+    CHECK_THROW(cal.AddChannel(cfg, "linear", 1000., 0., {1., 2.}), PaassException);
+    CHECK_THROW(cal.AddChannel(cfg, "cubic", 0., 1000., {1., 2.}), PaassException);
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
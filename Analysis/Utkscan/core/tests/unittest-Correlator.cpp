@@ -0,0 +1,144 @@
+///@file unittest-Correlator.cpp
+///@brief Checks the bookkeeping of the pixels with a decay list in the Correlator.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "Correlator.hpp"
+#include "Globals.hpp"
+#include "RootHandler.hpp"
+#include "XmlInterface.hpp"
+
+using namespace std;
+
+namespace {
+    const char *configFilename = "unittest-Correlator.xml";
+
+    ///The correlator that's shared by the tests, its histograms can only be registered once.
+    Correlator *correlator = nullptr;
+
+    ///Loads a configuration with the revision F clocks, the correlator needs the clock to convert its times.
+    void LoadGlobals() {
+        ofstream config(configFilename);
+        config << "<?xml version=\"1.0\"?>\n"
+               << "<Configuration>\n"
+               << "    <Description>unittest-Correlator</Description>\n"
+               << "    <Global>\n"
+               << "        <Revision version=\"F\"/>\n"
+               << "        <EventWidth unit=\"s\" value=\"1e-6\"/>\n"
+               << "    </Global>\n"
+               << "    <Map/>\n"
+               << "</Configuration>\n";
+        config.close();
+        XmlInterface::get(configFilename);
+        Globals::get(configFilename);
+        RootHandler::get("/tmp/unittest-Correlator");
+        remove(configFilename);
+    }
+
+    EventInfo MakeEvent(const EventInfo::EEventTypes &type, const double &time) {
+        EventInfo event;
+        event.type = type;
+        event.time = time;
+        event.energy = 100;
+        return event;
+    }
+}
+
+TEST(TestKeySet) {
+    KeySet keys(10);
+    CHECK(keys.GetSortedMembers().empty());
+
+    keys.Insert(7);
+    keys.Insert(2);
+    keys.Insert(9);
+    keys.Insert(2);
+    CHECK_EQUAL(3u, keys.GetSortedMembers().size());
+    CHECK_ARRAY_EQUAL(vector<unsigned int>({2, 7, 9}), keys.GetSortedMembers(), 3);
+
+    //Erasing moves the last member into the hole that it leaves, and keys that aren't in the set are ignored.
+    keys.Erase(2);
+    keys.Erase(4);
+    CHECK_ARRAY_EQUAL(vector<unsigned int>({7, 9}), keys.GetSortedMembers(), 2);
+    keys.Erase(9);
+    CHECK_ARRAY_EQUAL(vector<unsigned int>({7}), keys.GetSortedMembers(), 1);
+    keys.Insert(0);
+    keys.Insert(9);
+    CHECK_ARRAY_EQUAL(vector<unsigned int>({0, 7, 9}), keys.GetSortedMembers(), 3);
+    keys.Erase(7);
+    keys.Erase(0);
+    keys.Erase(9);
+    CHECK(keys.GetSortedMembers().empty());
+}
+
+TEST(TestListBoundKeepsImplant) {
+    CorrelationList list;
+    list.Add(MakeEvent(EventInfo::IMPLANT_EVENT, 10), 3);
+    for (unsigned int i = 1; i <= 5; i++)
+        list.Add(MakeEvent(EventInfo::DECAY_EVENT, 10 + i), 3);
+
+    CHECK_EQUAL(3u, list.size());
+    CHECK_EQUAL(10, list.GetImplantTime());
+    CHECK_EQUAL(14, list[1].time);
+    CHECK_EQUAL(15, list.back().time);
+}
+
+TEST(TestCorrelatorListBound) {
+    Correlator &corr = *correlator;
+
+    EventInfo implant = MakeEvent(EventInfo::IMPLANT_EVENT, 1000);
+    corr.Correlate(implant, 1, 2);
+    CHECK_EQUAL(Correlator::VALID_IMPLANT, corr.GetCondition());
+
+    for (unsigned int i = 1; i <= 5; i++) {
+        EventInfo decay = MakeEvent(EventInfo::DECAY_EVENT, 1000 + 1000 * i);
+        corr.Correlate(decay, 1, 2);
+        CHECK_EQUAL(Correlator::VALID_DECAY, corr.GetCondition());
+    }
+
+    //The decays only push out older decays, the implant that they're correlated with stays.
+    CHECK_EQUAL(1000, corr.GetImplantTime(1, 2));
+    CHECK_EQUAL(5000, corr.GetDecayTime(1, 2));
+}
+
+///The times start well after the other tests so that their lists are already gone.
+TEST(TestCorrelatorExpiry) {
+    Correlator &corr = *correlator;
+    const double expiryTicks = 60 / Globals::get()->GetFilterClockInSeconds();
+    const double start = 10 * expiryTicks;
+
+    EventInfo first = MakeEvent(EventInfo::IMPLANT_EVENT, start);
+    corr.Correlate(first, 0, 0);
+    EventInfo second = MakeEvent(EventInfo::IMPLANT_EVENT, start + 0.95 * expiryTicks);
+    corr.Correlate(second, 1, 1);
+    CHECK_EQUAL(start, corr.GetImplantTime(0, 0));
+
+    //The first implant is older than the expiry time when the third one comes in.
+    EventInfo third = MakeEvent(EventInfo::IMPLANT_EVENT, start + 1.2 * expiryTicks);
+    corr.Correlate(third, 2, 2);
+    CHECK(std::isnan(corr.GetImplantTime(0, 0)));
+    CHECK_EQUAL(second.time, corr.GetImplantTime(1, 1));
+    CHECK_EQUAL(third.time, corr.GetImplantTime(2, 2));
+
+    //The dropped pixel is gone from its strips too, so a decay on them doesn't find it.
+    EventInfo decay = MakeEvent(EventInfo::DECAY_EVENT, start + 1.25 * expiryTicks);
+    corr.CorrelateAllY(decay, 0);
+    CHECK(std::isnan(corr.GetDecayTime(0, 0)));
+    EventInfo otherDecay = MakeEvent(EventInfo::DECAY_EVENT, start + 1.25 * expiryTicks);
+    corr.CorrelateAllX(otherDecay, 1);
+    CHECK_CLOSE(0.3 * expiryTicks, corr.GetDecayTime(1, 1), 1);
+}
+
+int main(int argv, char *argc[]) {
+    LoadGlobals();
+    correlator = new Correlator(4, 4, 3);
+    int result = UnitTest::RunAllTests();
+    delete correlator;
+    delete RootHandler::get();
+    return result;
+}
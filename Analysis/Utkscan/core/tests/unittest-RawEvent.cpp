@@ -0,0 +1,72 @@
+///@file unittest-RawEvent.cpp
+///@brief Checks the summaries that the RawEvent hands out by the ids that the DetectorLibrary interned.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <cstdio>
+#include <fstream>
+
+#include <UnitTest++.h>
+
+#include "DetectorLibrary.hpp"
+#include "Globals.hpp"
+#include "RawEvent.hpp"
+#include "XmlInterface.hpp"
+
+using namespace std;
+
+namespace {
+    const char *configFilename = "unittest-RawEvent.xml";
+
+    ///Loads a configuration with an empty map, the summaries that we ask for are interned by the test.
+    void LoadGlobals() {
+        ofstream config(configFilename);
+        config << "<?xml version=\"1.0\"?>\n"
+               << "<Configuration>\n"
+               << "    <Description>unittest-RawEvent</Description>\n"
+               << "    <Global>\n"
+               << "        <Revision version=\"F\"/>\n"
+               << "        <EventWidth unit=\"s\" value=\"1e-6\"/>\n"
+               << "    </Global>\n"
+               << "    <Map/>\n"
+               << "</Configuration>\n";
+        config.close();
+        XmlInterface::get(configFilename);
+        Globals::get(configFilename);
+        DetectorLibrary::get();
+        remove(configFilename);
+    }
+}
+
+///A lookup that doesn't construct the summary caches that it's missing, that mustn't stop a later lookup from
+/// constructing it.
+TEST(TestMissingSummaryIsConstructedLater) {
+    const unsigned int id = DetectorLibrary::get()->GetSummaryId("unittest");
+    RawEvent event;
+
+    CHECK(event.GetSummary(id, false) == NULL);
+    CHECK(event.GetSummary(id, false) == NULL);
+
+    DetectorSummary *summary = event.GetSummary(id, true);
+    CHECK(summary != NULL);
+    if (!summary)
+        return;
+    CHECK_EQUAL("unittest", summary->GetName());
+    CHECK(event.GetSummary(id, false) == summary);
+    CHECK(event.GetSummary("unittest", false) == summary);
+}
+
+///Constructing a summary invalidates the cached misses of the other ids, since they could have been added too.
+TEST(TestMissingSummaryFoundAfterItsAdded) {
+    const unsigned int id = DetectorLibrary::get()->GetSummaryId("unittest:added");
+    RawEvent event;
+
+    CHECK(event.GetSummary(id, false) == NULL);
+    DetectorSummary *summary = event.GetSummary("unittest:added", true);
+    CHECK(summary != NULL);
+    CHECK(event.GetSummary(id, false) == summary);
+}
+
+int main(int argv, char *argc[]) {
+    LoadGlobals();
+    return (UnitTest::RunAllTests());
+}
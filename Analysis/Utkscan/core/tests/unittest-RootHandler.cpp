@@ -9,7 +9,9 @@
 #include <UnitTest++.h>
 
 #include <chrono>
+#include <iostream>
 #include <random>
+#include <vector>
 
 TEST(TestRootHandler) {
     RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler");
@@ -31,6 +33,117 @@ TEST(TestRootHandler) {
     delete RootHandler::get();
 }
 
+TEST(TestHistogramHandles) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler-handles");
+
+    handler->RegisterHistogram(0, "test1d", 10);
+    handler->RegisterHistogram(1, "test2d-xy", 10, 10);
+    handler->RegisterHistogram(2, "test3d", 10, 10, 10);
+
+    CHECK_THROW(handler->GetHandle(123), std::invalid_argument);
+    CHECK_EQUAL(handler->GetHandle(0), handler->GetHandle(0));
+
+    RootHandler::HistogramHandle *handle1d = handler->GetHandle(0);
+    RootHandler::HistogramHandle *handle2d = handler->GetHandle(1);
+    RootHandler::HistogramHandle *handle3d = handler->GetHandle(2);
+
+    for (unsigned int i = 0; i < 1000; i++) {
+        CHECK(handler->Plot(*handle1d, 2.5));
+        CHECK(handler->Plot(*handle2d, 2.5, 3.5));
+        CHECK(handler->Plot(*handle2d, 2.5, -1, 4.5));
+        CHECK(handler->Plot(*handle3d, 2.5, 3.5, 4.5));
+        CHECK(handler->Plot(0, 5.5));
+    }
+
+    //The fills are buffered until we ask for the histogram.
+    CHECK_EQUAL(1000, handler->Get1DHistogram(0)->GetBinContent(3));
+    CHECK_EQUAL(1000, handler->Get1DHistogram(0)->GetBinContent(6));
+    CHECK_EQUAL(1000, handler->Get2DHistogram(1)->GetBinContent(3, 4));
+    CHECK_EQUAL(1000, handler->Get2DHistogram(1)->GetBinContent(3, 5));
+    CHECK_EQUAL(1000, handler->Get3DHistogram(2)->GetBinContent(3, 4, 5));
+
+    delete RootHandler::get();
+}
+
+TEST(TestFlush) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler-flush");
+    handler->RegisterHistogram(0, "test1d", 10);
+    handler->RegisterHistogram(1, "test2d-xy", 10, 10);
+
+    for (unsigned int flush = 0; flush < 10; flush++) {
+        for (unsigned int i = 0; i < 1000; i++) {
+            handler->Plot(0, 2.5);
+            handler->Plot(1, 2.5, 3.5);
+        }
+        handler->Flush();
+    }
+
+    delete RootHandler::get();
+
+    TFile file("/tmp/unittest-RootHandler-flush-hist.root");
+    TH1D *histogram1d = dynamic_cast<TH1D *>(file.Get("h0"));
+    TH2D *histogram2d = dynamic_cast<TH2D *>(file.Get("h1"));
+    CHECK(histogram1d);
+    CHECK(histogram2d);
+    if (histogram1d && histogram2d) {
+        CHECK_EQUAL(10000, histogram1d->GetEntries());
+        CHECK_EQUAL(10000, histogram2d->GetBinContent(3, 4));
+    }
+    file.Close();
+}
+
+///A microbenchmark comparing filling by id with filling through a handle. We only print the rates since the
+/// timing depends on the machine.
+TEST(BenchmarkHistogramFills) {
+    RootHandler *handler = RootHandler::get("/tmp/unittest-RootHandler-benchmark");
+
+    static const unsigned int numHistograms = 100;
+    static const unsigned int numFills = 2000000;
+
+    for (unsigned int i = 0; i < numHistograms; i++)
+        handler->RegisterHistogram(i, "benchmark", 1024);
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<double> values(0, 1024);
+    std::uniform_int_distribution<unsigned int> ids(0, numHistograms - 1);
+    std::vector<std::pair<unsigned int, double> > fills;
+    for (unsigned int i = 0; i < numFills; i++)
+        fills.push_back(std::make_pair(ids(generator), values(generator)));
+
+    std::vector<RootHandler::HistogramHandle *> handles;
+    for (unsigned int i = 0; i < numHistograms; i++)
+        handles.push_back(handler->GetHandle(i));
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &fill : fills)
+        handles[fill.first]->histogram->Fill(fill.second);
+    std::chrono::duration<double> directTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (const auto &fill : fills)
+        handler->Plot(fill.first, fill.second);
+    handler->ApplyFills();
+    std::chrono::duration<double> idTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (const auto &fill : fills)
+        handler->Plot(*handles[fill.first], fill.second);
+    handler->ApplyFills();
+    std::chrono::duration<double> handleTime = std::chrono::steady_clock::now() - start;
+
+    double entries = 0;
+    for (unsigned int i = 0; i < numHistograms; i++)
+        entries += handler->Get1DHistogram(i)->GetEntries();
+    CHECK_EQUAL(3. * numFills, entries);
+
+    std::cout << "BenchmarkHistogramFills - TH1::Fill : " << numFills / directTime.count() << " fills/s" << std::endl
+              << "BenchmarkHistogramFills - Plot by id : " << numFills / idTime.count() << " fills/s" << std::endl
+              << "BenchmarkHistogramFills - Plot by handle : " << numFills / handleTime.count() << " fills/s"
+              << std::endl;
+
+    delete RootHandler::get();
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
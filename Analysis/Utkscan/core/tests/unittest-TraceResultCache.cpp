@@ -0,0 +1,165 @@
+///@file unittest-TraceResultCache.cpp
+///@brief Checks that the trace cache gives back what was stored in it and forgets results made with other settings.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <cstdio>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "TraceResultCache.hpp"
+
+using namespace std;
+
+namespace {
+    const char *filename = "unittest-TraceResultCache.dat";
+    const vector<unsigned int> samples = {400, 401, 399, 400, 650, 900, 700, 500, 420, 405};
+
+    ///@return A trace that looks like it went through all of the analyzers
+    Trace MakeAnalyzedTrace() {
+        Trace trace(samples);
+        trace.SetHasValidAnalysis(true);
+        trace.SetPhase(4.25);
+        trace.SetQdc(1234.5);
+        trace.SetTailRatio(0.125);
+        trace.SetTau(3.5);
+        trace.SetFilteredBaseline(400.5);
+        trace.SetBaseline(make_pair(400.0, 0.75));
+        trace.SetMax(make_pair(5u, 500.0));
+        trace.SetExtrapolatedMax(make_pair(5u, 510.0));
+        trace.SetFilteredEnergies({480.0, 12.0});
+        trace.SetEnergySums({1.0, 2.0, 3.0});
+        trace.SetTriggerFilter({0.0, 10.0, 250.0});
+        trace.SetTriggerPositions({4u});
+        trace.CalculateTraceSansBaseline(400.0);
+        trace.SetWaveformRange(make_pair(3u, 8u));
+        return trace;
+    }
+
+    ///Writes one result for each of two channels to the file.
+    void WriteCache(const vector<unsigned long long> &channelHashes) {
+        TraceResultCache cache;
+        CHECK(cache.Open(filename, 1, channelHashes));
+        Trace trace = MakeAnalyzedTrace();
+        cache.Store(0, 123456, 500, trace);
+        cache.Store(1, 123460, 600, trace);
+        cache.Close();
+    }
+}
+
+TEST(TestRestoringWhatWeStored) {
+    remove(filename);
+    WriteCache({11, 22});
+
+    TraceResultCache cache;
+    CHECK(cache.Open(filename, 1, {11, 22}));
+
+    Trace expected = MakeAnalyzedTrace();
+    Trace trace(samples);
+    CHECK(cache.Restore(0, 123456, 500, trace));
+    CHECK(trace.HasValidAnalysis());
+    CHECK_EQUAL(expected.GetPhase(), trace.GetPhase());
+    CHECK_EQUAL(expected.GetQdc(), trace.GetQdc());
+    CHECK_EQUAL(expected.GetTailRatio(), trace.GetTailRatio());
+    CHECK_EQUAL(expected.GetTau(), trace.GetTau());
+    CHECK_EQUAL(expected.GetBaselineInfo().second, trace.GetBaselineInfo().second);
+    CHECK_EQUAL(expected.GetMaxInfo().second, trace.GetMaxInfo().second);
+    CHECK_EQUAL(expected.GetExtrapolatedMaxInfo().second, trace.GetExtrapolatedMaxInfo().second);
+    //The trace filter runs on every trace, so the cache leaves its results alone.
+    CHECK(trace.GetFilteredEnergies().empty());
+    CHECK(trace.GetEnergySums().empty());
+    CHECK(trace.GetTriggerFilter().empty());
+    CHECK(trace.GetTriggerPositions().empty());
+    CHECK_ARRAY_EQUAL(expected.GetTraceSansBaseline(), trace.GetTraceSansBaseline(), samples.size());
+    CHECK_EQUAL(expected.GetWaveform().size(), trace.GetWaveform().size());
+    CHECK_ARRAY_EQUAL(expected.GetWaveform(), trace.GetWaveform(), expected.GetWaveform().size());
+
+    //The energy and the length of the trace have to match the hit that the result was stored for.
+    CHECK(!cache.Restore(0, 123456, 501, trace));
+    Trace shorter(vector<unsigned int>(samples.begin(), samples.end() - 1));
+    CHECK(!cache.Restore(0, 123456, 500, shorter));
+    CHECK(!cache.Restore(0, 123457, 500, trace));
+    CHECK(cache.Restore(1, 123460, 600, trace));
+    remove(filename);
+}
+
+TEST(TestChangedChannelSettings) {
+    remove(filename);
+    WriteCache({11, 22});
+
+    TraceResultCache cache;
+    CHECK(cache.Open(filename, 1, {11, 23}));
+    Trace trace(samples);
+    CHECK(cache.Restore(0, 123456, 500, trace));
+    CHECK(!cache.Restore(1, 123460, 600, trace));
+    cache.Close();
+
+    //The stale result was dropped from the file when it was written again.
+    CHECK(cache.Open(filename, 1, {11, 22}));
+    CHECK(cache.Restore(0, 123456, 500, trace));
+    CHECK(!cache.Restore(1, 123460, 600, trace));
+    remove(filename);
+}
+
+TEST(TestChangedAnalyzers) {
+    remove(filename);
+    WriteCache({11, 22});
+
+    TraceResultCache cache;
+    CHECK(cache.Open(filename, 2, {11, 22}));
+    Trace trace(samples);
+    CHECK(!cache.Restore(0, 123456, 500, trace));
+    CHECK(!cache.Restore(1, 123460, 600, trace));
+    remove(filename);
+}
+
+TEST(TestHashes) {
+    CHECK(TraceResultCache::Hash("ab") != TraceResultCache::Hash("ba"));
+    CHECK(TraceResultCache::Hash("c", TraceResultCache::Hash("ab")) !=
+          TraceResultCache::Hash("bc", TraceResultCache::Hash("a")));
+
+    ChannelConfiguration first("vandle", "small", 0), second("vandle", "small", 1);
+    CHECK_EQUAL(TraceResultCache::Hash(first), TraceResultCache::Hash(second));
+    second.SetBaselineThreshold(3.0);
+    CHECK(TraceResultCache::Hash(first) != TraceResultCache::Hash(second));
+
+    FILE *file = fopen(filename, "w");
+    fputs("this is not a trace cache", file);
+    fclose(file);
+    TraceResultCache cache;
+    CHECK(!cache.Open(filename, 1, {11}));
+    CHECK(!cache.IsOpen());
+    remove(filename);
+}
+
+///A setting on a node below an analyzer has to change the hash just like one on the analyzer itself.
+TEST(TestNodeHashes) {
+    pugi::xml_document reference, changed;
+    CHECK(reference.load_string("<DetectorDriver><Analyzer name=\"CfdAnalyzer\" type=\"poly\"/>"
+                                        "<Analyzer name=\"FittingAnalyzer\"><Fit beta=\"0.5\"/></Analyzer>"
+                                        "</DetectorDriver>"));
+    unsigned long long hash = TraceResultCache::Hash(reference.child("DetectorDriver"));
+    CHECK_EQUAL(hash, TraceResultCache::Hash(reference.child("DetectorDriver")));
+
+    CHECK(changed.load_string("<DetectorDriver><Analyzer name=\"CfdAnalyzer\" type=\"poly\"/>"
+                                      "<Analyzer name=\"FittingAnalyzer\"><Fit beta=\"0.6\"/></Analyzer>"
+                                      "</DetectorDriver>"));
+    CHECK(hash != TraceResultCache::Hash(changed.child("DetectorDriver")));
+
+    //The same nodes one level further down aren't the same configuration.
+    CHECK(changed.load_string("<DetectorDriver><Analyzer name=\"CfdAnalyzer\" type=\"poly\">"
+                                      "<Analyzer name=\"FittingAnalyzer\"><Fit beta=\"0.5\"/></Analyzer>"
+                                      "</Analyzer></DetectorDriver>"));
+    CHECK(hash != TraceResultCache::Hash(changed.child("DetectorDriver")));
+
+    CHECK(changed.load_string("<DetectorDriver><Analyzer name=\"CfdAnalyzer\" type=\"poly\"/>"
+                                      "<Analyzer name=\"FittingAnalyzer\"><Fit beta=\"0.5\"/>gsl</Analyzer>"
+                                      "</DetectorDriver>"));
+    CHECK(hash != TraceResultCache::Hash(changed.child("DetectorDriver")));
+
+    CHECK(TraceResultCache::Hash(1e-8, hash) != TraceResultCache::Hash(8e-9, hash));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
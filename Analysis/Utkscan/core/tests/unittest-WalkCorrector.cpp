@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include <cmath>
+#include <vector>
 
 #include <UnitTest++.h>
 
@@ -95,6 +96,33 @@ TEST_FIXTURE(WalkCorrector, Test_GetCorrection) {
     CHECK_EQUAL(expected, GetCorrection(cfg, raw));
 }
 
+TEST_FIXTURE(WalkCorrector, Test_CompiledCorrections) {
+    vector<ChannelConfiguration> channels;
+    channels.push_back(ChannelConfiguration("unit", "test", 0));
+    channels.push_back(ChannelConfiguration("unit", "test", 1));
+    channels.push_back(ChannelConfiguration("unit", "test", 2));
+
+    vector<double> low = {0.5, 2.1, 3.7, 0.4, 0.1};
+    vector<double> high = {0.5, 2.1, 3.7};
+    AddChannel(channels[0], "A", 0., 100., low);
+    AddChannel(channels[0], "B2", 100., 1000., high);
+    AddChannel(channels[2], "B2", 0., 1000., high);
+    Compile(channels);
+
+    const unsigned int ids[] = {0, 0, 0, 1, 2, 3};
+    const double raw[] = {20.3, 300., 2000., 20.3, 20.3, 20.3};
+    double corrections[6];
+    GetCorrections(ids, raw, corrections, 6);
+
+    for (unsigned int i = 0; i < 5; i++) {
+        CHECK_EQUAL(GetCorrection(channels[ids[i]], raw[i]), corrections[i]);
+        CHECK_EQUAL(corrections[i], GetCorrection(ids[i], raw[i]));
+    }
+    CHECK_EQUAL(0.0, corrections[2]);
+    CHECK_EQUAL(0.0, corrections[3]);
+    CHECK_EQUAL(0.0, corrections[5]);
+}
+
 int main(int argv, char *argc[]) {
     return (UnitTest::RunAllTests());
 }
@@ -79,6 +79,13 @@ public:
     /** Perform Process */
     virtual bool Process(RawEvent &event);
 
+    /** \return True since we look at the traces of the strips */
+    virtual bool UsesTraces(void) const { return true; }
+
+    /** \return True since the correlator keeps the implants and decays for
+     * the whole run */
+    virtual bool IsSequentialOnly(void) const { return true; }
+
 protected:
     /** Picks what event type we had 
      * \return true if the event type was found(?) */
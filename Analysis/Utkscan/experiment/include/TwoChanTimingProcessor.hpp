@@ -34,6 +34,9 @@ public:
     /// @param [in] event : the event to process
     /// @return true if processing was successful */
     bool Process(RawEvent &event);
+
+    ///@return True since we plot the traces of the start and stop
+    bool UsesTraces(void) const { return true; }
 private:
     TTree *tree_; //!< Pointer to the tree that we register in the constructor
 };
@@ -6,6 +6,7 @@
 #ifndef __DSSDPROCESSOR_HPP_
 #define __DSSDPROCESSOR_HPP_
 
+#include "Correlator.hpp"
 #include "EventProcessor.hpp"
 
 class DetectorSummary;
@@ -16,13 +17,26 @@ class RawEvent;
 class DssdProcessor : public EventProcessor {
 public:
     DssdProcessor(); // no virtual c'tors
+
+    /** Constructor that sets the size of the detector for the correlator
+     * \param [in] numFront : the number of front strips
+     * \param [in] numBack : the number of back strips
+     * \param [in] maxListSize : the largest number of events kept for a pixel */
+    DssdProcessor(const unsigned int &numFront, const unsigned int &numBack, const unsigned int &maxListSize);
+
     virtual void DeclarePlots(void);
 
     virtual bool Process(RawEvent &event);
 
+    /** \return True since the implants are correlated with decays that come
+     * at any later time in the run */
+    virtual bool IsSequentialOnly(void) const { return true; }
+
 private:
     DetectorSummary *frontSummary; ///< all detectors of type dssd_front
     DetectorSummary *backSummary;  ///< all detectors of type dssd_back
+    unsigned int mcpSummaryId; ///< the handle of the mcp summary
+    Correlator corr; ///< correlates the implants with their decays
     static const double cutoffEnergy; ///< cutoff energy for implants versus decays
 };
 
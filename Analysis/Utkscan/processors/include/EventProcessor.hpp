@@ -5,11 +5,12 @@
 #ifndef __EVENTPROCESSOR_HPP_
 #define __EVENTPROCESSOR_HPP_
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
-
-#include <sys/times.h>
+#include <vector>
 
 #include "Plots.hpp"
 #include "TreeCorrelator.hpp"
@@ -54,6 +55,36 @@ public:
      * \return True if there was an event */
     virtual bool HasEvent(void) const;
 
+    /** See if the detectors of interest have any events in the provided event.
+     * This is used when the processor runs on an event that it was not
+     * initialized with.
+     * \param [in] event : the event to check
+     * \return True if there was an event */
+    bool HasEventIn(RawEvent &event) const;
+
+    /** Processors that return true here are run in parallel on several
+     * events at once. To opt in, the processor must not keep any state from
+     * one event to the next, must read the detector summaries from the event
+     * that it is handed (not from sumMap or from statics), must not use the
+     * TreeCorrelator, and no other processor may depend on its results. It
+     * may only fill histograms. All other processors run in event order.
+     * \return True if the processor can run on several events at once */
+    virtual bool IsEventParallel(void) const { return false; }
+
+    /** Processors that return true here keep state for the whole run, e.g.
+     * implants that are waiting for their decays, which a few warm-up spills
+     * can't rebuild. A run that uses one of them is never split into pieces
+     * that are scanned separately.
+     * \return True if the run has to be scanned in order from the start */
+    virtual bool IsSequentialOnly(void) const { return false; }
+
+    /** Traces are only decoded for the channels that an analyzer or a
+     * processor uses them for. Processors that read the samples of the
+     * traces of their associated types have to return true. The results of
+     * the trace analyzers don't count, the analyzers ask for those traces.
+     * \return True if the processor reads the samples of the traces */
+    virtual bool UsesTraces(void) const { return false; }
+
     /** Initialize the processor if the detectors that require it are used in
      * the analysis
      * \param [in] event : the event to initialize with
@@ -102,17 +133,17 @@ protected:
     std::string name; //!< Name of the Processor
     std::set<std::string> associatedTypes; //!< Set of associated types for Processor
     bool initDone;//!< True if the initialization has finished
-    bool didProcess;//!< True if the process finished
+    std::atomic<bool> didProcess;//!< True if the process finished
     std::map<std::string, const DetectorSummary *> sumMap; //!< Map of associated detector summary
 
     /** Plots class for given Processor, takes care of declaration
     * and plotting within boundaries allowed by PlotsRegistry */
     Plots histo;
 private:
-    tms tmsBegin; //!< The beginning processor time
+    std::vector<unsigned int> summaryIds_; //!< The handles of the summaries in sumMap, used by HasEventIn
+    std::mutex timingMutex_; //!< Protects the totals when we're running on several threads
     double userTime;//!< The user time spent in the processor
     double systemTime;//!< The system time spent in the processor
-    double clocksPerSecond;//!< The number of clock cycles per second
 };
 
 #endif // __EVENTPROCESSOR_HPP_
@@ -25,6 +25,12 @@ public:
 
     ///Declare the plots for the processor
     virtual void DeclarePlots(void);
+
+    ///@return True since we only plot the germanium singles
+    virtual bool IsEventParallel(void) const { return true; }
+
+private:
+    unsigned int geSummaryId_; ///< The handle of the ge summary
 };
 
 #endif // __GEPROCESSOR_HPP_
@@ -26,6 +26,13 @@ public:
     * \param [in] event : the event to process
     * \return true if the processing was successful */
     bool Process(RawEvent &event);
+
+    /** \return True since the traces are checked for pileups */
+    bool UsesTraces(void) const { return true; }
+
+    /** \return True since the implants are correlated with decays that come
+     * at any later time in the run */
+    virtual bool IsSequentialOnly(void) const { return true; }
 private:
     static const double cutoffEnergy; ///< cutoff energy for implants versus decays
     static const double implantTof;   ///< minimum time-of-flight for an implant
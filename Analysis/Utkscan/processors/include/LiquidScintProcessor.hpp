@@ -28,6 +28,9 @@ public:
     * \return true if the processing was successful */
     virtual bool Process(RawEvent &event);
 
+    /** \return True since we plot the traces of the liquids */
+    virtual bool UsesTraces(void) const { return true; }
+
     /** Declare plots for processor */
     virtual void DeclarePlots(void);
 
@@ -32,6 +32,9 @@ public:
 * \return true if the processing was successful */
     bool Process(RawEvent &event);
 
+    /** \return True since the QDCs are summed from the traces */
+    bool UsesTraces(void) const { return true; }
+
     /** Declare plots for processor */
     void DeclarePlots(void);
 
@@ -73,6 +73,9 @@ public:
     */
     virtual bool Process(RawEvent &event);
 
+    /** \return True since the QDCs are summed from the traces */
+    virtual bool UsesTraces(void) const { return true; }
+
     /** Declares the plots for the processor */
     virtual void DeclarePlots(void);
 };
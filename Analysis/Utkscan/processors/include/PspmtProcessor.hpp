@@ -32,6 +32,9 @@ public:
      * \return Returns true if the processing was successful */
     bool Process(RawEvent &event);
 
+    /** \return True since we read the traces of the anodes */
+    bool UsesTraces(void) const { return true; }
+
 private:
     ///Structure defining what data we're storing
     struct PspmtData {
@@ -40,6 +40,7 @@ public:
 
 private:
     double a_; //!< a variable global to the class
+    unsigned int templateSummaryId_; //!< the handle of the template summary
     std::vector<ChanEvent *> evts_; //!< vector of events for people to get
 };
 
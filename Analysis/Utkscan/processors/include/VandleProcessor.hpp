@@ -93,6 +93,7 @@ private:
     TimingMap starts_;//!< A map to to hold all the starts
     BarMap barStarts_;//!< A map that holds all of the bar starts
     DetectorSummary *geSummary_;//!< The Detector Summary for Ge Events
+    unsigned int geSummaryId_;//!< The handle of the clover summary
 
     bool hasDecay_; //!< True if there was a correlated beta decay
     double decayTime_; //!< the time of the decay
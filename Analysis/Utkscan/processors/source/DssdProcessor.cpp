@@ -10,6 +10,7 @@
 
 #include "Correlator.hpp"
 #include "DammPlotIds.hpp"
+#include "DetectorLibrary.hpp"
 #include "DssdProcessor.hpp"
 #include "RawEvent.hpp"
 
@@ -30,7 +31,13 @@ namespace dammIds {
     }
 }
 
-DssdProcessor::DssdProcessor() : EventProcessor(OFFSET, RANGE, "DssdProcessor"), frontSummary(NULL), backSummary(NULL) {
+DssdProcessor::DssdProcessor() : DssdProcessor(Correlator::defaultNumStrips, Correlator::defaultNumStrips,
+                                                Correlator::defaultMaxListSize) {}
+
+DssdProcessor::DssdProcessor(const unsigned int &numFront, const unsigned int &numBack,
+                             const unsigned int &maxListSize) :
+        EventProcessor(OFFSET, RANGE, "DssdProcessor"), frontSummary(NULL), backSummary(NULL),
+        mcpSummaryId(DetectorLibrary::get()->GetSummaryId("mcp")), corr(numFront, numBack, maxListSize) {
     associatedTypes.insert("dssd_front");
     associatedTypes.insert("dssd_back");
 }
@@ -63,8 +70,6 @@ bool DssdProcessor::Process(RawEvent &event) {
     if (!EventProcessor::Process(event))
         return false;
 
-    static Correlator corr;
-
     //some kind of magic number that correlates to some kind of useful value.
     static double cutoffEnergy = 4800;
 
@@ -82,7 +87,7 @@ bool DssdProcessor::Process(RawEvent &event) {
 
     bool hasFront = (frontSummary->GetMult() > 0);
     bool hasBack = (backSummary->GetMult() > 0);
-    bool hasMcp = (event.GetSummary("mcp")->GetMult() > 0);
+    bool hasMcp = (event.GetSummary(mcpSummaryId)->GetMult() > 0);
 
     if (hasFront) {
         const ChanEvent *ch = frontSummary->GetMaxEvent();
@@ -12,8 +12,7 @@
 #include <sstream>
 #include <vector>
 
-#include <unistd.h>
-#include <sys/times.h>
+#include <sys/resource.h>
 
 #include "DetectorLibrary.hpp"
 #include "EventProcessor.hpp"
@@ -22,18 +21,25 @@
 
 using namespace std;
 
+namespace {
+    ///The CPU time of the calling thread when the processor began. The processors on a thread run one after the
+    /// other, so they can share it, and the event threads don't see each other's.
+    thread_local rusage processBegin;
+
+    ///@return The difference between two times in seconds
+    double Seconds(const timeval &end, const timeval &begin) {
+        return (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) * 1e-6;
+    }
+}
+
 EventProcessor::EventProcessor() :
         name("generic"), initDone(false), didProcess(false),
         histo(0, 0, "generic"),
-        userTime(0.), systemTime(0.) {
-    clocksPerSecond = sysconf(_SC_CLK_TCK);
-}
+        userTime(0.), systemTime(0.) {}
 
 EventProcessor::EventProcessor(int offset, int range, std::string proc_name) :
         name(proc_name), initDone(false), didProcess(false),
-        histo(offset, range, proc_name), userTime(0.), systemTime(0.) {
-    clocksPerSecond = sysconf(_SC_CLK_TCK);
-}
+        histo(offset, range, proc_name), userTime(0.), systemTime(0.) {}
 
 EventProcessor::~EventProcessor() {
     if (initDone)
@@ -52,6 +58,15 @@ bool EventProcessor::HasEvent(void) const {
     return (false);
 }
 
+bool EventProcessor::HasEventIn(RawEvent &event) const {
+    for (vector<unsigned int>::const_iterator it = summaryIds_.begin(); it != summaryIds_.end(); it++) {
+        const DetectorSummary *summary = event.GetSummary(*it, false);
+        if (summary && summary->GetMult() > 0)
+            return (true);
+    }
+    return (false);
+}
+
 bool EventProcessor::Init(RawEvent &rawev) {
     vector<string> intersect;
     const set <string> &usedDets = DetectorLibrary::get()->GetUsedDetectors();
@@ -66,6 +81,7 @@ bool EventProcessor::Init(RawEvent &rawev) {
     for (vector<string>::const_iterator it = intersect.begin();
          it != intersect.end(); it++) {
         sumMap.insert(make_pair(*it, rawev.GetSummary(*it)));
+        summaryIds_.push_back(DetectorLibrary::get()->GetSummaryId(*it));
     }
 
     initDone = true;
@@ -88,23 +104,25 @@ bool EventProcessor::Process(RawEvent &event) {
     if (!initDone)
         return (didProcess = false);
 
-    times(&tmsBegin);
-
+    getrusage(RUSAGE_THREAD, &processBegin);
     EndProcess();
     return (didProcess = true);
 }
 
+///The times are for the calling thread only, so the totals are the time
+/// that the processor spent on every thread.
 void EventProcessor::EndProcess(void) {
-    tms tmsEnd;
-
-    times(&tmsEnd);
-
-    userTime += (tmsEnd.tms_utime - tmsBegin.tms_utime) / clocksPerSecond;
-    systemTime += (tmsEnd.tms_stime - tmsBegin.tms_stime) / clocksPerSecond;
+    rusage processEnd;
+    getrusage(RUSAGE_THREAD, &processEnd);
+    {
+        lock_guard<mutex> lock(timingMutex_);
+        userTime += Seconds(processEnd.ru_utime, processBegin.ru_utime);
+        systemTime += Seconds(processEnd.ru_stime, processBegin.ru_stime);
+    }
 
     //! Reset the beginning time so multiple calls of EndProcess from
     //! derived classes work properly
-    times(&tmsBegin);
+    processBegin = processEnd;
 }
 
 
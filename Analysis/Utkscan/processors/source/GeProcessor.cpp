@@ -27,7 +27,8 @@ namespace dammIds {
 using namespace std;
 using namespace dammIds::ge;
 
-GeProcessor::GeProcessor() : EventProcessor(OFFSET, RANGE, "GeProcessor") {
+GeProcessor::GeProcessor() : EventProcessor(OFFSET, RANGE, "GeProcessor"),
+                             geSummaryId_(DetectorLibrary::get()->GetSummaryId("ge")) {
     associatedTypes.insert("ge"); // associate with germanium detectors
 }
 
@@ -39,8 +40,8 @@ bool GeProcessor::PreProcess(RawEvent &event) {
     if (!EventProcessor::PreProcess(event))
         return false;
 
-    static const vector<ChanEvent *> &geEvents =
-            event.GetSummary("ge", true)->GetList();
+    const vector<ChanEvent *> &geEvents =
+            event.GetSummary(geSummaryId_, true)->GetList();
 
     for (vector<ChanEvent *>::const_iterator ge = geEvents.begin();
          ge != geEvents.end(); ge++) {
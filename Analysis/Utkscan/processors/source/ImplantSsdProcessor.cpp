@@ -355,8 +355,8 @@ bool ImplantSsdProcessor::Process(RawEvent &event) {
         cout << "Flagging for pileup" << endl;
 
         cout << "fast trace " << fastTracesWritten << " in strip " << location << " : ";
-        vector<double> filterEnergies = trace.GetFilteredEnergies();
-        vector<unsigned int> filterTimes = trace.GetTriggerPositions();
+        const vector<double> &filterEnergies = trace.GetFilteredEnergies();
+        const vector<unsigned int> &filterTimes = trace.GetTriggerPositions();
         for(unsigned int filterCount = 0; filterCount < filterEnergies.size(); filterCount++)
             cout << filterEnergies.at(filterCount) << " " << filterTimes.at(filterCount) << " , ";
         cout << "  mcp mult " << info.mcpMult << endl;
@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include "DammPlotIds.hpp"
+#include "DetectorLibrary.hpp"
 #include "DetectorSummary.hpp"
 #include "RawEvent.hpp"
 #include "TemplateProcessor.hpp"
@@ -20,11 +21,13 @@ namespace dammIds {
 using namespace std;
 using namespace dammIds::dettemplate;
 
-TemplateProcessor::TemplateProcessor() : EventProcessor(OFFSET, RANGE, "TemplateProcessor") {
+TemplateProcessor::TemplateProcessor() : EventProcessor(OFFSET, RANGE, "TemplateProcessor"),
+                                         templateSummaryId_(DetectorLibrary::get()->GetSummaryId("template")) {
     associatedTypes.insert("template");
 }
 
-TemplateProcessor::TemplateProcessor(const double &a) : EventProcessor(OFFSET, RANGE, "TemplateProcessor") {
+TemplateProcessor::TemplateProcessor(const double &a) : EventProcessor(OFFSET, RANGE, "TemplateProcessor"),
+                                                         templateSummaryId_(DetectorLibrary::get()->GetSummaryId("template")) {
     associatedTypes.insert("template");
     a_ = a;
 }
@@ -38,7 +41,7 @@ bool TemplateProcessor::PreProcess(RawEvent &event) {
     if (!EventProcessor::PreProcess(event))
         return false;
 
-    evts_ = event.GetSummary("template")->GetList();
+    evts_ = event.GetSummary(templateSummaryId_)->GetList();
 
     for (vector<ChanEvent *>::const_iterator it = evts_.begin(); it != evts_.end(); it++) {
         unsigned int location = (*it)->GetChanID().GetLocation();
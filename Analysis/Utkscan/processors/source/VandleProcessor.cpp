@@ -16,6 +16,7 @@
 #include "BarBuilder.hpp"
 #include "DammPlotIds.hpp"
 #include "DetectorDriver.hpp"
+#include "DetectorLibrary.hpp"
 #include "RawEvent.hpp"
 #include "TimingMapBuilder.hpp"
 #include "VandleProcessor.hpp"
@@ -44,13 +45,14 @@ namespace dammIds {
 using namespace std;
 using namespace dammIds::vandle;
 
-VandleProcessor::VandleProcessor() : EventProcessor(OFFSET, RANGE, "VandleProcessor") {
+VandleProcessor::VandleProcessor() : EventProcessor(OFFSET, RANGE, "VandleProcessor"),
+                                     geSummaryId_(DetectorLibrary::get()->GetSummaryId("clover")) {
     associatedTypes.insert("vandle");
 }
 
 VandleProcessor::VandleProcessor(const std::vector<std::string> &typeList, const double &res, const double &offset,
                                  const unsigned int &numStarts, const double &compression/*=1.0*/) :
-        EventProcessor(OFFSET,RANGE,"VandleProcessor") {
+        EventProcessor(OFFSET,RANGE,"VandleProcessor"), geSummaryId_(DetectorLibrary::get()->GetSummaryId("clover")) {
     associatedTypes.insert("vandle");
     plotMult_ = res;
     plotOffset_ = offset;
@@ -114,7 +116,7 @@ bool VandleProcessor::Process(RawEvent &event) {
 
     histo.Plot(D_DEBUGGING, 30);
 
-    geSummary_ = event.GetSummary("clover");
+    geSummary_ = event.GetSummary(geSummaryId_);
 
     static const vector<ChanEvent *> &betaStarts = event.GetSummary("beta_scint:beta")->GetList();
     static const vector<ChanEvent *> &liquidStarts = event.GetSummary("liquid:scint:start")->GetList();
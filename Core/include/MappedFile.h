@@ -0,0 +1,65 @@
+/** \file MappedFile.h
+  * \brief Maps a whole input file into memory so that it can be read in place.
+  *
+  * The mapping is private and writable. Changes never reach the file on disk,
+  * which lets a reader patch a few words around a spill while it is unpacked
+  * and put them back afterwards.
+  *
+  * \author S. V. Paulauskas
+  * \date October 18, 2026
+  */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+
+#include <stddef.h>
+
+class MappedFile {
+public:
+    /// Default constructor.
+    MappedFile();
+
+    /// Destructor, unmaps the file.
+    ~MappedFile();
+
+    /// Map a file into memory, any file that was mapped already is unmapped first.
+    /// \param[in] filename_ The path of the file to map.
+    /// \return True if the whole file was mapped.
+    bool Open(const std::string &filename_);
+
+    /// Unmap the file.
+    void Close();
+
+    /// \return True if a file is mapped.
+    bool IsOpen() const { return data != NULL; }
+
+    /// \return A pointer to the first byte of the file.
+    char *GetData() { return data; }
+
+    /// \return The length of the file in bytes.
+    size_t GetLength() const { return length; }
+
+    /// Set the number of bytes that we ask the kernel to read ahead of the reader.
+    void SetReadahead(const size_t &bytes_) { readahead = bytes_; }
+
+    /** Tell the kernel where the reader is. The next readahead window is requested once the reader is halfway
+      * through the last one, and the pages that are a full window behind the reader are released so that scanning
+      * a large run does not fill up memory.
+      * \param[in] offset_ The number of bytes into the file that the reader has reached.
+      */
+    void Advise(const size_t &offset_);
+
+private:
+    char *data; /// The start of the mapping.
+    size_t length; /// The length of the file in bytes.
+    size_t readahead; /// The size of the readahead window in bytes.
+    size_t advised; /// The end of the last window that we asked the kernel to read.
+    size_t released; /// Everything before this offset has been released.
+    size_t pageSize; /// The page size of the system.
+
+    /// \return The offset rounded down to a page boundary.
+    size_t PageFloor(const size_t &offset_) const { return offset_ - offset_ % pageSize; }
+};
+
+#endif
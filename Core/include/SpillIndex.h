@@ -0,0 +1,91 @@
+/** \file SpillIndex.h
+  * \brief An index of the spills in a pld or ldf file, kept in a sidecar file next to the data.
+  *
+  * Each entry records where a reader should start in the data file to get a
+  * spill, how many words the spill has, and the earliest and latest event
+  * times in it. With the index a reader can seek straight to a spill or to a
+  * time in the run instead of scanning the file from the start.
+  *
+  * \author S. V. Paulauskas
+  * \date October 18, 2026
+  */
+#ifndef SPILL_INDEX_H
+#define SPILL_INDEX_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// The index information for a single spill.
+struct SpillIndexEntry {
+    unsigned long long offset; /// Byte offset in the data file at which a reader should start to get the spill.
+    unsigned int nWords; /// Number of words in the spill.
+    unsigned int numEvents; /// Number of events that were found in the spill.
+    unsigned long long firstTime; /// Earliest event time in the spill in clock ticks.
+    unsigned long long lastTime; /// Latest event time in the spill in clock ticks.
+};
+
+class SpillIndex {
+public:
+    /// Default constructor.
+    SpillIndex();
+
+    /// Destructor, closes the index file if we're writing one.
+    ~SpillIndex() { Close(); }
+
+    /// \return The name of the index file that goes with a data file.
+    static std::string GetIndexFilename(const std::string &data_filename_) { return data_filename_ + ".idx"; }
+
+    /** Find the earliest and latest event times in a spill. The spill is made up of module buffers, each one starts
+      * with its length (including the two word header) and module number followed by the events from the FIFO.
+      * \param[in]  data_   Pointer to the spill.
+      * \param[in]  nWords_ The number of words in the spill.
+      * \param[out] first_  The earliest event time that was found.
+      * \param[out] last_   The latest event time that was found.
+      * \return The number of events that were found, the times are only set if this is not zero.
+      */
+    static unsigned int ScanSpill(const unsigned int *data_, const unsigned int &nWords_, unsigned long long &first_,
+                                  unsigned long long &last_);
+
+    /// Create a new index file, the entries are written to it as they're added.
+    bool Create(const std::string &filename_);
+
+    /** Add a spill to the index file that we're writing.
+      * \param[in]  offset_ The byte offset at which a reader should start to get the spill.
+      * \param[in]  data_   Pointer to the spill.
+      * \param[in]  nWords_ The number of words in the spill.
+      * \return True if the entry was written.
+      */
+    bool Add(const unsigned long long &offset_, const unsigned int *data_, const unsigned int &nWords_);
+
+    /// Close the index file that we're writing.
+    void Close();
+
+    /// Load all of the entries from an index file.
+    bool Load(const std::string &filename_);
+
+    /// \return The entries that were loaded.
+    const std::vector<SpillIndexEntry> &GetEntries() const { return entries; }
+
+    /// \return The earliest event time in the indexed file.
+    unsigned long long GetStartTime() const;
+
+    /// \return The first spill whose events reach the time, or the number of spills if there are none.
+    size_t FindFirstSpill(const unsigned long long &time_) const;
+
+    /// \return One past the last spill that has events at or before the time.
+    size_t FindStopSpill(const unsigned long long &time_) const;
+
+private:
+    std::ofstream file; /// The index file that we're writing.
+    std::vector<SpillIndexEntry> entries; /// The entries loaded from an index file.
+    unsigned long long lastTime; /// The latest time written so far, given to spills without any events.
+
+    /** Walk the events in a module buffer with the provided event length mask.
+      * \return True if the events exactly fill the buffer.
+      */
+    static bool ScanModule(const unsigned int *data_, const unsigned int &nWords_, const unsigned int &lengthMask_,
+                           unsigned int &numEvents_, unsigned long long &first_, unsigned long long &last_);
+};
+
+#endif
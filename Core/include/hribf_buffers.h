@@ -24,6 +24,8 @@
 #include <fstream>
 #include <vector>
 
+#include "SpillIndex.h"
+
 #define HRIBF_BUFFERS_VERSION "1.3.00"
 #define HRIBF_BUFFERS_DATE "Sept. 19th, 2016"
 
@@ -151,6 +153,19 @@ public:
     virtual bool Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
                       unsigned int max_bytes_, bool dry_run_mode = false);
 
+    /** Find the next data spill in a file that has been mapped into memory. Nothing is copied, data_ points at the
+      * spill inside of the mapping.
+      * \param[in]  map_        Pointer to the start of the mapped file.
+      * \param[in]  map_length_ The length of the mapped file in bytes.
+      * \param[in,out] offset_  The byte offset to start looking at, on success it is moved past the spill.
+      * \param[out] data_       Pointer to the first word of the spill.
+      * \param[out] nBytes      The size of the spill in bytes.
+      * \param[in]  max_bytes_  The largest spill that we will accept in bytes.
+      * \return True if a complete spill was found.
+      */
+    bool Read(char *map_, const size_t &map_length_, size_t &offset_, unsigned int *&data_, unsigned int &nBytes,
+              unsigned int max_bytes_);
+
     /// Set initial values.
     virtual void Reset() {}
 };
@@ -258,6 +273,7 @@ private:
     unsigned int missing_chunks; /// Count of the number of missing spill chunks which were dropped.
 
     unsigned int buff_pos; /// The actual position in the current ldf buffer.
+    unsigned int spill_start; /// The ldf buffer, counted from the first one read, holding the start of the last full spill.
 
     /// DATA buffer (1 word buffer type, 1 word buffer size)
     bool open_(std::ofstream *file_);
@@ -292,6 +308,10 @@ public:
     /// Return the number of missing or dropped spill chunks.
     unsigned int GetNumMissing() { return missing_chunks; }
 
+    /// Return the ldf buffer, counted from the first one read since the last reset, that held the first chunk of the
+    /// last full spill which was read.
+    unsigned int GetSpillStartBuffer() { return spill_start; }
+
     /// Write a data spill to file
     virtual bool Write(std::ofstream *file_, char *data_, unsigned int nWords_,
                        int &buffs_written);
@@ -332,6 +352,7 @@ private:
     HEAD_buffer headBuff;
     DATA_buffer dataBuff;
     EOF_buffer eofBuff;
+    SpillIndex spill_index; /// The index of the spills in the current file.
     unsigned int max_spill_size;
     unsigned int current_file_num;
     unsigned int output_format;
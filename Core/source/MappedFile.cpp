@@ -0,0 +1,90 @@
+/** \file MappedFile.cpp
+  * \brief Maps a whole input file into memory so that it can be read in place.
+  *
+  * \author S. V. Paulauskas
+  * \date October 18, 2026
+  */
+#include <algorithm>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+/// 64 MB is enough to keep a fast disk busy without holding on to much memory.
+MappedFile::MappedFile() : data(NULL), length(0), readahead(64 * 1024 * 1024), advised(0), released(0) {
+    pageSize = (size_t) sysconf(_SC_PAGESIZE);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string &filename_) {
+    Close();
+
+    int fd = open(filename_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "MappedFile::Open - Unable to open " << filename_ << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        std::cout << "MappedFile::Open - Unable to get the size of " << filename_ << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, (size_t) info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        std::cout << "MappedFile::Open - Unable to map " << filename_ << std::endl;
+        return false;
+    }
+
+    data = (char *) mapping;
+    length = (size_t) info.st_size;
+    advised = released = 0;
+
+    madvise(data, length, MADV_SEQUENTIAL);
+    Advise(0);
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data)
+        munmap(data, length);
+    data = NULL;
+    length = advised = released = 0;
+}
+
+void MappedFile::Advise(const size_t &offset_) {
+    if (!data)
+        return;
+
+    // The reader may have been moved back, e.g. by a rewind.
+    if (offset_ < released)
+        released = PageFloor(offset_);
+    if (offset_ + readahead < advised)
+        advised = offset_;
+
+    if (offset_ + readahead / 2 >= advised && advised < length) {
+        size_t start = PageFloor(std::max(offset_, advised));
+        size_t stop = std::min(length, offset_ + readahead);
+        madvise(data + start, stop - start, MADV_WILLNEED);
+        advised = stop;
+    }
+
+    if (offset_ > released + 2 * readahead) {
+        size_t stop = PageFloor(offset_ - readahead);
+        madvise(data + released, stop - released, MADV_DONTNEED);
+        released = stop;
+    }
+}
@@ -0,0 +1,180 @@
+/** \file SpillIndex.cpp
+  * \brief An index of the spills in a pld or ldf file, kept in a sidecar file next to the data.
+  *
+  * \author S. V. Paulauskas
+  * \date October 18, 2026
+  */
+#include <algorithm>
+#include <iostream>
+
+#include "SpillIndex.h"
+
+namespace {
+    const unsigned int indexMagic = 0x58444953; // "SIDX"
+    const unsigned int indexVersion = 1;
+    const unsigned int endSpillVsn = 9999;
+    const unsigned int wallClockVsn = 1000;
+    const unsigned int minimumEventLength = 4;
+}
+
+SpillIndex::SpillIndex() : lastTime(0) {}
+
+unsigned int SpillIndex::ScanSpill(const unsigned int *data_, const unsigned int &nWords_,
+                                   unsigned long long &first_, unsigned long long &last_) {
+    unsigned int numEvents = 0;
+    unsigned int pos = 0;
+    while (pos + 2 <= nWords_) {
+        if (data_[pos] == 0xFFFFFFFF) { // Delimiters between buffers
+            pos++;
+            continue;
+        }
+
+        unsigned int lenRec = data_[pos];
+        unsigned int vsn = data_[pos + 1];
+        if (vsn == endSpillVsn || lenRec < 2 || pos + lenRec > nWords_)
+            break;
+
+        // The newer firmwares use bit 30 for the event length, the older ones don't. Only one of the two masks
+        // walks the events so that they exactly fill the buffer.
+        if (vsn != wallClockVsn && lenRec > 2) {
+            if (!ScanModule(&data_[pos + 2], lenRec - 2, 0x7FFE0000, numEvents, first_, last_))
+                ScanModule(&data_[pos + 2], lenRec - 2, 0x3FFE0000, numEvents, first_, last_);
+        }
+        pos += lenRec;
+    }
+    return numEvents;
+}
+
+bool SpillIndex::ScanModule(const unsigned int *data_, const unsigned int &nWords_, const unsigned int &lengthMask_,
+                            unsigned int &numEvents_, unsigned long long &first_, unsigned long long &last_) {
+    unsigned int numEvents = 0;
+    unsigned long long first = 0, last = 0;
+    unsigned int pos = 0;
+    while (pos < nWords_) {
+        unsigned int eventLength = (data_[pos] & lengthMask_) >> 17;
+        if (eventLength < minimumEventLength || pos + eventLength > nWords_)
+            return false;
+
+        unsigned long long time = ((unsigned long long) (data_[pos + 2] & 0xFFFF) << 32) | data_[pos + 1];
+        if (numEvents == 0 || time < first)
+            first = time;
+        if (numEvents == 0 || time > last)
+            last = time;
+        numEvents++;
+        pos += eventLength;
+    }
+
+    if (numEvents != 0) {
+        if (numEvents_ == 0 || first < first_)
+            first_ = first;
+        if (numEvents_ == 0 || last > last_)
+            last_ = last;
+        numEvents_ += numEvents;
+    }
+    return true;
+}
+
+bool SpillIndex::Create(const std::string &filename_) {
+    Close();
+    lastTime = 0;
+
+    file.open(filename_.c_str(), std::ios::binary);
+    if (!file.is_open() || !file.good()) {
+        std::cout << "SpillIndex::Create - Unable to open " << filename_ << std::endl;
+        file.close();
+        return false;
+    }
+
+    file.write((char *) &indexMagic, 4);
+    file.write((char *) &indexVersion, 4);
+    return true;
+}
+
+bool SpillIndex::Add(const unsigned long long &offset_, const unsigned int *data_, const unsigned int &nWords_) {
+    if (!file.is_open() || !file.good())
+        return false;
+
+    SpillIndexEntry entry;
+    entry.offset = offset_;
+    entry.nWords = nWords_;
+    entry.numEvents = ScanSpill(data_, nWords_, entry.firstTime, entry.lastTime);
+
+    // A spill without any events is placed at the end of the last one so that the times never go backwards.
+    if (entry.numEvents == 0)
+        entry.firstTime = entry.lastTime = lastTime;
+    else
+        lastTime = std::max(lastTime, entry.lastTime);
+
+    file.write((char *) &entry.offset, 8);
+    file.write((char *) &entry.nWords, 4);
+    file.write((char *) &entry.numEvents, 4);
+    file.write((char *) &entry.firstTime, 8);
+    file.write((char *) &entry.lastTime, 8);
+    return file.good();
+}
+
+void SpillIndex::Close() {
+    if (file.is_open())
+        file.close();
+}
+
+bool SpillIndex::Load(const std::string &filename_) {
+    entries.clear();
+
+    std::ifstream input(filename_.c_str(), std::ios::binary);
+    if (!input.is_open() || !input.good())
+        return false;
+
+    unsigned int magic = 0, version = 0;
+    input.read((char *) &magic, 4);
+    input.read((char *) &version, 4);
+    if (!input.good() || magic != indexMagic || version != indexVersion) {
+        std::cout << "SpillIndex::Load - " << filename_ << " is not a spill index we know how to read." << std::endl;
+        return false;
+    }
+
+    SpillIndexEntry entry;
+    while (input.read((char *) &entry.offset, 8) && input.read((char *) &entry.nWords, 4) &&
+           input.read((char *) &entry.numEvents, 4) && input.read((char *) &entry.firstTime, 8) &&
+           input.read((char *) &entry.lastTime, 8))
+        entries.push_back(entry);
+
+    // A run that was interrupted can leave a partial entry at the end, which we ignore.
+    return true;
+}
+
+unsigned long long SpillIndex::GetStartTime() const {
+    for (std::vector<SpillIndexEntry>::const_iterator it = entries.begin(); it != entries.end(); it++)
+        if (it->numEvents != 0)
+            return it->firstTime;
+    return 0;
+}
+
+size_t SpillIndex::FindFirstSpill(const unsigned long long &time_) const {
+    std::vector<SpillIndexEntry>::const_iterator it = entries.begin();
+    size_t count = entries.size();
+    // The last times never go backwards, so we can bisect on them.
+    while (count > 0) {
+        size_t step = count / 2;
+        if ((it + step)->lastTime < time_) {
+            it += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    return it - entries.begin();
+}
+
+size_t SpillIndex::FindStopSpill(const unsigned long long &time_) const {
+    std::vector<SpillIndexEntry>::const_iterator it = entries.begin();
+    size_t count = entries.size();
+    while (count > 0) {
+        size_t step = count / 2;
+        if ((it + step)->firstTime <= time_) {
+            it += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    return it - entries.begin();
+}
@@ -348,6 +348,64 @@ bool PLD_data::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
     return true;
 }
 
+/// Read a pld style data buffer from a file that has been mapped into memory.
+bool PLD_data::Read(char *map_, const size_t &map_length_, size_t &offset_, unsigned int *&data_,
+                    unsigned int &nBytes, unsigned int max_bytes_) {
+    if (!map_ || offset_ % 4 != 0) { return false; }
+
+    // Search for the start of the next DATA buffer.
+    unsigned int countw = 0;
+    while (offset_ + 8 <= map_length_ && *(unsigned int *) (map_ + offset_) != bufftype) {
+        offset_ += 4;
+        countw++;
+    }
+
+    if (offset_ + 8 > map_length_) {
+        if (debug_mode) {
+            std::cout << "debug: encountered physical end-of-file before start of spill!\n";
+        }
+        return false;
+    }
+
+    if (countw != 0 && debug_mode) {
+        std::cout << "debug: not a valid DATA buffer\n";
+        std::cout << "debug: read an extra " << countw << " words to get to first DATA buffer!\n";
+    }
+
+    nBytes = *(unsigned int *) (map_ + offset_ + 4) * 4;
+
+    if (debug_mode) {
+        std::cout << "debug: reading spill of " << nBytes << " bytes\n";
+    }
+
+    if (nBytes > max_bytes_) {
+        if (debug_mode) {
+            std::cout << "debug: spill size is greater than size of data array!\n";
+        }
+        return false;
+    }
+
+    if (offset_ + 12 + nBytes > map_length_) {
+        if (debug_mode) {
+            std::cout << "debug: encountered physical end-of-file in the middle of a spill!\n";
+        }
+        return false;
+    }
+
+    data_ = (unsigned int *) (map_ + offset_ + 8);
+    unsigned int end_buff_check = *(unsigned int *) (map_ + offset_ + 8 + nBytes);
+    offset_ += 12 + nBytes;
+
+    if (end_buff_check != buffend) { // Buffer was not terminated properly
+        if (debug_mode) {
+            std::cout << "debug: buffer not terminated properly\n";
+        }
+        return false;
+    }
+
+    return true;
+}
+
 /// Default constructor.
 DIR_buffer::DIR_buffer() : BufferType(DIR,
                                       NO_HEADER_SIZE) { // 0x20524944 "DIR "
@@ -640,6 +698,7 @@ DATA_buffer::DATA_buffer() : BufferType(DATA,
     good_chunks = 0;
     missing_chunks = 0;
     buff_pos = 0;
+    spill_start = 0;
     this->Reset();
 }
 
@@ -841,7 +900,10 @@ bool DATA_buffer::Read(std::ifstream *file_, char *data_, unsigned int &nBytes,
                     missing_chunks += current_chunk_num;
 
                     full_spill = false;
-                } else { full_spill = true; }
+                } else {
+                    full_spill = true;
+                    spill_start = bcount - 1;
+                }
                 first_chunk = false;
             } else if (total_num_chunks != prev_num_chunks) {
                 if (debug_mode) {
@@ -1003,6 +1065,7 @@ void DATA_buffer::Reset() {
     retval = 0;
     good_chunks = 0;
     missing_chunks = 0;
+    spill_start = 0;
 }
 
 EOF_buffer::EOF_buffer() : BufferType(ENDFILE, NO_HEADER_SIZE) {} // 0x20464F45 "EOF "
@@ -1226,6 +1289,12 @@ int PollOutputFile::Write(char *data_, unsigned int nWords_) {
 
     if (nWords_ > max_spill_size) { max_spill_size = nWords_; }
 
+    // A reader has to start at the beginning of an ldf buffer, the spill may be packed in after the end of the last
+    // one. Every buffer in an ldf file is the same size, so the buffer that we're in starts at a multiple of it.
+    unsigned long long offset = output_file.tellp();
+    if (output_format == 0)
+        offset -= offset % (4 * ACTUAL_BUFF_SIZE);
+
     // Write data to disk
     int buffs_written;
     if (output_format == 0) {
@@ -1243,6 +1312,8 @@ int PollOutputFile::Write(char *data_, unsigned int nWords_) {
     }
     number_spills++;
 
+    spill_index.Add(offset, (unsigned int *) data_, nWords_);
+
     return buffs_written;
 }
 
@@ -1346,6 +1417,9 @@ bool PollOutputFile::OpenNewFile(std::string title_, unsigned int &run_num_, std
     current_filename = filename;
     get_full_filename(current_full_filename);
 
+    // The index is only an aid for readers, the run goes on without it.
+    spill_index.Create(SpillIndex::GetIndexFilename(filename));
+
     if (output_format == 0) {
         dirBuff.SetRunNumber(run_num_);
         dirBuff.Write(&output_file); // Every .ldf file gets a DIR header
@@ -1423,6 +1497,8 @@ unsigned int PollOutputFile::GetRunNumber() {
 
 /// Write the footer and close the file.
 void PollOutputFile::CloseFile(float total_run_time_/*=0.0*/) {
+    spill_index.Close();
+
     if (!output_file.is_open() || !output_file.good()) { return; }
 
     if (output_format == 0) {
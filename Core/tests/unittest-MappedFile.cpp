@@ -0,0 +1,102 @@
+///@file unittest-MappedFile.cpp
+///@brief Checks that spills read from a mapped pld file match the ones read through a stream.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <fstream>
+#include <vector>
+
+#include <cstdio>
+
+#include <UnitTest++.h>
+
+#include "hribf_buffers.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace unittest_mapped_file {
+    static const char *filename = "unittest-MappedFile.pld";
+    static const unsigned int maxSpillWords = 1000;
+
+    ///@return The spills that we write to the file, each one has a different length.
+    vector<vector<unsigned int> > MakeSpills() {
+        vector<vector<unsigned int> > spills;
+        for (unsigned int spill = 1; spill <= 5; spill++)
+            spills.push_back(vector<unsigned int>(spill * 100, spill));
+        return spills;
+    }
+
+    ///Writes the spills into a pld file with a few stray words between two of the spills.
+    void WriteFile(const vector<vector<unsigned int> > &spills) {
+        ofstream file(filename, ios::binary);
+        PLD_data writer;
+        for (unsigned int i = 0; i < spills.size(); i++) {
+            writer.Write(&file, (char *) spills[i].data(), spills[i].size());
+            if (i == 1) {
+                unsigned int stray = 0x12345678;
+                file.write((char *) &stray, 4);
+            }
+        }
+    }
+}
+
+using namespace unittest_mapped_file;
+
+TEST(TestMappedSpillsMatchStream) {
+    vector<vector<unsigned int> > spills = MakeSpills();
+    WriteFile(spills);
+
+    MappedFile mapped;
+    CHECK(mapped.Open(filename));
+    mapped.SetReadahead(4096);
+
+    PLD_data reader;
+    size_t offset = 0;
+    unsigned int *spill = NULL;
+    unsigned int nBytes = 0;
+    for (unsigned int i = 0; i < spills.size(); i++) {
+        CHECK(reader.Read(mapped.GetData(), mapped.GetLength(), offset, spill, nBytes, 4 * maxSpillWords));
+        mapped.Advise(offset);
+        CHECK_EQUAL(4 * spills[i].size(), nBytes);
+        CHECK_ARRAY_EQUAL(spills[i], spill, spills[i].size());
+    }
+    CHECK_EQUAL(mapped.GetLength(), offset);
+    CHECK(!reader.Read(mapped.GetData(), mapped.GetLength(), offset, spill, nBytes, 4 * maxSpillWords));
+
+    //Changing the mapping must not change the file.
+    mapped.GetData()[8] = 0;
+    mapped.Close();
+    ifstream file(filename, ios::binary);
+    vector<unsigned int> streamed(maxSpillWords);
+    CHECK(reader.Read(&file, (char *) streamed.data(), nBytes, 4 * maxSpillWords));
+    CHECK_ARRAY_EQUAL(spills[0], streamed, spills[0].size());
+
+    remove(filename);
+}
+
+TEST(TestOversizedSpill) {
+    vector<vector<unsigned int> > spills = MakeSpills();
+    WriteFile(spills);
+
+    MappedFile mapped;
+    CHECK(mapped.Open(filename));
+
+    PLD_data reader;
+    size_t offset = 0;
+    unsigned int *spill = NULL;
+    unsigned int nBytes = 0;
+    CHECK(!reader.Read(mapped.GetData(), mapped.GetLength(), offset, spill, nBytes, 4 * 50));
+    CHECK_EQUAL(0u, offset);
+
+    remove(filename);
+}
+
+TEST(TestMissingFile) {
+    MappedFile mapped;
+    CHECK(!mapped.Open("this-file-does-not-exist.pld"));
+    CHECK(!mapped.IsOpen());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
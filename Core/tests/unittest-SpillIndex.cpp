@@ -0,0 +1,196 @@
+///@file unittest-SpillIndex.cpp
+///@brief Checks the spill index that is written next to the data files, and that seeking with it finds the spills.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+
+#include <UnitTest++.h>
+
+#include "hribf_buffers.h"
+#include "SpillIndex.h"
+
+using namespace std;
+
+namespace unittest_spill_index {
+    static const unsigned int eventLength = 4;
+    static const unsigned long long ticksPerSpill = 1000000;
+
+    ///@return An event header with the provided length and time.
+    void AddEvent(vector<unsigned int> &spill, const unsigned int &length, const unsigned long long &time) {
+        spill.push_back(length << 17);
+        spill.push_back((unsigned int) (time & 0xFFFFFFFF));
+        spill.push_back((unsigned int) (time >> 32));
+        for (unsigned int i = 3; i < length; i++)
+            spill.push_back(i);
+    }
+
+    ///@return A spill with a single module whose events start at a time set by the spill number.
+    vector<unsigned int> MakeSpill(const unsigned int &number, const unsigned int &numEvents) {
+        vector<unsigned int> spill;
+        spill.push_back(2 + numEvents * eventLength);
+        spill.push_back(0);
+        for (unsigned int i = 0; i < numEvents; i++)
+            AddEvent(spill, eventLength, (number + 1) * ticksPerSpill + i * 10);
+        return spill;
+    }
+
+    ///@return Spills that are small enough to share an ldf buffer, mixed with ones that take up several buffers.
+    vector<vector<unsigned int> > MakeSpills() {
+        vector<vector<unsigned int> > spills;
+        for (unsigned int i = 0; i < 12; i++)
+            spills.push_back(MakeSpill(i, i % 4 == 3 ? 5000 : 300));
+        return spills;
+    }
+
+    ///@return The name of the file that was written.
+    string WriteRun(const vector<vector<unsigned int> > &spills, const unsigned int &format) {
+        PollOutputFile output;
+        output.SetFileFormat(format);
+        unsigned int runNumber = 0;
+        output.OpenNewFile("unittest", runNumber, "unittest-SpillIndex", "./");
+        string filename = output.GetCurrentFilename();
+        for (unsigned int i = 0; i < spills.size(); i++)
+            output.Write((char *) spills[i].data(), spills[i].size());
+        output.CloseFile();
+        return filename;
+    }
+}
+
+using namespace unittest_spill_index;
+
+TEST(TestScanSpill) {
+    vector<unsigned int> spill = MakeSpill(0, 10);
+
+    //A second module from older firmware, whose event lengths do not use bit 30. The wall clock buffer is skipped.
+    spill.push_back(2 + 2 * eventLength);
+    spill.push_back(1);
+    AddEvent(spill, eventLength, 50);
+    spill[spill.size() - eventLength] |= 0x40000000;
+    AddEvent(spill, eventLength, 5000000);
+    spill.push_back(4);
+    spill.push_back(1000);
+    spill.push_back(1);
+    spill.push_back(2);
+    spill.push_back(2);
+    spill.push_back(9999);
+
+    unsigned long long first = 0, last = 0;
+    CHECK_EQUAL(12u, SpillIndex::ScanSpill(spill.data(), spill.size(), first, last));
+    CHECK_EQUAL(50u, first);
+    CHECK_EQUAL(5000000u, last);
+
+    vector<unsigned int> empty = {2, 0, 2, 9999};
+    CHECK_EQUAL(0u, SpillIndex::ScanSpill(empty.data(), empty.size(), first, last));
+}
+
+TEST(TestFindSpills) {
+    static const char *filename = "unittest-SpillIndex.idx";
+    vector<vector<unsigned int> > spills = MakeSpills();
+    vector<unsigned int> empty = {2, 0};
+
+    SpillIndex writer;
+    CHECK(writer.Create(filename));
+    for (unsigned int i = 0; i < 4; i++)
+        CHECK(writer.Add(i * 100, spills[i].data(), spills[i].size()));
+    CHECK(writer.Add(400, empty.data(), empty.size()));
+    writer.Close();
+
+    SpillIndex index;
+    CHECK(index.Load(filename));
+    CHECK_EQUAL(5u, index.GetEntries().size());
+    CHECK_EQUAL(300u, index.GetEntries()[3].offset);
+    CHECK_EQUAL(5000u, index.GetEntries()[3].numEvents);
+    CHECK_EQUAL(ticksPerSpill, index.GetStartTime());
+    CHECK_EQUAL(index.GetEntries()[3].lastTime, index.GetEntries()[4].firstTime);
+
+    CHECK_EQUAL(0u, index.FindFirstSpill(0));
+    CHECK_EQUAL(2u, index.FindFirstSpill(2 * ticksPerSpill + 5000));
+    CHECK_EQUAL(3u, index.FindFirstSpill(3 * ticksPerSpill + 5000));
+    CHECK_EQUAL(0u, index.FindStopSpill(0));
+    CHECK_EQUAL(2u, index.FindStopSpill(2 * ticksPerSpill + 5000));
+
+    remove(filename);
+    CHECK(!index.Load(filename));
+}
+
+TEST(TestSeekPld) {
+    vector<vector<unsigned int> > spills = MakeSpills();
+    string filename = WriteRun(spills, 1);
+
+    SpillIndex index;
+    CHECK(index.Load(SpillIndex::GetIndexFilename(filename)));
+    CHECK_EQUAL(spills.size(), index.GetEntries().size());
+
+    ifstream file(filename.c_str(), ios::binary);
+    PLD_data reader;
+    vector<unsigned int> data(6000 * eventLength);
+    unsigned int nBytes;
+    for (unsigned int i = spills.size(); i-- > 0;) {
+        file.seekg(index.GetEntries()[i].offset);
+        CHECK(reader.Read(&file, (char *) data.data(), nBytes, 4 * data.size()));
+        CHECK_EQUAL(4 * spills[i].size(), nBytes);
+        CHECK_ARRAY_EQUAL(spills[i], data, spills[i].size());
+    }
+
+    remove(filename.c_str());
+    remove(SpillIndex::GetIndexFilename(filename).c_str());
+}
+
+///Starting at an ldf buffer we may first get the tail of an earlier spill, which is not a full spill, and the full
+/// spills that start in the same buffer before the one we want.
+TEST(TestSeekLdf) {
+    vector<vector<unsigned int> > spills = MakeSpills();
+    string filename = WriteRun(spills, 0);
+
+    SpillIndex index;
+    CHECK(index.Load(SpillIndex::GetIndexFilename(filename)));
+    const vector<SpillIndexEntry> &entries = index.GetEntries();
+    CHECK_EQUAL(spills.size(), entries.size());
+
+    ifstream file(filename.c_str(), ios::binary);
+    vector<unsigned int> data(6000 * eventLength);
+    unsigned int nBytes;
+    bool fullSpill, badSpill;
+    for (unsigned int i = 0; i < spills.size(); i++) {
+        unsigned int toSkip = 0;
+        while (toSkip < i && entries[i - toSkip - 1].offset == entries[i].offset)
+            toSkip++;
+
+        file.clear();
+        file.seekg(entries[i].offset);
+        DATA_buffer reader;
+        while (reader.Read(&file, (char *) data.data(), nBytes, 4 * data.size(), fullSpill, badSpill)) {
+            if (fullSpill && toSkip-- == 0)
+                break;
+        }
+        CHECK(fullSpill);
+        CHECK_EQUAL(4 * (spills[i].size() + 2), nBytes);
+        CHECK_ARRAY_EQUAL(spills[i], data, spills[i].size());
+    }
+
+    //This is how the index builder finds the offsets in a file that has no index.
+    file.clear();
+    file.seekg(0);
+    DIR_buffer dir;
+    HEAD_buffer head;
+    DATA_buffer reader;
+    dir.Read(&file);
+    head.Read(&file);
+    unsigned long long dataStart = file.tellg();
+    for (unsigned int i = 0; i < spills.size(); i++) {
+        CHECK(reader.Read(&file, (char *) data.data(), nBytes, 4 * data.size(), fullSpill, badSpill));
+        CHECK(fullSpill);
+        CHECK_EQUAL(entries[i].offset, dataStart + reader.GetSpillStartBuffer() * 4 * ACTUAL_BUFF_SIZE);
+    }
+
+    remove(filename.c_str());
+    remove(SpillIndex::GetIndexFilename(filename).c_str());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
@@ -0,0 +1,102 @@
+///@file BoundedQueue.hpp
+///@brief A fixed size, lock-free queue for handing work between exactly two threads.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef PIXIESUITE_BOUNDEDQUEUE_HPP
+#define PIXIESUITE_BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///A bounded single-producer, single-consumer ring buffer. Exactly one thread may call the push methods and exactly
+/// one (other) thread may call the pop methods. No locks are taken, the two threads only communicate through the
+/// head and tail indices. The blocking methods spin for a short while, then yield, then sleep, so that an idle stage
+/// does not burn an entire core. The storage is allocated once in the constructor.
+template<typename T>
+class BoundedQueue {
+public:
+    ///Constructor
+    ///@param[in] capacity : The maximum number of elements that the queue can hold.
+    BoundedQueue(const size_t &capacity) : buffer_(capacity + 1), head_(0), tail_(0) {}
+
+    ///Default Destructor
+    ~BoundedQueue() {}
+
+    ///@return The maximum number of elements that the queue can hold.
+    size_t GetCapacity() const { return buffer_.size() - 1; }
+
+    ///@return True if there is nothing in the queue. Only exact when called from the consumer.
+    bool IsEmpty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+    ///Attempts to add an element to the queue. The element is moved into the queue when this succeeds.
+    ///@param[in] item : The element to add.
+    ///@return False if the queue was full.
+    bool TryPush(T &item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = Next(tail);
+        if (next == head_.load(std::memory_order_acquire))
+            return false;
+        buffer_[tail] = std::move(item);
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    ///Attempts to remove the next element from the queue.
+    ///@param[out] item : The element that was removed.
+    ///@return False if the queue was empty.
+    bool TryPop(T &item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+        item = std::move(buffer_[head]);
+        head_.store(Next(head), std::memory_order_release);
+        return true;
+    }
+
+    ///Adds an element to the queue, waiting for space if the queue is full.
+    ///@param[in] item : The element to add.
+    ///@return True if we had to wait for the consumer, this is used to monitor back-pressure.
+    bool Push(T &item) {
+        if (TryPush(item))
+            return false;
+        for (unsigned int attempt = 0; !TryPush(item); attempt++)
+            Backoff(attempt);
+        return true;
+    }
+
+    ///Removes the next element from the queue, waiting for one to arrive if the queue is empty.
+    ///@param[out] item : The element that was removed.
+    ///@return True if we had to wait for the producer.
+    bool Pop(T &item) {
+        if (TryPop(item))
+            return false;
+        for (unsigned int attempt = 0; !TryPop(item); attempt++)
+            Backoff(attempt);
+        return true;
+    }
+
+private:
+    std::vector<T> buffer_; ///< The storage, one slot is always left empty to tell a full queue from an empty one.
+    std::atomic<size_t> head_; ///< The next slot to be read, only written by the consumer.
+    char padding_[64]; ///< Keeps the two indices off of the same cache line.
+    std::atomic<size_t> tail_; ///< The next slot to be written, only written by the producer.
+
+    ///@return The index of the slot after the provided one.
+    size_t Next(const size_t &idx) const { return idx + 1 == buffer_.size() ? 0 : idx + 1; }
+
+    ///Waits a little bit longer each time we're called.
+    ///@param[in] attempt : The number of times that we've already waited.
+    static void Backoff(const unsigned int &attempt) {
+        if (attempt < 64)
+            return;
+        if (attempt < 128)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+};
+
+#endif //PIXIESUITE_BOUNDEDQUEUE_HPP
@@ -36,17 +36,22 @@ namespace Filtering {
                                    " long to filter the data. Provide shorter values.");
 
         vector<double> filter(data.size(), 0.0);
-        double sum1 = 0, sum2 = 0;
-        for (int i = 0; i < (int) data.size(); i++) {
-            if ((i - 2 * l - g + 1) >= 0) {
-                for (int a = i - 2 * l - g + 1; a < i - l - g; a++)
-                    sum1 += data[a];
-                for (int a = i - l + 1; a < i; a++)
-                    sum2 += data[a];
-                filter[i] += sum2 - sum1;
-            }
-            sum1 = sum2 = 0.;
-        }
+
+        //Both windows are l - 1 samples long, so there's nothing to sum if l < 2.
+        const int width = l - 1;
+        if (width <= 0)
+            return filter;
+
+        //runningSum[i] is the sum of the first i samples. This makes every window sum a single subtraction, so the
+        // filter is O(N) no matter how long the windows are.
+        vector<double> runningSum(data.size() + 1, 0.0);
+        for (unsigned int i = 0; i < data.size(); i++)
+            runningSum[i + 1] = runningSum[i] + data[i];
+
+        //The iterations are independent of each other, so the compiler is free to vectorize this loop.
+        const double *sum = runningSum.data();
+        for (int i = 2 * l + g - 1; i < (int) data.size(); i++)
+            filter[i] = (sum[i] - sum[i - width]) - (sum[i - l - g] - sum[i - l - g - width]);
         return filter;
     }
 }
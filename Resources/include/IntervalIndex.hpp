@@ -0,0 +1,90 @@
+///@file IntervalIndex.hpp
+///@brief A sorted set of open time intervals that can be searched with a binary search.
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#ifndef PIXIESUITE_INTERVALINDEX_HPP
+#define PIXIESUITE_INTERVALINDEX_HPP
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+///Holds a set of open intervals (begin, end) sorted by their beginning. Intervals that overlap are merged when they
+/// are added, so the ends are sorted too and a point or a span can be located with a single binary search. The
+/// endpoints themselves are never inside an interval, which is how the rejection regions have always been checked.
+class IntervalIndex {
+public:
+    ///How a span of time lies with respect to the intervals.
+    enum Overlap {
+        OUTSIDE, ///< None of the span is inside an interval
+        INSIDE, ///< All of the span is inside a single interval
+        PARTIAL ///< Some of the span is inside an interval
+    };
+
+    ///Default Constructor
+    IntervalIndex() {}
+
+    ///Default Destructor
+    ~IntervalIndex() {}
+
+    ///Adds an interval, merging it with any of the intervals that it overlaps. Empty intervals are ignored.
+    ///@param[in] begin : The start of the interval
+    ///@param[in] end : The end of the interval
+    void Add(const double &begin, const double &end) {
+        if (end <= begin)
+            return;
+
+        std::pair<double, double> interval(begin, end);
+        std::vector<std::pair<double, double> >::iterator first = std::lower_bound(
+                intervals_.begin(), intervals_.end(), begin,
+                [](const std::pair<double, double> &a, const double &b) { return a.second <= b; });
+        std::vector<std::pair<double, double> >::iterator last = first;
+        while (last != intervals_.end() && last->first < end) {
+            interval.first = std::min(interval.first, last->first);
+            interval.second = std::max(interval.second, last->second);
+            ++last;
+        }
+        intervals_.insert(intervals_.erase(first, last), interval);
+    }
+
+    ///Removes all of the intervals.
+    void Clear() { intervals_.clear(); }
+
+    ///@return True if there are no intervals
+    bool IsEmpty() const { return intervals_.empty(); }
+
+    ///@return The merged intervals in order
+    const std::vector<std::pair<double, double> > &GetIntervals() const { return intervals_; }
+
+    ///@return True if the point is inside one of the intervals
+    ///@param[in] time : The point to look for
+    bool Contains(const double &time) const {
+        std::vector<std::pair<double, double> >::const_iterator it = Find(time);
+        return it != intervals_.end() && it->first < time;
+    }
+
+    ///Works out how the closed span [first, last] lies with respect to the intervals.
+    ///@param[in] first : The start of the span
+    ///@param[in] last : The end of the span
+    ///@return INSIDE if the whole span is inside a single interval, OUTSIDE if none of it is and PARTIAL otherwise
+    Overlap Classify(const double &first, const double &last) const {
+        std::vector<std::pair<double, double> >::const_iterator it = Find(first);
+        if (it == intervals_.end())
+            return OUTSIDE;
+        if (it->first < first && last < it->second)
+            return INSIDE;
+        //The interval ends after the start of the span, so the span reaches into it if it gets past its beginning.
+        return it->first < last ? PARTIAL : OUTSIDE;
+    }
+
+private:
+    std::vector<std::pair<double, double> > intervals_; ///< The disjoint intervals sorted by their start
+
+    ///@return The first interval that ends after the time
+    std::vector<std::pair<double, double> >::const_iterator Find(const double &time) const {
+        return std::upper_bound(intervals_.begin(), intervals_.end(), time,
+                                [](const double &a, const std::pair<double, double> &b) { return a < b.second; });
+    }
+};
+
+#endif //PIXIESUITE_INTERVALINDEX_HPP
@@ -6,6 +6,7 @@
 #ifndef __RANDOMINTERFACE_HPP_
 #define __RANDOMINTERFACE_HPP_
 
+#include <mutex>
 #include <random>
 
 /// An  of numbers using Mersenne twister - Singleton Class
@@ -14,7 +15,7 @@ public:
     /** \return The only instance to the random pool */
     static RandomInterface *get();
 
-    /** \return a random number in the specified range [0, range]
+    /** \return a random number in the specified range [0, range]. This is safe to call from several threads.
     * \param [in] range : the upper bound for the range to get */
     double Generate(const double &range = 1);
 private:
@@ -25,6 +26,7 @@ private:
 
     std::mt19937_64 engine_;
     std::uniform_real_distribution<double> distribution_;
+    std::mutex mutex_; //!< Protects the engine when we're called from several threads
     unsigned seed_;
 };
 
@@ -20,7 +20,7 @@
 class TrapFilterParameters {
 public:
     //!Default Constructor
-    TrapFilterParameters() {};
+    TrapFilterParameters() : g_(0), l_(0), t_(0) {};
 
     //!Constructor accepting risetime, flattop, and tau/threshold parameters
     //!in units of nanoseconds.
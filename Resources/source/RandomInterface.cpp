@@ -21,5 +21,6 @@ RandomInterface::RandomInterface() {
 }
 
 double RandomInterface::Generate(const double &range/*=1*/) {
+    std::lock_guard<std::mutex> lock(mutex_);
     return distribution_(engine_) * range;
 }
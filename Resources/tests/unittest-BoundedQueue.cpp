@@ -0,0 +1,61 @@
+///@file unittest-BoundedQueue.cpp
+///@brief Unit tests for the BoundedQueue class
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <UnitTest++.h>
+
+#include <thread>
+
+#include "BoundedQueue.hpp"
+
+using namespace std;
+
+TEST(TestFullAndEmptyQueue) {
+    BoundedQueue<int> queue(2);
+    int item = 1;
+
+    CHECK(queue.IsEmpty());
+    CHECK(!queue.TryPop(item));
+
+    CHECK(queue.TryPush(item));
+    item = 2;
+    CHECK(queue.TryPush(item));
+    item = 3;
+    CHECK(!queue.TryPush(item));
+
+    CHECK(queue.TryPop(item));
+    CHECK_EQUAL(1, item);
+    CHECK(queue.TryPop(item));
+    CHECK_EQUAL(2, item);
+    CHECK(queue.IsEmpty());
+}
+
+///Pushes many more elements than the queue can hold through a second thread to make sure that nothing is lost or
+/// reordered when the indices wrap around.
+TEST(TestProducerConsumerOrdering) {
+    static const unsigned int numItems = 100000;
+    BoundedQueue<unsigned int> queue(16);
+
+    thread producer([&queue]() {
+        for (unsigned int i = 0; i < numItems; i++) {
+            unsigned int item = i;
+            queue.Push(item);
+        }
+    });
+
+    unsigned int numOutOfOrder = 0;
+    for (unsigned int i = 0; i < numItems; i++) {
+        unsigned int item;
+        queue.Pop(item);
+        if (item != i)
+            numOutOfOrder++;
+    }
+    producer.join();
+
+    CHECK_EQUAL((unsigned int) 0, numOutOfOrder);
+    CHECK(queue.IsEmpty());
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}
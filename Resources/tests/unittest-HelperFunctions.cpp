@@ -18,6 +18,38 @@ TEST(TestTrapezoidalFiltering) {
                       filteredTrace.size(), 0.1);
 }
 
+///The filter as it was calculated before we switched to running sums, every window is summed from scratch.
+static vector<double> DirectTrapezoidalFilter(const vector<double> &data, const int &l, const int &g) {
+    vector<double> filter(data.size(), 0.0);
+    for (int i = max(2 * l + g - 1, 0); i < (int) data.size(); i++) {
+        double sum1 = 0, sum2 = 0;
+        for (int a = i - 2 * l - g + 1; a < i - l - g; a++)
+            sum1 += data[a];
+        for (int a = i - l + 1; a < i; a++)
+            sum2 += data[a];
+        filter[i] = sum2 - sum1;
+    }
+    return filter;
+}
+
+///Traces hold integers, so the running sums must give exactly what we get by summing the windows directly.
+TEST(TestTrapezoidalFilterMatchesDirectSums) {
+    vector<double> integerTrace;
+    for (unsigned int i = 0; i < 2000; i++)
+        integerTrace.push_back((i * 7919) % 4096);
+
+    for (int l = 0; l < 12; l++) {
+        for (int g = 0; g < 6; g++) {
+            vector<double> expected = DirectTrapezoidalFilter(integerTrace, l, g);
+            CHECK_ARRAY_EQUAL(expected, Filtering::TrapezoidalFilter(integerTrace, l, g), expected.size());
+
+            expected = DirectTrapezoidalFilter(trace_sans_baseline, l, g);
+            CHECK_ARRAY_CLOSE(expected, Filtering::TrapezoidalFilter(trace_sans_baseline, l, g), expected.size(),
+                              1e-9);
+        }
+    }
+}
+
 TEST(TestCalculateSlopeAndIntercept) {
     auto result = Polynomial::CalculateSlope(xy1, xy2);
     CHECK_EQUAL(slope, result);
@@ -0,0 +1,80 @@
+///@file unittest-IntervalIndex.cpp
+///@brief Unit tests for the IntervalIndex class
+///@author S. V. Paulauskas
+///@date October 18, 2026
+#include <UnitTest++.h>
+
+#include "IntervalIndex.hpp"
+
+using namespace std;
+
+TEST(TestMergingIntervals) {
+    IntervalIndex index;
+    CHECK(index.IsEmpty());
+
+    index.Add(50, 60);
+    index.Add(10, 20);
+    index.Add(15, 30);
+    index.Add(30, 40);
+    index.Add(5, 5);
+    index.Add(45, 70);
+
+    //Intervals that only touch stay apart since their shared end isn't inside either of them.
+    CHECK_EQUAL(3u, index.GetIntervals().size());
+    CHECK_EQUAL(10, index.GetIntervals()[0].first);
+    CHECK_EQUAL(30, index.GetIntervals()[0].second);
+    CHECK_EQUAL(30, index.GetIntervals()[1].first);
+    CHECK_EQUAL(40, index.GetIntervals()[1].second);
+    CHECK_EQUAL(45, index.GetIntervals()[2].first);
+    CHECK_EQUAL(70, index.GetIntervals()[2].second);
+
+    index.Add(0, 100);
+    CHECK_EQUAL(1u, index.GetIntervals().size());
+
+    index.Clear();
+    CHECK(index.IsEmpty());
+}
+
+TEST(TestContains) {
+    IntervalIndex index;
+    CHECK(!index.Contains(1));
+
+    index.Add(10, 20);
+    index.Add(30, 40);
+
+    CHECK(!index.Contains(5));
+    CHECK(!index.Contains(10));
+    CHECK(index.Contains(10.5));
+    CHECK(index.Contains(19.9));
+    CHECK(!index.Contains(20));
+    CHECK(!index.Contains(25));
+    CHECK(index.Contains(35));
+    CHECK(!index.Contains(40));
+    CHECK(!index.Contains(45));
+}
+
+TEST(TestClassify) {
+    IntervalIndex index;
+    CHECK_EQUAL(IntervalIndex::OUTSIDE, index.Classify(0, 100));
+
+    index.Add(10, 20);
+    index.Add(30, 40);
+
+    CHECK_EQUAL(IntervalIndex::OUTSIDE, index.Classify(0, 5));
+    CHECK_EQUAL(IntervalIndex::OUTSIDE, index.Classify(0, 10));
+    CHECK_EQUAL(IntervalIndex::OUTSIDE, index.Classify(20, 30));
+    CHECK_EQUAL(IntervalIndex::OUTSIDE, index.Classify(45, 50));
+
+    CHECK_EQUAL(IntervalIndex::INSIDE, index.Classify(11, 19));
+    CHECK_EQUAL(IntervalIndex::INSIDE, index.Classify(35, 35));
+
+    CHECK_EQUAL(IntervalIndex::PARTIAL, index.Classify(5, 11));
+    CHECK_EQUAL(IntervalIndex::PARTIAL, index.Classify(10, 20));
+    CHECK_EQUAL(IntervalIndex::PARTIAL, index.Classify(15, 25));
+    CHECK_EQUAL(IntervalIndex::PARTIAL, index.Classify(25, 35));
+    CHECK_EQUAL(IntervalIndex::PARTIAL, index.Classify(0, 50));
+}
+
+int main(int argv, char *argc[]) {
+    return (UnitTest::RunAllTests());
+}